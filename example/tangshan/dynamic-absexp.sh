@@ -73,7 +73,13 @@ cat << ieof > $PAR_FILE
       "fault_plane" : {
         "fault_geometry_dir" : "${INPUTDIR}/prep_fault",
         "fault_init_stress_dir" : "${INPUTDIR}/prep_fault",
-        "fault_inteval" : 100.0
+        "fault_inteval" : 100.0,
+        "#x_stretch" : {
+          "type" : "geometric",
+          "uniform_cells" : 20,
+          "ratio" : 1.08,
+          "max_factor" : 4.0
+        }
       },
       "#grid_import" : {
         "import_dir" : "${INPUTDIR}/prep_fault",
@@ -168,6 +168,9 @@ cat << ieof > $PAR_FILE
 
   "in_station_file" : "$INPUTDIR/station.list",
   "fault_station_file" : "$INPUTDIR/fault_station.list",
+  "#fault_output_sparse" : 1,
+  "#fault_output_sparse_vs_threshold" : 1.0e-3,
+  "#fault_output_sparse_tolerance" : 1.0e-3,
 
   "#receiver_line" : [
     {
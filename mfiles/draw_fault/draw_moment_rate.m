@@ -0,0 +1,40 @@
+clear all;
+close all;
+clc;
+% -------------------------- parameters input -------------------------- %
+% moment_rate.txt is written by solver in output dir
+output_dir='../../project2/output';
+
+% figure control parameters
+flag_print=0;
+
+% ---------------------------------------------------------------------- %
+% columns: it t moment_rate M0 Mw area_slipping area_ruptured num_slipping
+data = load([output_dir,'/moment_rate.txt']);
+t  = data(:,2);
+Mr = data(:,3);
+M0 = data(:,4);
+Mw = data(:,5);
+area_rup = data(:,7);
+
+figure(1)
+subplot(2,1,1)
+plot(t,Mr,'b','linewidth',1.0);
+xlabel('Time (s)');
+ylabel('Moment rate (N*m/s)');
+title(['M0 = ',num2str(M0(end),'%.3e'),' N*m, Mw = ',num2str(Mw(end),'%.2f')]);
+subplot(2,1,2)
+plot(t,area_rup/1e6,'r','linewidth',1.0);
+xlabel('Time (s)');
+ylabel('Ruptured area (km^2)');
+set(gcf,'color','white','renderer','painters');
+% save and print figure
+if flag_print
+    width= 800;
+    height=600;
+    set(gcf,'paperpositionmode','manual');
+    set(gcf,'paperunits','points');
+    set(gcf,'papersize',[width,height]);
+    set(gcf,'paperposition',[0,0,width,height]);
+    print(gcf,'moment_rate.png','-dpng');
+end
@@ -73,79 +73,85 @@ int init_gd_device(gd_t *gd, gd_t *gd_d)
 
 int init_md_device(md_t *md, md_t *md_d)
 {
-  size_t siz_icmp = md->siz_icmp;
+  // one value per material if compressed
+  size_t siz_mat = md->siz_mat;
 
   memcpy(md_d,md,sizeof(md_t));
+  if (md->mat_nbyte > 0)
+  {
+    md_d->mat_id = cuda_malloc(md->mat_nbyte*md->siz_icmp);
+    CUDACHECK(cudaMemcpy(md_d->mat_id, md->mat_id, md->mat_nbyte*md->siz_icmp, cudaMemcpyHostToDevice));
+  }
   if (md->medium_type == CONST_MEDIUM_ELASTIC_ISO)
   {
-    md_d->rho    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->lambda = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->mu     = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    CUDACHECK(cudaMemcpy(md_d->rho,    md->rho,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->lambda, md->lambda, sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->mu,     md->mu,     sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
+    md_d->rho    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->lambda = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->mu     = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    CUDACHECK(cudaMemcpy(md_d->rho,    md->rho,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->lambda, md->lambda, sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->mu,     md->mu,     sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
   }
   if (md->medium_type == CONST_MEDIUM_ELASTIC_VTI)
   {
-    md_d->rho    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c11    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c33    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c55    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c66    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c13    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    CUDACHECK(cudaMemcpy(md_d->rho,    md->rho,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c11,    md->c11,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c33,    md->c33,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c55,    md->c55,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c66,    md->c66,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c13,    md->c13,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
+    md_d->rho    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c11    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c33    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c55    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c66    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c13    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    CUDACHECK(cudaMemcpy(md_d->rho,    md->rho,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c11,    md->c11,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c33,    md->c33,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c55,    md->c55,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c66,    md->c66,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c13,    md->c13,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
   }
   if (md->medium_type == CONST_MEDIUM_ELASTIC_ANISO)
   {
-    md_d->rho    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c11    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c12    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c13    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c14    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c15    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c16    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c22    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c23    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c24    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c25    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c26    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c33    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c34    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c35    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c36    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c44    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c45    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c46    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c55    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c56    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    md_d->c66    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
-    CUDACHECK(cudaMemcpy(md_d->rho,    md->rho,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c11,    md->c11,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c12,    md->c12,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c13,    md->c13,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c14,    md->c14,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c15,    md->c15,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c16,    md->c16,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c22,    md->c22,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c23,    md->c23,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c24,    md->c24,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c25,    md->c25,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c26,    md->c26,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c33,    md->c33,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c34,    md->c34,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c35,    md->c35,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c36,    md->c36,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c44,    md->c44,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c45,    md->c45,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c46,    md->c46,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c55,    md->c55,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c56,    md->c56,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
-    CUDACHECK(cudaMemcpy(md_d->c66,    md->c66,    sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
+    md_d->rho    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c11    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c12    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c13    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c14    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c15    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c16    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c22    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c23    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c24    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c25    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c26    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c33    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c34    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c35    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c36    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c44    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c45    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c46    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c55    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c56    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    md_d->c66    = (float *) cuda_malloc(sizeof(float)*siz_mat);
+    CUDACHECK(cudaMemcpy(md_d->rho,    md->rho,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c11,    md->c11,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c12,    md->c12,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c13,    md->c13,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c14,    md->c14,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c15,    md->c15,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c16,    md->c16,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c22,    md->c22,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c23,    md->c23,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c24,    md->c24,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c25,    md->c25,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c26,    md->c26,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c33,    md->c33,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c34,    md->c34,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c35,    md->c35,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c36,    md->c36,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c44,    md->c44,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c45,    md->c45,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c46,    md->c46,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c55,    md->c55,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c56,    md->c56,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(md_d->c66,    md->c66,    sizeof(float)*siz_mat, cudaMemcpyHostToDevice));
   }
 
   return 0;
@@ -170,11 +176,42 @@ int init_fd_device(fd_t *fd, fd_device_t *fd_device_d)
   return 0;
 }
 
-int init_metric_device(gd_metric_t *metric, gd_metric_t *metric_d)
+int init_metric_device(gd_metric_t *metric, gd_metric_t *metric_d, int is_recompute)
 {
   size_t siz_icmp = metric->siz_icmp;
 
   memcpy(metric_d,metric,sizeof(gd_metric_t));
+
+  // only coords on device, metric derived in kernels
+  if (is_recompute == 1)
+  {
+    metric_d->is_recompute = 1;
+    metric_d->jac    = NULL;
+    metric_d->xi_x   = NULL;
+    metric_d->xi_y   = NULL;
+    metric_d->xi_z   = NULL;
+    metric_d->eta_x  = NULL;
+    metric_d->eta_y  = NULL;
+    metric_d->eta_z  = NULL;
+    metric_d->zeta_x = NULL;
+    metric_d->zeta_y = NULL;
+    metric_d->zeta_z = NULL;
+
+    metric_d->x3d = (float *) cuda_malloc(sizeof(float)*siz_icmp);
+    metric_d->y3d = (float *) cuda_malloc(sizeof(float)*siz_icmp);
+    metric_d->z3d = (float *) cuda_malloc(sizeof(float)*siz_icmp);
+
+    CUDACHECK(cudaMemcpy(metric_d->x3d, metric->x3d, sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(metric_d->y3d, metric->y3d, sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
+    CUDACHECK(cudaMemcpy(metric_d->z3d, metric->z3d, sizeof(float)*siz_icmp, cudaMemcpyHostToDevice));
+
+    return 0;
+  }
+
+  metric_d->is_recompute = 0;
+  metric_d->x3d = NULL;
+  metric_d->y3d = NULL;
+  metric_d->z3d = NULL;
   metric_d->jac     = (float *) cuda_malloc(sizeof(float)*siz_icmp);
   metric_d->xi_x    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
   metric_d->xi_y    = (float *) cuda_malloc(sizeof(float)*siz_icmp);
@@ -652,6 +689,10 @@ int dealloc_md_device(md_t md_d)
     CUDACHECK(cudaFree(md_d.c56)); 
     CUDACHECK(cudaFree(md_d.c66)); 
   }
+  if (md_d.mat_nbyte > 0)
+  {
+    CUDACHECK(cudaFree(md_d.mat_id)); 
+  }
 
   return 0;
 }
@@ -675,6 +716,14 @@ int dealloc_fd_device(fd_device_t fd_device_d)
 
 int dealloc_metric_device(gd_metric_t metric_d)
 {
+  if (metric_d.is_recompute == 1)
+  {
+    CUDACHECK(cudaFree(metric_d.x3d));
+    CUDACHECK(cudaFree(metric_d.y3d));
+    CUDACHECK(cudaFree(metric_d.z3d));
+    return 0;
+  }
+
   CUDACHECK(cudaFree(metric_d.jac   )); 
   CUDACHECK(cudaFree(metric_d.xi_x  )); 
   CUDACHECK(cudaFree(metric_d.xi_y  )); 
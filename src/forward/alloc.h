@@ -22,7 +22,7 @@ int
 init_fd_device(fd_t *fd, fd_device_t *fd_device_d);
 
 int
-init_metric_device(gd_metric_t *metric, gd_metric_t *metric_d);
+init_metric_device(gd_metric_t *metric, gd_metric_t *metric_d, int is_recompute);
 
 int 
 init_fault_coef_device(gd_t *gd, fault_coef_t *FC, fault_coef_t *FC_d);
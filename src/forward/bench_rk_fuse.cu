@@ -0,0 +1,396 @@
+/*******************************************************************************
+ * check and timing of fused RK update on synthetic arrays
+ *  RK stages of wavefield, fault wavefield and one PML face are run by
+ *  the separate kernels, by the fused device update, by one launch per
+ *  segment and by the fused host update, each followed by ablexp damping
+ *  of w_end as in drv_rk_curv_col_allstep. results must be bitwise
+ *  identical
+ *
+ *  usage: bench_rk_fuse nx ny nz [number_of_steps]
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "constants.h"
+#include "gd_t.h"
+#include "wav_t.h"
+#include "bdry_t.h"
+#include "fault_info.h"
+#include "fault_wav_t.h"
+#include "rk_fuse.h"
+#include "prof_t.h"
+#include "cuda_common.h"
+
+#define BENCH_NUM_STAGE 4
+#define BENCH_NUM_FAULT 2
+#define BENCH_PML_LAYER 10
+
+static float bench_rk_a[BENCH_NUM_STAGE-1] = { 0.5, 0.5, 1.0 };
+static float bench_rk_b[BENCH_NUM_STAGE]   = { 1.0/6.0, 1.0/3.0, 1.0/3.0, 1.0/6.0 };
+
+/*
+ * pointers of one copy of the state, levels pre, tmp, rhs, end
+ */
+
+typedef struct
+{
+  float *buff;
+  float *w[4];
+  float *f[4];
+  float *p[4];
+} bench_state_t;
+
+typedef struct
+{
+  size_t siz_w;
+  size_t siz_f; // one fault
+  size_t siz_p;
+  size_t siz_all;
+} bench_size_t;
+
+static void
+bench_point(bench_state_t *S, bench_size_t *Z, float *buff)
+{
+  S->buff = buff;
+  float *ptr = buff;
+  for (int n=0; n < 4; n++) { S->w[n] = ptr; ptr += Z->siz_w; }
+  for (int n=0; n < 4; n++) { S->f[n] = ptr; ptr += Z->siz_f * BENCH_NUM_FAULT; }
+  for (int n=0; n < 4; n++) { S->p[n] = ptr; ptr += Z->siz_p; }
+}
+
+// lcg, same values on each call
+static void
+bench_fill(float *v, size_t size)
+{
+  unsigned int seed = 12345;
+  for (size_t i=0; i < size; i++) {
+    seed = seed * 1103515245u + 12345u;
+    v[i] = ((seed >> 8) & 0xffff) / 32768.0f - 1.0f;
+  }
+}
+
+static void
+bench_swap(bench_state_t *S)
+{
+  float *tmp;
+  tmp = S->w[0]; S->w[0] = S->w[3]; S->w[3] = tmp;
+  tmp = S->f[0]; S->f[0] = S->f[3]; S->f[3] = tmp;
+  tmp = S->p[0]; S->p[0] = S->p[3]; S->p[3] = tmp;
+}
+
+/*
+ * one step by separate kernels, in order of drv_rk_curv_col_allstep
+ */
+
+static void
+bench_step_sep(bench_state_t *S, bench_size_t *Z, gd_t *gd, fault_t F,
+               bdryexp_t bdryexp, float dt)
+{
+  int ncmp = 9;
+  dim3 block(256);
+  dim3 grid_w((Z->siz_w + block.x - 1) / block.x);
+  dim3 grid_p((Z->siz_p + block.x - 1) / block.x);
+  dim3 block_f(4,8,8);
+  dim3 grid_f((2*ncmp + block_f.x - 1) / block_f.x,
+              (gd->nj + block_f.y - 1) / block_f.y,
+              (gd->nk + block_f.z - 1) / block_f.z);
+
+  for (int istage=0; istage < BENCH_NUM_STAGE; istage++)
+  {
+    float coef_b = bench_rk_b[istage] * dt;
+    if (istage < BENCH_NUM_STAGE-1)
+    {
+      float coef_a = bench_rk_a[istage] * dt;
+      wav_update <<<grid_w, block>>> (Z->siz_w, coef_a, S->w[1], S->w[0], S->w[2]);
+      for (int id=0; id < BENCH_NUM_FAULT; id++) {
+        fault_wav_update <<<grid_f, block_f>>> (*gd, ncmp, coef_a, id, F,
+                  S->f[1] + id*Z->siz_f, S->f[0] + id*Z->siz_f, S->f[2] + id*Z->siz_f);
+      }
+      wav_update <<<grid_p, block>>> (Z->siz_p, coef_a, S->p[1], S->p[0], S->p[2]);
+    }
+    if (istage == 0)
+    {
+      wav_update <<<grid_w, block>>> (Z->siz_w, coef_b, S->w[3], S->w[0], S->w[2]);
+      for (int id=0; id < BENCH_NUM_FAULT; id++) {
+        fault_wav_update <<<grid_f, block_f>>> (*gd, ncmp, coef_b, id, F,
+                  S->f[3] + id*Z->siz_f, S->f[0] + id*Z->siz_f, S->f[2] + id*Z->siz_f);
+      }
+      wav_update <<<grid_p, block>>> (Z->siz_p, coef_b, S->p[3], S->p[0], S->p[2]);
+    }
+    else
+    {
+      wav_update_end <<<grid_w, block>>> (Z->siz_w, coef_b, S->w[3], S->w[2]);
+      for (int id=0; id < BENCH_NUM_FAULT; id++) {
+        fault_wav_update_end <<<grid_f, block_f>>> (*gd, ncmp, coef_b, id, F,
+                  S->f[3] + id*Z->siz_f, S->f[2] + id*Z->siz_f);
+      }
+      wav_update_end <<<grid_p, block>>> (Z->siz_p, coef_b, S->p[3], S->p[2]);
+    }
+  }
+  bdry_ablexp_apply(bdryexp, gd, S->w[3], ncmp);
+
+  bench_swap(S);
+}
+
+/*
+ * bdry_ablexp_apply on host copy
+ */
+
+static void
+bench_ablexp_host(bdryexp_t bdryexp, gd_t *gd, float *w_end, int ncmp)
+{
+  bdry_block_t *D = bdryexp.bdry_blk;
+  for (int n=0; n < CONST_NDIM_2; n++)
+  {
+    if (D[n].enable == 0) continue;
+    for (int k=D[n].nk1; k < D[n].nk1 + D[n].nk; k++) {
+      for (int j=D[n].nj1; j < D[n].nj1 + D[n].nj; j++) {
+        for (int i=D[n].ni1; i < D[n].ni1 + D[n].ni; i++)
+        {
+          size_t iptr = i + j * gd->siz_iy + k * gd->siz_iz;
+          float mask = (bdryexp.ablexp_Ex[i] < bdryexp.ablexp_Ey[j]) ?
+                        bdryexp.ablexp_Ex[i] : bdryexp.ablexp_Ey[j];
+          if (mask > bdryexp.ablexp_Ez[k]) mask = bdryexp.ablexp_Ez[k];
+          for (int icmp=0; icmp < ncmp; icmp++) {
+            w_end[iptr + icmp * gd->siz_icmp] *= mask;
+          }
+        }
+      }
+    }
+  }
+}
+
+#define BENCH_FUSE_DEVICE 0
+#define BENCH_FUSE_EACH   1
+#define BENCH_FUSE_HOST   2
+
+static void
+bench_step_fuse(bench_state_t *S, bench_size_t *Z, gd_t *gd,
+                rk_fuse_t *fuse_send, rk_fuse_t *fuse_rest, fault_t F,
+                bdrypml_t pml, bdryexp_t bdryexp, float dt, int mode)
+{
+  wav_t       wav;
+  fault_wav_t FW;
+  wav.siz_ilevel  = Z->siz_w;
+  FW.siz_ilevel   = Z->siz_f;
+  FW.number_fault = BENCH_NUM_FAULT;
+
+  bdrypml_auxvar_t *auxvar = &(pml.auxvar[0][0]);
+  auxvar->pre = S->p[0];
+  auxvar->tmp = S->p[1];
+  auxvar->rhs = S->p[2];
+  auxvar->end = S->p[3];
+
+  for (int istage=0; istage < BENCH_NUM_STAGE; istage++)
+  {
+    float coef_a = (istage < BENCH_NUM_STAGE-1) ? bench_rk_a[istage] * dt : 0.0;
+    float coef_b = bench_rk_b[istage] * dt;
+    rk_fuse_set_stage(fuse_send, fuse_rest, istage, BENCH_NUM_STAGE, coef_a, coef_b,
+                      wav, S->w[0], S->w[1], S->w[2], S->w[3],
+                      FW,  S->f[0], S->f[1], S->f[2], S->f[3],
+                      F, pml);
+    if (mode == BENCH_FUSE_HOST) {
+      rk_fuse_update_host(fuse_send);
+      rk_fuse_update_host(fuse_rest);
+    } else if (mode == BENCH_FUSE_EACH) {
+      rk_fuse_update_each(fuse_send);
+      rk_fuse_update_each(fuse_rest);
+    } else {
+      rk_fuse_update(fuse_send);
+      rk_fuse_update(fuse_rest);
+    }
+  }
+  if (mode == BENCH_FUSE_HOST) {
+    bench_ablexp_host(bdryexp, gd, S->w[3], 9);
+  } else {
+    bdry_ablexp_apply(bdryexp, gd, S->w[3], 9);
+  }
+
+  bench_swap(S);
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 4) {
+    fprintf(stderr, "usage: %s nx ny nz [number_of_steps]\n", argv[0]);
+    exit(1);
+  }
+
+  MPI_Init(&argc, &argv);
+
+  int nghost = 3;
+  gd_t gd;
+  memset(&gd, 0, sizeof(gd_t));
+  gd.ni = atoi(argv[1]);
+  gd.nj = atoi(argv[2]);
+  gd.nk = atoi(argv[3]);
+  int num_of_steps = (argc > 4) ? atoi(argv[4]) : 10;
+
+  gd.nx = gd.ni + 2 * nghost;
+  gd.ny = gd.nj + 2 * nghost;
+  gd.nz = gd.nk + 2 * nghost;
+  gd.ni1 = nghost; gd.ni2 = gd.ni1 + gd.ni - 1;
+  gd.nj1 = nghost; gd.nj2 = gd.nj1 + gd.nj - 1;
+  gd.nk1 = nghost; gd.nk2 = gd.nk1 + gd.nk - 1;
+  gd.siz_iy   = gd.nx;
+  gd.siz_iz   = (size_t) gd.nx * gd.ny;
+  gd.siz_icmp = (size_t) gd.nx * gd.ny * gd.nz;
+  gd.siz_slice_yz = (size_t) gd.ny * gd.nz;
+
+  bench_size_t Z;
+  Z.siz_w   = gd.siz_icmp * 9;
+  Z.siz_f   = gd.siz_slice_yz * 2 * 9;
+  Z.siz_p   = (size_t) BENCH_PML_LAYER * gd.nj * gd.nk * 9;
+  Z.siz_all = 4 * (Z.siz_w + Z.siz_f * BENCH_NUM_FAULT + Z.siz_p);
+
+  // initial values, united mask and ablexp mask on host
+  float *h_init = (float *) malloc(Z.siz_all * sizeof(float));
+  float *h_sep  = (float *) malloc(Z.siz_all * sizeof(float));
+  float *h_fuse = (float *) malloc(Z.siz_all * sizeof(float));
+  float *h_each = (float *) malloc(Z.siz_all * sizeof(float));
+  float *h_host = (float *) malloc(Z.siz_all * sizeof(float));
+  bench_fill(h_init, Z.siz_all);
+
+  int   *united = (int   *) malloc(gd.siz_slice_yz * BENCH_NUM_FAULT * sizeof(int));
+  for (size_t i=0; i < gd.siz_slice_yz * BENCH_NUM_FAULT; i++) {
+    united[i] = (i % 7 == 0) ? 1 : 0;
+  }
+  float *E = (float *) malloc((gd.nx + gd.ny + gd.nz) * sizeof(float));
+  for (int i=0; i < gd.nx + gd.ny + gd.nz; i++) E[i] = 1.0;
+  int nlay = BENCH_PML_LAYER;
+  if (nlay > gd.ni) nlay = gd.ni;
+  if (nlay > gd.nj) nlay = gd.nj;
+  if (nlay > gd.nk) nlay = gd.nk;
+  for (int i=0; i < nlay; i++) {
+    E[gd.ni2 - i]                 = 0.92 + 0.008 * i;
+    E[gd.nx + gd.nj1 + i]         = 0.92 + 0.008 * i;
+    E[gd.nx + gd.ny + gd.nk1 + i] = 0.95 + 0.005 * i;
+  }
+
+  // device copies
+  float *d_buff[3];
+  int   *d_united;
+  float *d_E;
+  for (int n=0; n < 3; n++) {
+    CUDACHECK(cudaMalloc((void **) &d_buff[n], Z.siz_all * sizeof(float)));
+    CUDACHECK(cudaMemcpy(d_buff[n], h_init, Z.siz_all * sizeof(float), cudaMemcpyHostToDevice));
+  }
+  CUDACHECK(cudaMalloc((void **) &d_united, gd.siz_slice_yz * BENCH_NUM_FAULT * sizeof(int)));
+  CUDACHECK(cudaMalloc((void **) &d_E, (gd.nx + gd.ny + gd.nz) * sizeof(float)));
+  CUDACHECK(cudaMemcpy(d_united, united, gd.siz_slice_yz * BENCH_NUM_FAULT * sizeof(int),
+                       cudaMemcpyHostToDevice));
+  CUDACHECK(cudaMemcpy(d_E, E, (gd.nx + gd.ny + gd.nz) * sizeof(float),
+                       cudaMemcpyHostToDevice));
+  memcpy(h_host, h_init, Z.siz_all * sizeof(float));
+
+  // one block over inner points, mask is 1 off the layers
+  bdryexp_t bdryexp_d, bdryexp_h;
+  memset(&bdryexp_d, 0, sizeof(bdryexp_t));
+  bdryexp_d.is_enable_ablexp = 1;
+  bdry_block_t *D = bdryexp_d.bdry_blk;
+  D[0].enable = 1;
+  D[0].ni1 = gd.ni1; D[0].ni = gd.ni;
+  D[0].nj1 = gd.nj1; D[0].nj = gd.nj;
+  D[0].nk1 = gd.nk1; D[0].nk = gd.nk;
+  bdryexp_h = bdryexp_d;
+  bdryexp_d.ablexp_Ex = d_E;
+  bdryexp_d.ablexp_Ey = d_E + gd.nx;
+  bdryexp_d.ablexp_Ez = d_E + gd.nx + gd.ny;
+  bdryexp_h.ablexp_Ex = E;
+  bdryexp_h.ablexp_Ey = E + gd.nx;
+  bdryexp_h.ablexp_Ez = E + gd.nx + gd.ny;
+
+  fault_t F_d, F_h;
+  memset(&F_d, 0, sizeof(fault_t));
+  memset(&F_h, 0, sizeof(fault_t));
+  for (int id=0; id < BENCH_NUM_FAULT; id++) {
+    F_d.fault_one[id].united = d_united + id * gd.siz_slice_yz;
+    F_h.fault_one[id].united = united   + id * gd.siz_slice_yz;
+  }
+
+  bdrypml_t pml;
+  memset(&pml, 0, sizeof(bdrypml_t));
+  pml.is_enable_pml = 1;
+  pml.is_sides_pml[0][0] = 1;
+  pml.auxvar[0][0].siz_ilevel = Z.siz_p;
+
+  rk_fuse_t fuse_send_d, fuse_rest_d, fuse_send_h, fuse_rest_h;
+  rk_fuse_init(&fuse_send_d, &gd);
+  rk_fuse_init(&fuse_rest_d, &gd);
+  rk_fuse_init(&fuse_send_h, &gd);
+  rk_fuse_init(&fuse_rest_h, &gd);
+
+  bench_state_t S_sep, S_fuse, S_each, S_host;
+  bench_point(&S_sep,  &Z, d_buff[0]);
+  bench_point(&S_fuse, &Z, d_buff[1]);
+  bench_point(&S_each, &Z, d_buff[2]);
+  bench_point(&S_host, &Z, h_host);
+
+  float dt = 1.0e-3;
+  double t_sep = 0.0, t_fuse = 0.0, t_each = 0.0, t_host = 0.0;
+  for (int it=0; it < num_of_steps; it++)
+  {
+    double t0 = prof_wtime();
+    bench_step_sep(&S_sep, &Z, &gd, F_d, bdryexp_d, dt);
+    CUDACHECK(cudaDeviceSynchronize());
+    double t1 = prof_wtime();
+    bench_step_fuse(&S_fuse, &Z, &gd, &fuse_send_d, &fuse_rest_d, F_d, pml,
+                    bdryexp_d, dt, BENCH_FUSE_DEVICE);
+    CUDACHECK(cudaDeviceSynchronize());
+    double t2 = prof_wtime();
+    bench_step_fuse(&S_each, &Z, &gd, &fuse_send_d, &fuse_rest_d, F_d, pml,
+                    bdryexp_d, dt, BENCH_FUSE_EACH);
+    CUDACHECK(cudaDeviceSynchronize());
+    double t3 = prof_wtime();
+    bench_step_fuse(&S_host, &Z, &gd, &fuse_send_h, &fuse_rest_h, F_h, pml,
+                    bdryexp_h, dt, BENCH_FUSE_HOST);
+    double t4 = prof_wtime();
+    // first step has launch warm-up
+    if (it > 0 || num_of_steps == 1) {
+      t_sep  += t1 - t0;
+      t_fuse += t2 - t1;
+      t_each += t3 - t2;
+      t_host += t4 - t3;
+    }
+  }
+
+  CUDACHECK(cudaMemcpy(h_sep,  d_buff[0], Z.siz_all * sizeof(float), cudaMemcpyDeviceToHost));
+  CUDACHECK(cudaMemcpy(h_fuse, d_buff[1], Z.siz_all * sizeof(float), cudaMemcpyDeviceToHost));
+  CUDACHECK(cudaMemcpy(h_each, d_buff[2], Z.siz_all * sizeof(float), cudaMemcpyDeviceToHost));
+
+  int is_same_sep  = memcmp(h_sep,  h_fuse, Z.siz_all * sizeof(float)) == 0;
+  int is_same_each = memcmp(h_each, h_fuse, Z.siz_all * sizeof(float)) == 0;
+  int is_same_host = memcmp(h_host, h_fuse, Z.siz_all * sizeof(float)) == 0;
+
+  int nstep = (num_of_steps > 1) ? num_of_steps - 1 : 1;
+  fprintf(stdout, "grid %d x %d x %d, %d faults, %d steps of %d stages, %d + %d segments\n",
+          gd.ni, gd.nj, gd.nk, BENCH_NUM_FAULT, num_of_steps, BENCH_NUM_STAGE,
+          fuse_send_d.num_of_seg, fuse_rest_d.num_of_seg);
+  fprintf(stdout, "  separate kernels %9.4f ms per step\n", t_sep  / nstep * 1.0e3);
+  fprintf(stdout, "  fused device     %9.4f ms per step, %s to separate kernels\n",
+          t_fuse / nstep * 1.0e3, is_same_sep  == 1 ? "identical" : "DIFFERENT");
+  fprintf(stdout, "  launch per array %9.4f ms per step, %s to fused device\n",
+          t_each / nstep * 1.0e3, is_same_each == 1 ? "identical" : "DIFFERENT");
+  fprintf(stdout, "  fused host       %9.4f ms per step, %s to fused device\n",
+          t_host / nstep * 1.0e3, is_same_host == 1 ? "identical" : "DIFFERENT");
+
+  CUDACHECK(cudaFree(d_buff[0]));
+  CUDACHECK(cudaFree(d_buff[1]));
+  CUDACHECK(cudaFree(d_buff[2]));
+  CUDACHECK(cudaFree(d_united));
+  CUDACHECK(cudaFree(d_E));
+  free(h_init);
+  free(h_sep);
+  free(h_fuse);
+  free(h_each);
+  free(h_host);
+  free(united);
+  free(E);
+
+  MPI_Finalize();
+
+  return (is_same_sep == 1 && is_same_each == 1 && is_same_host == 1) ? 0 : 1;
+}
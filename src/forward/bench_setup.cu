@@ -0,0 +1,201 @@
+/*******************************************************************************
+ * timing of host set-up loops on a synthetic curvilinear grid
+ *  metric, grid AABB and dt estimation are run with one thread and with
+ *  all threads, results of all threads must be bitwise identical
+ *
+ *  usage: bench_setup nx ny nz [num_of_threads]
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <mpi.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "constants.h"
+#include "gd_t.h"
+#include "md_t.h"
+#include "blk_t.h"
+#include "prof_t.h"
+
+#define BENCH_NUM_PASS 3
+
+typedef struct
+{
+  float dtmax, dtmaxVp, dtmaxL;
+  int   dtmaxi, dtmaxj, dtmaxk;
+} bench_dt_t;
+
+static int
+bench_set_num_threads(int num_of_threads)
+{
+#ifdef _OPENMP
+  omp_set_num_threads(num_of_threads);
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+/*
+ * smooth topography and stretched layers, media with a gradient
+ */
+
+static void
+bench_gen(gd_t *gd, md_t *md, float dh)
+{
+  for (int k = 0; k < gd->nz; k++) {
+    for (int j = 0; j < gd->ny; j++) {
+      for (int i = 0; i < gd->nx; i++)
+      {
+        size_t iptr = i + j * gd->siz_iy + k * gd->siz_iz;
+        float x = i * dh;
+        float y = j * dh;
+        float s = (float) k / (gd->nz - 1);
+        float topo = 0.1 * gd->nz * dh * sin(0.05*i) * cos(0.07*j);
+        gd->x3d[iptr] = x + 0.05 * dh * sin(0.3*j + 0.2*k);
+        gd->y3d[iptr] = y + 0.05 * dh * cos(0.2*i + 0.3*k);
+        gd->z3d[iptr] = (s - 1.0) * (gd->nz - 1) * dh * (1.0 + 0.2*s) + s * topo;
+
+        md->rho   [iptr] = 2700.0 + 0.5 * k;
+        md->mu    [iptr] = md->rho[iptr] * (3000.0 + 10.0 * sin(0.1*i)) * 3000.0;
+        md->lambda[iptr] = md->mu[iptr] * (1.0 + 0.01 * (j % 7));
+      }
+    }
+  }
+}
+
+/*
+ * best of passes in seconds
+ */
+
+static double
+bench_run(gd_t *gd, gd_metric_t *metric, md_t *md, int iwork, bench_dt_t *dt)
+{
+  double t_best = 1.0e30;
+
+  for (int n = 0; n < BENCH_NUM_PASS; n++)
+  {
+    double t0 = prof_wtime();
+    if (iwork == 0) {
+      gd_curv_metric_cal(gd, metric);
+    } else if (iwork == 1) {
+      gd_curv_set_minmax(gd);
+    } else {
+      blk_dt_esti_curv(gd, md, 1.3,
+                       &dt->dtmax, &dt->dtmaxVp, &dt->dtmaxL,
+                       &dt->dtmaxi, &dt->dtmaxj, &dt->dtmaxk);
+    }
+    double t1 = prof_wtime();
+    if (t1 - t0 < t_best) t_best = t1 - t0;
+  }
+
+  return t_best;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 4) {
+    fprintf(stderr, "usage: %s nx ny nz [num_of_threads]\n", argv[0]);
+    exit(1);
+  }
+
+  MPI_Init(&argc, &argv);
+
+  gd_t        gd;
+  gd_metric_t metric;
+  md_t        md;
+  memset(&gd, 0, sizeof(gd_t));
+
+  int nghost = 3;
+  gd.ni = atoi(argv[1]);
+  gd.nj = atoi(argv[2]);
+  gd.nk = atoi(argv[3]);
+  gd.nx = gd.ni + 2 * nghost;
+  gd.ny = gd.nj + 2 * nghost;
+  gd.nz = gd.nk + 2 * nghost;
+  gd.ni1 = nghost;
+  gd.ni2 = gd.ni1 + gd.ni - 1;
+  gd.nj1 = nghost;
+  gd.nj2 = gd.nj1 + gd.nj - 1;
+  gd.nk1 = nghost;
+  gd.nk2 = gd.nk1 + gd.nk - 1;
+  gd.npoint_ghosts = nghost;
+  gd.siz_iy   = gd.nx;
+  gd.siz_iz   = (size_t) gd.nx * gd.ny;
+  gd.siz_icmp = (size_t) gd.nx * gd.ny * gd.nz;
+
+  int num_of_threads = 1;
+#ifdef _OPENMP
+  num_of_threads = omp_get_max_threads();
+#endif
+  if (argc > 4) num_of_threads = atoi(argv[4]);
+
+  gd_curv_init(&gd);
+  gd_curv_metric_init(&gd, &metric);
+  md_init(&gd, &md, CONST_MEDIUM_ELASTIC_ISO, 0);
+
+  bench_gen(&gd, &md, 100.0);
+
+  fprintf(stdout, "grid %d x %d x %d (%zu points with ghosts), %d passes\n",
+          gd.ni, gd.nj, gd.nk, gd.siz_icmp, BENCH_NUM_PASS);
+
+  const char *work_name[3] = { "metric_cal", "set_minmax", "dt_esti" };
+
+  // copies of serial results
+  size_t siz_metric = metric.siz_icmp * metric.ncmp;
+  float *metric_ref = (float *) malloc(siz_metric * sizeof(float));
+  float *cell_ref   = (float *) malloc(gd.siz_icmp * 6 * sizeof(float));
+  float *cell_var[6] = { gd.cell_xmin, gd.cell_xmax, gd.cell_ymin,
+                         gd.cell_ymax, gd.cell_zmin, gd.cell_zmax };
+  bench_dt_t dt_ref, dt;
+
+  int is_same_all = 1;
+  for (int iwork = 0; iwork < 3; iwork++)
+  {
+    bench_set_num_threads(1);
+    double t_serial = bench_run(&gd, &metric, &md, iwork, &dt_ref);
+
+    if (iwork == 0) {
+      memcpy(metric_ref, metric.v4d, siz_metric * sizeof(float));
+    } else if (iwork == 1) {
+      for (int n = 0; n < 6; n++) {
+        memcpy(cell_ref + n * gd.siz_icmp, cell_var[n], gd.siz_icmp * sizeof(float));
+      }
+    }
+
+    int nthd = bench_set_num_threads(num_of_threads);
+    double t_par = bench_run(&gd, &metric, &md, iwork, &dt);
+
+    int is_same = 1;
+    if (iwork == 0) {
+      is_same = memcmp(metric_ref, metric.v4d, siz_metric * sizeof(float)) == 0;
+    } else if (iwork == 1) {
+      for (int n = 0; n < 6; n++) {
+        if (memcmp(cell_ref + n * gd.siz_icmp, cell_var[n],
+                   gd.siz_icmp * sizeof(float)) != 0) is_same = 0;
+      }
+    } else {
+      is_same = memcmp(&dt_ref, &dt, sizeof(bench_dt_t)) == 0;
+    }
+    if (is_same == 0) is_same_all = 0;
+
+    fprintf(stdout, "  %-12s 1 thread %9.4f s, %3d threads %9.4f s, speedup %6.2f, %s\n",
+            work_name[iwork], t_serial, nthd, t_par,
+            t_par > 0.0 ? t_serial / t_par : 0.0,
+            is_same == 1 ? "identical" : "DIFFERENT");
+  }
+
+  fprintf(stdout, "  dt=%e at i=%d j=%d k=%d, Vp=%f, L=%f\n",
+          dt.dtmax, dt.dtmaxi, dt.dtmaxj, dt.dtmaxk, dt.dtmaxVp, dt.dtmaxL);
+
+  free(metric_ref);
+  free(cell_ref);
+
+  MPI_Finalize();
+
+  return is_same_all == 1 ? 0 : 1;
+}
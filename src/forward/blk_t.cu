@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdint.h>
 #include <mpi.h>
 
 #include "fdlib_mem.h"
@@ -68,6 +69,78 @@ blk_set_output(blk_t *blk,
  * estimate dt
  *********************************************************************/
 
+/*
+ * Vp of one point
+ */
+
+static inline float
+blk_point_vp(md_t *md, size_t iptr)
+{
+  float Vp;
+
+  if (md->medium_type == CONST_MEDIUM_ELASTIC_ISO) {
+    Vp = sqrt( (md->lambda[iptr] + 2.0 * md->mu[iptr]) / md->rho[iptr] );
+  } else if (md->medium_type == CONST_MEDIUM_ELASTIC_VTI) {
+    float Vpv = sqrt( md->c33[iptr] / md->rho[iptr] );
+    float Vph = sqrt( md->c11[iptr] / md->rho[iptr] );
+    Vp = Vph > Vpv ? Vph : Vpv;
+  } else if (md->medium_type == CONST_MEDIUM_ELASTIC_ANISO) {
+    // need to implement accurate solution
+    Vp = sqrt( md->c11[iptr] / md->rho[iptr] );
+  } else {
+    Vp = sqrt( md->kappa[iptr] / md->rho[iptr] );
+  }
+
+  return Vp;
+}
+
+/*
+ * min L of point iptr to 8 adjacent planes, each plane through the
+ *  neighbours at -ii, -jj and -kk with ii, jj, kk of -1 or 1.
+ *  same ops as fdlib_math_dist_point2plane, inlined to vectorize
+ */
+
+static inline float
+blk_point_min_len(const float *x3d, const float *y3d, const float *z3d,
+                  size_t iptr, size_t siz_iy, size_t siz_iz)
+{
+  float x0 = x3d[iptr];
+  float y0 = y3d[iptr];
+  float z0 = z3d[iptr];
+
+  float dtLe = 1.0e20;
+
+  // n = 0-7 runs kk, jj, ii from -1 to 1 as the plain triple loop
+  for (int n = 0; n < 8; n++)
+  {
+    size_t iptr1 = iptr - ((n & 1) ? 1      : -1     );
+    size_t iptr2 = iptr - ((n & 2) ? siz_iy : -siz_iy);
+    size_t iptr3 = iptr - ((n & 4) ? siz_iz : -siz_iz);
+
+    float x1 = x3d[iptr1], y1 = y3d[iptr1], z1 = z3d[iptr1];
+
+    float x12 = x3d[iptr2] - x1;
+    float y12 = y3d[iptr2] - y1;
+    float z12 = z3d[iptr2] - z1;
+    float x13 = x3d[iptr3] - x1;
+    float y13 = y3d[iptr3] - y1;
+    float z13 = z3d[iptr3] - z1;
+
+    float px = y12 * z13 - z12 * y13;
+    float py = z12 * x13 - x12 * z13;
+    float pz = x12 * y13 - y12 * x13;
+
+    float d = px * x1 + py * y1 + pz * z1;
+    float L = (float)fabs( (px * x0 + py * y0 + pz * z0) - d);
+    L = L/sqrtf(px * px + py * py + pz * pz);
+
+    // NaN of degenerated plane is skipped
+    dtLe = dtLe > L ? L : dtLe;
+  }
+
+  return dtLe;
+}
+
 int
 blk_dt_esti_curv(gd_t *gd, md_t *md,
     float CFL, float *dtmax, float *dtmaxVp, float *dtmaxL,
@@ -75,75 +148,73 @@ blk_dt_esti_curv(gd_t *gd, md_t *md,
 {
   int ierr = 0;
 
-  float dtmax_local = 1.0e10;
-  float Vp;
-
   float *x3d = gd->x3d;
   float *y3d = gd->y3d;
   float *z3d = gd->z3d;
+  size_t siz_iy = gd->siz_iy;
+  size_t siz_iz = gd->siz_iz;
+  int ni1 = gd->ni1;
+  int ni2 = gd->ni2;
 
-  for (int k = gd->nk1; k <= gd->nk2; k++)
+  // min dt and first point of it in k-j-i order, identical to a serial
+  //  scan: each thread keeps first min of its rows, ties between
+  //  threads go to the smaller iptr
+  float  dtmax_local = 1.0e10;
+  size_t iptr_min    = SIZE_MAX;
+
+  #pragma omp parallel
   {
-    for (int j = gd->nj1; j <= gd->nj2; j++)
+    float *dt_row = (float *) malloc(gd->ni * sizeof(float));
+    float  dt_thd   = 1.0e10;
+    size_t iptr_thd = SIZE_MAX;
+
+    #pragma omp for collapse(2) schedule(static)
+    for (int k = gd->nk1; k <= gd->nk2; k++)
     {
-      for (int i = gd->ni1; i <= gd->ni2; i++)
+      for (int j = gd->nj1; j <= gd->nj2; j++)
       {
-        size_t iptr = i + j * gd->siz_iy + k * gd->siz_iz;
-
-        if (md->medium_type == CONST_MEDIUM_ELASTIC_ISO) {
-          Vp = sqrt( (md->lambda[iptr] + 2.0 * md->mu[iptr]) / md->rho[iptr] );
-        } else if (md->medium_type == CONST_MEDIUM_ELASTIC_VTI) {
-          float Vpv = sqrt( md->c33[iptr] / md->rho[iptr] );
-          float Vph = sqrt( md->c11[iptr] / md->rho[iptr] );
-          Vp = Vph > Vpv ? Vph : Vpv;
-        } else if (md->medium_type == CONST_MEDIUM_ELASTIC_ANISO) {
-          // need to implement accurate solution
-          Vp = sqrt( md->c11[iptr] / md->rho[iptr] );
-        } else if (md->medium_type == CONST_MEDIUM_ACOUSTIC_ISO) {
-          Vp = sqrt( md->kappa[iptr] / md->rho[iptr] );
+        size_t iptr_j = j * siz_iy + k * siz_iz;
+
+        #pragma omp simd
+        for (int i = ni1; i <= ni2; i++)
+        {
+          size_t iptr = i + iptr_j;
+          float Vp   = blk_point_vp(md, iptr);
+          float dtLe = blk_point_min_len(x3d, y3d, z3d, iptr, siz_iy, siz_iz);
+          dt_row[i-ni1] = CFL / Vp * dtLe;
         }
 
-        float dtLe = 1.0e20;
-        float p0[] = { x3d[iptr], y3d[iptr], z3d[iptr] };
-
-        // min L to 8 adjacent planes
-        for (int kk = -1; kk <=1; kk++) {
-          for (int jj = -1; jj <= 1; jj++) {
-            for (int ii = -1; ii <= 1; ii++) {
-              if (ii != 0 && jj !=0 && kk != 0)
-              {
-                float p1[] = { x3d[iptr-ii], y3d[iptr-ii], z3d[iptr-ii] };
-                float p2[] = { x3d[iptr-jj*gd->siz_iy],
-                               y3d[iptr-jj*gd->siz_iy],
-                               z3d[iptr-jj*gd->siz_iy] };
-                float p3[] = { x3d[iptr-kk*gd->siz_iz],
-                               y3d[iptr-kk*gd->siz_iz],
-                               z3d[iptr-kk*gd->siz_iz] };
-
-                float L = fdlib_math_dist_point2plane(p0, p1, p2, p3);
-
-                if (dtLe > L) dtLe = L;
-              }
-            }
+        for (int i = ni1; i <= ni2; i++)
+        {
+          if (dt_row[i-ni1] < dt_thd) {
+            dt_thd   = dt_row[i-ni1];
+            iptr_thd = i + iptr_j;
           }
         }
+      } // j
+    } // k
 
-        // convert to dt
-        float dt_point = CFL / Vp * dtLe;
-
-        // if smaller
-        if (dt_point < dtmax_local) {
-          dtmax_local = dt_point;
-          *dtmaxi = i;
-          *dtmaxj = j;
-          *dtmaxk = k;
-          *dtmaxVp = Vp;
-          *dtmaxL  = dtLe;
-        }
+    #pragma omp critical
+    {
+      if (iptr_thd != SIZE_MAX &&
+          (dt_thd < dtmax_local || (dt_thd == dtmax_local && iptr_thd < iptr_min)))
+      {
+        dtmax_local = dt_thd;
+        iptr_min    = iptr_thd;
+      }
+    }
 
-      } // i
-    } // i
-  } //k
+    free(dt_row);
+  }
+
+  if (iptr_min != SIZE_MAX)
+  {
+    *dtmaxk  = iptr_min / siz_iz;
+    *dtmaxj  = (iptr_min % siz_iz) / siz_iy;
+    *dtmaxi  = iptr_min % siz_iy;
+    *dtmaxVp = blk_point_vp(md, iptr_min);
+    *dtmaxL  = blk_point_min_len(x3d, y3d, z3d, iptr_min, siz_iy, siz_iz);
+  }
 
   *dtmax = dtmax_local;
 
@@ -1197,430 +1268,3 @@ macdrp_unpack_fault_mesg_z2(
   }
   return;
 }
-
-int
-macdrp_fault_output_mesg_init(mympi_t *mympi,
-                              fd_t *fd,
-                              int nj,
-                              int nk,
-                              int num_of_out_vars,
-                              int number_fault)
-{
-  // mpi mesg
-  mympi->siz_sbuff_out_fault = 0;
-  mympi->siz_rbuff_out_fault = 0;
-  // fault var exchange
-  mympi->siz_sbuff_y1_out_fault = nk * num_of_out_vars * number_fault;
-  mympi->siz_sbuff_y2_out_fault = nk * num_of_out_vars * number_fault;
-
-  mympi->siz_sbuff_z1_out_fault = nj *  num_of_out_vars * number_fault;
-  mympi->siz_sbuff_z2_out_fault = nj *  num_of_out_vars * number_fault;
-
-  mympi->siz_rbuff_y1_out_fault = nk * num_of_out_vars * number_fault;
-  mympi->siz_rbuff_y2_out_fault = nk * num_of_out_vars * number_fault;
-
-  mympi->siz_rbuff_z1_out_fault = nj * num_of_out_vars * number_fault;
-  mympi->siz_rbuff_z2_out_fault = nj * num_of_out_vars * number_fault;
-
-  size_t siz_s = mympi->siz_sbuff_y1_out_fault
-               + mympi->siz_sbuff_y2_out_fault
-               + mympi->siz_sbuff_z1_out_fault
-               + mympi->siz_sbuff_z2_out_fault;
-
-  size_t siz_r = mympi->siz_rbuff_y1_out_fault
-               + mympi->siz_rbuff_y2_out_fault
-               + mympi->siz_rbuff_z1_out_fault
-               + mympi->siz_rbuff_z2_out_fault;
-
-  if (siz_s > mympi->siz_sbuff_out_fault) mympi->siz_sbuff_out_fault = siz_s;
-  if (siz_r > mympi->siz_rbuff_out_fault) mympi->siz_rbuff_out_fault = siz_r;
-  // alloc in gpu
-  mympi->sbuff_out_fault = (float *) cuda_malloc(mympi->siz_sbuff_out_fault * sizeof(MPI_FLOAT));
-  mympi->rbuff_out_fault = (float *) cuda_malloc(mympi->siz_rbuff_out_fault * sizeof(MPI_FLOAT));
-
-  return 0;
-}
-
-int
-fault_var_exchange(gd_t *gd, fault_t F_d, mympi_t *mympi, int *neighid_d)
-{
-  int nj1 = gd->nj1;
-  int nj2 = gd->nj2;
-  int nk1 = gd->nk1;
-  int nk2 = gd->nk2;
-  int nj = gd->nj;
-  int nk = gd->nk;
-  int ny = gd->ny;
-  size_t siz_slice_yz = gd->siz_slice_yz;
-
-  size_t siz_sbuff_y1_out_fault = mympi->siz_sbuff_y1_out_fault;
-  size_t siz_sbuff_y2_out_fault = mympi->siz_sbuff_y2_out_fault;
-  size_t siz_sbuff_z1_out_fault = mympi->siz_sbuff_z1_out_fault;
-  size_t siz_sbuff_z2_out_fault = mympi->siz_sbuff_z2_out_fault;
-
-  float *sbuff_y1_out_fault = mympi->sbuff_out_fault;
-  float *sbuff_y2_out_fault = sbuff_y1_out_fault + siz_sbuff_y1_out_fault;
-  float *sbuff_z1_out_fault = sbuff_y2_out_fault + siz_sbuff_y2_out_fault;
-  float *sbuff_z2_out_fault = sbuff_z1_out_fault + siz_sbuff_z1_out_fault;
-
-  size_t siz_rbuff_y1_out_fault = mympi->siz_rbuff_y1_out_fault;
-  size_t siz_rbuff_y2_out_fault = mympi->siz_rbuff_y2_out_fault;
-  size_t siz_rbuff_z1_out_fault = mympi->siz_rbuff_z1_out_fault;
-  size_t siz_rbuff_z2_out_fault = mympi->siz_rbuff_z2_out_fault;
-
-  float *rbuff_y1_out_fault = mympi->rbuff_out_fault;
-  float *rbuff_y2_out_fault = rbuff_y1_out_fault + siz_rbuff_y1_out_fault;
-  float *rbuff_z1_out_fault = rbuff_y2_out_fault + siz_rbuff_y2_out_fault;
-  float *rbuff_z2_out_fault = rbuff_z1_out_fault + siz_rbuff_z1_out_fault;
-
-  int number_fault = F_d.number_fault;
-  int ncmp = F_d.ncmp - 2;
-  int ny1_g = 1;
-  int ny2_g = 1;
-  int nz1_g = 1;
-  int nz2_g = 1;
-  MPI_Status status;
-  // pack
-  {
-    dim3 block(ny1_g,8);
-    dim3 grid;
-    grid.x = (ny1_g + block.x -1) / block.x;
-    grid.y = (nk + block.y - 1) / block.y;
-    int size_y1 = siz_sbuff_y1_out_fault/number_fault; // int/int 
-    for(int id=0; id<number_fault; id++)
-    {
-      // get one fault size
-      float *sbuff_y1_thisone = sbuff_y1_out_fault + id*size_y1;
-      pack_fault_out_mesg_y1<<<grid, block >>>(
-                                   id, F_d, sbuff_y1_thisone, siz_slice_yz, 
-                                   ncmp, ny, nj1, nk1, ny1_g, nk);
-    }
-    CUDACHECK(cudaDeviceSynchronize());
-  }
-  {
-    dim3 block(ny2_g,8);
-    dim3 grid;
-    grid.x = (ny2_g + block.x -1) / block.x;
-    grid.y = (nk + block.y - 1) / block.y;
-    int size_y2 = siz_sbuff_y2_out_fault/number_fault; // int/int 
-    for(int id=0; id<number_fault; id++)
-    {
-      // get one fault size
-      float *sbuff_y2_thisone = sbuff_y2_out_fault + id*size_y2;
-      pack_fault_out_mesg_y2<<<grid, block >>>(
-                                   id, F_d, sbuff_y2_thisone, siz_slice_yz, 
-                                   ncmp, ny, nj2, nk1, ny2_g, nk);
-    }
-    CUDACHECK(cudaDeviceSynchronize());
-  }
-  {
-    dim3 block(8,nz1_g);
-    dim3 grid;
-    grid.x = (nj + block.x -1) / block.x;
-    grid.y = (nz1_g + block.y - 1) / block.y;
-    int size_z1 = siz_sbuff_z1_out_fault/number_fault; // int/int 
-    for(int id=0; id<number_fault; id++)
-    {
-      // get one fault size
-      float *sbuff_z1_thisone = sbuff_z1_out_fault + id*size_z1;
-      pack_fault_out_mesg_z1<<<grid, block >>>(
-                                   id, F_d, sbuff_z1_thisone, siz_slice_yz, 
-                                   ncmp, ny, nj1, nk1, nj, nz1_g);
-    }
-    CUDACHECK(cudaDeviceSynchronize());
-  }
-  {
-    dim3 block(8,nz2_g);
-    dim3 grid;
-    grid.x = (nj + block.x -1) / block.x;
-    grid.y = (nz2_g + block.y - 1) / block.y;
-    int size_z2 = siz_sbuff_z2_out_fault/number_fault; // int/int 
-    for(int id=0; id<number_fault; id++)
-    {
-      // get one fault size
-      float *sbuff_z2_thisone = sbuff_z2_out_fault + id*size_z2;
-      pack_fault_out_mesg_z2<<<grid, block >>>(
-                                   id, F_d, sbuff_z2_thisone, siz_slice_yz, 
-                                   ncmp, ny, nj1, nk2, nj, nz2_g);
-    }
-    CUDACHECK(cudaDeviceSynchronize());
-  }
-  // send and recv fault var data
-  MPI_Sendrecv(sbuff_y1_out_fault, siz_sbuff_y1_out_fault, MPI_FLOAT, mympi->neighid[2], 11,
-               rbuff_y2_out_fault, siz_rbuff_y2_out_fault, MPI_FLOAT, mympi->neighid[3], 11,
-               mympi->topocomm, &status);
-  MPI_Sendrecv(sbuff_y2_out_fault, siz_sbuff_y2_out_fault, MPI_FLOAT, mympi->neighid[3], 22,
-               rbuff_y1_out_fault, siz_rbuff_y1_out_fault, MPI_FLOAT, mympi->neighid[2], 22,
-               mympi->topocomm, &status);
-  MPI_Sendrecv(sbuff_z1_out_fault, siz_sbuff_z1_out_fault, MPI_FLOAT, mympi->neighid[4], 33,
-               rbuff_z2_out_fault, siz_rbuff_z2_out_fault, MPI_FLOAT, mympi->neighid[5], 33,
-               mympi->topocomm, &status);
-  MPI_Sendrecv(sbuff_z2_out_fault, siz_sbuff_z2_out_fault, MPI_FLOAT, mympi->neighid[5], 44,
-               rbuff_z1_out_fault, siz_rbuff_z1_out_fault, MPI_FLOAT, mympi->neighid[4], 44,
-               mympi->topocomm, &status);
-
-  // unpack
-  {
-    dim3 block(ny2_g,8);
-    dim3 grid;
-    grid.x = (ny2_g + block.x -1) / block.x;
-    grid.y = (nk + block.y - 1) / block.y;
-    int size_y1 = siz_rbuff_y1_out_fault/number_fault; // int/int 
-    for(int id=0; id<number_fault; id++)
-    {
-      // get one fault size
-      float *rbuff_y1_thisone = rbuff_y1_out_fault + id*size_y1;
-      unpack_fault_out_mesg_y1<<<grid, block >>>(
-                                   id, F_d, rbuff_y1_thisone, siz_slice_yz, 
-                                   ncmp, ny, nj1, nk1, ny2_g, nk, neighid_d);
-    }
-    CUDACHECK(cudaDeviceSynchronize());
-  }
-  {
-    dim3 block(ny1_g,8);
-    dim3 grid;
-    grid.x = (ny1_g + block.x -1) / block.x;
-    grid.y = (nk + block.y - 1) / block.y;
-    int size_y2 = siz_rbuff_y2_out_fault/number_fault; // int/int 
-    for(int id=0; id<number_fault; id++)
-    {
-      // get one fault size
-      float *rbuff_y2_thisone = rbuff_y2_out_fault + id*size_y2;
-      unpack_fault_out_mesg_y2<<<grid, block >>>(
-                                   id, F_d, rbuff_y2_thisone, siz_slice_yz, 
-                                   ncmp, ny, nj2, nk1, ny1_g, nk, neighid_d);
-    }
-    CUDACHECK(cudaDeviceSynchronize());
-  }
-  {
-    dim3 block(8,nz2_g);
-    dim3 grid;
-    grid.x = (nj + block.x -1) / block.x;
-    grid.y = (nz2_g + block.y - 1) / block.y;
-    int size_z1 = siz_rbuff_z1_out_fault/number_fault; // int/int 
-    for(int id=0; id<number_fault; id++)
-    {
-      // get one fault size
-      float *rbuff_z1_thisone = rbuff_z1_out_fault + id*size_z1;
-      unpack_fault_out_mesg_z1<<<grid, block >>>(
-                                   id, F_d, rbuff_z1_thisone, siz_slice_yz, 
-                                   ncmp, ny, nj1, nk1, nj, nz2_g, neighid_d);
-    }
-    CUDACHECK(cudaDeviceSynchronize());
-  }
-  {
-    dim3 block(8,nz1_g);
-    dim3 grid;
-    grid.x = (nj + block.x -1) / block.x;
-    grid.y = (nz1_g + block.y - 1) / block.y;
-    int size_z2 = siz_rbuff_z2_out_fault/number_fault; // int/int 
-    for(int id=0; id<number_fault; id++)
-    {
-      // get one fault size
-      float *rbuff_z2_thisone = rbuff_z2_out_fault + id*size_z2;
-      unpack_fault_out_mesg_z2<<<grid, block >>>(
-                                   id, F_d, rbuff_z2_thisone, siz_slice_yz, 
-                                   ncmp, ny, nj1, nk2, nj, nz1_g, neighid_d);
-    }
-    CUDACHECK(cudaDeviceSynchronize());
-  }
-
-  return 0;
-}
-
-__global__ void
-pack_fault_out_mesg_y1(
-             int id, fault_t  F, float *sbuff_y1_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj1, int nk1, int ny1_g, int nk)
-{
-  int iy = blockIdx.x * blockDim.x + threadIdx.x;
-  int iz = blockIdx.y * blockDim.y + threadIdx.y;
-  size_t iptr_b;
-  size_t iptr;
-  fault_one_t *F_thisone = F.fault_one + id;
-  if(iy<ny1_g && iz<nk)
-  {
-    iptr     = (iz+nk1) * ny + (iy+nj1);
-    iptr_b   = iz*ny1_g + iy;
-    for(int i=0; i<ncmp; i++)
-    {
-      sbuff_y1_fault[iptr_b + i*ny1_g*nk] = F_thisone->output[iptr + i*siz_slice_yz];
-    }
-  }
-
-  return;
-}
-
-__global__ void
-pack_fault_out_mesg_y2(
-             int id, fault_t  F, float *sbuff_y2_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj2, int nk1, int ny2_g, int nk)
-{
-  int iy = blockIdx.x * blockDim.x + threadIdx.x;
-  int iz = blockIdx.y * blockDim.y + threadIdx.y;
-  size_t iptr_b;
-  size_t iptr;
-  fault_one_t *F_thisone = F.fault_one + id;
-  if(iy<ny2_g && iz<nk)
-  {
-    iptr     = (iz+nk1) * ny + (iy+nj2-ny2_g+1);
-    iptr_b   = iz*ny2_g + iy;
-    for(int i=0; i<ncmp; i++)
-    {
-      sbuff_y2_fault[iptr_b + i*ny2_g*nk] = F_thisone->output[iptr + i*siz_slice_yz];
-    }
-  }
-
-  return;
-}
-
-__global__ void
-pack_fault_out_mesg_z1(
-             int id, fault_t  F, float *sbuff_z1_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj1, int nk1, int nj, int nz1_g)
-{
-  int iy = blockIdx.x * blockDim.x + threadIdx.x;
-  int iz = blockIdx.y * blockDim.y + threadIdx.y;
-  size_t iptr_b;
-  size_t iptr;
-  fault_one_t *F_thisone = F.fault_one + id;
-  if(iy<nj && iz<nz1_g)
-  {
-    iptr     = (iz+nk1) * ny + (iy+nj1);
-    iptr_b   = iz*nj + iy;
-    for(int i=0; i<ncmp; i++)
-    {
-      sbuff_z1_fault[iptr_b + i*nz1_g*nj] = F_thisone->output[iptr + i*siz_slice_yz];
-    }
-  }
-
-  return;
-}
-
-__global__ void
-pack_fault_out_mesg_z2(
-             int id, fault_t  F, float *sbuff_z2_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj1, int nk2, int nj, int nz2_g)
-{
-  int iy = blockIdx.x * blockDim.x + threadIdx.x;
-  int iz = blockIdx.y * blockDim.y + threadIdx.y;
-  size_t iptr_b;
-  size_t iptr;
-  fault_one_t *F_thisone = F.fault_one + id;
-  if(iy<nj && iz<nz2_g)
-  {
-    iptr     = (iz+nk2-nz2_g+1) * ny + (iy+nj1);
-    iptr_b   = iz*nj + iy;
-    for(int i=0; i<ncmp; i++)
-    {
-      sbuff_z2_fault[iptr_b + i*nz2_g*nj] = F_thisone->output[iptr + i*siz_slice_yz];
-    }
-  }
-
-  return;
-}
-
-__global__ void
-unpack_fault_out_mesg_y1(
-             int id, fault_t F, float *rbuff_y1_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj1, int nk1, int ny2_g, int nk, int *neighid)
-{
-  int iy = blockIdx.x * blockDim.x + threadIdx.x;
-  int iz = blockIdx.y * blockDim.y + threadIdx.y;
-  size_t iptr_b;
-  size_t iptr;
-  fault_one_t *F_thisone = F.fault_one + id;
-  if(neighid[2] != MPI_PROC_NULL)
-  {
-    if(iy<ny2_g && iz<nk)
-    {
-      iptr     = (iz+nk1) * ny + (iy+nj1-ny2_g);
-      iptr_b   = iz*ny2_g + iy;
-      for(int i=0; i<ncmp; i++)
-      {
-        F_thisone->output[iptr + i*siz_slice_yz] = rbuff_y1_fault[iptr_b + i*ny2_g*nk];
-      }
-    }
-  }
-
-  return;
-}
-
-__global__ void
-unpack_fault_out_mesg_y2(
-             int id, fault_t F, float *rbuff_y2_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj2, int nk1, int ny1_g, int nk, int *neighid)
-{
-  int iy = blockIdx.x * blockDim.x + threadIdx.x;
-  int iz = blockIdx.y * blockDim.y + threadIdx.y;
-  size_t iptr_b;
-  size_t iptr;
-  fault_one_t *F_thisone = F.fault_one + id;
-  if(neighid[3] != MPI_PROC_NULL)
-  {
-    if(iy<ny1_g && iz<nk)
-    {
-      iptr     = (iz+nk1) * ny + (iy+nj2+1);
-      iptr_b   = iz*ny1_g + iy;
-      for(int i=0; i<ncmp; i++)
-      {
-        F_thisone->output[iptr + i*siz_slice_yz] = rbuff_y2_fault[iptr_b + i*ny1_g*nk];
-      }
-    }
-  }
-
-  return;
-}
-
-__global__ void
-unpack_fault_out_mesg_z1(
-             int id, fault_t F, float *rbuff_z1_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj1, int nk1, int nj, int nz2_g, int *neighid)
-{
-  int iy = blockIdx.x * blockDim.x + threadIdx.x;
-  int iz = blockIdx.y * blockDim.y + threadIdx.y;
-  size_t iptr_b;
-  size_t iptr;
-  fault_one_t *F_thisone = F.fault_one + id;
-  if(neighid[4] != MPI_PROC_NULL)
-  {
-    if(iy<nj && iz<nz2_g)
-    {
-      iptr     = (iz+nk1-nz2_g) * ny + (iy+nj1);
-      iptr_b   = iz*nj + iy;
-      for(int i=0; i<ncmp; i++)
-      {
-        F_thisone->output[iptr + i*siz_slice_yz] = rbuff_z1_fault[iptr_b + i*nz2_g*nj];
-      }
-    }
-  }
-
-  return;
-}
-
-__global__ void
-unpack_fault_out_mesg_z2(
-             int id, fault_t F, float *rbuff_z2_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj1, int nk2, int nj, int nz1_g, int *neighid)
-{
-  int iy = blockIdx.x * blockDim.x + threadIdx.x;
-  int iz = blockIdx.y * blockDim.y + threadIdx.y;
-  size_t iptr_b;
-  size_t iptr;
-  fault_one_t *F_thisone = F.fault_one + id;
-  if(neighid[5] != MPI_PROC_NULL)
-  {
-    if(iy<nj && iz<nz1_g)
-    {
-      iptr     = (iz+nk2+1) * ny + (iy+nj1);
-      iptr_b   = iz*nj + iy;
-      for(int i=0; i<ncmp; i++)
-      {
-        F_thisone->output[iptr + i*siz_slice_yz] = rbuff_z2_fault[iptr_b + i*nz1_g*nj];
-      }
-    }
-  }
-
-  return;
-}
-
@@ -133,14 +133,6 @@ macdrp_fault_mesg_init(mympi_t *mympi,
                        int num_of_vars_fault,
                        int number_fault);
 int
-blk_macdrp_fault_output_mesg_init(mympi_t *mympi,
-                                  fd_t *fd,
-                                  int nj,
-                                  int nk,
-                                  int num_of_out_vars,
-                                  int number_fault);
-
-int
 macdrp_pack_mesg_gpu(float *w_cur,
                      fd_t *fd,
                      gd_t *gd,
@@ -260,55 +252,4 @@ macdrp_unpack_fault_mesg_z2(
            float *fw_cur, float *rbuff_z2_fault, size_t siz_slice_yz, 
            int num_of_vars, int ny, int nj1, int nk2, int nj, int nz1_g, int *neighid);
 
-int
-macdrp_fault_output_mesg_init(mympi_t *mympi,
-                              fd_t *fd,
-                              int nj,
-                              int nk,
-                              int num_of_out_vars,
-                              int number_fault);
-
-int
-fault_var_exchange(gd_t *gd, fault_t F_d, mympi_t *mympi, int *neighid_d);
-
-__global__ void
-pack_fault_out_mesg_y1(
-             int id, fault_t F_d, float *sbuff_y1_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj1, int nk1, int ny1_g, int nk);
-
-__global__ void
-pack_fault_out_mesg_y2(
-             int id, fault_t F_d, float *sbuff_y2_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj2, int nk1, int ny2_g, int nk);
-
-__global__ void
-pack_fault_out_mesg_z1(
-             int id, fault_t F_d, float *sbuff_z1_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj1, int nk1, int nj, int nz1_g);
-
-__global__ void
-pack_fault_out_mesg_z2(
-             int id, fault_t F_d, float *sbuff_z2_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj1, int nk2, int nj, int nz2_g);
-
-__global__ void
-unpack_fault_out_mesg_y1(
-             int id, fault_t F_d, float *rbuff_y1_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj1, int nk1, int ny2_g, int nk, int *neighid);
-
-__global__ void
-unpack_fault_out_mesg_y2(
-             int id, fault_t F_d, float *rbuff_y2_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj2, int nk1, int ny1_g, int nk, int *neighid);
-
-__global__ void
-unpack_fault_out_mesg_z1(
-             int id, fault_t F_d, float *rbuff_z1_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj1, int nk1, int nj, int nz2_g, int *neighid);
-
-__global__ void
-unpack_fault_out_mesg_z2(
-             int id, fault_t F_d, float *rbuff_z2_fault, size_t siz_slice_yz, 
-             int ncmp, int ny, int nj1, int nk2, int nj, int nz1_g, int *neighid);
-
 #endif
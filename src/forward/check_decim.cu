@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * check of decimation at both ends of trace, host only
+ *  a constant trace and a step trace (as fault stress with initial value
+ *  and cumulative slip) are decimated, the first and last
+ *  DECIM_HALF_LEN_OUT outputs must keep the input value
+ *
+ *  usage: check_decim [factor] [nt_total]
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "constants.h"
+#include "decim_t.h"
+
+#define CHECK_NUM_TRACE 2
+#define CHECK_TOL       1.0e-5
+
+static float
+check_input(int itrace, int it, int nt_total)
+{
+  if (itrace == 0) return 7.25;
+
+  return (it < nt_total / 2) ? 2.0 : -3.0;
+}
+
+int main(int argc, char *argv[])
+{
+  int factor   = (argc > 1) ? atoi(argv[1]) : 5;
+  int nt_total = (argc > 2) ? atoi(argv[2]) : 307;
+
+  decim_t decim;
+  int nt_out = decim_nt_out(factor, nt_total);
+  decim_init(&decim, factor, CHECK_NUM_TRACE, nt_total, nt_out);
+
+  float *trace = (float *) calloc((size_t) CHECK_NUM_TRACE * nt_out, sizeof(float));
+  for (int it=0; it < nt_total; it++) {
+    for (int n=0; n < CHECK_NUM_TRACE; n++) {
+      decim_push(&decim, n, it, check_input(n, it, nt_total), trace + n * nt_out);
+    }
+  }
+  for (int n=0; n < CHECK_NUM_TRACE; n++) {
+    decim_finish_trace(&decim, n, nt_total, trace + n * nt_out);
+  }
+
+  const char *trace_name[CHECK_NUM_TRACE] = { "constant", "step" };
+  int num_of_ends = DECIM_HALF_LEN_OUT < nt_out ? DECIM_HALF_LEN_OUT : nt_out;
+  int is_pass = 1;
+  for (int n=0; n < CHECK_NUM_TRACE; n++)
+  {
+    double err_max = 0.0;
+    for (int i=0; i < num_of_ends; i++)
+    {
+      int ms[2] = { i, nt_out - 1 - i };
+      for (int e=0; e < 2; e++)
+      {
+        int m = ms[e];
+        float v = check_input(n, m * decim.factor, nt_total);
+        double err = fabs(trace[n * nt_out + m] - v) / fabs(v);
+        if (err > err_max) err_max = err;
+      }
+    }
+    int is_same = err_max <= CHECK_TOL;
+    if (is_same == 0) is_pass = 0;
+    fprintf(stdout, "factor %d, %d steps, %s trace: max rel err of %d samples at each end %g, %s\n",
+            decim.factor, nt_total, trace_name[n], num_of_ends, err_max,
+            is_same == 1 ? "kept" : "CHANGED");
+  }
+
+  free(trace);
+  decim_free(&decim);
+
+  return is_pass == 1 ? 0 : 1;
+}
@@ -0,0 +1,357 @@
+/*******************************************************************************
+ * check of sparse fault output read back by fault_sparse_read, host only
+ *  (-DFAULT_SPARSE_HOST_ONLY)
+ *  frames of a synthetic expanding rupture are written by an interrupted
+ *  run, with a cut frame at its end, and by a restart from an earlier
+ *  step. the index must hold each frame once with key frames at the first
+ *  frame and at the restart, and the data file must be truncated to it.
+ *  frames rebuilt by fault_sparse_read, in full and in ranges starting
+ *  after a key frame, must equal input with tolerance 0, and be within
+ *  tolerance of last written values otherwise
+ *
+ *  usage: check_fault_sparse [fault_sparse_read] [work_dir]
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "constants.h"
+#include "fault_sparse_t.h"
+
+#define CHECK_NJ        37
+#define CHECK_NK        23
+#define CHECK_NT        120
+#define CHECK_SKIP      3
+// step the first run stops at and the restart starts from
+#define CHECK_IT_STOP   92
+#define CHECK_IT_START  60
+#define CHECK_DT        0.01f
+#define CHECK_VS_THRES  1.5f
+
+// same order as fault output
+static const char *check_cmp_name[FAULT_SPARSE_NCMP] = {
+  "Tn", "Ts1", "Ts2", "Vs", "Vs1", "Vs2", "Slip", "Slip1", "Slip2"};
+
+/*
+ * rupture front expands from (11,15) at 0.4 point per step, slip rate is
+ *  non-zero within 4 points behind front, Tn drifts within 1e-3 of it
+ */
+
+static float
+check_value(int icmp, int j, int k, int it)
+{
+  float d   = sqrtf((float)((j-11)*(j-11) + (k-15)*(k-15)));
+  float r   = 0.4f * it;
+  float tau = (r - d) / 4.0f;
+  float vs  = (tau > 0.0f && tau < 1.0f) ? 2.0f * sinf((float)PI * tau) : 0.0f;
+  float slip = (tau > 0.0f) ? 1.5f * fminf(tau, 1.0f) : 0.0f;
+  float ts   = (tau > 0.0f) ? 70.0f - 10.0f * fminf(tau, 1.0f) : 70.0f + 0.001f * k;
+
+  switch (icmp)
+  {
+    case 0: return -120.0f + 0.01f * j + 2.0f * vs + 0.05f * it / CHECK_NT;
+    case 1: return ts;
+    case 2: return 0.5f * ts - 30.0f;
+    case 3: return vs;
+    case 4: return 0.8f * vs;
+    case 5: return 0.6f * vs;
+    case 6: return slip;
+    case 7: return 0.8f * slip;
+    default: return 0.6f * slip;
+  }
+}
+
+static void
+check_open(fault_sparse_t *fsparse, const char *dir, float tolerance, int *i_index)
+{
+  size_t siz_slice = (size_t)CHECK_NJ * CHECK_NK;
+
+  memset(fsparse, 0, sizeof(fault_sparse_t));
+  fsparse->enable       = 1;
+  fsparse->number_fault = 1;
+  fsparse->nj = CHECK_NJ;
+  fsparse->nk = CHECK_NK;
+  fsparse->i_index      = i_index;
+  fsparse->vs_threshold = CHECK_VS_THRES;
+  fsparse->tolerance    = tolerance;
+  fsparse->is_key       = 1;
+
+  fsparse->fname     = (char **) malloc(sizeof(char *));
+  fsparse->fname_idx = (char **) malloc(sizeof(char *));
+  fsparse->fname[0]     = (char *) malloc(CONST_MAX_STRLEN * sizeof(char));
+  fsparse->fname_idx[0] = (char *) malloc(CONST_MAX_STRLEN * sizeof(char));
+  sprintf(fsparse->fname[0],     "%s/check_fault_sparse.bin", dir);
+  sprintf(fsparse->fname_idx[0], "%s/check_fault_sparse.idx", dir);
+  fsparse->fp     = (FILE **) malloc(sizeof(FILE *));
+  fsparse->fp_idx = (FILE **) malloc(sizeof(FILE *));
+  fsparse->nbyte        = (long long *) malloc(sizeof(long long));
+  fsparse->num_of_frame = (int *) malloc(sizeof(int));
+
+  fsparse->flag = (unsigned char *) malloc(sizeof(unsigned char)*siz_slice);
+  fsparse->pidx = (int *) malloc(sizeof(int)*siz_slice);
+  fsparse->run  = (int *) malloc(sizeof(int)*(siz_slice+1));
+  fsparse->val  = (float *) malloc(sizeof(float)*FAULT_SPARSE_NCMP*siz_slice);
+}
+
+static void
+check_close(fault_sparse_t *fsparse)
+{
+  fclose(fsparse->fp[0]);
+  fclose(fsparse->fp_idx[0]);
+  free(fsparse->fname[0]);
+  free(fsparse->fname_idx[0]);
+  free(fsparse->fname);
+  free(fsparse->fname_idx);
+  free(fsparse->fp);
+  free(fsparse->fp_idx);
+  free(fsparse->nbyte);
+  free(fsparse->num_of_frame);
+  free(fsparse->flag);
+  free(fsparse->pidx);
+  free(fsparse->run);
+  free(fsparse->val);
+}
+
+/*
+ * frames of it_beg to it_end, points flagged and last values updated as
+ *  fault_sparse_flag_gpu
+ */
+
+static void
+check_run(fault_sparse_t *fsparse, float *last, int it_beg, int it_end)
+{
+  int nj = CHECK_NJ;
+  size_t siz_slice = (size_t)CHECK_NJ * CHECK_NK;
+
+  for (int it = it_beg; it < it_end; it += CHECK_SKIP)
+  {
+    for (size_t p=0; p < siz_slice; p++)
+    {
+      int j = p % nj;
+      int k = p / nj;
+      int is_put = fsparse->is_key;
+      if (check_value(FAULT_SPARSE_VS, j, k, it) > fsparse->vs_threshold) is_put = 1;
+      for (int icmp=0; icmp < FAULT_SPARSE_NCMP; icmp++)
+      {
+        float v  = check_value(icmp, j, k, it);
+        float v0 = last[icmp*siz_slice + p];
+        if (fabsf(v - v0) > fsparse->tolerance * fabsf(v0)) is_put = 1;
+      }
+      if (is_put == 1) {
+        for (int icmp=0; icmp < FAULT_SPARSE_NCMP; icmp++) {
+          last[icmp*siz_slice + p] = check_value(icmp, j, k, it);
+        }
+      }
+      fsparse->flag[p] = (unsigned char) is_put;
+    }
+
+    int num_of_run;
+    int num_of_point = fault_sparse_pack(fsparse, &num_of_run);
+    for (int ip=0; ip < num_of_point; ip++) {
+      for (int icmp=0; icmp < FAULT_SPARSE_NCMP; icmp++) {
+        fsparse->val[icmp*num_of_point + ip] = last[icmp*siz_slice + fsparse->pidx[ip]];
+      }
+    }
+    fault_sparse_write(fsparse, 0, it, it * CHECK_DT, num_of_run, num_of_point);
+    fsparse->is_key = 0;
+  }
+}
+
+/*
+ * index must hold frames of all steps once, keys at first frame and at
+ *  restart, data file must end at last frame
+ */
+
+static int
+check_index(fault_sparse_t *fsparse)
+{
+  int is_pass = 1;
+
+  FILE *fp_idx = fopen(fsparse->fname_idx[0], "rb");
+  FILE *fp     = fopen(fsparse->fname[0], "rb");
+  char magic[8];
+  if (fp_idx == NULL || fp == NULL || fread(magic, 1, 8, fp_idx) != 8) {
+    fprintf(stdout,"can't read index %s\n", fsparse->fname_idx[0]);
+    return 0;
+  }
+
+  int n = 0;
+  long long nbyte_end = FAULT_SPARSE_HEAD_NBYTE;
+  for (;;)
+  {
+    int   it, num_of_run, num_of_point, is_key;
+    float time;
+    long long offset;
+    if (fread(&it,           sizeof(int),   1, fp_idx) != 1) break;
+    if (fread(&time,         sizeof(float), 1, fp_idx) != 1) break;
+    if (fread(&num_of_run,   sizeof(int),   1, fp_idx) != 1) break;
+    if (fread(&num_of_point, sizeof(int),   1, fp_idx) != 1) break;
+    if (fread(&is_key,       sizeof(int),   1, fp_idx) != 1) break;
+    if (fread(&offset, sizeof(long long),   1, fp_idx) != 1) break;
+
+    int is_key_ref = (it == 0 || it == CHECK_IT_START) ? 1 : 0;
+    if (it != n * CHECK_SKIP || is_key != is_key_ref || offset != nbyte_end) {
+      fprintf(stdout,"index record %d: it=%d key=%d offset=%lld, expected it=%d key=%d offset=%lld\n",
+              n, it, is_key, offset, n * CHECK_SKIP, is_key_ref, nbyte_end);
+      is_pass = 0;
+    }
+    if (is_key == 1 && num_of_point != CHECK_NJ * CHECK_NK) {
+      fprintf(stdout,"key frame of it=%d has %d points\n", it, num_of_point);
+      is_pass = 0;
+    }
+    nbyte_end = offset + FAULT_SPARSE_FRAME_NBYTE(num_of_run, num_of_point);
+    n += 1;
+  }
+  fclose(fp_idx);
+
+  int num_of_frame = (CHECK_NT + CHECK_SKIP - 1) / CHECK_SKIP;
+  fseek(fp, 0, SEEK_END);
+  long long nbyte_file = ftell(fp);
+  fclose(fp);
+  if (n != num_of_frame || nbyte_file != nbyte_end) {
+    fprintf(stdout,"%d frames of %lld bytes, expected %d frames of %lld bytes\n",
+            n, nbyte_file, num_of_frame, nbyte_end);
+    is_pass = 0;
+  }
+
+  return is_pass;
+}
+
+/*
+ * rebuild frames [frame_start, frame_start+frame_count) by
+ *  fault_sparse_read and compare with input
+ */
+
+static int
+check_read(fault_sparse_t *fsparse, const char *tool, const char *dir,
+           int frame_start, int frame_count)
+{
+  char fname_nc[CONST_MAX_STRLEN];
+  char cmd[3*CONST_MAX_STRLEN];
+  sprintf(fname_nc, "%s/check_fault_sparse.nc", dir);
+  sprintf(cmd, "%s %s %s %s %d %d > /dev/null", tool, fsparse->fname[0],
+          fsparse->fname_idx[0], fname_nc, frame_start, frame_count);
+  if (system(cmd) != 0) {
+    fprintf(stdout,"failed: %s\n", cmd);
+    return 0;
+  }
+
+  int ncid, timeid, varid[FAULT_SPARSE_NCMP];
+  int ierr = nc_open(fname_nc, NC_NOWRITE, &ncid);
+  ierr += nc_inq_varid(ncid, "time", &timeid);
+  for (int icmp=0; icmp < FAULT_SPARSE_NCMP; icmp++) {
+    ierr += nc_inq_varid(ncid, check_cmp_name[icmp], varid+icmp);
+  }
+  if (ierr != NC_NOERR) {
+    fprintf(stdout,"can't read %s\n", fname_nc);
+    return 0;
+  }
+
+  float *v = (float *) malloc(sizeof(float)*CHECK_NJ*CHECK_NK);
+  double err_max = 0.0;
+  int num_of_fail = 0;
+  for (int n=0; n < frame_count; n++)
+  {
+    int it = (frame_start + n) * CHECK_SKIP;
+    size_t start_t   = n;
+    size_t startp[3] = { start_t, 0, 0 };
+    size_t countp[3] = { 1, CHECK_NK, CHECK_NJ };
+    float time;
+    nc_get_var1_float(ncid, timeid, &start_t, &time);
+    if (time != it * CHECK_DT) num_of_fail += 1;
+
+    for (int icmp=0; icmp < FAULT_SPARSE_NCMP; icmp++)
+    {
+      nc_get_vara_float(ncid, varid[icmp], startp, countp, v);
+      for (int k=0; k < CHECK_NK; k++) {
+        for (int j=0; j < CHECK_NJ; j++)
+        {
+          float v1 = v[j + k * CHECK_NJ];
+          float v0 = check_value(icmp, j, k, it);
+          double err = fabs((double) v1 - v0);
+          if (fabs((double) v1) > 0.0) err /= fabs((double) v1);
+          if (err > err_max) err_max = err;
+          // last written value is kept while within tolerance of it
+          if (fabsf(v0 - v1) > fsparse->tolerance * fabsf(v1) * (1.0f + 1.0e-5f)) {
+            if (num_of_fail < 10) {
+              fprintf(stdout,"  frame %d %s (%d,%d): %g rebuilt as %g\n",
+                      frame_start + n, check_cmp_name[icmp], j, k, v0, v1);
+            }
+            num_of_fail += 1;
+          }
+        }
+      }
+    }
+  }
+  nc_close(ncid);
+  free(v);
+  remove(fname_nc);
+
+  fprintf(stdout,"tolerance %g, frames [%d,%d): max relative error %.3e, %s\n",
+          fsparse->tolerance, frame_start, frame_start + frame_count, err_max,
+          num_of_fail == 0 ? "kept" : "FAILED");
+
+  return num_of_fail == 0 ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+  const char *tool = (argc > 1) ? argv[1] : "./fault_sparse_read";
+  const char *dir  = (argc > 2) ? argv[2] : ".";
+  int is_pass = 1;
+
+  int   i_index = 5;
+  int   topoid[3] = {0, 0, 0};
+  float tolerance[2] = {0.0f, 1.0e-3f};
+  size_t siz_slice = (size_t)CHECK_NJ * CHECK_NK;
+  float *last = (float *) malloc(sizeof(float)*FAULT_SPARSE_NCMP*siz_slice);
+
+  int num_of_frame = (CHECK_NT + CHECK_SKIP - 1) / CHECK_SKIP;
+  int frame_restart = CHECK_IT_START / CHECK_SKIP;
+
+  for (int itol=0; itol < 2; itol++)
+  {
+    fault_sparse_t fsparse;
+
+    // interrupted run with a frame cut at its end
+    check_open(&fsparse, dir, tolerance[itol], &i_index);
+    memset(last, 0, sizeof(float)*FAULT_SPARSE_NCMP*siz_slice);
+    fault_sparse_create(&fsparse, topoid);
+    check_run(&fsparse, last, 0, CHECK_IT_STOP);
+    fwrite(fsparse.val, sizeof(float), 37, fsparse.fp[0]);
+    check_close(&fsparse);
+
+    // restart, last written values are lost as in checkpoint
+    check_open(&fsparse, dir, tolerance[itol], &i_index);
+    memset(last, 0, sizeof(float)*FAULT_SPARSE_NCMP*siz_slice);
+    fault_sparse_reopen(&fsparse, CHECK_IT_START);
+    if (fsparse.num_of_frame[0] != frame_restart) {
+      fprintf(stdout,"restart kept %d frames, expected %d\n",
+              fsparse.num_of_frame[0], frame_restart);
+      is_pass = 0;
+    }
+    check_run(&fsparse, last, CHECK_IT_START, CHECK_NT);
+
+    if (check_index(&fsparse) == 0) is_pass = 0;
+
+    // all frames, from restart key, and across restart from first key
+    if (check_read(&fsparse, tool, dir, 0, num_of_frame) == 0) is_pass = 0;
+    if (check_read(&fsparse, tool, dir, frame_restart + 3, 9) == 0) is_pass = 0;
+    if (check_read(&fsparse, tool, dir, frame_restart - 4, 8) == 0) is_pass = 0;
+
+    fprintf(stdout,"tolerance %g: %.2f%% of points written after restart\n",
+            tolerance[itol], 100.0 * fsparse.num_of_point_put / fsparse.num_of_point_all);
+
+    remove(fsparse.fname[0]);
+    remove(fsparse.fname_idx[0]);
+    check_close(&fsparse);
+  }
+
+  free(last);
+
+  fprintf(stdout,"fault_sparse check %s\n", is_pass == 1 ? "passed" : "FAILED");
+
+  return is_pass == 1 ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * check of size-class memory pool, host only (-DMEM_POOL_HOST_ONLY)
+ *  block of each size class must hold the request and above
+ *  2^MEM_POOL_FINE_SHIFT be at most 1/4 larger, blocks allocated and freed
+ *  in random order must be reused without new system malloc, and free of
+ *  pointer not from pool must fail
+ *
+ *  usage: check_mem_pool [num_of_block]
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem_pool.h"
+
+#define CHECK_MAX_SIZE ((size_t) 1 << 26)
+
+static size_t
+check_rand_size(void)
+{
+  // wide range of sizes, mostly of io buffers
+  int shift = rand() % 22;
+  return ((size_t) 1 << shift) + (size_t) rand() % ((size_t) 1 << shift);
+}
+
+int main(int argc, char *argv[])
+{
+  int num_of_block = (argc > 1) ? atoi(argv[1]) : 300;
+  int is_pass = 1;
+
+  // bound of size classes
+  double ratio_max = 0.0;
+  for (size_t nbyte = 1; nbyte <= CHECK_MAX_SIZE; nbyte += 1 + nbyte / 97)
+  {
+    size_t siz_blk = mem_pool_class_size(mem_pool_size_class(nbyte));
+    if (siz_blk < nbyte) {
+      fprintf(stdout,"size %zu: block of %zu bytes too small\n", nbyte, siz_blk);
+      is_pass = 0;
+    }
+    if (nbyte >= ((size_t) 1 << MEM_POOL_FINE_SHIFT)) {
+      double ratio = (double) siz_blk / nbyte;
+      if (ratio > ratio_max) ratio_max = ratio;
+    }
+  }
+  fprintf(stdout,"max block over request above %d bytes: %.4f\n",
+          1 << MEM_POOL_FINE_SHIFT, ratio_max);
+  if (ratio_max > 1.25) is_pass = 0;
+
+  // alloc and free in random order
+  mem_pool_t pool;
+  mem_pool_init(&pool, MEM_POOL_HOST, "check");
+
+  size_t *siz  = (size_t *) malloc(num_of_block * sizeof(size_t));
+  void  **ptr  = (void **) malloc(num_of_block * sizeof(void *));
+  int    *perm = (int *) malloc(num_of_block * sizeof(int));
+
+  srand(1234);
+  for (int n=0; n < num_of_block; n++) {
+    siz[n] = check_rand_size();
+    perm[n] = n;
+  }
+
+  size_t num_of_sys_malloc = 0;
+  for (int iround=0; iround < 2; iround++)
+  {
+    for (int n=0; n < num_of_block; n++) {
+      ptr[n] = mem_pool_malloc(&pool, siz[n]);
+      memset(ptr[n], n & 0xff, siz[n]);
+    }
+    for (int n=num_of_block-1; n > 0; n--) {
+      int m = rand() % (n+1);
+      int t = perm[n]; perm[n] = perm[m]; perm[m] = t;
+    }
+    for (int n=0; n < num_of_block; n++)
+    {
+      int i = perm[n];
+      unsigned char *p = (unsigned char *) ptr[i];
+      if (p[0] != (i & 0xff) || p[siz[i]-1] != (i & 0xff)) {
+        fprintf(stdout,"block %d of %zu bytes overwritten\n", i, siz[i]);
+        is_pass = 0;
+      }
+      if (mem_pool_free(&pool, ptr[i]) != 0) is_pass = 0;
+    }
+    if (pool.nbyte_in_use != 0) {
+      fprintf(stdout,"round %d: %zu bytes still in use\n", iround, pool.nbyte_in_use);
+      is_pass = 0;
+    }
+    if (iround == 0) {
+      num_of_sys_malloc = pool.num_of_sys_malloc;
+    } else if (pool.num_of_sys_malloc != num_of_sys_malloc) {
+      fprintf(stdout,"blocks not reused: %zu system malloc after %zu\n",
+              pool.num_of_sys_malloc, num_of_sys_malloc);
+      is_pass = 0;
+    }
+  }
+  fprintf(stdout,"%d blocks, 2 rounds: reserved %.3f MB, high water %.3f MB, "
+                 "system malloc %zu\n",
+          num_of_block, pool.nbyte_reserved / 1048576.0,
+          pool.nbyte_high_water / 1048576.0, pool.num_of_sys_malloc);
+
+  // pointer not from pool, error message is expected
+  int not_pool;
+  if (mem_pool_free(&pool, &not_pool) == 0) {
+    fprintf(stdout,"free of pointer not from pool passed\n");
+    is_pass = 0;
+  }
+
+  mem_pool_destroy(&pool);
+  free(siz);
+  free(ptr);
+  free(perm);
+
+  fprintf(stdout,"mem_pool check %s\n", is_pass == 1 ? "passed" : "FAILED");
+
+  return is_pass == 1 ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+/*******************************************************************************
+ * check of error-bounded codec of snapshot frames, host only
+ *  random, smooth, all zero, huge and NaN frames whose sizes are not
+ *  multiples of block edge are coded block by block and decoded, each
+ *  block must be within ZBLOCK_BOUND of its points and each decoded value
+ *  within eb of input, NaN and Inf must be kept
+ *
+ *  usage: check_zblock [seed]
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "zblock.h"
+
+#define CHECK_NUM_KIND 5
+#define CHECK_NUM_DIMS 4
+#define CHECK_NUM_EB   4
+
+static const char *kind_name[CHECK_NUM_KIND] = {
+  "random", "smooth", "zero", "huge", "nan" };
+
+static float
+check_rand(void)
+{
+  return (float) rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+static void
+check_fill(float *v, int kind, int ni, int nj, int nk)
+{
+  for (int k=0; k < nk; k++) {
+    for (int j=0; j < nj; j++) {
+      for (int i=0; i < ni; i++)
+      {
+        size_t iptr = i + (size_t) j * ni + (size_t) k * ni * nj;
+        float x = (float) i / ni, y = (float) j / nj, z = (float) k / nk;
+        switch (kind)
+        {
+          case 0: v[iptr] = check_rand(); break;
+          case 1: v[iptr] = sinf(6.0f*x) * cosf(4.0f*y) + 0.5f * z; break;
+          case 2: v[iptr] = 0.0f; break;
+          case 3: v[iptr] = 3.0e37f * check_rand(); break;
+          default:
+            v[iptr] = sinf(6.0f*x + 3.0f*y - 2.0f*z);
+            if (rand() % 17 == 0) v[iptr] = NAN;
+            if (rand() % 53 == 0) v[iptr] = (rand() % 2 == 0) ? INFINITY : -INFINITY;
+            break;
+        }
+      }
+    }
+  }
+}
+
+/*
+ * code and decode all blocks of frame, return number of failures
+ */
+
+static int
+check_frame(const float *v, float *w, unsigned char *zbuf,
+            int ni, int nj, int nk, float eb, double *ratio)
+{
+  int nbi, nbj, nbk;
+  int num_of_block = zblock_frame_dims(ni, nj, nk, &nbi, &nbj, &nbk);
+  int num_of_fail = 0;
+  size_t zbyte_all = 0;
+
+  for (int ib=0; ib < num_of_block; ib++)
+  {
+    int bi, bj, bk;
+    size_t off = zblock_frame_offset(ib, ni, nj, nk, &bi, &bj, &bk);
+    size_t zsize = zblock_encode(v + off, bi, bj, bk, ni, (size_t) ni * nj, eb, zbuf);
+    if (zsize > ZBLOCK_BOUND(bi * bj * bk)) {
+      fprintf(stdout,"  block %d of %d x %d x %d: %zu bytes over bound\n",
+              ib, bi, bj, bk, zsize);
+      num_of_fail += 1;
+    }
+    if (zblock_decode(zbuf, zsize, bi, bj, bk, ni, (size_t) ni * nj, eb, w + off) != 0) {
+      fprintf(stdout,"  block %d is broken\n", ib);
+      num_of_fail += 1;
+    }
+    zbyte_all += zsize;
+  }
+
+  size_t siz_frame = (size_t) ni * nj * nk;
+  for (size_t m=0; m < siz_frame; m++)
+  {
+    int is_ok;
+    if (isnan(v[m])) {
+      is_ok = isnan(w[m]);
+    } else if (isinf(v[m])) {
+      is_ok = (w[m] == v[m]);
+    } else {
+      is_ok = fabs((double) w[m] - v[m]) <= eb;
+    }
+    if (is_ok == 0) {
+      if (num_of_fail < 10) {
+        fprintf(stdout,"  point %zu: %g decoded to %g, eb %g\n", m, v[m], w[m], eb);
+      }
+      num_of_fail += 1;
+    }
+  }
+
+  *ratio = (double) siz_frame * sizeof(float) / (zbyte_all > 0 ? zbyte_all : 1);
+
+  return num_of_fail;
+}
+
+int main(int argc, char *argv[])
+{
+  int seed = (argc > 1) ? atoi(argv[1]) : 1234;
+  srand(seed);
+
+  // none is multiple of block edge in all directions
+  int dims[CHECK_NUM_DIMS][3] = { {13, 11, 9}, {17, 5, 3}, {1, 1, 1}, {9, 23, 10} };
+  // relative to range of frame, 0 for lossless, last one is absolute
+  //  to overflow quantization of huge values
+  float eb_rel[CHECK_NUM_EB] = { 1.0e-2f, 1.0e-5f, 0.0f, 1.0e-3f };
+
+  size_t siz_max = 0;
+  for (int d=0; d < CHECK_NUM_DIMS; d++) {
+    size_t siz = (size_t) dims[d][0] * dims[d][1] * dims[d][2];
+    if (siz > siz_max) siz_max = siz;
+  }
+  float *v = (float *) malloc(siz_max * sizeof(float));
+  float *w = (float *) malloc(siz_max * sizeof(float));
+  unsigned char *zbuf = (unsigned char *) malloc(ZBLOCK_BOUND(ZBLOCK_MAX_POINTS));
+  if (v == NULL || w == NULL || zbuf == NULL) {
+    fprintf(stderr,"Error: can't alloc frames\n");
+    exit(1);
+  }
+
+  int num_of_fail = 0;
+  for (int kind=0; kind < CHECK_NUM_KIND; kind++) {
+    for (int d=0; d < CHECK_NUM_DIMS; d++) {
+      for (int e=0; e < CHECK_NUM_EB; e++)
+      {
+        int ni = dims[d][0], nj = dims[d][1], nk = dims[d][2];
+        check_fill(v, kind, ni, nj, nk);
+        memset(w, 0, siz_max * sizeof(float));
+
+        float vmin, vmax;
+        zblock_frame_range(v, (size_t) ni * nj * nk, &vmin, &vmax);
+        float eb = eb_rel[e] * (vmax - vmin);
+        // absolute one, and all zero frame still has a bound
+        if (e == CHECK_NUM_EB-1 || (eb_rel[e] > 0.0f && !(eb > 0.0f))) eb = eb_rel[e];
+
+        double ratio;
+        int nfail = check_frame(v, w, zbuf, ni, nj, nk, eb, &ratio);
+        fprintf(stdout,"%-6s %2d x %2d x %2d, eb %-10g: ratio %7.2f, %s\n",
+                kind_name[kind], ni, nj, nk, eb, ratio, nfail == 0 ? "kept" : "FAILED");
+        num_of_fail += nfail;
+      }
+    }
+  }
+
+  free(v);
+  free(w);
+  free(zbuf);
+
+  fprintf(stdout,"zblock check %s\n", num_of_fail == 0 ? "passed" : "FAILED");
+
+  return num_of_fail == 0 ? 0 : 1;
+}
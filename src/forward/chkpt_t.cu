@@ -0,0 +1,681 @@
+/*******************************************************************************
+ * checkpoint/restart of set-up and time loop vars
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "constants.h"
+#include "chkpt_t.h"
+#include "prof_t.h"
+#include "cuda_common.h"
+
+// set by signal handler, checked in chkpt_check
+static volatile sig_atomic_t chkpt_sig_flag = 0;
+
+static void
+chkpt_sig_handler(int sig)
+{
+  chkpt_sig_flag = 1;
+}
+
+int
+chkpt_init(chkpt_t *chkpt, int every, float wall_time, int on_signal,
+           char *dir, int myid, double t_start)
+{
+  chkpt->every     = every;
+  chkpt->wall_time = wall_time;
+  chkpt->on_signal = on_signal;
+  chkpt->is_voting = 0;
+  chkpt->enable    = (every > 0 || wall_time > 0.0 || on_signal == 1) ? 1 : 0;
+  chkpt->myid      = myid;
+  chkpt->t_start   = t_start;
+  sprintf(chkpt->dir, "%s", dir);
+
+  chkpt->num_of_sec = 0;
+  chkpt->max_of_sec = 64;
+  chkpt->sec = (chkpt_sec_t *) malloc(sizeof(chkpt_sec_t) * chkpt->max_of_sec);
+
+  chkpt->it       = 0;
+  chkpt->nt_total = 0;
+  chkpt->dt       = 0.0;
+
+  chkpt->stage     = NULL;
+  chkpt->siz_stage = 0;
+
+  chkpt->is_writing  = 0;
+  chkpt->ierr_writer = 0;
+
+  if (on_signal == 1)
+  {
+    struct sigaction act;
+    memset(&act, 0, sizeof(act));
+    act.sa_handler = chkpt_sig_handler;
+    sigemptyset(&act.sa_mask);
+    sigaction(SIGUSR1, &act, NULL);
+    sigaction(SIGTERM, &act, NULL);
+  }
+
+  return 0;
+}
+
+int
+chkpt_reset(chkpt_t *chkpt)
+{
+  chkpt->num_of_sec = 0;
+
+  return 0;
+}
+
+int
+chkpt_add(chkpt_t *chkpt, char *name, void *ptr, size_t nbyte, int is_device)
+{
+  if (chkpt->num_of_sec == chkpt->max_of_sec)
+  {
+    chkpt->max_of_sec *= 2;
+    chkpt->sec = (chkpt_sec_t *) realloc(chkpt->sec,
+                                  sizeof(chkpt_sec_t) * chkpt->max_of_sec);
+  }
+
+  chkpt_sec_t *sec = chkpt->sec + chkpt->num_of_sec;
+
+  snprintf(sec->name, CHKPT_NAME_STRLEN, "%s", name);
+  sec->ptr       = ptr;
+  sec->nbyte     = nbyte;
+  sec->is_device = is_device;
+  sec->offset    = 0;
+
+  chkpt->num_of_sec += 1;
+
+  return 0;
+}
+
+/*
+ * device state of fault: input, output block and inner vars
+ */
+
+int
+chkpt_add_fault(chkpt_t *chkpt, gd_t *gd, fault_t *F_d)
+{
+  size_t siz_slice_yz = gd->ny * gd->nz;
+  char name[CHKPT_NAME_STRLEN];
+
+  for (int id=0; id<F_d->number_fault; id++)
+  {
+    fault_one_t *thisone = F_d->fault_one + id;
+
+    float *f_var[] = {thisone->T0x, thisone->T0y, thisone->T0z,
+                      thisone->mu_s, thisone->mu_d, thisone->Dc, thisone->C0,
+                      thisone->tTn, thisone->tTs1, thisone->tTs2};
+    const char *f_name[] = {"T0x", "T0y", "T0z", "mu_s", "mu_d", "Dc", "C0",
+                            "tTn", "tTs1", "tTs2"};
+    for (int n=0; n<10; n++)
+    {
+      sprintf(name, "fault%d_%s", id, f_name[n]);
+      chkpt_add(chkpt, name, f_var[n], sizeof(float)*siz_slice_yz, 1);
+    }
+
+    // Tn ... Init_t0
+    sprintf(name, "fault%d_output", id);
+    chkpt_add(chkpt, name, thisone->output, sizeof(float)*siz_slice_yz*F_d->ncmp, 1);
+
+    int *i_var[] = {thisone->united, thisone->faultgrid,
+                    thisone->rup_index_y, thisone->rup_index_z,
+                    thisone->flag_rup, thisone->init_t0_flag};
+    const char *i_name[] = {"united", "faultgrid", "rup_index_y", "rup_index_z",
+                            "flag_rup", "init_t0_flag"};
+    for (int n=0; n<6; n++)
+    {
+      sprintf(name, "fault%d_%s", id, i_name[n]);
+      chkpt_add(chkpt, name, i_var[n], sizeof(int)*siz_slice_yz, 1);
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * previous level of fault wavefield and traction kept between steps
+ */
+
+int
+chkpt_add_fault_wav(chkpt_t *chkpt, gd_t *gd, fault_wav_t *FW_d, float *f_pre_d)
+{
+  size_t siz_slice_yz = gd->ny * gd->nz;
+  int number_fault = FW_d->number_fault;
+
+  chkpt_add(chkpt, "fault_wav", f_pre_d,
+            sizeof(float)*FW_d->siz_ilevel*number_fault, 1);
+
+  chkpt_add(chkpt, "fault_T1x", FW_d->T1x, sizeof(float)*7*siz_slice_yz*number_fault, 1);
+  chkpt_add(chkpt, "fault_T1y", FW_d->T1y, sizeof(float)*7*siz_slice_yz*number_fault, 1);
+  chkpt_add(chkpt, "fault_T1z", FW_d->T1z, sizeof(float)*7*siz_slice_yz*number_fault, 1);
+  chkpt_add(chkpt, "fault_hT1x", FW_d->hT1x, sizeof(float)*siz_slice_yz*number_fault, 1);
+  chkpt_add(chkpt, "fault_hT1y", FW_d->hT1y, sizeof(float)*siz_slice_yz*number_fault, 1);
+  chkpt_add(chkpt, "fault_hT1z", FW_d->hT1z, sizeof(float)*siz_slice_yz*number_fault, 1);
+  chkpt_add(chkpt, "fault_mT1x", FW_d->mT1x, sizeof(float)*siz_slice_yz*number_fault, 1);
+  chkpt_add(chkpt, "fault_mT1y", FW_d->mT1y, sizeof(float)*siz_slice_yz*number_fault, 1);
+  chkpt_add(chkpt, "fault_mT1z", FW_d->mT1z, sizeof(float)*siz_slice_yz*number_fault, 1);
+
+  return 0;
+}
+
+/*
+ * host fault coef, same arrays as fault_coef_init
+ */
+
+int
+chkpt_add_fault_coef(chkpt_t *chkpt, gd_t *gd, fault_coef_t *FC)
+{
+  size_t ny = gd->ny;
+  size_t nz = gd->nz;
+  char name[CHKPT_NAME_STRLEN];
+
+  for (int id=0; id<FC->number_fault; id++)
+  {
+    fault_coef_one_t *h = FC->fault_coef_one + id;
+
+    float *h_yz[] = {h->D21_1, h->D22_1, h->D23_1, h->D31_1, h->D32_1, h->D33_1,
+                     h->D21_2, h->D22_2, h->D23_2, h->D31_2, h->D32_2, h->D33_2,
+                     h->matMin2Plus1, h->matMin2Plus2, h->matMin2Plus3,
+                     h->matMin2Plus4, h->matMin2Plus5,
+                     h->matPlus2Min1, h->matPlus2Min2, h->matPlus2Min3,
+                     h->matPlus2Min4, h->matPlus2Min5,
+                     h->matT1toVx_Min, h->matVytoVx_Min, h->matVztoVx_Min,
+                     h->matT1toVx_Plus, h->matVytoVx_Plus, h->matVztoVx_Plus};
+    int num_yz = sizeof(h_yz) / sizeof(float *);
+    for (int n=0; n<num_yz; n++)
+    {
+      sprintf(name, "fault%d_coef_yz%d", id, n);
+      chkpt_add(chkpt, name, h_yz[n], sizeof(float)*ny*nz*9, 0);
+    }
+
+    float *h_2[] = {h->rho_f, h->mu_f, h->lam_f};
+    float *h_3[] = {h->vec_n, h->vec_s1, h->vec_s2};
+    float *h_1[] = {h->x_et, h->y_et, h->z_et};
+    for (int n=0; n<3; n++)
+    {
+      sprintf(name, "fault%d_coef_2_%d", id, n);
+      chkpt_add(chkpt, name, h_2[n], sizeof(float)*ny*nz*2, 0);
+      sprintf(name, "fault%d_coef_3_%d", id, n);
+      chkpt_add(chkpt, name, h_3[n], sizeof(float)*ny*nz*3, 0);
+      sprintf(name, "fault%d_coef_1_%d", id, n);
+      chkpt_add(chkpt, name, h_1[n], sizeof(float)*ny*nz, 0);
+    }
+
+    // matrix along free surface line
+    float *h_y[] = {h->matVx2Vz1, h->matVy2Vz1, h->matVx2Vz2, h->matVy2Vz2,
+                    h->matPlus2Min1f, h->matPlus2Min2f, h->matPlus2Min3f,
+                    h->matMin2Plus1f, h->matMin2Plus2f, h->matMin2Plus3f,
+                    h->matT1toVxf_Min, h->matVytoVxf_Min,
+                    h->matT1toVxf_Plus, h->matVytoVxf_Plus};
+    int num_y = sizeof(h_y) / sizeof(float *);
+    for (int n=0; n<num_y; n++)
+    {
+      sprintf(name, "fault%d_coef_y%d", id, n);
+      chkpt_add(chkpt, name, h_y[n], sizeof(float)*ny*9, 0);
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * previous level of pml auxvar, should be called after pre is set
+ */
+
+int
+chkpt_add_pml(chkpt_t *chkpt, bdrypml_t *bdrypml_d)
+{
+  if (bdrypml_d->is_enable_pml == 0) return 0;
+
+  char name[CHKPT_NAME_STRLEN];
+
+  for (int idim=0; idim<CONST_NDIM; idim++) {
+    for (int iside=0; iside<2; iside++) {
+      if (bdrypml_d->is_sides_pml[idim][iside]==1) {
+        bdrypml_auxvar_t *auxvar_d = &(bdrypml_d->auxvar[idim][iside]);
+        sprintf(name, "pml%d%d", idim, iside);
+        chkpt_add(chkpt, name, auxvar_d->pre, sizeof(float)*auxvar_d->siz_ilevel, 1);
+      }
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * host seismo of stations and lines, with history of decimation filters,
+ *  samples already in trace stores and running spectra
+ */
+
+int
+chkpt_add_recv(chkpt_t *chkpt, iorecv_t *iorecv, ioline_t *ioline,
+               io_fault_recv_t *io_fault_recv)
+{
+  char name[CHKPT_NAME_STRLEN];
+
+  for (int ir=0; ir<iorecv->total_number; ir++)
+  {
+    sprintf(name, "recv%d", ir);
+    chkpt_add(chkpt, name, iorecv->recvone[ir].seismo,
+              sizeof(float)*iorecv->ncmp*iorecv->nt_buff, 0);
+  }
+
+  for (int n=0; n<ioline->num_of_lines; n++)
+  {
+    sprintf(name, "line%d", n);
+    chkpt_add(chkpt, name, ioline->recv_seismo[n],
+              sizeof(float)*ioline->line_nr[n]*ioline->ncmp*ioline->nt_buff, 0);
+  }
+
+  for (int ir=0; ir<io_fault_recv->total_number; ir++)
+  {
+    sprintf(name, "fault_recv%d", ir);
+    chkpt_add(chkpt, name, io_fault_recv->fault_recvone[ir].seismo,
+              sizeof(float)*io_fault_recv->ncmp*io_fault_recv->nt_buff, 0);
+  }
+
+  // steps not yet in decimated samples
+  decim_t *decim[3] = { &iorecv->decim, &ioline->decim, &io_fault_recv->decim };
+  const char *decim_name[3] = { "recv_decim", "line_decim", "fault_recv_decim" };
+  for (int n=0; n<3; n++)
+  {
+    if (decim[n]->hist == NULL) continue;
+    sprintf(name, "%s", decim_name[n]);
+    chkpt_add(chkpt, name, decim[n]->hist,
+              sizeof(float)*decim[n]->num_of_trace*decim[n]->num_of_tap, 0);
+  }
+
+  // samples in trace stores, seismo keep the ones after
+  seis_store_t *store[3] = { &iorecv->store, &ioline->store, &io_fault_recv->store };
+  const char *store_name[3] = { "recv_store", "line_store", "fault_recv_store" };
+  for (int n=0; n<3; n++)
+  {
+    if (store[n]->enable == 0) continue;
+    sprintf(name, "%s", store_name[n]);
+    chkpt_add(chkpt, name, &(store[n]->num_of_put), sizeof(int), 0);
+  }
+
+  // running spectra of stations
+  if (iorecv->spec.enable == 1)
+  {
+    chkpt_add(chkpt, "recv_spec", iorecv->spec.state,
+              sizeof(double)*iorecv->spec.num_of_trace*iorecv->spec.num_of_freq*2, 0);
+    chkpt_add(chkpt, "recv_spec_step", &(iorecv->spec.num_of_step), sizeof(int), 0);
+  }
+
+  return 0;
+}
+
+/*
+ * all vars carried by time loop. pre levels are swapped each step,
+ *  so sections are added again before each dump
+ */
+
+int
+chkpt_add_state(chkpt_t *chkpt, gd_t *gd,
+                wav_t *wav_d, float *w_pre_d,
+                fault_wav_t *FW_d, float *f_pre_d,
+                fault_t *F_d, bdrypml_t *bdrypml_d,
+                float *PG_d, float *Dis_accu_d, im_t *im, kinsrc_t *kinsrc,
+                iorecv_t *iorecv, ioline_t *ioline,
+                io_fault_recv_t *io_fault_recv, iosnap_nc_t *iosnap_nc)
+{
+  size_t siz_slice_xy = gd->nx * gd->ny;
+
+  chkpt_reset(chkpt);
+
+  chkpt_add(chkpt, "wav", w_pre_d, sizeof(float)*wav_d->siz_ilevel, 1);
+  chkpt_add_fault_wav(chkpt, gd, FW_d, f_pre_d);
+  chkpt_add_fault(chkpt, gd, F_d);
+  chkpt_add_pml(chkpt, bdrypml_d);
+
+  // only with free surface
+  if (PG_d != NULL) {
+    chkpt_add(chkpt, "PG", PG_d, sizeof(float)*CONST_NDIM_5*siz_slice_xy, 1);
+    chkpt_add(chkpt, "Dis_accu", Dis_accu_d, sizeof(float)*CONST_NDIM*siz_slice_xy, 1);
+  }
+
+  // oscillators and Husid samples of intensity measures
+  if (im->enable == 1) {
+    chkpt_add(chkpt, "im_state", im->state_d,
+              sizeof(float)*im->num_of_period*IM_NUM_STATE*im->siz_slice, 1);
+    chkpt_add(chkpt, "im", im->im_d, sizeof(float)*im->num_of_layer*im->siz_slice, 1);
+    chkpt_add(chkpt, "im_husid", im->husid_d, sizeof(float)*im->max_husid*im->siz_slice, 1);
+    chkpt_add(chkpt, "im_husid_every", &(im->husid_every), sizeof(int), 0);
+    chkpt_add(chkpt, "im_num_of_husid", &(im->num_of_husid), sizeof(int), 0);
+    chkpt_add(chkpt, "im_num_of_step", &(im->num_of_step), sizeof(int), 0);
+  }
+
+  // moment rate of subfaults, flushed before dump, kept by thread 0
+  if (kinsrc->series != NULL) {
+    chkpt_add(chkpt, "kinsrc_series", kinsrc->series,
+              sizeof(double)*kinsrc->nt_sample*kinsrc->num_of_sub*KINSRC_NUM_RATE, 0);
+  }
+
+  chkpt_add_recv(chkpt, iorecv, ioline, io_fault_recv);
+
+  // time index of snapshot files, slice and fault use it
+  chkpt_add(chkpt, "snap_cur_it", iosnap_nc->cur_it,
+            sizeof(int)*iosnap_nc->num_of_snap, 0);
+
+  return 0;
+}
+
+/*
+ * decide dump after step it, same result on all threads.
+ *  signal may only reach part of threads, so stop is voted by
+ *  MPI_Iallreduce posted at step it and completed at step it+1, after a
+ *  step of exchanges it is mostly done and doesn't sync the time loop.
+ *  stop is one step after the signal or wall time
+ */
+
+int
+chkpt_check(chkpt_t *chkpt, int it, MPI_Comm comm)
+{
+  if (chkpt->enable == 0) return CHKPT_NONE;
+
+  int is_stop = 0;
+
+  if (chkpt->on_signal == 1 || chkpt->wall_time > 0.0)
+  {
+    if (chkpt->is_voting == 1) {
+      MPI_Wait(&chkpt->vote_req, MPI_STATUS_IGNORE);
+      chkpt->is_voting = 0;
+      is_stop = chkpt->vote_recv;
+    }
+
+    if (is_stop == 0)
+    {
+      chkpt->vote_send = 0;
+      if (chkpt_sig_flag == 1) chkpt->vote_send = 1;
+      if (chkpt->wall_time > 0.0 && prof_wtime() - chkpt->t_start > chkpt->wall_time) {
+        chkpt->vote_send = 1;
+      }
+      MPI_Iallreduce(&chkpt->vote_send, &chkpt->vote_recv, 1, MPI_INT, MPI_MAX,
+                     comm, &chkpt->vote_req);
+      chkpt->is_voting = 1;
+    }
+  }
+
+  if (is_stop == 1) return CHKPT_DUMP_STOP;
+
+  if (chkpt->every > 0 && (it+1) % chkpt->every == 0) return CHKPT_DUMP;
+
+  return CHKPT_NONE;
+}
+
+static void
+chkpt_stage_reserve(chkpt_t *chkpt, size_t nbyte)
+{
+  if (chkpt->siz_stage >= nbyte) return;
+
+  if (chkpt->stage != NULL) {
+    CUDACHECK(cudaFreeHost(chkpt->stage));
+  }
+  CUDACHECK(cudaMallocHost((void **) &(chkpt->stage), nbyte));
+  chkpt->siz_stage = nbyte;
+}
+
+static void
+chkpt_get_fname(chkpt_t *chkpt, char *kind, char *fname)
+{
+  sprintf(fname, "%s/chkpt_%s_rank%d.bin", chkpt->dir, kind, chkpt->myid);
+}
+
+/*
+ * header, section table, then section data in same order.
+ *  written to .tmp first, so a killed writer keeps the previous file
+ */
+
+static void *
+chkpt_writer(void *arg)
+{
+  chkpt_t *chkpt = (chkpt_t *) arg;
+
+  char tmp_fname[CONST_MAX_STRLEN+8];
+  sprintf(tmp_fname, "%s.tmp", chkpt->fname);
+
+  FILE *fp = fopen(tmp_fname, "wb");
+  if (fp == NULL) {
+    fprintf(stderr,"Error: can't create checkpoint file %s\n", tmp_fname);
+    chkpt->ierr_writer = 1;
+    return NULL;
+  }
+
+  size_t nbyte_all = 0;
+  for (int n=0; n < chkpt->num_of_sec; n++) {
+    nbyte_all += chkpt->sec[n].nbyte;
+  }
+
+  int ierr = 0;
+  ierr += fwrite(CHKPT_MAGIC, 1, 8, fp) != 8;
+  ierr += fwrite(&(chkpt->myid),       sizeof(int),   1, fp) != 1;
+  ierr += fwrite(&(chkpt->it),         sizeof(int),   1, fp) != 1;
+  ierr += fwrite(&(chkpt->nt_total),   sizeof(int),   1, fp) != 1;
+  ierr += fwrite(&(chkpt->dt),         sizeof(float), 1, fp) != 1;
+  ierr += fwrite(&(chkpt->num_of_sec), sizeof(int),   1, fp) != 1;
+  for (int n=0; n < chkpt->num_of_sec; n++) {
+    ierr += fwrite(chkpt->sec[n].name, 1, CHKPT_NAME_STRLEN, fp) != CHKPT_NAME_STRLEN;
+    ierr += fwrite(&(chkpt->sec[n].nbyte), sizeof(size_t), 1, fp) != 1;
+  }
+  ierr += fwrite(chkpt->stage, 1, nbyte_all, fp) != nbyte_all;
+  ierr += fflush(fp) != 0;
+  ierr += fsync(fileno(fp)) != 0;
+  fclose(fp);
+
+  if (ierr != 0 || rename(tmp_fname, chkpt->fname) != 0) {
+    fprintf(stderr,"Error: failed to write checkpoint file %s\n", chkpt->fname);
+    chkpt->ierr_writer = 1;
+  }
+
+  return NULL;
+}
+
+/*
+ * stage added sections to host, then write them in background if is_async.
+ *  staging buff is reused, so wait previous writer first
+ */
+
+int
+chkpt_write(chkpt_t *chkpt, char *kind, int it, int nt_total, float dt,
+            int is_async)
+{
+  chkpt_wait(chkpt);
+
+  size_t nbyte_all = 0;
+  for (int n=0; n < chkpt->num_of_sec; n++) {
+    chkpt->sec[n].offset = nbyte_all;
+    nbyte_all += chkpt->sec[n].nbyte;
+  }
+  chkpt_stage_reserve(chkpt, nbyte_all);
+
+  for (int n=0; n < chkpt->num_of_sec; n++)
+  {
+    chkpt_sec_t *sec = chkpt->sec + n;
+    if (sec->is_device == 1) {
+      CUDACHECK(cudaMemcpy(chkpt->stage + sec->offset, sec->ptr, sec->nbyte,
+                           cudaMemcpyDeviceToHost));
+    } else {
+      memcpy(chkpt->stage + sec->offset, sec->ptr, sec->nbyte);
+    }
+  }
+
+  chkpt->it       = it;
+  chkpt->nt_total = nt_total;
+  chkpt->dt       = dt;
+  chkpt_get_fname(chkpt, kind, chkpt->fname);
+
+  if (is_async == 1)
+  {
+    if (pthread_create(&(chkpt->writer), NULL, chkpt_writer, chkpt) != 0) {
+      fprintf(stderr,"Error: can't create checkpoint writer thread\n");
+      fflush(stderr);
+      MPI_Abort(MPI_COMM_WORLD,1);
+    }
+    chkpt->is_writing = 1;
+  }
+  else
+  {
+    chkpt_writer(chkpt);
+  }
+
+  if (chkpt->ierr_writer != 0) MPI_Abort(MPI_COMM_WORLD,1);
+
+  return 0;
+}
+
+/*
+ * complete vote still posted at end of time loop, all threads call it
+ */
+
+int
+chkpt_check_end(chkpt_t *chkpt)
+{
+  if (chkpt->is_voting == 0) return 0;
+
+  MPI_Wait(&chkpt->vote_req, MPI_STATUS_IGNORE);
+  chkpt->is_voting = 0;
+
+  return 0;
+}
+
+int
+chkpt_wait(chkpt_t *chkpt)
+{
+  if (chkpt->is_writing == 0) return 0;
+
+  pthread_join(chkpt->writer, NULL);
+  chkpt->is_writing = 0;
+
+  if (chkpt->ierr_writer != 0) MPI_Abort(MPI_COMM_WORLD,1);
+
+  return 0;
+}
+
+/*
+ * load added sections from file, sections in file but not added are
+ *  skipped. header values are kept in it, nt_total and dt.
+ *  error is returned instead of abort, as set-up worker threads read
+ *  by chkpt_read_one and must not call MPI, caller aborts
+ */
+
+int
+chkpt_read(chkpt_t *chkpt, char *kind)
+{
+  char fname[CONST_MAX_STRLEN];
+  chkpt_get_fname(chkpt, kind, fname);
+
+  FILE *fp = fopen(fname, "rb");
+  if (fp == NULL) {
+    fprintf(stderr,"Error: can't open checkpoint file %s\n", fname);
+    fflush(stderr);
+    return 1;
+  }
+
+  char magic[8];
+  int  myid, num_of_sec;
+  int  ierr = 0;
+  ierr += fread(magic, 1, 8, fp) != 8;
+  ierr += fread(&myid,              sizeof(int),   1, fp) != 1;
+  ierr += fread(&(chkpt->it),       sizeof(int),   1, fp) != 1;
+  ierr += fread(&(chkpt->nt_total), sizeof(int),   1, fp) != 1;
+  ierr += fread(&(chkpt->dt),       sizeof(float), 1, fp) != 1;
+  ierr += fread(&num_of_sec,        sizeof(int),   1, fp) != 1;
+  if (ierr != 0 || strncmp(magic, CHKPT_MAGIC, 8) != 0 || myid != chkpt->myid) {
+    fprintf(stderr,"Error: %s is not a checkpoint file of thread %d\n", fname, chkpt->myid);
+    fflush(stderr);
+    fclose(fp);
+    return 1;
+  }
+
+  char   *file_name  = (char *)   malloc(CHKPT_NAME_STRLEN * num_of_sec);
+  size_t *file_nbyte = (size_t *) malloc(sizeof(size_t) * num_of_sec);
+  for (int n=0; n < num_of_sec; n++) {
+    ierr += fread(file_name + n*CHKPT_NAME_STRLEN, 1, CHKPT_NAME_STRLEN, fp) != CHKPT_NAME_STRLEN;
+    ierr += fread(file_nbyte + n, sizeof(size_t), 1, fp) != 1;
+  }
+  long data_start = ftell(fp);
+
+  for (int m=0; m < chkpt->num_of_sec; m++)
+  {
+    chkpt_sec_t *sec = chkpt->sec + m;
+
+    size_t offset = 0;
+    int    is_found = 0;
+    for (int n=0; n < num_of_sec; n++)
+    {
+      if (strncmp(file_name + n*CHKPT_NAME_STRLEN, sec->name, CHKPT_NAME_STRLEN) == 0) {
+        is_found = 1;
+        if (file_nbyte[n] != sec->nbyte) is_found = -1;
+        break;
+      }
+      offset += file_nbyte[n];
+    }
+    if (is_found != 1) {
+      fprintf(stderr,"Error: %s of %zu bytes is not in checkpoint file %s\n",
+              sec->name, sec->nbyte, fname);
+      fflush(stderr);
+      fclose(fp);
+      free(file_name);
+      free(file_nbyte);
+      return 1;
+    }
+
+    char *buff = (char *) sec->ptr;
+    if (sec->is_device == 1) {
+      chkpt_stage_reserve(chkpt, sec->nbyte);
+      buff = chkpt->stage;
+    }
+
+    fseek(fp, data_start + (long) offset, SEEK_SET);
+    ierr += fread(buff, 1, sec->nbyte, fp) != sec->nbyte;
+
+    if (sec->is_device == 1) {
+      CUDACHECK(cudaMemcpy(sec->ptr, buff, sec->nbyte, cudaMemcpyHostToDevice));
+    }
+  }
+  fclose(fp);
+  free(file_name);
+  free(file_nbyte);
+
+  if (ierr != 0) {
+    fprintf(stderr,"Error: failed to read checkpoint file %s\n", fname);
+    fflush(stderr);
+    return 1;
+  }
+
+  return 0;
+}
+
+int
+chkpt_read_one(chkpt_t *chkpt, char *kind, char *name, void *ptr, size_t nbyte)
+{
+  chkpt_reset(chkpt);
+  chkpt_add(chkpt, name, ptr, nbyte, 0);
+  int ierr = chkpt_read(chkpt, kind);
+  chkpt_reset(chkpt);
+
+  return ierr;
+}
+
+int
+chkpt_free(chkpt_t *chkpt)
+{
+  chkpt_wait(chkpt);
+
+  if (chkpt->stage != NULL) {
+    CUDACHECK(cudaFreeHost(chkpt->stage));
+  }
+  chkpt->stage     = NULL;
+  chkpt->siz_stage = 0;
+
+  free(chkpt->sec);
+  chkpt->sec = NULL;
+
+  return 0;
+}
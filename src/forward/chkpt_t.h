@@ -0,0 +1,142 @@
+#ifndef CHKPT_T_H
+#define CHKPT_T_H
+
+#include <pthread.h>
+#include <mpi.h>
+
+#include "constants.h"
+#include "gd_t.h"
+#include "md_t.h"
+#include "fault_info.h"
+#include "wav_t.h"
+#include "fault_wav_t.h"
+#include "bdry_t.h"
+#include "io_funcs.h"
+#include "im_t.h"
+#include "kinsrc_t.h"
+
+/*************************************************
+ * checkpoint/restart
+ *  each thread writes chkpt_<kind>_rank%d.bin of named sections,
+ *  kind "setup" keeps coord, metric, media and fault coef once,
+ *  kind "state" keeps all vars carried by time loop and is rewritten
+ *  at each dump. sections are staged to pinned host memory and written
+ *  to file by a background thread
+ *************************************************/
+
+#define CHKPT_MAGIC        "CGFDCKP1"
+#define CHKPT_NAME_STRLEN  32
+
+// result of chkpt_check
+#define CHKPT_NONE      0
+#define CHKPT_DUMP      1
+#define CHKPT_DUMP_STOP 2
+
+typedef struct
+{
+  char   name[CHKPT_NAME_STRLEN];
+  void  *ptr;      // source when writing, target when reading
+  size_t nbyte;
+  int    is_device;
+  size_t offset;   // in staging buff
+} chkpt_sec_t;
+
+typedef struct
+{
+  int   enable;
+  int   every;     // dump each number of steps, 0 to disable
+  float wall_time; // dump and stop after seconds since start, <= 0 to disable
+  int   on_signal; // dump and stop at SIGUSR1 or SIGTERM
+
+  // stop vote of threads, posted at a step and completed at the next
+  int   is_voting;
+  int   vote_send;
+  int   vote_recv;
+  MPI_Request vote_req;
+
+  int   myid;
+  char  dir[CONST_MAX_STRLEN];
+  double t_start;
+
+  int num_of_sec;
+  int max_of_sec;
+  chkpt_sec_t *sec;
+
+  // header of file
+  int   it;
+  int   nt_total;
+  float dt;
+
+  // pinned staging buff
+  char  *stage;
+  size_t siz_stage;
+
+  // background writer
+  pthread_t writer;
+  int   is_writing;
+  int   ierr_writer;
+  char  fname[CONST_MAX_STRLEN];
+} chkpt_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+chkpt_init(chkpt_t *chkpt, int every, float wall_time, int on_signal,
+           char *dir, int myid, double t_start);
+
+int
+chkpt_reset(chkpt_t *chkpt);
+
+int
+chkpt_add(chkpt_t *chkpt, char *name, void *ptr, size_t nbyte, int is_device);
+
+int
+chkpt_add_fault(chkpt_t *chkpt, gd_t *gd, fault_t *F_d);
+
+int
+chkpt_add_fault_wav(chkpt_t *chkpt, gd_t *gd, fault_wav_t *FW_d, float *f_pre_d);
+
+int
+chkpt_add_fault_coef(chkpt_t *chkpt, gd_t *gd, fault_coef_t *FC);
+
+int
+chkpt_add_pml(chkpt_t *chkpt, bdrypml_t *bdrypml_d);
+
+int
+chkpt_add_recv(chkpt_t *chkpt, iorecv_t *iorecv, ioline_t *ioline,
+               io_fault_recv_t *io_fault_recv);
+
+int
+chkpt_add_state(chkpt_t *chkpt, gd_t *gd,
+                wav_t *wav_d, float *w_pre_d,
+                fault_wav_t *FW_d, float *f_pre_d,
+                fault_t *F_d, bdrypml_t *bdrypml_d,
+                float *PG_d, float *Dis_accu_d, im_t *im, kinsrc_t *kinsrc,
+                iorecv_t *iorecv, ioline_t *ioline,
+                io_fault_recv_t *io_fault_recv, iosnap_nc_t *iosnap_nc);
+
+int
+chkpt_check(chkpt_t *chkpt, int it, MPI_Comm comm);
+
+int
+chkpt_check_end(chkpt_t *chkpt);
+
+int
+chkpt_write(chkpt_t *chkpt, char *kind, int it, int nt_total, float dt,
+            int is_async);
+
+int
+chkpt_wait(chkpt_t *chkpt);
+
+int
+chkpt_read(chkpt_t *chkpt, char *kind);
+
+int
+chkpt_read_one(chkpt_t *chkpt, char *kind, char *name, void *ptr, size_t nbyte);
+
+int
+chkpt_free(chkpt_t *chkpt);
+
+#endif
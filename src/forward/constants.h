@@ -26,6 +26,14 @@
 // visco type
 #define CONST_VISCO_GRAVES_QS  1
 
+// x spacing away from faults
+#define CONST_STRETCH_NONE      0
+#define CONST_STRETCH_GEOMETRIC 1
+#define CONST_STRETCH_TANH      2
+
+// max number of materials indexed by 16-bit id
+#define CONST_MAX_MATERIAL 65536
+
 #define handle_nc_err(err)                       \
 {                                                \
   if (err != NC_NOERR) {                         \
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include "cuda_common.h"
 
 void setDeviceBeforeInit(int gpu_id_start)
@@ -16,14 +17,15 @@ void setDeviceBeforeInit(int gpu_id_start)
   fflush(stdout);
 }
 
-void *cuda_malloc(size_t len)
+void *cuda_malloc_at(size_t len, const char *file, int line)
 {
   void *p;
   const cudaError_t err = cudaMalloc(&p, len);
   if (cudaSuccess == err) return p;
-  fprintf(stderr, "Error @ %s, ", __FILE__);
-  fprintf(stderr, "code: %d, reson: %s\n", err, cudaGetErrorString(err));
-  return 0;
+  fprintf(stderr, "Error: %s:%d, cudaMalloc of %zu bytes, ", file, line, len);
+  fprintf(stderr, "code: %d, reason: %s\n", err, cudaGetErrorString(err));
+  fflush(stderr);
+  exit(1);
 }
 
 
@@ -15,7 +15,10 @@
 
 void setDeviceBeforeInit(int gpu_id_start);
   
-void *cuda_malloc(size_t len);
+// exit with size and caller on failure, never returns NULL
+#define cuda_malloc(len) cuda_malloc_at((len), __FILE__, __LINE__)
+
+void *cuda_malloc_at(size_t len, const char *file, int line);
 
 #endif
 
@@ -0,0 +1,122 @@
+/*******************************************************************************
+ * streaming anti-alias decimation of station traces
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "constants.h"
+#include "decim_t.h"
+
+int
+decim_nt_out(int factor, int nt_total)
+{
+  if (factor <= 1) return nt_total;
+
+  return (nt_total - 1) / factor + 1;
+}
+
+int
+decim_init(decim_t *decim, int factor, int num_of_trace, int nt_total,
+           int nt_buff)
+{
+  decim->factor       = factor > 1 ? factor : 1;
+  decim->num_of_trace = num_of_trace;
+  decim->nt_out       = decim_nt_out(decim->factor, nt_total);
+  decim->nt_buff      = nt_buff;
+  decim->half_len     = 0;
+  decim->num_of_tap   = 1;
+  decim->coef         = NULL;
+  decim->hist         = NULL;
+
+  if (decim->factor == 1) return 0;
+
+  int half_len = DECIM_HALF_LEN_OUT * decim->factor;
+  int ntap = 2 * half_len + 1;
+  decim->half_len   = half_len;
+  decim->num_of_tap = ntap;
+
+  // cutoff in cycles per step, unit gain at zero frequency
+  double fc  = 0.4 / decim->factor;
+  double sum = 0.0;
+  decim->coef = (float *) malloc(ntap * sizeof(float));
+  double *h = (double *) malloc(ntap * sizeof(double));
+  for (int n=0; n < ntap; n++)
+  {
+    int    m = n - half_len;
+    double s = (m == 0) ? 2.0 * fc : sin(2.0 * PI * fc * m) / (PI * m);
+    double w = 0.42 - 0.5 * cos(2.0 * PI * n / (ntap - 1))
+                    + 0.08 * cos(4.0 * PI * n / (ntap - 1));
+    h[n] = s * w;
+    sum += h[n];
+  }
+  for (int n=0; n < ntap; n++) {
+    decim->coef[n] = (float) (h[n] / sum);
+  }
+  free(h);
+
+  decim->hist = (float *) malloc((size_t) num_of_trace * ntap * sizeof(float));
+  decim_reset(decim);
+
+  return 0;
+}
+
+/*
+ * output samples completed after steps 0 to num_of_step-1 are pushed
+ */
+
+int
+decim_num_ready(decim_t *decim, int num_of_step)
+{
+  int num_of_ready = num_of_step;
+  if (decim->factor > 1)
+  {
+    int it_c = num_of_step - 1 - decim->half_len;
+    num_of_ready = (it_c < 0) ? 0 : it_c / decim->factor + 1;
+  }
+  if (num_of_ready > decim->nt_out) num_of_ready = decim->nt_out;
+
+  return num_of_ready;
+}
+
+int
+decim_reset(decim_t *decim)
+{
+  if (decim->hist != NULL) {
+    memset(decim->hist, 0, sizeof(float) * decim->num_of_trace * decim->num_of_tap);
+  }
+
+  return 0;
+}
+
+/*
+ * steps after the last one repeat it, gives the last outputs
+ */
+
+int
+decim_finish_trace(decim_t *decim, int itrace, int nt_total, float *trace)
+{
+  if (decim->factor == 1 || nt_total <= 0) return 0;
+
+  int    ntap = decim->num_of_tap;
+  float  v_last = decim->hist[(size_t) itrace * ntap + (nt_total - 1) % ntap];
+  int it_last = (decim->nt_out - 1) * decim->factor + decim->half_len;
+  for (int it = nt_total; it <= it_last; it++) {
+    decim_push(decim, itrace, it, v_last, trace);
+  }
+
+  return 0;
+}
+
+int
+decim_free(decim_t *decim)
+{
+  if (decim->coef != NULL) free(decim->coef);
+  if (decim->hist != NULL) free(decim->hist);
+  decim->coef = NULL;
+  decim->hist = NULL;
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef DECIM_T_H
+#define DECIM_T_H
+
+/*************************************************
+ * streaming decimation of station traces
+ *  sample m of output is at step m*factor, filtered by a symmetric
+ *  lowpass FIR (windowed sinc, -6 dB at 0.8 of the decimated Nyquist,
+ *  Blackman window) of DECIM_HALF_LEN_OUT*factor taps on each side, so
+ *  the output has no time shift. only kept samples are filtered, the
+ *  polyphase way; each trace keeps a ring of its last num_of_tap inputs.
+ *  output m is ready when step m*factor+half_len is pushed, the last
+ *  ones are completed by decim_finish_trace.
+ *  steps before 0 take the value of step 0 and steps after the last
+ *  take the value of the last, so traces not starting or ending at zero
+ *  (fault stress, cumulative slip) keep their values at both ends.
+ *  factor 1 stores each step unfiltered. sample m is put at m % nt_buff
+ *  of trace, a ring when traces are streamed to disk
+ *************************************************/
+
+#define DECIM_HALF_LEN_OUT 10
+
+typedef struct
+{
+  int factor;
+  int half_len;   // taps on each side of center
+  int num_of_tap;
+  int num_of_trace;
+  int nt_out;     // samples of output trace
+  int nt_buff;    // samples of trace buffer
+  float *coef;
+  float *hist;    // [num_of_trace][num_of_tap], ring by step
+} decim_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+decim_nt_out(int factor, int nt_total);
+
+int
+decim_init(decim_t *decim, int factor, int num_of_trace, int nt_total,
+           int nt_buff);
+
+int
+decim_num_ready(decim_t *decim, int num_of_step);
+
+int
+decim_reset(decim_t *decim);
+
+int
+decim_finish_trace(decim_t *decim, int itrace, int nt_total, float *trace);
+
+int
+decim_free(decim_t *decim);
+
+/*
+ * input of step it to trace itrace, output sample written to trace if ready
+ */
+
+static inline void
+decim_push(decim_t *decim, int itrace, int it, float v, float *trace)
+{
+  if (decim->factor == 1) {
+    trace[it % decim->nt_buff] = v;
+    return;
+  }
+
+  int    ntap = decim->num_of_tap;
+  float *hist = decim->hist + (size_t) itrace * ntap;
+  if (it == 0) {
+    for (int n=0; n < ntap; n++) hist[n] = v;
+  }
+  hist[it % ntap] = v;
+
+  int it_c = it - decim->half_len;
+  if (it_c < 0 || it_c % decim->factor != 0) return;
+
+  int m = it_c / decim->factor;
+  if (m >= decim->nt_out) return;
+
+  // coef is symmetric, coef[n] is the weight of step it - n
+  double sum = 0.0;
+  int i0 = it % ntap;
+  for (int n=0; n < ntap; n++)
+  {
+    int i = i0 - n;
+    if (i < 0) i += ntap;
+    sum += decim->coef[n] * hist[i];
+  }
+  trace[m % decim->nt_buff] = (float) sum;
+}
+
+#endif
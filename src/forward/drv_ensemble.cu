@@ -0,0 +1,55 @@
+/*******************************************************************************
+ * ensemble of rupture scenarios on same set-up
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <mpi.h>
+
+#include "constants.h"
+#include "fault_info.h"
+#include "io_funcs.h"
+#include "drv_ensemble.h"
+
+/*
+ * reset fault and outputs of host for member iens, device state is
+ *  created again by solver
+ */
+
+int
+drv_ensemble_set_member(blk_t *blk, par_t *par, int iens,
+                        MPI_Comm comm, int myid)
+{
+  char *output_dir      = par->ensemble_output_dir[iens];
+  char *init_stress_dir = par->ensemble_init_stress_dir[iens];
+
+  if (myid==0)
+  {
+    fprintf(stdout,"ensemble member %d of %d: init_stress_dir=%s, output_dir=%s\n",
+            iens, par->number_of_ensemble_member, init_stress_dir, output_dir);
+    fflush(stdout);
+
+    if (mkdir(output_dir, 0755) != 0 && errno != EEXIST) {
+      fprintf(stderr,"Error: can't create output dir %s\n", output_dir);
+      fflush(stderr);
+      MPI_Abort(MPI_COMM_WORLD,1);
+    }
+  }
+  MPI_Barrier(comm);
+
+  sprintf(blk->output_dir, "%s", output_dir);
+
+  // init stress, friction and rupture flags of this member
+  fault_set(blk->fault, blk->fault_coef, blk->gd,
+            par->bdry_has_free, par->fault_grid, init_stress_dir);
+
+  io_output_set_dir(blk->iofault, blk->ioslice, blk->iosnap, output_dir);
+
+  // member stopped early should not keep seismo of previous one
+  io_seismo_reset(blk->iorecv, blk->ioline, blk->io_fault_recv);
+
+  return 0;
+}
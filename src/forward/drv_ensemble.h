@@ -0,0 +1,23 @@
+#ifndef DRV_ENSEMBLE_H
+#define DRV_ENSEMBLE_H
+
+#include <mpi.h>
+
+#include "par_t.h"
+#include "blk_t.h"
+
+/*************************************************
+ * ensemble of init stress and friction
+ *  members share grid, metric, media, fault coef and boundary set-up,
+ *  and are run one by one by drv_rk_curv_col_allstep
+ *************************************************/
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+drv_ensemble_set_member(blk_t *blk, par_t *par, int iens,
+                        MPI_Comm comm, int myid);
+
+#endif
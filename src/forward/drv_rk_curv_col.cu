@@ -18,6 +18,15 @@
 #include "transform.h"
 #include "fault_wav_t.h"
 #include "alloc.h"
+#include "resid_t.h"
+#include "mem_pool.h"
+#include "health_t.h"
+#include "chkpt_t.h"
+#include "rk_fuse.h"
+#include "fault_sparse_t.h"
+#include "moment_t.h"
+#include "im_t.h"
+#include "kinsrc_t.h"
 #include "cuda_common.h"
 
 /*******************************************************************************
@@ -30,6 +39,7 @@ drv_rk_curv_col_allstep(
   fd_t         *fd,
   gd_t     *gd,
   gd_metric_t  *metric,
+  gd_metric_t  *metric_d_setup,
   md_t         *md,
   par_t        *par,
   bdryfree_t   *bdryfree,
@@ -46,14 +56,16 @@ drv_rk_curv_col_allstep(
   ioslice_t    *ioslice,
   iosnap_t     *iosnap,
   io_fault_recv_t     *io_fault_recv,
+  prof_t       *prof,
+  chkpt_t      *chkpt,
   // time
   float dt, int nt_total, float t0,
   char *output_fname_part,
-  char *output_dir)
+  char *output_dir,
+  int  *num_of_step)
 {
   int imethod = par->imethod;
   int io_time_skip = par->io_time_skip;
-  int qc_check_nan_number_of_step = par->qc_check_nan_number_of_step;
 
   int num_rk_stages = fd->num_rk_stages;
   int num_of_pairs =  fd->num_of_pairs;
@@ -90,7 +102,11 @@ drv_rk_curv_col_allstep(
   init_gdinfo_device(gd, &gd_d);
   init_md_device(md, &md_d);
   init_fd_device(fd, &fd_device_d);
-  init_metric_device(metric, &metric_d);
+  if (metric_d_setup != NULL) {
+    metric_d = *metric_d_setup;
+  } else {
+    init_metric_device(metric, &metric_d, par->metric_recompute);
+  }
   init_wave_device(wav, &wav_d);
   init_bdryfree_device(gd, bdryfree, &bdryfree_d);
   init_bdrypml_device(gd, bdrypml, &bdrypml_d);
@@ -99,8 +115,48 @@ drv_rk_curv_col_allstep(
   init_fault_coef_device(gd, fault_coef, &fault_coef_d);
   init_fault_device(gd, fault, &fault_d);
 
+  // memory saved and cost of metric recomputed in kernels
+  gd_metric_recompute_report(metric, &metric_d, comm, myid);
+
+  // kinematic source of subfaults, geometry uses host coords and fault coef
+  kinsrc_t kinsrc;
+  kinsrc_init(&kinsrc, par->kinematic_source_output, par->kinematic_source_subfault_points,
+              par->kinematic_source_sample_every, par->kinematic_source_time_length,
+              dt, t0, nt_total, par->fault_grid, gd, metric_d,
+              fault_coef, fault_coef_d, comm, myid);
+
+  // release host mirrors which have been uploaded
+  resid_t resid;
+  resid_init(&resid, par->release_host_mirror);
+  resid_add_md(&resid, md, &md_d);
+  resid_add_metric(&resid, metric, &metric_d);
+  // kinematic source of each ensemble member sums host coords again
+  resid_add_gd(&resid, gd, &metric_d,
+               par->kinematic_source_output == 1 && par->number_of_ensemble_member > 1);
+  resid_add_fault_coef(&resid, gd, fault_coef, &fault_coef_d);
+  resid_release(&resid);
+  resid_print(&resid, myid);
+
+  // health monitor of wavefield
+  health_t health;
+  health_init(&health, par->qc_check_nan_number_of_step, par->health_max_velocity,
+              par->health_check_on_host, myid, output_dir);
+  health.resid = &resid;
+  int is_unhealthy = 0;
+
   // get device wavefield 
   float *w_buff = wav->v5d; // size number is V->siz_icmp * (V->ncmp+6)
+
+  // pools of temporary buffers used by io, reused through all steps
+  mem_pool_t pool_d;
+  mem_pool_t pool_h;
+  mem_pool_init(&pool_d, MEM_POOL_DEVICE, "io_device");
+  mem_pool_init(&pool_h, MEM_POOL_HOST,   "io_pinned");
+  // pinned staging buff of station values, 8 points interp of recv
+  //  and 4 points interp of fault recv
+  size_t siz_recv_buff = CONST_2_NDIM * wav->ncmp;
+  if (siz_recv_buff < 4 * fault->ncmp) siz_recv_buff = 4 * fault->ncmp;
+  float *recv_buff = (float *) mem_pool_malloc(&pool_h, sizeof(float)*siz_recv_buff);
   // GPU local pointer
   float *w_cur_d;
   float *w_pre_d;
@@ -131,22 +187,35 @@ drv_rk_curv_col_allstep(
   float t_end; // time after this loop for nc output
   // for mpi message
   int   ipair_mpi, istage_mpi;
-  // create fault slice nc output files
-  if (myid==0) fprintf(stdout,"prepare fault slice nc output ...\n"); 
   iofault_nc_t iofault_nc;
-  io_fault_nc_create(iofault,
-                     gd->ni, gd->nj, gd->nk, topoid,
-                     &iofault_nc);
-  // create slice nc output files
-  if (myid==0) fprintf(stdout,"prepare slice nc output ...\n"); 
   ioslice_nc_t ioslice_nc;
-  io_slice_nc_create(ioslice, wav->ncmp, wav->cmp_name,
-                     gd->ni, gd->nj, gd->nk, topoid,
-                     &ioslice_nc);
-  // create snapshot nc output files
-  if (myid==0) fprintf(stdout,"prepare snap nc output ...\n"); 
   iosnap_nc_t  iosnap_nc;
-  io_snap_nc_create(iosnap, &iosnap_nc, topoid);
+  if (par->checkpoint_restart == 1)
+  {
+    // continue writing files of the interrupted run
+    if (myid==0) fprintf(stdout,"reopen nc output ...\n"); 
+    io_fault_nc_reopen(iofault, &iofault_nc);
+    io_slice_nc_reopen(ioslice, wav->ncmp, wav->cmp_name, &ioslice_nc);
+    io_snap_nc_reopen(iosnap, &iosnap_nc);
+  }
+  else
+  {
+    // global index of first physical point, for merging files of threads
+    int g_start[CONST_NDIM] = { gd->gni1, gd->gnj1, gd->gnk1 };
+    // create fault slice nc output files
+    if (myid==0) fprintf(stdout,"prepare fault slice nc output ...\n"); 
+    io_fault_nc_create(iofault,
+                       gd->ni, gd->nj, gd->nk, g_start, topoid,
+                       &iofault_nc);
+    // create slice nc output files
+    if (myid==0) fprintf(stdout,"prepare slice nc output ...\n"); 
+    io_slice_nc_create(ioslice, wav->ncmp, wav->cmp_name,
+                       gd->ni, gd->nj, gd->nk, g_start, topoid,
+                       &ioslice_nc);
+    // create snapshot nc output files
+    if (myid==0) fprintf(stdout,"prepare snap nc output ...\n"); 
+    io_snap_nc_create(iosnap, &iosnap_nc, topoid, nt_total);
+  }
 
   // only y/z mpi
   int num_of_r_reqs = 4;
@@ -168,6 +237,12 @@ drv_rk_curv_col_allstep(
     }
   }
 
+  // rk update of one stage, by one launch or one launch per array
+  rk_fuse_t fuse_send;
+  rk_fuse_t fuse_rest;
+  rk_fuse_init(&fuse_send, gd);
+  rk_fuse_init(&fuse_rest, gd);
+
   int isfree = bdryfree_d.is_sides_free[CONST_NDIM-1][1];
   // alloc free surface PGV, PGA and PGD
   float *PG_d = NULL;
@@ -180,6 +255,54 @@ drv_rk_curv_col_allstep(
     Dis_accu_d = init_Dis_accu_device(gd);
     PG = (float *) fdlib_mem_calloc_1d_float(CONST_NDIM_5*ny*nx,0.0,"PGV,A,D malloc");
   }
+  // PSA, CAV, Arias intensity and duration of free surface
+  im_t im;
+  im_init(&im, par->im_output * isfree, par->im_psa_num_of_period, par->im_psa_period,
+          par->im_psa_damping, par->im_husid_samples, dt, gd);
+
+  // load vars of time loop and continue from the dumped step
+  int it_start = 0;
+  if (par->checkpoint_restart == 1)
+  {
+    chkpt_add_state(chkpt, gd, &wav_d, w_pre_d, &fault_wav_d, f_pre_d,
+                    &fault_d, &bdrypml_d, PG_d, Dis_accu_d, &im, &kinsrc,
+                    iorecv, ioline, io_fault_recv, &iosnap_nc);
+    if (chkpt_read(chkpt, "state") != 0) MPI_Abort(MPI_COMM_WORLD,1);
+    if (chkpt->nt_total != nt_total || chkpt->dt != dt) {
+      fprintf(stderr,"ERROR: checkpoint of nt_total=%d, dt=%g, but nt_total=%d, dt=%g\n",
+              chkpt->nt_total, chkpt->dt, nt_total, dt);
+      MPI_Abort(MPI_COMM_WORLD,1);
+    }
+    // files of threads should be dumped at same step
+    int it_min, it_max;
+    MPI_Allreduce(&(chkpt->it), &it_min, 1, MPI_INT, MPI_MIN, comm);
+    MPI_Allreduce(&(chkpt->it), &it_max, 1, MPI_INT, MPI_MAX, comm);
+    if (it_min != it_max) {
+      if (myid==0) fprintf(stderr,"ERROR: checkpoint steps differ among threads: %d to %d\n",
+                           it_min, it_max);
+      MPI_Abort(MPI_COMM_WORLD,1);
+    }
+    it_start = chkpt->it;
+    if (myid==0) fprintf(stdout,"restart from checkpoint at it=%d\n", it_start); 
+  }
+  // seismo streamed to trace stores of this run
+  io_seismo_stream_open(iorecv, ioline, io_fault_recv, output_dir, myid,
+                        par->checkpoint_restart);
+  // sparse fault plane output replaces time frames of fault nc files
+  fault_sparse_t fsparse;
+  fault_sparse_init(&fsparse, iofault, gd, par->fault_output_sparse,
+                    par->fault_output_sparse_vs_threshold,
+                    par->fault_output_sparse_tolerance);
+  if (par->checkpoint_restart == 1) {
+    fault_sparse_reopen(&fsparse, it_start);
+  } else {
+    fault_sparse_create(&fsparse, topoid);
+  }
+  // moment rate, M0 and Mw of faults at each step
+  moment_t moment;
+  moment_init(&moment, par->moment_rate_output, par->moment_rate_flush_every, dt, t0,
+              gd, gd_d, metric_d, fault_coef, fault_coef_d,
+              it_start, par->checkpoint_restart, myid, output_dir);
   // calculate conversion matrix for free surface
   if (isfree == 1)
   {
@@ -206,29 +329,49 @@ drv_rk_curv_col_allstep(
 
   if (myid==0) fprintf(stdout,"start time loop ...\n"); 
 
-  for (int it=0; it<nt_total; it++)
+  // last step done, decimated seismo are completed only at end
+  int it_last = it_start - 1;
+  *num_of_step = 0;
+
+  prof_beg(prof, PROF_TIME_LOOP);
+  for (int it=it_start; it<nt_total; it++)
   {
     t_cur = it * dt + t0;
     t_end = t_cur +dt;
 
+    // io before stages is traced as stage -1
+    trace_set_step(prof->trace, it, -1);
+
     //-- recv by interp
-    io_recv_keep(iorecv, w_pre_d, w_buff, it, wav->ncmp, wav->siz_icmp);
+    prof_beg(prof, PROF_RECV_KEEP);
+    io_recv_keep(iorecv, w_pre_d, recv_buff, it, wav->ncmp, wav->siz_icmp, &pool_d);
 
-    io_fault_recv_keep(io_fault_recv, fault_d, w_buff, it, gd->siz_slice_yz);
+    io_fault_recv_keep(io_fault_recv, fault_d, recv_buff, it, gd->siz_slice_yz, &pool_d, comm);
 
     //-- line values
-    io_line_keep(ioline, w_pre_d, w_buff, it, wav->ncmp, wav->siz_icmp);
+    io_line_keep(ioline, w_pre_d, recv_buff, it, wav->ncmp, wav->siz_icmp, &pool_d);
+    prof_end(prof, PROF_RECV_KEEP);
     if(it%io_time_skip == 0)
     {
       int it_skip = (int)(it/io_time_skip);
       // io fault var each dt, use w_buff as buff
-      io_fault_nc_put(&iofault_nc, gd, fault, fault_d, w_buff, it_skip, t_cur);
+      prof_beg(prof, PROF_IO_FAULT);
+      if (fsparse.enable == 1) {
+        fault_sparse_put(&fsparse, fault_d, it, t_cur);
+      } else if (par->fault_output_dense == 1) {
+        io_fault_nc_put(&iofault_nc, gd, fault, fault_d, w_buff, it_skip, t_cur, &pool_d);
+      }
+      prof_end(prof, PROF_IO_FAULT);
       // write slice, use w_buff as buff
-      io_slice_nc_put(ioslice,&ioslice_nc,gd,w_pre_d,w_buff,it_skip,t_cur);
+      prof_beg(prof, PROF_IO_SLICE);
+      io_slice_nc_put(ioslice,&ioslice_nc,gd,w_pre_d,w_buff,it_skip,t_cur,&pool_d);
+      prof_end(prof, PROF_IO_SLICE);
     }
     // snapshot
-    io_snap_nc_put(iosnap, &iosnap_nc, gd, md, wav, 
-                   w_pre_d, w_buff, nt_total, it, t_cur);
+    prof_beg(prof, PROF_IO_SNAP);
+    io_snap_nc_put(iosnap, &iosnap_nc, gd, md, &resid, wav,
+                   w_pre_d, w_buff, nt_total, it, t_cur, &pool_d);
+    prof_end(prof, PROF_IO_SNAP);
 
 
     if (myid==0 && it%10==0) fprintf(stdout,"-> it=%d, t=%f\n", it, t_cur);
@@ -238,6 +381,8 @@ drv_rk_curv_col_allstep(
     // loop RK stages for one step
     for (istage=0; istage<num_rk_stages; istage++)
     {
+      trace_set_step(prof->trace, it, istage);
+
       // for mesg
       if (istage != num_rk_stages-1) {
         ipair_mpi = ipair;
@@ -278,11 +423,14 @@ drv_rk_curv_col_allstep(
       {
         case CONST_MEDIUM_ELASTIC_ISO : {
 
+          prof_beg(prof, PROF_TRANSFORM);
           wave2fault_onestage(
                         w_cur_d, w_rhs_d, wav_d, 
                         f_cur_d, f_rhs_d, fault_wav_d,
                         fault_d, metric_d, gd_d);
+          prof_end(prof, PROF_TRANSFORM);
 
+          prof_beg(prof, PROF_FRICTION);
           trial_slipweakening_onestage(
                         w_cur_d, f_cur_d, f_pre_d, 
                         isfree, dt,
@@ -291,11 +439,14 @@ drv_rk_curv_col_allstep(
                         fd->pair_fdy_op[ipair][istage],
                         fd->pair_fdz_op[ipair][istage],
                         myid);
+          prof_end(prof, PROF_FRICTION);
 
+          prof_beg(prof, PROF_TRANSFORM);
           fault2wave_onestage(
                         w_cur_d, wav_d, 
                         f_cur_d, fault_wav_d,
                         fault_d, metric_d, gd_d);
+          prof_end(prof, PROF_TRANSFORM);
 
           sv_curv_col_el_iso_onestage(
                         w_cur_d, w_rhs_d, wav_d, gd_d, fd_device_d, 
@@ -303,8 +454,9 @@ drv_rk_curv_col_allstep(
                         fd->pair_fdx_op[ipair][istage],
                         fd->pair_fdy_op[ipair][istage],
                         fd->pair_fdz_op[ipair][istage],
-                        myid);
+                        prof, myid);
 
+          prof_beg(prof, PROF_FAULT_RHS);
           sv_curv_col_el_iso_fault_onestage(
                         w_cur_d, w_rhs_d, f_cur_d, f_rhs_d,
                         isfree, imethod, wav_d, 
@@ -314,6 +466,7 @@ drv_rk_curv_col_allstep(
                         fd->pair_fdy_op[ipair][istage],
                         fd->pair_fdz_op[ipair][istage],
                         myid);
+          prof_end(prof, PROF_FAULT_RHS);
 
           break;
         }
@@ -322,256 +475,66 @@ drv_rk_curv_col_allstep(
       }
 
       // recv mesg
+      prof_beg(prof, PROF_MPI_START);
       MPI_Startall(num_of_r_reqs, mympi->pair_r_reqs[ipair_mpi][istage_mpi]);
       MPI_Startall(num_of_r_reqs, mympi->pair_r_reqs_fault[ipair_mpi][istage_mpi]);
+      prof_end(prof, PROF_MPI_START);
 
       // rk start
-      if (istage==0)
-      {
-        coef_a = rk_a[istage] * dt;
-        coef_b = rk_b[istage] * dt;
-
-        // temp wavefield
-        {
-          dim3 block(256);
-          dim3 grid;
-          grid.x = (wav_d.siz_ilevel + block.x - 1) / block.x;
-          wav_update <<<grid, block>>> (wav_d.siz_ilevel, coef_a, w_tmp_d, w_pre_d, w_rhs_d);
-        }
-        {
-          dim3 block(4,8,8);
-          dim3 grid;
-          grid.x = (2*fault_wav->ncmp + block.x - 1) / block.x;
-          grid.y = (nj + block.y - 1) / block.y;
-          grid.z = (nk + block.z - 1) / block.z;
-          for(int id=0; id<fault_wav->number_fault; id++)
-          {
-            float *f_tmp_thisone = f_tmp_d + id*fault_wav->siz_ilevel;
-            float *f_pre_thisone = f_pre_d + id*fault_wav->siz_ilevel;
-            float *f_rhs_thisone = f_rhs_d + id*fault_wav->siz_ilevel;
-            fault_wav_update <<<grid, block>>> (gd_d, fault_wav->ncmp, coef_a, 
-                                                id, fault_d, f_tmp_thisone, f_pre_thisone, f_rhs_thisone);
-          }
-
-          fault2wave_onestage(
-                        w_tmp_d, wav_d, 
-                        f_tmp_d, fault_wav_d,
-                        fault_d, metric_d, gd_d);
-        }
-
-        // pack and isend
-        macdrp_pack_mesg_gpu(w_tmp_d, fd, gd, mympi, ipair_mpi, istage_mpi, wav->ncmp, myid);
-        macdrp_pack_fault_mesg_gpu(f_tmp_d, fd, gd, fault_wav_d, mympi, ipair_mpi, istage_mpi, myid);
-        MPI_Startall(num_of_s_reqs, mympi->pair_s_reqs[ipair_mpi][istage_mpi]);
-        MPI_Startall(num_of_s_reqs, mympi->pair_s_reqs_fault[ipair_mpi][istage_mpi]);
-        
-        // pml_tmp
-        if(bdrypml_d.is_enable_pml == 1)
-        {
-          for (int idim=0; idim<CONST_NDIM; idim++) {
-            for (int iside=0; iside<2; iside++) {
-              if (bdrypml_d.is_sides_pml[idim][iside]==1) {
-                bdrypml_auxvar_t *auxvar_d = &(bdrypml_d.auxvar[idim][iside]);
-                dim3 block(256);
-                dim3 grid;
-                grid.x = (auxvar_d->siz_ilevel + block.x - 1) / block.x;
-                wav_update <<<grid, block>>> (
-                           auxvar_d->siz_ilevel, coef_a, auxvar_d->tmp, auxvar_d->pre, auxvar_d->rhs);
-              }
-            }
-          }
-        }
-        // w_end
-        {
-          dim3 block(256);
-          dim3 grid;
-          grid.x = (wav_d.siz_ilevel + block.x - 1) / block.x;
-          wav_update <<<grid, block>>> (wav_d.siz_ilevel, coef_b, w_end_d, w_pre_d, w_rhs_d);
-        }
-        {
-          dim3 block(4,8,8);
-          dim3 grid;
-          grid.x = (2*fault_wav->ncmp + block.x - 1) / block.x;
-          grid.y = (nj + block.y - 1) / block.y;
-          grid.z = (nk + block.z - 1) / block.z;
-          for(int id=0; id<fault_wav->number_fault; id++)
-          {
-            float *f_end_thisone = f_end_d + id*fault_wav->siz_ilevel;
-            float *f_pre_thisone = f_pre_d + id*fault_wav->siz_ilevel;
-            float *f_rhs_thisone = f_rhs_d + id*fault_wav->siz_ilevel;
-            fault_wav_update <<<grid, block>>> (gd_d, fault_wav->ncmp, coef_b, 
-                                                id, fault_d, f_end_thisone, f_pre_thisone, f_rhs_thisone);
-          }
-
-        }
-        // pml_end
-        if(bdrypml_d.is_enable_pml == 1)
-        {
-          for (int idim=0; idim<CONST_NDIM; idim++) {
-            for (int iside=0; iside<2; iside++) {
-              if (bdrypml_d.is_sides_pml[idim][iside]==1) {
-                bdrypml_auxvar_t *auxvar_d = &(bdrypml_d.auxvar[idim][iside]);
-                dim3 block(256);
-                dim3 grid;
-                grid.x = (auxvar_d->siz_ilevel + block.x - 1) / block.x;
-                wav_update <<<grid, block>>> (
-                            auxvar_d->siz_ilevel, coef_b, auxvar_d->end, auxvar_d->pre, auxvar_d->rhs);
-              }
-            }
-          }
-        }
-      }
-      else if (istage<num_rk_stages-1)
-      {
-        coef_a = rk_a[istage] * dt;
-        coef_b = rk_b[istage] * dt;
-        //temp wavefield
-        {
-          dim3 block(256);
-          dim3 grid;
-          grid.x = (wav_d.siz_ilevel + block.x - 1) / block.x;
-          wav_update <<<grid, block>>> (wav_d.siz_ilevel, coef_a, w_tmp_d, w_pre_d, w_rhs_d);
-          //CUDACHECK(cudaDeviceSynchronize());
-        }
-        {
-          dim3 block(4,8,8);
-          dim3 grid;
-          grid.x = (2*fault_wav->ncmp + block.x - 1) / block.x;
-          grid.y = (nj + block.y - 1) / block.y;
-          grid.z = (nk + block.z - 1) / block.z;
-          for(int id=0; id<fault_wav->number_fault; id++)
-          {
-            float *f_tmp_thisone = f_tmp_d + id*fault_wav->siz_ilevel;
-            float *f_pre_thisone = f_pre_d + id*fault_wav->siz_ilevel;
-            float *f_rhs_thisone = f_rhs_d + id*fault_wav->siz_ilevel;
-            fault_wav_update <<<grid, block>>> (gd_d, fault_wav->ncmp, coef_a, 
-                                                id, fault_d, f_tmp_thisone, f_pre_thisone, f_rhs_thisone);
-          }
-
-          fault2wave_onestage(
-                        w_tmp_d, wav_d, 
-                        f_tmp_d, fault_wav_d,
-                        fault_d, metric_d, gd_d);
-        }
-
-        // pack and isend
-        macdrp_pack_mesg_gpu(w_tmp_d, fd, gd, mympi, ipair_mpi, istage_mpi, wav->ncmp, myid);
-        macdrp_pack_fault_mesg_gpu(f_tmp_d, fd, gd, fault_wav_d, mympi, ipair_mpi, istage_mpi, myid);
-        MPI_Startall(num_of_s_reqs, mympi->pair_s_reqs[ipair_mpi][istage_mpi]);
-        MPI_Startall(num_of_s_reqs, mympi->pair_s_reqs_fault[ipair_mpi][istage_mpi]);
-        // pml_tmp
-        if(bdrypml_d.is_enable_pml == 1)
-        {
-          for (int idim=0; idim<CONST_NDIM; idim++) {
-            for (int iside=0; iside<2; iside++) {
-              if (bdrypml_d.is_sides_pml[idim][iside]==1) {
-                bdrypml_auxvar_t *auxvar_d = &(bdrypml_d.auxvar[idim][iside]);
-                dim3 block(256);
-                dim3 grid;
-                grid.x = (auxvar_d->siz_ilevel + block.x - 1) / block.x;
-                wav_update <<<grid, block>>> (
-                           auxvar_d->siz_ilevel, coef_a, auxvar_d->tmp, auxvar_d->pre, auxvar_d->rhs);
-              }
-            }
-          }
-        }
-        // w_end
-        {
-          dim3 block(256);
-          dim3 grid;
-          grid.x = (wav_d.siz_ilevel + block.x - 1) / block.x;
-          wav_update_end <<<grid, block>>> (wav_d.siz_ilevel, coef_b, w_end_d, w_rhs_d);
-        }
-        {
-          dim3 block(4,8,8);
-          dim3 grid;
-          grid.x = (2*fault_wav->ncmp + block.x - 1) / block.x;
-          grid.y = (nj + block.y - 1) / block.y;
-          grid.z = (nk + block.z - 1) / block.z;
-          for(int id=0; id<fault_wav->number_fault; id++)
-          {
-            float *f_end_thisone = f_end_d + id*fault_wav->siz_ilevel;
-            float *f_rhs_thisone = f_rhs_d + id*fault_wav->siz_ilevel;
-            fault_wav_update_end <<<grid, block>>>(gd_d, fault_wav->ncmp, coef_b, 
-                                                   id, fault_d, f_end_thisone, f_rhs_thisone);
-          }
-        }
-        // pml_end
-        if(bdrypml_d.is_enable_pml == 1)
-        {
-          for (int idim=0; idim<CONST_NDIM; idim++) {
-            for (int iside=0; iside<2; iside++) {
-              if (bdrypml_d.is_sides_pml[idim][iside]==1) {
-                bdrypml_auxvar_t *auxvar_d = &(bdrypml_d.auxvar[idim][iside]);
-                dim3 block(256);
-                dim3 grid;
-                grid.x = (auxvar_d->siz_ilevel + block.x - 1) / block.x;
-                wav_update_end <<<grid, block>>> (
-                           auxvar_d->siz_ilevel, coef_b, auxvar_d->end, auxvar_d->rhs);
-              }
-            }
-          }
-        }
+      prof_beg(prof, PROF_RK_UPDATE);
+      coef_a = (istage < num_rk_stages-1) ? rk_a[istage] * dt : 0.0;
+      coef_b = rk_b[istage] * dt;
+
+      rk_fuse_set_stage(&fuse_send, &fuse_rest, istage, num_rk_stages,
+                        coef_a, coef_b,
+                        wav_d, w_pre_d, w_tmp_d, w_rhs_d, w_end_d,
+                        fault_wav_d, f_pre_d, f_tmp_d, f_rhs_d, f_end_d,
+                        fault_d, bdrypml_d);
+      if (par->rk_fuse_update == 1) {
+        rk_fuse_update(&fuse_send);
+      } else {
+        rk_fuse_update_each(&fuse_send);
       }
-      else // last stage
-      {
-        coef_b = rk_b[istage] * dt;
 
-        // w_end
-        {
-          dim3 block(256);
-          dim3 grid;
-          grid.x = (wav_d.siz_ilevel + block.x - 1) / block.x;
-          wav_update_end <<<grid, block>>>(wav_d.siz_ilevel, coef_b, w_end_d, w_rhs_d);
-        }
-        {
-          dim3 block(4,8,8);
-          dim3 grid;
-          grid.x = (2*fault_wav->ncmp + block.x - 1) / block.x;
-          grid.y = (nj + block.y - 1) / block.y;
-          grid.z = (nk + block.z - 1) / block.z;
-          for(int id=0; id<fault_wav->number_fault; id++)
-          {
-            float *f_end_thisone = f_end_d + id*fault_wav->siz_ilevel;
-            float *f_rhs_thisone = f_rhs_d + id*fault_wav->siz_ilevel;
-            fault_wav_update_end <<<grid, block>>> (gd_d, fault_wav->ncmp, coef_b, 
-                                                    id, fault_d, f_end_thisone, f_rhs_thisone);
-          }
-
-          fault2wave_onestage(
-                        w_end_d, wav_d, 
-                        f_end_d, fault_wav_d,
-                        fault_d, metric_d, gd_d);
-        }
-        
-        // pack and isend
-        macdrp_pack_mesg_gpu(w_end_d, fd, gd, mympi, ipair_mpi, istage_mpi, wav->ncmp, myid);
-        macdrp_pack_fault_mesg_gpu(f_end_d, fd, gd, fault_wav_d, mympi, ipair_mpi, istage_mpi, myid);
-        MPI_Startall(num_of_s_reqs, mympi->pair_s_reqs[ipair_mpi][istage_mpi]);
-        MPI_Startall(num_of_s_reqs, mympi->pair_s_reqs_fault[ipair_mpi][istage_mpi]);
-        // pml_end
-        if(bdrypml_d.is_enable_pml == 1)
-        {
-          for (int idim=0; idim<CONST_NDIM; idim++) {
-            for (int iside=0; iside<2; iside++) {
-              if (bdrypml->is_sides_pml[idim][iside]==1) {
-                bdrypml_auxvar_t *auxvar_d = &(bdrypml_d.auxvar[idim][iside]);
-                dim3 block(256);
-                dim3 grid;
-                grid.x = (auxvar_d->siz_ilevel + block.x - 1) / block.x;
-                wav_update_end <<<grid, block>>> (
-                           auxvar_d->siz_ilevel, coef_b, auxvar_d->end, auxvar_d->rhs);
-              }
-            }
-          }
-        }
+      // level sent to neighbours
+      float *w_send_d = (istage != num_rk_stages-1) ? w_tmp_d : w_end_d;
+      float *f_send_d = (istage != num_rk_stages-1) ? f_tmp_d : f_end_d;
+
+      prof_end(prof, PROF_RK_UPDATE);
+      prof_beg(prof, PROF_TRANSFORM);
+      fault2wave_onestage(
+                    w_send_d, wav_d, 
+                    f_send_d, fault_wav_d,
+                    fault_d, metric_d, gd_d);
+      prof_end(prof, PROF_TRANSFORM);
+
+      // pack and isend
+      prof_beg(prof, PROF_PACK);
+      macdrp_pack_mesg_gpu(w_send_d, fd, gd, mympi, ipair_mpi, istage_mpi, wav->ncmp, myid);
+      macdrp_pack_fault_mesg_gpu(f_send_d, fd, gd, fault_wav_d, mympi, ipair_mpi, istage_mpi, myid);
+      prof_end(prof, PROF_PACK);
+      prof_beg(prof, PROF_MPI_START);
+      MPI_Startall(num_of_s_reqs, mympi->pair_s_reqs[ipair_mpi][istage_mpi]);
+      MPI_Startall(num_of_s_reqs, mympi->pair_s_reqs_fault[ipair_mpi][istage_mpi]);
+      prof_end(prof, PROF_MPI_START);
+      prof_beg(prof, PROF_RK_UPDATE);
+
+      // end level and pml, overlap with exchange
+      if (par->rk_fuse_update == 1) {
+        rk_fuse_update(&fuse_rest);
+      } else {
+        rk_fuse_update_each(&fuse_rest);
       }
+      prof_end(prof, PROF_RK_UPDATE);
 
+      prof_beg(prof, PROF_MPI_WAIT);
       MPI_Waitall(num_of_s_reqs, mympi->pair_s_reqs[ipair_mpi][istage_mpi], MPI_STATUS_IGNORE);
       MPI_Waitall(num_of_r_reqs, mympi->pair_r_reqs[ipair_mpi][istage_mpi], MPI_STATUS_IGNORE);
       MPI_Waitall(num_of_s_reqs, mympi->pair_s_reqs_fault[ipair_mpi][istage_mpi], MPI_STATUS_IGNORE);
       MPI_Waitall(num_of_r_reqs, mympi->pair_r_reqs_fault[ipair_mpi][istage_mpi], MPI_STATUS_IGNORE);
+      prof_end(prof, PROF_MPI_WAIT);
  
+      prof_beg(prof, PROF_UNPACK);
       if (istage != num_rk_stages-1) 
       {
         macdrp_unpack_mesg_gpu(w_tmp_d, fd, gd, mympi, ipair_mpi, istage_mpi, wav->ncmp, neighid_d);
@@ -581,22 +544,32 @@ drv_rk_curv_col_allstep(
         macdrp_unpack_mesg_gpu(w_end_d, fd, gd, mympi, ipair_mpi, istage_mpi, wav->ncmp, neighid_d);
         macdrp_unpack_fault_mesg_gpu(f_end_d, fd, gd, fault_wav_d, mympi, ipair_mpi, istage_mpi, neighid_d);
       }
+      prof_end(prof, PROF_UNPACK);
 
       // update fault output var in each stage
       // now only Tn Ts1 Ts2 need
       coef_b = rk_b[istage];
+      prof_beg(prof, PROF_FAULT_UPDATE);
       fault_var_stage_update(coef_b,istage, gd_d, fault_d);
+      prof_end(prof, PROF_FAULT_UPDATE);
     } // RK stages
+    *num_of_step += 1;
 
     //--------------------------------------------
     // QC
     //--------------------------------------------
-    if (qc_check_nan_number_of_step >0  && (it % qc_check_nan_number_of_step) == 0) {
-      if (myid==0) fprintf(stdout,"-> check value nan\n");
-    }
+    prof_beg(prof, PROF_HEALTH);
+    is_unhealthy = health_check(&health, it, t_end, w_end_d, f_end_d,
+                                gd, gd_d, wav, fault_wav,
+                                md, md_d, metric, metric_d, comm);
+    prof_end(prof, PROF_HEALTH);
+    // all threads get same result, stop together and close output
+    if (is_unhealthy == 1) break;
     //--------------------------------------------
     if (bdryexp_d.is_enable_ablexp == 1) {
+      prof_beg(prof, PROF_PML);
       bdry_ablexp_apply(bdryexp_d, gd, w_end_d, wav->ncmp);
+      prof_end(prof, PROF_PML);
     }
 
     //--------------------------------------------
@@ -605,19 +578,22 @@ drv_rk_curv_col_allstep(
     // calculate PGV, PGA and PGD for surface 
     if (isfree == 1)
     {
+      prof_beg(prof, PROF_SURFACE_PG);
       dim3 block(8,8);
       dim3 grid;
       grid.x = (ni + block.x - 1) / block.x;
       grid.y = (nj + block.y - 1) / block.y;
       PG_calcu_gpu<<<grid, block>>> (w_end_d, w_pre_d, gd_d, PG_d, Dis_accu_d, dt);
+      im_keep(&im, it, w_end_d, w_pre_d, gd, gd_d);
+      prof_end(prof, PROF_SURFACE_PG);
     }
 
     // calculate fault slip, Vs, ... at each dt  
+    prof_beg(prof, PROF_FAULT_UPDATE);
     fault_var_update(f_end_d, it, dt, gd_d, fault_d, fault_coef_d, fault_wav_d);
-    if(io_fault_recv->flag_swap == 1)
-    {
-      fault_var_exchange(gd, fault_d, mympi, neighid_d);
-    }
+    prof_end(prof, PROF_FAULT_UPDATE);
+    moment_keep(&moment, it, gd, gd_d, fault_d, comm);
+    kinsrc_keep(&kinsrc, it, gd_d, fault_d, comm);
     // swap w_pre and w_end pointer, avoid copying
     w_cur_d = w_pre_d; w_pre_d = w_end_d; w_end_d = w_cur_d;
     f_cur_d = f_pre_d; f_pre_d = f_end_d; f_end_d = f_cur_d;
@@ -633,22 +609,76 @@ drv_rk_curv_col_allstep(
         }
       }
     }
+
+    // device time of scopes in this step
+    prof_step_end(prof);
+
+    it_last = it;
+
+    //--------------------------------------------
+    // checkpoint of state at start of next step
+    //--------------------------------------------
+    int chkpt_flag = chkpt_check(chkpt, it, comm);
+    if (chkpt_flag != CHKPT_NONE && it+1 < nt_total)
+    {
+      prof_beg(prof, PROF_CHKPT);
+      // buffered shared fault stations go to seismo before dump
+      io_fault_recv_reduce(io_fault_recv, comm);
+      io_seismo_stream_wait(iorecv, ioline, io_fault_recv);
+      moment_flush(&moment, comm);
+      kinsrc_flush(&kinsrc, comm);
+      io_snap_nc_flush(&iosnap_nc);
+      chkpt_add_state(chkpt, gd, &wav_d, w_pre_d, &fault_wav_d, f_pre_d,
+                      &fault_d, &bdrypml_d, PG_d, Dis_accu_d, &im, &kinsrc,
+                      iorecv, ioline, io_fault_recv, &iosnap_nc);
+      // staged to host, written in background
+      chkpt_write(chkpt, "state", it+1, nt_total, dt, 1);
+      prof_end(prof, PROF_CHKPT);
+      if (myid==0) fprintf(stdout,"checkpoint at it=%d\n", it+1);
+    }
+    if (chkpt_flag == CHKPT_DUMP_STOP)
+    {
+      if (myid==0) fprintf(stdout,"stop after checkpoint at it=%d\n", it+1);
+      break;
+    }
   } // time loop
+  io_fault_recv_reduce(io_fault_recv, comm);
+  if (it_last == nt_total-1) {
+    io_seismo_finish(iorecv, ioline, io_fault_recv, nt_total);
+  }
+  io_seismo_stream_close(iorecv, ioline, io_fault_recv);
+  moment_flush(&moment, comm);
+  if (it_last == nt_total-1) {
+    kinsrc_finish(&kinsrc, gd_d, fault_d, comm, output_dir);
+  }
+  // last dump should be on disk before exit
+  chkpt_check_end(chkpt);
+  chkpt_wait(chkpt);
+  CUDACHECK(cudaDeviceSynchronize());
+  prof_end(prof, PROF_TIME_LOOP);
 
   cudaMemcpy(PG,PG_d,sizeof(float)*CONST_NDIM_5*gd->ny*gd->nx,cudaMemcpyDeviceToHost);
   if (isfree == 1)
   {
-    PG_slice_output(PG,gd,output_dir,output_fname_part,topoid);
+    im_finish(&im, gd, gd_d);
+    PG_slice_output(PG,gd,&im,output_dir,output_fname_part,topoid);
   }
   // io fault init_t0, peak_Vs at final time, use w_buff as buff
-  io_fault_end_t_nc_put(&iofault_nc, gd, fault, fault_d, w_buff);
+  io_fault_end_t_nc_put(&iofault_nc, gd, fault, fault_d, w_buff, &pool_d);
+
+  // next ensemble member uploads host media, metric and fault coef again
+  if (par->number_of_ensemble_member > 1) {
+    resid_fetch_all(&resid);
+  }
 
   // finish all time loop calculate, cudafree device pointer
   CUDACHECK(cudaFree(PG_d));
   CUDACHECK(cudaFree(Dis_accu_d));
   CUDACHECK(cudaFree(neighid_d));
   dealloc_md_device(md_d);
-  dealloc_metric_device(metric_d);
+  if (metric_d_setup == NULL) {
+    dealloc_metric_device(metric_d);
+  }
   dealloc_fd_device(fd_device_d);
   dealloc_fault_coef_device(fault_coef_d);
   dealloc_fault_device(fault_d);
@@ -658,11 +688,27 @@ drv_rk_curv_col_allstep(
   dealloc_bdryexp_device(bdryexp_d);
   dealloc_wave_device(wav_d);
 
+  // device copies are gone, released host mirrors can't be fetched
+  resid_free(&resid);
+
+  health_free(&health);
+  moment_free(&moment);
+  kinsrc_free(&kinsrc);
+  im_free(&im);
+
+  mem_pool_free(&pool_h, recv_buff);
+  mem_pool_print(&pool_d, myid);
+  mem_pool_print(&pool_h, myid);
+  mem_pool_destroy(&pool_d);
+  mem_pool_destroy(&pool_h);
+
   // close nc
   io_fault_nc_close(&iofault_nc);
+  fault_sparse_close(&fsparse, comm, myid);
   io_slice_nc_close(&ioslice_nc);
   io_snap_nc_close(&iosnap_nc);
 
-  return 0;
+  // 1 if stopped by health monitor
+  return is_unhealthy;
 }
 
@@ -10,6 +10,8 @@
 #include "fault_wav_t.h"
 #include "bdry_t.h"
 #include "io_funcs.h"
+#include "prof_t.h"
+#include "chkpt_t.h"
 
 /*************************************************
  * function prototype
@@ -20,6 +22,7 @@ drv_rk_curv_col_allstep(
   fd_t        *fd,
   gd_t    *gd,
   gd_metric_t *metric,
+  gd_metric_t *metric_d_setup, // uploaded in set-up, NULL to upload here
   md_t        *md,
   par_t       *par,
   bdryfree_t  *bdryfree,
@@ -36,9 +39,12 @@ drv_rk_curv_col_allstep(
   ioslice_t   *ioslice,
   iosnap_t    *iosnap,
   io_fault_recv_t    *io_fault_recv,
+  prof_t      *prof,
+  chkpt_t     *chkpt,
   // time
   float dt, int nt_total, float t0,
   char *output_fname_part,
-  char *output_dir);
+  char *output_dir,
+  int  *num_of_step); // steps run, less than nt_total at restart or stop
 
 #endif
@@ -0,0 +1,486 @@
+/*******************************************************************************
+ * event-driven sparse output of fault plane
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "constants.h"
+#include "fault_sparse_t.h"
+#ifndef FAULT_SPARSE_HOST_ONLY
+#include "cuda_common.h"
+#endif
+
+static const char *fault_sparse_cmp_name[FAULT_SPARSE_NCMP] = {
+  "Tn", "Ts1", "Ts2", "Vs", "Vs1", "Vs2", "Slip", "Slip1", "Slip2"};
+
+#ifndef FAULT_SPARSE_HOST_ONLY
+/*
+ * files are named after the fault nc file: x.nc -> x_sparse.bin, x_sparse.idx
+ */
+
+static void
+fault_sparse_set_fname(char *fname, const char *fname_nc, const char *suffix)
+{
+  char base[CONST_MAX_STRLEN];
+  sprintf(base, "%s", fname_nc);
+  size_t len = strlen(base);
+  if (len > 3 && strcmp(base + len - 3, ".nc") == 0) {
+    base[len-3] = '\0';
+  }
+  sprintf(fname, "%s_sparse.%s", base, suffix);
+}
+
+int
+fault_sparse_init(fault_sparse_t *fsparse, iofault_t *iofault, gd_t *gd,
+                  int enable, float vs_threshold, float tolerance)
+{
+  fsparse->enable       = enable;
+  fsparse->number_fault = 0;
+  fsparse->num_of_point_put = 0.0;
+  fsparse->num_of_point_all = 0.0;
+
+  if (enable == 0) return 0;
+
+  int number_fault = iofault->number_fault;
+  int nj = gd->nj;
+  int nk = gd->nk;
+  size_t siz_slice = (size_t)nj * nk;
+
+  fsparse->number_fault = number_fault;
+  fsparse->nj = nj;
+  fsparse->nk = nk;
+  fsparse->ny = gd->ny;
+  fsparse->siz_slice_yz = gd->siz_slice_yz;
+  fsparse->i_index      = iofault->fault_local_index;
+  fsparse->vs_threshold = vs_threshold;
+  fsparse->tolerance    = tolerance;
+  fsparse->is_key       = 1;
+
+  fsparse->fname     = (char **) malloc(number_fault * sizeof(char *));
+  fsparse->fname_idx = (char **) malloc(number_fault * sizeof(char *));
+  fsparse->fp        = (FILE **) malloc(number_fault * sizeof(FILE *));
+  fsparse->fp_idx    = (FILE **) malloc(number_fault * sizeof(FILE *));
+  fsparse->nbyte        = (long long *) malloc(number_fault * sizeof(long long));
+  fsparse->num_of_frame = (int *) malloc(number_fault * sizeof(int));
+  fsparse->last_d       = (float **) malloc(number_fault * sizeof(float *));
+
+  for (int id=0; id < number_fault; id++)
+  {
+    fsparse->fname[id]     = (char *) malloc(CONST_MAX_STRLEN * sizeof(char));
+    fsparse->fname_idx[id] = (char *) malloc(CONST_MAX_STRLEN * sizeof(char));
+    fault_sparse_set_fname(fsparse->fname[id],     iofault->fault_fname[id], "bin");
+    fault_sparse_set_fname(fsparse->fname_idx[id], iofault->fault_fname[id], "idx");
+    fsparse->fp[id]     = NULL;
+    fsparse->fp_idx[id] = NULL;
+    fsparse->nbyte[id]        = 0;
+    fsparse->num_of_frame[id] = 0;
+
+    fsparse->last_d[id] = (float *) cuda_malloc(sizeof(float)*FAULT_SPARSE_NCMP*siz_slice);
+    CUDACHECK(cudaMemset(fsparse->last_d[id], 0, sizeof(float)*FAULT_SPARSE_NCMP*siz_slice));
+  }
+
+  fsparse->flag_d = (unsigned char *) cuda_malloc(sizeof(unsigned char)*siz_slice);
+  fsparse->pidx_d = (int *) cuda_malloc(sizeof(int)*siz_slice);
+  fsparse->val_d  = (float *) cuda_malloc(sizeof(float)*FAULT_SPARSE_NCMP*siz_slice);
+  fsparse->flag = (unsigned char *) malloc(sizeof(unsigned char)*siz_slice);
+  fsparse->pidx = (int *) malloc(sizeof(int)*siz_slice);
+  // runs are separated by at least one point
+  fsparse->run  = (int *) malloc(sizeof(int)*(siz_slice+1));
+  fsparse->val  = (float *) malloc(sizeof(float)*FAULT_SPARSE_NCMP*siz_slice);
+
+  return 0;
+}
+#endif
+
+int
+fault_sparse_create(fault_sparse_t *fsparse, int *topoid)
+{
+  if (fsparse->enable == 0) return 0;
+
+  for (int id=0; id < fsparse->number_fault; id++)
+  {
+    FILE *fp     = fopen(fsparse->fname[id], "wb");
+    FILE *fp_idx = fopen(fsparse->fname_idx[id], "wb");
+    if (fp == NULL || fp_idx == NULL) {
+      fprintf(stderr,"Error: can't create sparse fault file %s\n", fsparse->fname[id]);
+      fflush(stderr);
+      exit(1);
+    }
+
+    char cmp_name[FAULT_SPARSE_NCMP][FAULT_SPARSE_NAME_STRLEN];
+    memset(cmp_name, 0, sizeof(cmp_name));
+    for (int icmp=0; icmp < FAULT_SPARSE_NCMP; icmp++) {
+      strncpy(cmp_name[icmp], fault_sparse_cmp_name[icmp], FAULT_SPARSE_NAME_STRLEN-1);
+    }
+    int ncmp = FAULT_SPARSE_NCMP;
+
+    int ierr = 0;
+    ierr += fwrite(FAULT_SPARSE_MAGIC, 1, 8, fp) != 8;
+    ierr += fwrite(&(fsparse->nj),  sizeof(int), 1, fp) != 1;
+    ierr += fwrite(&(fsparse->nk),  sizeof(int), 1, fp) != 1;
+    ierr += fwrite(&ncmp,           sizeof(int), 1, fp) != 1;
+    ierr += fwrite(fsparse->i_index+id, sizeof(int), 1, fp) != 1;
+    ierr += fwrite(topoid,          sizeof(int), 3, fp) != 3;
+    ierr += fwrite(&(fsparse->vs_threshold), sizeof(float), 1, fp) != 1;
+    ierr += fwrite(&(fsparse->tolerance),    sizeof(float), 1, fp) != 1;
+    ierr += fwrite(cmp_name, 1, sizeof(cmp_name), fp) != sizeof(cmp_name);
+    ierr += fwrite(FAULT_SPARSE_IDX_MAGIC, 1, 8, fp_idx) != 8;
+    ierr += fflush(fp) != 0;
+    ierr += fflush(fp_idx) != 0;
+    if (ierr != 0) {
+      fprintf(stderr,"Error: failed to write header of %s\n", fsparse->fname[id]);
+      fflush(stderr);
+      exit(1);
+    }
+
+    fsparse->fp[id]     = fp;
+    fsparse->fp_idx[id] = fp_idx;
+    fsparse->nbyte[id]  = FAULT_SPARSE_HEAD_NBYTE;
+    fsparse->num_of_frame[id] = 0;
+  }
+
+  return 0;
+}
+
+/*
+ * keep frames before it_start of the interrupted run and append after
+ *  them. last written values are not in checkpoint, so the first frame
+ *  after restart is a key frame
+ */
+
+int
+fault_sparse_reopen(fault_sparse_t *fsparse, int it_start)
+{
+  if (fsparse->enable == 0) return 0;
+
+  for (int id=0; id < fsparse->number_fault; id++)
+  {
+    FILE *fp     = fopen(fsparse->fname[id], "rb");
+    FILE *fp_idx = fopen(fsparse->fname_idx[id], "rb");
+    if (fp == NULL || fp_idx == NULL) {
+      fprintf(stderr,"Error: can't open sparse fault file %s to restart\n", fsparse->fname[id]);
+      fflush(stderr);
+      exit(1);
+    }
+
+    char magic[8];
+    char magic_idx[8];
+    int  nj = -1, nk = -1;
+    int  ierr = 0;
+    ierr += fread(magic, 1, 8, fp) != 8;
+    ierr += fread(&nj, sizeof(int), 1, fp) != 1;
+    ierr += fread(&nk, sizeof(int), 1, fp) != 1;
+    ierr += fread(magic_idx, 1, 8, fp_idx) != 8;
+    if (ierr != 0 || strncmp(magic, FAULT_SPARSE_MAGIC, 8) != 0 ||
+        strncmp(magic_idx, FAULT_SPARSE_IDX_MAGIC, 8) != 0 ||
+        nj != fsparse->nj || nk != fsparse->nk)
+    {
+      fprintf(stderr,"Error: %s is not sparse fault output of this grid\n", fsparse->fname[id]);
+      fflush(stderr);
+      exit(1);
+    }
+
+    // frames before it_start
+    long long nbyte = FAULT_SPARSE_HEAD_NBYTE;
+    int num_of_frame = 0;
+    for (;;)
+    {
+      int   it, num_of_run, num_of_point, is_key;
+      float time;
+      long long offset;
+      if (fread(&it,           sizeof(int),   1, fp_idx) != 1) break;
+      if (fread(&time,         sizeof(float), 1, fp_idx) != 1) break;
+      if (fread(&num_of_run,   sizeof(int),   1, fp_idx) != 1) break;
+      if (fread(&num_of_point, sizeof(int),   1, fp_idx) != 1) break;
+      if (fread(&is_key,       sizeof(int),   1, fp_idx) != 1) break;
+      if (fread(&offset, sizeof(long long),   1, fp_idx) != 1) break;
+      if (it >= it_start) break;
+      nbyte = offset + FAULT_SPARSE_FRAME_NBYTE(num_of_run, num_of_point);
+      num_of_frame += 1;
+    }
+    fclose(fp_idx);
+
+    // frame is written before its record
+    fseek(fp, 0, SEEK_END);
+    long long nbyte_file = ftell(fp);
+    fclose(fp);
+    if (nbyte_file < nbyte) {
+      fprintf(stderr,"Error: sparse fault file %s is shorter than its index\n", fsparse->fname[id]);
+      fflush(stderr);
+      exit(1);
+    }
+
+    if (truncate(fsparse->fname[id], nbyte) != 0 ||
+        truncate(fsparse->fname_idx[id],
+                 FAULT_SPARSE_IDX_HEAD_NBYTE + num_of_frame * FAULT_SPARSE_IDX_NBYTE) != 0)
+    {
+      fprintf(stderr,"Error: can't truncate sparse fault file %s\n", fsparse->fname[id]);
+      fflush(stderr);
+      exit(1);
+    }
+
+    fsparse->fp[id]     = fopen(fsparse->fname[id], "ab");
+    fsparse->fp_idx[id] = fopen(fsparse->fname_idx[id], "ab");
+    if (fsparse->fp[id] == NULL || fsparse->fp_idx[id] == NULL) {
+      fprintf(stderr,"Error: can't open sparse fault file %s to append\n", fsparse->fname[id]);
+      fflush(stderr);
+      exit(1);
+    }
+    fsparse->nbyte[id] = nbyte;
+    fsparse->num_of_frame[id] = num_of_frame;
+  }
+
+  fsparse->is_key = 1;
+
+  return 0;
+}
+
+/*
+ * runs of consecutive flagged points in j then k, and their indices in
+ *  pidx, return number of points
+ */
+
+int
+fault_sparse_pack(fault_sparse_t *fsparse, int *num_of_run)
+{
+  int  siz_slice    = fsparse->nj * fsparse->nk;
+  int  num_of_point = 0;
+  int  nrun = 0;
+  int *run  = fsparse->run;
+
+  for (int p=0; p < siz_slice; p++)
+  {
+    if (fsparse->flag[p] == 0) continue;
+    fsparse->pidx[num_of_point] = p;
+    num_of_point += 1;
+    if (nrun > 0 && run[2*nrun-2] + run[2*nrun-1] == p) {
+      run[2*nrun-1] += 1;
+    } else {
+      run[2*nrun  ] = p;
+      run[2*nrun+1] = 1;
+      nrun += 1;
+    }
+  }
+
+  *num_of_run = nrun;
+
+  return num_of_point;
+}
+
+/*
+ * frame of packed points with values in val [ncmp][num_of_point],
+ *  is_key is of this frame
+ */
+
+int
+fault_sparse_write(fault_sparse_t *fsparse, int id, int it, float time,
+                   int num_of_run, int num_of_point)
+{
+  FILE *fp     = fsparse->fp[id];
+  FILE *fp_idx = fsparse->fp_idx[id];
+  size_t nval  = (size_t)FAULT_SPARSE_NCMP * num_of_point;
+  long long offset = fsparse->nbyte[id];
+
+  int ierr = 0;
+  ierr += fwrite(&it,           sizeof(int),   1, fp) != 1;
+  ierr += fwrite(&time,         sizeof(float), 1, fp) != 1;
+  ierr += fwrite(&num_of_run,   sizeof(int),   1, fp) != 1;
+  ierr += fwrite(&num_of_point, sizeof(int),   1, fp) != 1;
+  ierr += fwrite(fsparse->run, sizeof(int), 2*num_of_run, fp) != 2*num_of_run;
+  ierr += fwrite(fsparse->val, sizeof(float), nval, fp) != nval;
+  // frame is on disk before its record
+  ierr += fflush(fp) != 0;
+  ierr += fwrite(&it,              sizeof(int),   1, fp_idx) != 1;
+  ierr += fwrite(&time,            sizeof(float), 1, fp_idx) != 1;
+  ierr += fwrite(&num_of_run,      sizeof(int),   1, fp_idx) != 1;
+  ierr += fwrite(&num_of_point,    sizeof(int),   1, fp_idx) != 1;
+  ierr += fwrite(&(fsparse->is_key), sizeof(int), 1, fp_idx) != 1;
+  ierr += fwrite(&offset,    sizeof(long long),   1, fp_idx) != 1;
+  ierr += fflush(fp_idx) != 0;
+  if (ierr != 0) {
+    fprintf(stderr,"Error: failed to write frame of it=%d to %s\n", it, fsparse->fname[id]);
+    fflush(stderr);
+    exit(1);
+  }
+
+  fsparse->nbyte[id] += FAULT_SPARSE_FRAME_NBYTE(num_of_run, num_of_point);
+  fsparse->num_of_frame[id] += 1;
+  fsparse->num_of_point_put += num_of_point;
+  fsparse->num_of_point_all += (double)fsparse->nj * fsparse->nk;
+
+  return 0;
+}
+
+#ifndef FAULT_SPARSE_HOST_ONLY
+/*
+ * points are flagged and last values updated on device, only flags and
+ *  values of written points are copied to host
+ */
+
+int
+fault_sparse_put(fault_sparse_t *fsparse, fault_t F_d, int it, float time)
+{
+  if (fsparse->enable == 0) return 0;
+
+  int nj = fsparse->nj;
+  int nk = fsparse->nk;
+  size_t siz_slice = (size_t)nj * nk;
+
+  dim3 block(8,8);
+  dim3 grid;
+  grid.x = (nj+block.x-1)/block.x;
+  grid.y = (nk+block.y-1)/block.y;
+
+  for (int id=0; id < fsparse->number_fault; id++)
+  {
+    fault_sparse_flag_gpu <<<grid, block>>> (nj, nk, fsparse->ny, id, F_d,
+                                             fsparse->siz_slice_yz,
+                                             fsparse->last_d[id], fsparse->flag_d,
+                                             fsparse->vs_threshold, fsparse->tolerance,
+                                             fsparse->is_key);
+    CUDACHECK(cudaMemcpy(fsparse->flag, fsparse->flag_d, sizeof(unsigned char)*siz_slice,
+                         cudaMemcpyDeviceToHost));
+
+    int num_of_run;
+    int num_of_point = fault_sparse_pack(fsparse, &num_of_run);
+
+    if (num_of_point > 0)
+    {
+      CUDACHECK(cudaMemcpy(fsparse->pidx_d, fsparse->pidx, sizeof(int)*num_of_point,
+                           cudaMemcpyHostToDevice));
+      dim3 block_g(256);
+      dim3 grid_g((num_of_point+block_g.x-1)/block_g.x);
+      fault_sparse_gather_gpu <<<grid_g, block_g>>> (num_of_point, siz_slice,
+                                                     fsparse->pidx_d, fsparse->last_d[id],
+                                                     fsparse->val_d);
+      CUDACHECK(cudaMemcpy(fsparse->val, fsparse->val_d,
+                           sizeof(float)*FAULT_SPARSE_NCMP*num_of_point,
+                           cudaMemcpyDeviceToHost));
+    }
+
+    fault_sparse_write(fsparse, id, it, time, num_of_run, num_of_point);
+  }
+
+  fsparse->is_key = 0;
+
+  return 0;
+}
+
+/*
+ * size of sparse files against dense frames of same number over all
+ *  threads, printed by thread 0
+ */
+
+int
+fault_sparse_close(fault_sparse_t *fsparse, MPI_Comm comm, int myid)
+{
+  if (fsparse->enable == 0) return 0;
+
+  size_t nbyte_frame = sizeof(float) * (1 + FAULT_SPARSE_NCMP * (size_t)fsparse->nj * fsparse->nk);
+
+  double val[4] = {0.0, 0.0, fsparse->num_of_point_put, fsparse->num_of_point_all};
+  for (int id=0; id < fsparse->number_fault; id++)
+  {
+    val[0] += (double) fsparse->nbyte[id]
+              + FAULT_SPARSE_IDX_HEAD_NBYTE
+              + (double) fsparse->num_of_frame[id] * FAULT_SPARSE_IDX_NBYTE;
+    val[1] += (double) fsparse->num_of_frame[id] * nbyte_frame;
+  }
+  double val_sum[4];
+  MPI_Reduce(val, val_sum, 4, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+  if (myid == 0)
+  {
+    fprintf(stdout,"sparse fault output: %d frames, %.3f MB for %.3f MB of dense frames,"
+                   " compression ratio %.2f\n",
+            fsparse->number_fault > 0 ? fsparse->num_of_frame[0] : 0,
+            val_sum[0] / 1.0e6, val_sum[1] / 1.0e6,
+            val_sum[0] > 0.0 ? val_sum[1] / val_sum[0] : 0.0);
+    fprintf(stdout,"  points written in this run: %.2f%%\n",
+            val_sum[3] > 0.0 ? 100.0 * val_sum[2] / val_sum[3] : 0.0);
+    fflush(stdout);
+  }
+
+  for (int id=0; id < fsparse->number_fault; id++)
+  {
+    if (fsparse->fp[id]     != NULL) fclose(fsparse->fp[id]);
+    if (fsparse->fp_idx[id] != NULL) fclose(fsparse->fp_idx[id]);
+    CUDACHECK(cudaFree(fsparse->last_d[id]));
+    free(fsparse->fname[id]);
+    free(fsparse->fname_idx[id]);
+  }
+  free(fsparse->fname);
+  free(fsparse->fname_idx);
+  free(fsparse->fp);
+  free(fsparse->fp_idx);
+  free(fsparse->nbyte);
+  free(fsparse->num_of_frame);
+  free(fsparse->last_d);
+
+  CUDACHECK(cudaFree(fsparse->flag_d));
+  CUDACHECK(cudaFree(fsparse->pidx_d));
+  CUDACHECK(cudaFree(fsparse->val_d));
+  free(fsparse->flag);
+  free(fsparse->pidx);
+  free(fsparse->run);
+  free(fsparse->val);
+
+  return 0;
+}
+
+/*
+ * flag of point j+k*nj, last values are set to current ones if flagged
+ */
+
+__global__ void
+fault_sparse_flag_gpu(int nj, int nk, int ny, int id, fault_t F,
+                      size_t siz_slice_yz, float *last, unsigned char *flag,
+                      float vs_threshold, float tolerance, int is_key)
+{
+  size_t iy = blockIdx.x * blockDim.x + threadIdx.x;
+  size_t iz = blockIdx.y * blockDim.y + threadIdx.y;
+  fault_one_t *F_thisone = F.fault_one + id;
+  if(iy < nj && iz < nk)
+  {
+    size_t siz_slice  = (size_t)nj * nk;
+    size_t iptr_slice = iy + iz*nj;
+    size_t iptr = (iy+3) + (iz+3) * ny;
+    float *output = F_thisone->output;
+
+    int is_put = is_key;
+    if (output[FAULT_SPARSE_VS*siz_slice_yz + iptr] > vs_threshold) is_put = 1;
+    for (int icmp=0; icmp < FAULT_SPARSE_NCMP; icmp++)
+    {
+      float v  = output[icmp*siz_slice_yz + iptr];
+      float v0 = last[icmp*siz_slice + iptr_slice];
+      if (fabsf(v - v0) > tolerance * fabsf(v0)) is_put = 1;
+    }
+
+    if (is_put == 1)
+    {
+      for (int icmp=0; icmp < FAULT_SPARSE_NCMP; icmp++) {
+        last[icmp*siz_slice + iptr_slice] = output[icmp*siz_slice_yz + iptr];
+      }
+    }
+    flag[iptr_slice] = (unsigned char) is_put;
+  }
+}
+
+__global__ void
+fault_sparse_gather_gpu(int num_of_point, size_t siz_slice, int *pidx,
+                        float *last, float *val)
+{
+  int ip = blockIdx.x * blockDim.x + threadIdx.x;
+  if (ip < num_of_point)
+  {
+    size_t iptr_slice = pidx[ip];
+    for (int icmp=0; icmp < FAULT_SPARSE_NCMP; icmp++) {
+      val[icmp*num_of_point + ip] = last[icmp*siz_slice + iptr_slice];
+    }
+  }
+}
+#endif
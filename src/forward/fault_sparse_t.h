@@ -0,0 +1,124 @@
+#ifndef FAULT_SPARSE_T_H
+#define FAULT_SPARSE_T_H
+
+#include <stdio.h>
+#ifndef FAULT_SPARSE_HOST_ONLY
+#include <mpi.h>
+
+#include "gd_t.h"
+#include "fault_info.h"
+#include "io_funcs.h"
+#endif
+
+/*************************************************
+ * event-driven sparse output of fault plane, instead of all points of
+ *  Tn, Ts1, Ts2, Vs, Vs1, Vs2, Slip, Slip1, Slip2 each io_time_skip.
+ *  a point is written with its 9 values if Vs > vs_threshold or any
+ *  value changed more than tolerance * |last written value| since it
+ *  was last written, tolerance 0 is lossless. first frame of a run and
+ *  of a restart writes all points (key frame).
+ *
+ *  data file, per fault and thread, next to the fault nc file:
+ *   header: magic, nj, nk, ncmp, i_index, topoid[3], vs_threshold,
+ *           tolerance, cmp_name[ncmp]
+ *   frame : it, time, num_of_run, num_of_point,
+ *           run[num_of_run][2] (first point j+k*nj, count),
+ *           val[ncmp][num_of_point]
+ *  index file, one record per frame to find frames without scanning:
+ *   header: magic
+ *   record: it, time, num_of_run, num_of_point, is_key, offset of frame
+ *
+ *  compile with -DFAULT_SPARSE_HOST_ONLY for files only, points are then
+ *  flagged and values set on host by the caller before pack and write
+ *************************************************/
+
+#define FAULT_SPARSE_MAGIC     "CGFDFSP1"
+#define FAULT_SPARSE_IDX_MAGIC "CGFDFSI1"
+#define FAULT_SPARSE_NCMP      9
+#define FAULT_SPARSE_NAME_STRLEN 8
+// component of slip rate
+#define FAULT_SPARSE_VS        3
+
+// bytes of headers, index record and frame
+#define FAULT_SPARSE_HEAD_NBYTE \
+  (8 + 7*sizeof(int) + 2*sizeof(float) + FAULT_SPARSE_NCMP*FAULT_SPARSE_NAME_STRLEN)
+#define FAULT_SPARSE_IDX_HEAD_NBYTE 8
+#define FAULT_SPARSE_IDX_NBYTE  (5*sizeof(int) + sizeof(long long))
+#define FAULT_SPARSE_FRAME_NBYTE(nrun,npoint) \
+  (4*sizeof(int) + 2*sizeof(int)*(size_t)(nrun) \
+   + FAULT_SPARSE_NCMP*sizeof(float)*(size_t)(npoint))
+
+typedef struct
+{
+  int enable;
+  int number_fault;
+
+  int nj, nk, ny;
+  size_t siz_slice_yz; // stride of components in fault output
+  int   *i_index;      // fault index with ghosts in this thread
+
+  float vs_threshold;
+  float tolerance;
+  int   is_key;        // next frame writes all points
+
+  char **fname;
+  char **fname_idx;
+  FILE **fp;
+  FILE **fp_idx;
+  long long *nbyte;    // size of data file
+  int   *num_of_frame; // frames in file
+
+  // last written values [ncmp][nk][nj] of each fault
+  float **last_d;
+  unsigned char *flag_d;
+  unsigned char *flag;
+  int   *pidx_d; // written points of frame
+  int   *pidx;
+  int   *run;
+  float *val_d;
+  float *val;
+
+  // points of this run, for summary
+  double num_of_point_put;
+  double num_of_point_all;
+} fault_sparse_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+fault_sparse_create(fault_sparse_t *fsparse, int *topoid);
+
+int
+fault_sparse_reopen(fault_sparse_t *fsparse, int it_start);
+
+int
+fault_sparse_pack(fault_sparse_t *fsparse, int *num_of_run);
+
+int
+fault_sparse_write(fault_sparse_t *fsparse, int id, int it, float time,
+                   int num_of_run, int num_of_point);
+
+#ifndef FAULT_SPARSE_HOST_ONLY
+int
+fault_sparse_init(fault_sparse_t *fsparse, iofault_t *iofault, gd_t *gd,
+                  int enable, float vs_threshold, float tolerance);
+
+int
+fault_sparse_put(fault_sparse_t *fsparse, fault_t F_d, int it, float time);
+
+int
+fault_sparse_close(fault_sparse_t *fsparse, MPI_Comm comm, int myid);
+
+__global__ void
+fault_sparse_flag_gpu(int nj, int nk, int ny, int id, fault_t F,
+                      size_t siz_slice_yz, float *last, unsigned char *flag,
+                      float vs_threshold, float tolerance, int is_key);
+
+__global__ void
+fault_sparse_gather_gpu(int num_of_point, size_t siz_slice, int *pidx,
+                        float *last, float *val);
+#endif
+
+#endif
@@ -16,6 +16,7 @@
 #include "fd_t.h"
 #include "gd_t.h"
 #include "constants.h"
+#include "cuda_common.h"
 
 int 
 gd_curv_init(gd_t *gd)
@@ -200,12 +201,21 @@ gd_curv_metric_init(gd_t        *gd,
   metric->cmp_pos  = cmp_pos;
   metric->cmp_name = cmp_name;
 
+  // stored metric by default
+  metric->is_recompute = 0;
+  metric->ni1 = gd->ni1;
+  metric->ni2 = gd->ni2;
+  metric->nj1 = gd->nj1;
+  metric->nj2 = gd->nj2;
+  metric->nk1 = gd->nk1;
+  metric->nk2 = gd->nk2;
+  metric->x3d = gd->x3d;
+  metric->y3d = gd->y3d;
+  metric->z3d = gd->z3d;
+
   return 0;
 }
 
-//
-// need to change to use fdlib_math.c
-//
 int
 gd_curv_metric_cal(gd_t    *gd,
                    gd_metric_t *metric)
@@ -216,12 +226,8 @@ gd_curv_metric_cal(gd_t    *gd,
   int nj2 = gd->nj2;
   int nk1 = gd->nk1;
   int nk2 = gd->nk2;
-  int nx  = gd->nx;
-  int ny  = gd->ny;
-  int nz  = gd->nz;
   size_t siz_iy   = gd->siz_iy;
   size_t siz_iz   = gd->siz_iz;
-  size_t siz_icmp = gd->siz_icmp;
 
   // point to each var
   float *x3d  = gd->x3d;
@@ -237,62 +243,29 @@ gd_curv_metric_cal(gd_t    *gd,
   float *zt_x = metric->zeta_x;
   float *zt_y = metric->zeta_y;
   float *zt_z = metric->zeta_z;
-  float *x3d_ptr;
-  float *y3d_ptr;
-  float *z3d_ptr; 
-  float x_xi, x_et, x_zt;
-  float y_xi, y_et, y_zt;
-  float z_xi, z_et, z_zt;
-  float jac;
-  float vec1[3], vec2[3], vec3[3], vecg[3];
 
+  // points are independent, rows of k-j are shared among threads
+  #pragma omp parallel for collapse(2) schedule(static)
   for (size_t k = nk1; k <= nk2; k++){
     for (size_t j = nj1; j <= nj2; j++) {
+      #pragma omp simd
       for (size_t i = ni1; i <= ni2; i++)
       {
         size_t iptr = i + j * siz_iy + k * siz_iz;
 
-        x_xi = 0.0; x_et = 0.0; x_zt = 0.0;
-        y_xi = 0.0; y_et = 0.0; y_zt = 0.0;
-        z_xi = 0.0; z_et = 0.0; z_zt = 0.0;
-
-        x3d_ptr = x3d + iptr;
-        y3d_ptr = y3d + iptr;
-        z3d_ptr = z3d + iptr;
-        M_FD_SHIFT_PTR_CENTER(x_xi, x3d_ptr, 1);
-        M_FD_SHIFT_PTR_CENTER(y_xi, y3d_ptr, 1);
-        M_FD_SHIFT_PTR_CENTER(z_xi, z3d_ptr, 1);
-
-        M_FD_SHIFT_PTR_CENTER(x_et, x3d_ptr, siz_iy);
-        M_FD_SHIFT_PTR_CENTER(y_et, y3d_ptr, siz_iy);
-        M_FD_SHIFT_PTR_CENTER(z_et, z3d_ptr, siz_iy);
-
-        M_FD_SHIFT_PTR_CENTER(x_zt, x3d_ptr, siz_iz);
-        M_FD_SHIFT_PTR_CENTER(y_zt, y3d_ptr, siz_iz);
-        M_FD_SHIFT_PTR_CENTER(z_zt, z3d_ptr, siz_iz);
-
-        vec1[0] = x_xi; vec1[1] = y_xi; vec1[2] = z_xi;
-        vec2[0] = x_et; vec2[1] = y_et; vec2[2] = z_et;
-        vec3[0] = x_zt; vec3[1] = y_zt; vec3[2] = z_zt;
-
-        fdlib_math_cross_product(vec1, vec2, vecg);
-        jac = fdlib_math_dot_product(vecg, vec3);
-        jac3d[iptr]  = jac;
-
-        fdlib_math_cross_product(vec2, vec3, vecg);
-        xi_x[iptr] = vecg[0] / jac;
-        xi_y[iptr] = vecg[1] / jac;
-        xi_z[iptr] = vecg[2] / jac;
-
-        fdlib_math_cross_product(vec3, vec1, vecg);
-        et_x[iptr] = vecg[0] / jac;
-        et_y[iptr] = vecg[1] / jac;
-        et_z[iptr] = vecg[2] / jac;
-
-        fdlib_math_cross_product(vec1, vec2, vecg);
-        zt_x[iptr] = vecg[0] / jac;
-        zt_y[iptr] = vecg[1] / jac;
-        zt_z[iptr] = vecg[2] / jac;
+        // same point func as recompute mode in kernels
+        gd_metric_pt_t mt = gd_metric_point(x3d, y3d, z3d, iptr, siz_iy, siz_iz);
+
+        jac3d[iptr] = mt.jac;
+        xi_x[iptr]  = mt.xi_x;
+        xi_y[iptr]  = mt.xi_y;
+        xi_z[iptr]  = mt.xi_z;
+        et_x[iptr]  = mt.eta_x;
+        et_y[iptr]  = mt.eta_y;
+        et_z[iptr]  = mt.eta_z;
+        zt_x[iptr]  = mt.zeta_x;
+        zt_y[iptr]  = mt.zeta_y;
+        zt_z[iptr]  = mt.zeta_z;
       }
     }
   }
@@ -303,6 +276,159 @@ gd_curv_metric_cal(gd_t    *gd,
   return 0;
 }
 
+/*
+ * sum of metric of a slab, to time load vs recompute
+ */
+
+__global__ void
+gd_metric_bench_gpu(gd_metric_t metric_d, size_t iptr_beg, size_t num_of_pt,
+                    float *sum_d)
+{
+  size_t n = blockIdx.x * blockDim.x + threadIdx.x;
+  if (n >= num_of_pt) return;
+
+  // stored slab starts at 0
+  size_t iptr = (metric_d.is_recompute == 1) ? iptr_beg + n : n;
+  gd_metric_pt_t mt = gd_metric_get(&metric_d, iptr);
+
+  sum_d[n] = mt.jac + mt.xi_x + mt.xi_y + mt.xi_z
+                    + mt.eta_x + mt.eta_y + mt.eta_z
+                    + mt.zeta_x + mt.zeta_y + mt.zeta_z;
+}
+
+/*
+ * memory saved by recompute mode, and cost of it on a slab of k-planes
+ *  measured on host and device against the stored metric
+ */
+
+int
+gd_metric_recompute_report(gd_metric_t *metric, gd_metric_t *metric_d,
+                           MPI_Comm comm, int myid)
+{
+  if (metric_d->is_recompute == 0) return 0;
+
+  int nk_slab = 4;
+  if (nk_slab > metric->nk2 - metric->nk1 + 1) nk_slab = metric->nk2 - metric->nk1 + 1;
+
+  size_t iptr_beg  = metric->nk1 * metric->siz_iz;
+  size_t num_of_pt = nk_slab * metric->siz_iz;
+
+  // stored slab on host and device, same view as full metric
+  gd_metric_t slab   = *metric;
+  gd_metric_t slab_d = *metric;
+  slab.is_recompute   = 0;
+  slab_d.is_recompute = 0;
+
+  float *v_h[10] = {metric->jac,   metric->xi_x,  metric->xi_y,  metric->xi_z,
+                    metric->eta_x, metric->eta_y, metric->eta_z,
+                    metric->zeta_x,metric->zeta_y,metric->zeta_z};
+  float *v_d[10];
+  for (int n=0; n<10; n++)
+  {
+    v_d[n] = (float *) cuda_malloc(sizeof(float)*num_of_pt);
+    CUDACHECK(cudaMemcpy(v_d[n], v_h[n] + iptr_beg, sizeof(float)*num_of_pt,
+                         cudaMemcpyHostToDevice));
+  }
+  slab_d.jac    = v_d[0];
+  slab_d.xi_x   = v_d[1]; slab_d.xi_y  = v_d[2]; slab_d.xi_z  = v_d[3];
+  slab_d.eta_x  = v_d[4]; slab_d.eta_y = v_d[5]; slab_d.eta_z = v_d[6];
+  slab_d.zeta_x = v_d[7]; slab_d.zeta_y= v_d[8]; slab_d.zeta_z= v_d[9];
+
+  // host
+  gd_metric_t recomp = *metric;
+  recomp.is_recompute = 1;
+
+  double t_load, t_comp, t0;
+  float  sum_load = 0.0, sum_comp = 0.0, err_max = 0.0;
+
+  t0 = MPI_Wtime();
+  for (size_t iptr = iptr_beg; iptr < iptr_beg + num_of_pt; iptr++) {
+    gd_metric_pt_t mt = gd_metric_get(&slab, iptr);
+    sum_load += mt.jac + mt.xi_x + mt.eta_y + mt.zeta_z;
+  }
+  t_load = MPI_Wtime() - t0;
+
+  t0 = MPI_Wtime();
+  for (size_t iptr = iptr_beg; iptr < iptr_beg + num_of_pt; iptr++) {
+    gd_metric_pt_t mt = gd_metric_get(&recomp, iptr);
+    sum_comp += mt.jac + mt.xi_x + mt.eta_y + mt.zeta_z;
+  }
+  t_comp = MPI_Wtime() - t0;
+
+  // recomputed values should be same as stored ones
+  for (size_t iptr = iptr_beg; iptr < iptr_beg + num_of_pt; iptr++) {
+    gd_metric_pt_t mt = gd_metric_get(&recomp, iptr);
+    float err = fabs(mt.jac - metric->jac[iptr]) / (fabs(metric->jac[iptr]) + 1.0e-30);
+    if (err > err_max) err_max = err;
+  }
+
+  // device
+  float *sum_d = (float *) cuda_malloc(sizeof(float)*num_of_pt);
+  cudaEvent_t ev_beg, ev_end;
+  float t_load_dev = 0.0, t_comp_dev = 0.0;
+  CUDACHECK(cudaEventCreate(&ev_beg));
+  CUDACHECK(cudaEventCreate(&ev_end));
+
+  dim3 block(256);
+  dim3 grid((num_of_pt + block.x - 1) / block.x);
+
+  // warm up
+  gd_metric_bench_gpu <<<grid, block>>> (*metric_d, iptr_beg, num_of_pt, sum_d);
+
+  CUDACHECK(cudaEventRecord(ev_beg, 0));
+  gd_metric_bench_gpu <<<grid, block>>> (slab_d, iptr_beg, num_of_pt, sum_d);
+  CUDACHECK(cudaEventRecord(ev_end, 0));
+  CUDACHECK(cudaEventSynchronize(ev_end));
+  CUDACHECK(cudaEventElapsedTime(&t_load_dev, ev_beg, ev_end));
+
+  CUDACHECK(cudaEventRecord(ev_beg, 0));
+  gd_metric_bench_gpu <<<grid, block>>> (*metric_d, iptr_beg, num_of_pt, sum_d);
+  CUDACHECK(cudaEventRecord(ev_end, 0));
+  CUDACHECK(cudaEventSynchronize(ev_end));
+  CUDACHECK(cudaEventElapsedTime(&t_comp_dev, ev_beg, ev_end));
+
+  CUDACHECK(cudaEventDestroy(ev_beg));
+  CUDACHECK(cudaEventDestroy(ev_end));
+  CUDACHECK(cudaFree(sum_d));
+  for (int n=0; n<10; n++) {
+    CUDACHECK(cudaFree(v_d[n]));
+  }
+
+  // 10 metric vars replaced by 3 coords on device
+  double val_loc[8], val_all[8];
+  val_loc[0] = (double) metric->siz_icmp * 10 * sizeof(float);
+  val_loc[1] = (double) metric->siz_icmp * 3  * sizeof(float);
+  val_loc[2] = 1.0e9 * t_load / num_of_pt;
+  val_loc[3] = 1.0e9 * t_comp / num_of_pt;
+  val_loc[4] = 1.0e6 * t_load_dev / num_of_pt;
+  val_loc[5] = 1.0e6 * t_comp_dev / num_of_pt;
+  val_loc[6] = sum_load;
+  val_loc[7] = sum_comp;
+
+  float err_all;
+  MPI_Reduce(val_loc,   val_all,   2, MPI_DOUBLE, MPI_SUM, 0, comm);
+  MPI_Reduce(val_loc+2, val_all+2, 4, MPI_DOUBLE, MPI_MAX, 0, comm);
+  MPI_Reduce(val_loc+6, val_all+6, 2, MPI_DOUBLE, MPI_SUM, 0, comm);
+  MPI_Reduce(&err_max, &err_all, 1, MPI_FLOAT, MPI_MAX, 0, comm);
+
+  if (myid == 0)
+  {
+    fprintf(stdout,"metric recomputed from coords:\n");
+    fprintf(stdout,"  device memory %f MB -> %f MB, saved %f MB\n",
+            val_all[0] / 1048576.0, val_all[1] / 1048576.0,
+            (val_all[0] - val_all[1]) / 1048576.0);
+    fprintf(stdout,"  host   ns per point: load %f, recompute %f\n",
+            val_all[2], val_all[3]);
+    fprintf(stdout,"  device ns per point: load %f, recompute %f\n",
+            val_all[4], val_all[5]);
+    fprintf(stdout,"  max relative diff of jac on host %e, checksum %e %e\n",
+            err_all, val_all[6], val_all[7]);
+    fflush(stdout);
+  }
+
+  return 0;
+}
+
 //
 // exchange metics/coords/media
 //
@@ -398,11 +524,44 @@ gd_exchange(gd_t *gd,
   return 0;
 }
 
+/*
+ * distance of n cells away from fault along x, spacing is dh within
+ *  uniform_cells, then grows smoothly up to max_factor * dh
+ */
+
+float
+gd_stretch_offset(int n, float dh, gd_stretch_t *stretch)
+{
+  if (stretch == NULL || stretch->itype == CONST_STRETCH_NONE) {
+    return n * dh;
+  }
+
+  double L = 0.0;
+  for (int m = 1; m <= n; m++)
+  {
+    double fac = 1.0;
+    int m1 = m - stretch->uniform_cells;
+    if (m1 > 0)
+    {
+      if (stretch->itype == CONST_STRETCH_GEOMETRIC) {
+        fac = pow(stretch->ratio, m1);
+        if (fac > stretch->max_factor) fac = stretch->max_factor;
+      } else {
+        fac = 1.0 + (stretch->max_factor - 1.0) * tanh(m1 / stretch->width);
+      }
+    }
+    L += fac * dh;
+  }
+
+  return (float) L;
+}
+
 int
 gd_curv_gen_fault(gd_t *gd,
                   int number_fault,
                   int *fault_x_index,
                   float dh,
+                  gd_stretch_t *stretch,
                   char *fault_coord_dir)
 {
   int nx = gd->nx;
@@ -433,6 +592,12 @@ gd_curv_gen_fault(gd_t *gd,
   float *fault_y = (float *) malloc(sizeof(float)*nj*nk);
   float *fault_z = (float *) malloc(sizeof(float)*nj*nk);
 
+  // x offset from fault by number of cells, x is not split by mpi
+  float *xoff = (float *) malloc(sizeof(float)*nx);
+  for (int n = 0; n < nx; n++) {
+    xoff[n] = gd_stretch_offset(n, dh, stretch);
+  }
+
   int i0, i1; 
   float x, y, z;
   float dhx, dhy, dhz;
@@ -450,7 +615,7 @@ gd_curv_gen_fault(gd_t *gd,
       for (int j = nj1; j <= nj2; j++){
         for (int i = ni1; i <= ni2; i++){
 
-          float x = fault_x[j-3 + (k-3) * nj] + (i-i0)*dh;
+          float x = fault_x[j-3 + (k-3) * nj] + (i >= i0 ? 1 : -1) * xoff[abs(i-i0)];
           float y = fault_y[j-3 + (k-3) * nj];
           float z = fault_z[j-3 + (k-3) * nj];
           //float x = fault_x[j-3 + (k-3) * nj] + (i-i0)*dh;
@@ -483,7 +648,7 @@ gd_curv_gen_fault(gd_t *gd,
         //left region
         for (int i = ni1; i <= i0; i++){
           iptr = i + j * siz_iy + k * siz_iz;
-          x3d[iptr] = x - (i0-i)*dh;
+          x3d[iptr] = x - xoff[i0-i];
           y3d[iptr] = y;
           z3d[iptr] = z;
         }
@@ -527,7 +692,7 @@ gd_curv_gen_fault(gd_t *gd,
         //right region
         for (int i = i1+1; i <= ni2; i++){
           iptr = i + j * siz_iy + k * siz_iz;
-          x3d[iptr] = x + (i-i1)*dh;
+          x3d[iptr] = x + xoff[i-i1];
           y3d[iptr] = y;
           z3d[iptr] = z;
         }
@@ -540,6 +705,41 @@ gd_curv_gen_fault(gd_t *gd,
   free(fault_x);
   free(fault_y);
   free(fault_z);
+  free(xoff);
+
+  return 0;
+}
+
+/*
+ * x points used vs uniform dh over same x extent
+ */
+
+int
+gd_curv_stretch_report(gd_t *gd, int number_fault, int *fault_x_index,
+                       float dh, gd_stretch_t *stretch, int myid)
+{
+  if (stretch->itype == CONST_STRETCH_NONE || myid != 0) return 0;
+
+  // global x index without ghost, same on all threads
+  int n_left  = fault_x_index[0];
+  int n_right = gd->total_point_x - 1 - fault_x_index[number_fault-1];
+  int n_mid   = fault_x_index[number_fault-1] - fault_x_index[0];
+
+  float L_left  = gd_stretch_offset(n_left,  dh, stretch);
+  float L_right = gd_stretch_offset(n_right, dh, stretch);
+
+  int ni_uniform = (int) ceil(L_left / dh) + (int) ceil(L_right / dh) + n_mid + 1;
+  double npt = (double) gd->total_point_y * gd->total_point_z;
+
+  fprintf(stdout,"stretched x spacing, uniform within %d cells of faults:\n",
+          stretch->uniform_cells);
+  fprintf(stdout,"  x extent left %f m, right %f m, outer spacing %f m\n",
+          L_left, L_right,
+          gd_stretch_offset(n_right, dh, stretch) - gd_stretch_offset(n_right-1, dh, stretch));
+  fprintf(stdout,"  x points %d, uniform dh needs %d, total points %e -> %e, reduced %f%%\n",
+          gd->total_point_x, ni_uniform, npt * ni_uniform, npt * gd->total_point_x,
+          100.0 * (1.0 - (double) gd->total_point_x / ni_uniform));
+  fflush(stdout);
 
   return 0;
 }
@@ -678,77 +878,84 @@ geometric_symmetry(gd_t *gd,float *v4d, int ncmp)
   size_t siz_iz  = gd->siz_iz;
   size_t siz_icmp  = gd->siz_icmp;
 
-  size_t iptr, iptr1, iptr2, iptr3; 
+  // ghosts of one side are never read while setting that side,
+  // so k-j rows of each side are parallel
   for(int icmp=0; icmp<ncmp; icmp++){
-    iptr = icmp * siz_icmp;
+    size_t iptr = icmp * siz_icmp;
     // x1 
+    #pragma omp parallel for collapse(2) schedule(static)
     for (size_t k = 0; k < nz; k++){
       for (size_t j = 0; j < ny; j++){
         for (size_t i = 0; i < ni1; i++)
         {
-          iptr1 = iptr + i + j * siz_iy + k * siz_iz;
-          iptr2 = iptr + ni1 + j * siz_iy + k * siz_iz;
-          iptr3 = iptr + (2*ni1-i) + j * siz_iy + k * siz_iz;
+          size_t iptr1 = iptr + i + j * siz_iy + k * siz_iz;
+          size_t iptr2 = iptr + ni1 + j * siz_iy + k * siz_iz;
+          size_t iptr3 = iptr + (2*ni1-i) + j * siz_iy + k * siz_iz;
           v4d[iptr1] = 2*v4d[iptr2] - v4d[iptr3];
         }
       }
     }
     // x2
+    #pragma omp parallel for collapse(2) schedule(static)
     for (size_t k = 0; k < nz; k++){
       for (size_t j = 0; j < ny; j++){
         for (size_t i = ni2+1; i < nx; i++)
         {
-          iptr1 = iptr + i + j * siz_iy + k * siz_iz;
-          iptr2 = iptr + ni2 + j * siz_iy + k * siz_iz;
-          iptr3 = iptr + (2*ni2-i) + j * siz_iy + k * siz_iz;
+          size_t iptr1 = iptr + i + j * siz_iy + k * siz_iz;
+          size_t iptr2 = iptr + ni2 + j * siz_iy + k * siz_iz;
+          size_t iptr3 = iptr + (2*ni2-i) + j * siz_iy + k * siz_iz;
           v4d[iptr1] = 2*v4d[iptr2] - v4d[iptr3];
         }
       }
     }
     // y1 
+    #pragma omp parallel for collapse(2) schedule(static)
     for (size_t k = 0; k < nz; k++){
       for (size_t j = 0; j < nj1; j++){
         for (size_t i = 0; i < nx; i++)
         {
-          iptr1 = iptr + i + j * siz_iy + k * siz_iz;
-          iptr2 = iptr + i + nj1 * siz_iy + k * siz_iz;
-          iptr3 = iptr + i + (2*nj1-j) * siz_iy + k * siz_iz;
+          size_t iptr1 = iptr + i + j * siz_iy + k * siz_iz;
+          size_t iptr2 = iptr + i + nj1 * siz_iy + k * siz_iz;
+          size_t iptr3 = iptr + i + (2*nj1-j) * siz_iy + k * siz_iz;
           v4d[iptr1] = 2*v4d[iptr2] - v4d[iptr3];
         }
       }
     }
     // y2 
+    #pragma omp parallel for collapse(2) schedule(static)
     for (size_t k = 0; k < nz; k++){
       for (size_t j = nj2+1; j < ny; j++){
         for (size_t i = 0; i < nx; i++)
         {
-          iptr1 = iptr + i + j * siz_iy + k * siz_iz;
-          iptr2 = iptr + i + nj2 * siz_iy + k * siz_iz;
-          iptr3 = iptr + i + (2*nj2-j) * siz_iy + k * siz_iz;
+          size_t iptr1 = iptr + i + j * siz_iy + k * siz_iz;
+          size_t iptr2 = iptr + i + nj2 * siz_iy + k * siz_iz;
+          size_t iptr3 = iptr + i + (2*nj2-j) * siz_iy + k * siz_iz;
           v4d[iptr1] = 2*v4d[iptr2] - v4d[iptr3];
         }
       }
     }
     // z1
+    #pragma omp parallel for collapse(2) schedule(static)
     for (size_t k = 0; k < nk1; k++){
       for (size_t j = 0; j < ny; j++){
         for (size_t i = 0; i < nx; i++)
         {
-          iptr1 = iptr + i + j * siz_iy + k * siz_iz;
-          iptr2 = iptr + i + j * siz_iy + nk1 * siz_iz;
-          iptr3 = iptr + i + j * siz_iy + (2*nk1-k) * siz_iz;
+          size_t iptr1 = iptr + i + j * siz_iy + k * siz_iz;
+          size_t iptr2 = iptr + i + j * siz_iy + nk1 * siz_iz;
+          size_t iptr3 = iptr + i + j * siz_iy + (2*nk1-k) * siz_iz;
           v4d[iptr1] = 2*v4d[iptr2] - v4d[iptr3];
         }
       }
     }
     // z2
+    #pragma omp parallel for collapse(2) schedule(static)
     for (size_t k = nk2+1; k < nz; k++) {
       for (size_t j = 0; j < ny; j++){
         for (size_t i = 0; i < nx; i++)
         {
-          iptr1 = iptr + i + j * siz_iy + k * siz_iz;
-          iptr2 = iptr + i + j * siz_iy + nk2 * siz_iz;
-          iptr3 = iptr + i + j * siz_iy + (2*nk2-k) * siz_iz;
+          size_t iptr1 = iptr + i + j * siz_iy + k * siz_iz;
+          size_t iptr2 = iptr + i + j * siz_iy + nk2 * siz_iz;
+          size_t iptr3 = iptr + i + j * siz_iy + (2*nk2-k) * siz_iz;
           v4d[iptr1] = 2*v4d[iptr2] - v4d[iptr3];
         }
       }
@@ -1069,23 +1276,96 @@ gd_curv_metric_import(gd_t *gd, gd_metric_t *metric, char *fname_coords, char *i
   return 0;
 }
 
+/*
+ * min/max of n values of a row, last one kept for equal values
+ */
+static inline void
+gd_row_minmax(const float *v, size_t n, float *vmin, float *vmax)
+{
+  float a = v[0];
+  float b = v[0];
+  for (size_t i = 0; i < n; i++) {
+    a = a < v[i] ? a : v[i];
+    b = b > v[i] ? b : v[i];
+  }
+  *vmin = a;
+  *vmax = b;
+}
+
+/*
+ * min/max of 8 corners of n cells along a row of one coord var,
+ *  pairs are merged in the order of corners k, j, i
+ */
+static inline void
+gd_cell_minmax(const float *__restrict__ v, float *__restrict__ vmin,
+               float *__restrict__ vmax,
+               size_t n, size_t siz_iy, size_t siz_iz)
+{
+  const float *v0 = v;
+  const float *v1 = v + siz_iy;
+  const float *v2 = v + siz_iz;
+  const float *v3 = v + siz_iz + siz_iy;
+
+  #pragma omp simd
+  for (size_t i = 0; i < n; i++)
+  {
+    float a0 = v0[i] < v0[i+1] ? v0[i] : v0[i+1];
+    float a1 = v1[i] < v1[i+1] ? v1[i] : v1[i+1];
+    float a2 = v2[i] < v2[i+1] ? v2[i] : v2[i+1];
+    float a3 = v3[i] < v3[i+1] ? v3[i] : v3[i+1];
+    a0 = a0 < a1 ? a0 : a1;
+    a2 = a2 < a3 ? a2 : a3;
+    vmin[i] = a0 < a2 ? a0 : a2;
+
+    float b0 = v0[i] > v0[i+1] ? v0[i] : v0[i+1];
+    float b1 = v1[i] > v1[i+1] ? v1[i] : v1[i+1];
+    float b2 = v2[i] > v2[i+1] ? v2[i] : v2[i+1];
+    float b3 = v3[i] > v3[i+1] ? v3[i] : v3[i+1];
+    b0 = b0 > b1 ? b0 : b1;
+    b2 = b2 > b3 ? b2 : b3;
+    vmax[i] = b0 > b2 ? b0 : b2;
+  }
+}
+
 /*
  * set min/max of grid for loc
  */
 int
 gd_curv_set_minmax(gd_t *gd)
 {
+  float *x3d = gd->x3d;
+  float *y3d = gd->y3d;
+  float *z3d = gd->z3d;
+  size_t siz_iy = gd->siz_iy;
+  size_t siz_iz = gd->siz_iz;
+
+  // min/max of each row in parallel, then rows in order. the ternary
+  //  keeps the last of equal values (e.g. -0 and 0), so the ordered
+  //  merge gives the same bits as one serial pass
+  size_t num_of_row = (size_t) gd->ny * gd->nz;
+  float *row_minmax = (float *) malloc(num_of_row * 6 * sizeof(float));
+
   // all points including ghosts
-  float xmin = gd->x3d[0], xmax = gd->x3d[0];
-  float ymin = gd->y3d[0], ymax = gd->y3d[0];
-  float zmin = gd->z3d[0], zmax = gd->z3d[0];
-  for (size_t i = 0; i < gd->siz_icmp; i++){
-      xmin = xmin < gd->x3d[i] ? xmin : gd->x3d[i];
-      xmax = xmax > gd->x3d[i] ? xmax : gd->x3d[i];
-      ymin = ymin < gd->y3d[i] ? ymin : gd->y3d[i];
-      ymax = ymax > gd->y3d[i] ? ymax : gd->y3d[i];
-      zmin = zmin < gd->z3d[i] ? zmin : gd->z3d[i];
-      zmax = zmax > gd->z3d[i] ? zmax : gd->z3d[i];
+  #pragma omp parallel for schedule(static)
+  for (size_t n = 0; n < num_of_row; n++)
+  {
+    size_t iptr = n * siz_iy;
+    gd_row_minmax(x3d+iptr, gd->nx, row_minmax+6*n+0, row_minmax+6*n+1);
+    gd_row_minmax(y3d+iptr, gd->nx, row_minmax+6*n+2, row_minmax+6*n+3);
+    gd_row_minmax(z3d+iptr, gd->nx, row_minmax+6*n+4, row_minmax+6*n+5);
+  }
+  float xmin = x3d[0], xmax = x3d[0];
+  float ymin = y3d[0], ymax = y3d[0];
+  float zmin = z3d[0], zmax = z3d[0];
+  for (size_t n = 0; n < num_of_row; n++)
+  {
+    float *v = row_minmax + 6 * n;
+    xmin = xmin < v[0] ? xmin : v[0];
+    xmax = xmax > v[1] ? xmax : v[1];
+    ymin = ymin < v[2] ? ymin : v[2];
+    ymax = ymax > v[3] ? ymax : v[3];
+    zmin = zmin < v[4] ? zmin : v[4];
+    zmax = zmax > v[5] ? zmax : v[5];
   }
   gd->xmin = xmin;
   gd->xmax = xmax;
@@ -1095,24 +1375,32 @@ gd_curv_set_minmax(gd_t *gd)
   gd->zmax = zmax;
 
   // all physics points without ghosts
+  num_of_row = (size_t) gd->nj * gd->nk;
+  #pragma omp parallel for schedule(static)
+  for (size_t n = 0; n < num_of_row; n++)
+  {
+    size_t j = gd->nj1 + n % gd->nj;
+    size_t k = gd->nk1 + n / gd->nj;
+    size_t iptr = gd->ni1 + j * siz_iy + k * siz_iz;
+    gd_row_minmax(x3d+iptr, gd->ni, row_minmax+6*n+0, row_minmax+6*n+1);
+    gd_row_minmax(y3d+iptr, gd->ni, row_minmax+6*n+2, row_minmax+6*n+3);
+    gd_row_minmax(z3d+iptr, gd->ni, row_minmax+6*n+4, row_minmax+6*n+5);
+  }
   xmin = gd->xmax;
   xmax = gd->xmin;
   ymin = gd->ymax;
   ymax = gd->ymin;
   zmin = gd->zmax;
   zmax = gd->zmin;
-  for (int k = gd->nk1; k <= gd->nk2; k++) {
-    for (int j = gd->nj1; j <= gd->nj2; j++) {
-      for (int i = gd->ni1; i <= gd->ni2; i++) {
-         size_t iptr = i + j * gd->siz_iy + k * gd->siz_iz;
-         xmin = xmin < gd->x3d[iptr] ? xmin : gd->x3d[iptr];
-         xmax = xmax > gd->x3d[iptr] ? xmax : gd->x3d[iptr];
-         ymin = ymin < gd->y3d[iptr] ? ymin : gd->y3d[iptr];
-         ymax = ymax > gd->y3d[iptr] ? ymax : gd->y3d[iptr];
-         zmin = zmin < gd->z3d[iptr] ? zmin : gd->z3d[iptr];
-         zmax = zmax > gd->z3d[iptr] ? zmax : gd->z3d[iptr];
-      }
-    }
+  for (size_t n = 0; n < num_of_row; n++)
+  {
+    float *v = row_minmax + 6 * n;
+    xmin = xmin < v[0] ? xmin : v[0];
+    xmax = xmax > v[1] ? xmax : v[1];
+    ymin = ymin < v[2] ? ymin : v[2];
+    ymax = ymax > v[3] ? ymax : v[3];
+    zmin = zmin < v[4] ? zmin : v[4];
+    zmax = zmax > v[5] ? zmax : v[5];
   }
   gd->xmin_phy = xmin;
   gd->xmax_phy = xmax;
@@ -1121,37 +1409,26 @@ gd_curv_set_minmax(gd_t *gd)
   gd->zmin_phy = zmin;
   gd->zmax_phy = zmax;
 
+  free(row_minmax);
+
   // set cell range, last cell along each dim unusage
-  for (int k = 0; k < gd->nz-1; k++) {
-    for (int j = 0; j < gd->ny-1; j++) {
-      for (int i = 0; i < gd->nx-1; i++) {
-         size_t iptr = i + j * gd->siz_iy + k * gd->siz_iz;
-         xmin = gd->x3d[iptr];
-         ymin = gd->y3d[iptr];
-         zmin = gd->z3d[iptr];
-         xmax = xmin;
-         ymax = ymin;
-         zmax = zmin;
-         for (int n3=0; n3<2; n3++) {
-         for (int n2=0; n2<2; n2++) {
-         for (int n1=0; n1<2; n1++) {
-           size_t iptr_pt = iptr + n3 * gd->siz_iz + n2 * gd->siz_iy + n1;
-           xmin = xmin < gd->x3d[iptr_pt] ? xmin : gd->x3d[iptr_pt];
-           xmax = xmax > gd->x3d[iptr_pt] ? xmax : gd->x3d[iptr_pt];
-           ymin = ymin < gd->y3d[iptr_pt] ? ymin : gd->y3d[iptr_pt];
-           ymax = ymax > gd->y3d[iptr_pt] ? ymax : gd->y3d[iptr_pt];
-           zmin = zmin < gd->z3d[iptr_pt] ? zmin : gd->z3d[iptr_pt];
-           zmax = zmax > gd->z3d[iptr_pt] ? zmax : gd->z3d[iptr_pt];
-         }
-         }
-         }
-         gd->cell_xmin[iptr] = xmin;
-         gd->cell_xmax[iptr] = xmax;
-         gd->cell_ymin[iptr] = ymin;
-         gd->cell_ymax[iptr] = ymax;
-         gd->cell_zmin[iptr] = zmin;
-         gd->cell_zmax[iptr] = zmax;
-      }
+  //  one pass per var keeps the i loop a plain stream of loads for simd
+  float *cell_xmin = gd->cell_xmin;
+  float *cell_xmax = gd->cell_xmax;
+  float *cell_ymin = gd->cell_ymin;
+  float *cell_ymax = gd->cell_ymax;
+  float *cell_zmin = gd->cell_zmin;
+  float *cell_zmax = gd->cell_zmax;
+  #pragma omp parallel for collapse(2) schedule(static)
+  for (size_t k = 0; k < gd->nz-1; k++) {
+    for (size_t j = 0; j < gd->ny-1; j++) {
+      size_t iptr_j = j * siz_iy + k * siz_iz;
+      gd_cell_minmax(x3d+iptr_j, cell_xmin+iptr_j, cell_xmax+iptr_j,
+                     gd->nx-1, siz_iy, siz_iz);
+      gd_cell_minmax(y3d+iptr_j, cell_ymin+iptr_j, cell_ymax+iptr_j,
+                     gd->nx-1, siz_iy, siz_iz);
+      gd_cell_minmax(z3d+iptr_j, cell_zmin+iptr_j, cell_zmax+iptr_j,
+                     gd->nx-1, siz_iy, siz_iz);
     }
   }
 
@@ -1176,56 +1453,65 @@ gd_curv_set_minmax(gd_t *gd)
     if (k_tile < nz_left) {
       gd->tile_kend[k_tile] += 1;
     }
+  }
+  for (int j_tile = 0; j_tile < GD_TILE_NY; j_tile++)
+  {
+    if (j_tile == 0) {
+      gd->tile_jstart[j_tile] = gd->nj1;
+    } else {
+      gd->tile_jstart[j_tile] = gd->tile_jend[j_tile-1] + 1;
+    }
 
-    for (int j_tile = 0; j_tile < GD_TILE_NY; j_tile++)
-    {
-      if (j_tile == 0) {
-        gd->tile_jstart[j_tile] = gd->nj1;
-      } else {
-        gd->tile_jstart[j_tile] = gd->tile_jend[j_tile-1] + 1;
-      }
+    gd->tile_jend  [j_tile] = gd->tile_jstart[j_tile] + ny_avg -1;
+    if (j_tile < ny_left) {
+      gd->tile_jend[j_tile] += 1;
+    }
+  }
+  for (int i_tile = 0; i_tile < GD_TILE_NX; i_tile++)
+  {
+    if (i_tile == 0) {
+      gd->tile_istart[i_tile] = gd->ni1;
+    } else {
+      gd->tile_istart[i_tile] = gd->tile_iend[i_tile-1] + 1;
+    }
 
-      gd->tile_jend  [j_tile] = gd->tile_jstart[j_tile] + ny_avg -1;
-      if (j_tile < ny_left) {
-        gd->tile_jend[j_tile] += 1;
-      }
+    gd->tile_iend  [i_tile] = gd->tile_istart[i_tile] + nx_avg -1;
+    if (i_tile < nx_left) {
+      gd->tile_iend[i_tile] += 1;
+    }
+  }
 
+  // each tile is reduced by one thread
+  #pragma omp parallel for collapse(3) schedule(dynamic)
+  for (int k_tile = 0; k_tile < GD_TILE_NZ; k_tile++)
+  {
+    for (int j_tile = 0; j_tile < GD_TILE_NY; j_tile++)
+    {
       for (int i_tile = 0; i_tile < GD_TILE_NX; i_tile++)
       {
-        if (i_tile == 0) {
-          gd->tile_istart[i_tile] = gd->ni1;
-        } else {
-          gd->tile_istart[i_tile] = gd->tile_iend[i_tile-1] + 1;
-        }
-
-        gd->tile_iend  [i_tile] = gd->tile_istart[i_tile] + nx_avg -1;
-        if (i_tile < nx_left) {
-          gd->tile_iend[i_tile] += 1;
-        }
-
         // use large value to init
-        xmin = 1.0e26;
-        ymin = 1.0e26;
-        zmin = 1.0e26;
-        xmax = -1.0e26;
-        ymax = -1.0e26;
-        zmax = -1.0e26;
+        float xmin = 1.0e26;
+        float ymin = 1.0e26;
+        float zmin = 1.0e26;
+        float xmax = -1.0e26;
+        float ymax = -1.0e26;
+        float zmax = -1.0e26;
         // for cells in each tile
         for (int k = gd->tile_kstart[k_tile]; k <= gd->tile_kend[k_tile]; k++)
         {
-          size_t iptr_k = k * gd->siz_iz;
+          size_t iptr_k = k * siz_iz;
           for (int j = gd->tile_jstart[j_tile]; j <= gd->tile_jend[j_tile]; j++)
           {
-            size_t iptr_j = iptr_k + j * gd->siz_iy;
+            size_t iptr_j = iptr_k + j * siz_iy;
             for (int i = gd->tile_istart[i_tile]; i <= gd->tile_iend[i_tile]; i++)
             {
               size_t iptr = i + iptr_j;
-              xmin = xmin < gd->cell_xmin[iptr] ? xmin : gd->cell_xmin[iptr];
-              xmax = xmax > gd->cell_xmax[iptr] ? xmax : gd->cell_xmax[iptr];
-              ymin = ymin < gd->cell_ymin[iptr] ? ymin : gd->cell_ymin[iptr];
-              ymax = ymax > gd->cell_ymax[iptr] ? ymax : gd->cell_ymax[iptr];
-              zmin = zmin < gd->cell_zmin[iptr] ? zmin : gd->cell_zmin[iptr];
-              zmax = zmax > gd->cell_zmax[iptr] ? zmax : gd->cell_zmax[iptr];
+              xmin = xmin < cell_xmin[iptr] ? xmin : cell_xmin[iptr];
+              xmax = xmax > cell_xmax[iptr] ? xmax : cell_xmax[iptr];
+              ymin = ymin < cell_ymin[iptr] ? ymin : cell_ymin[iptr];
+              ymax = ymax > cell_ymax[iptr] ? ymax : cell_ymax[iptr];
+              zmin = zmin < cell_zmin[iptr] ? zmin : cell_zmin[iptr];
+              zmax = zmax > cell_zmax[iptr] ? zmax : cell_zmax[iptr];
             }
           }
         }
@@ -110,8 +110,208 @@ typedef struct {
 
   size_t *cmp_pos;
   char  **cmp_name;
+
+  // 1: only coords are kept, metric is derived from them at each use
+  int is_recompute;
+  int ni1, ni2;
+  int nj1, nj2;
+  int nk1, nk2;
+  float *x3d; // pointer to coords
+  float *y3d;
+  float *z3d;
 } gd_metric_t;
 
+// stretched x spacing of grid generated from fault plane
+typedef struct {
+  int   itype;         // CONST_STRETCH_*
+  int   uniform_cells; // cells of uniform dh on each side of faults
+  float ratio;         // geometric: growth of spacing per cell
+  float width;         // tanh: cells of transition
+  float max_factor;    // max spacing / dh
+} gd_stretch_t;
+
+// metric of one point
+typedef struct {
+  float jac;
+  float xi_x, xi_y, xi_z;
+  float eta_x, eta_y, eta_z;
+  float zeta_x, zeta_y, zeta_z;
+} gd_metric_pt_t;
+
+
+/*************************************************
+ * metric of one point, used by kernels in both stored and recompute mode
+ *************************************************/
+
+/*
+ * center difference of coords, same coef as M_FD_SHIFT_PTR_CENTER
+ */
+__host__ __device__ inline float
+gd_metric_fd_center(float *var_ptr, size_t stride)
+{
+  return   (-0.01666667 * *(var_ptr - 3*stride))
+         + ( 0.15000000 * *(var_ptr - 2*stride))
+         + (-0.75000000 * *(var_ptr - stride))
+         + ( 0.75000000 * *(var_ptr + stride))
+         + (-0.15000000 * *(var_ptr + 2*stride))
+         + ( 0.01666667 * *(var_ptr + 3*stride));
+}
+
+/*
+ * metric of interior point from coords
+ */
+__host__ __device__ inline gd_metric_pt_t
+gd_metric_point(float *x3d, float *y3d, float *z3d,
+                size_t iptr, size_t siz_iy, size_t siz_iz)
+{
+  gd_metric_pt_t mt;
+
+  float x_xi = gd_metric_fd_center(x3d + iptr, 1);
+  float y_xi = gd_metric_fd_center(y3d + iptr, 1);
+  float z_xi = gd_metric_fd_center(z3d + iptr, 1);
+
+  float x_et = gd_metric_fd_center(x3d + iptr, siz_iy);
+  float y_et = gd_metric_fd_center(y3d + iptr, siz_iy);
+  float z_et = gd_metric_fd_center(z3d + iptr, siz_iy);
+
+  float x_zt = gd_metric_fd_center(x3d + iptr, siz_iz);
+  float y_zt = gd_metric_fd_center(y3d + iptr, siz_iz);
+  float z_zt = gd_metric_fd_center(z3d + iptr, siz_iz);
+
+  // vec_xi x vec_et
+  float g_x = y_xi * z_et - z_xi * y_et;
+  float g_y = z_xi * x_et - x_xi * z_et;
+  float g_z = x_xi * y_et - y_xi * x_et;
+
+  float jac = 0.0;
+  jac += g_x * x_zt;
+  jac += g_y * y_zt;
+  jac += g_z * z_zt;
+  mt.jac = jac;
+
+  // vec_et x vec_zt
+  mt.xi_x = (y_et * z_zt - z_et * y_zt) / jac;
+  mt.xi_y = (z_et * x_zt - x_et * z_zt) / jac;
+  mt.xi_z = (x_et * y_zt - y_et * x_zt) / jac;
+
+  // vec_zt x vec_xi
+  mt.eta_x = (y_zt * z_xi - z_zt * y_xi) / jac;
+  mt.eta_y = (z_zt * x_xi - x_zt * z_xi) / jac;
+  mt.eta_z = (x_zt * y_xi - y_zt * x_xi) / jac;
+
+  mt.zeta_x = g_x / jac;
+  mt.zeta_y = g_y / jac;
+  mt.zeta_z = g_z / jac;
+
+  return mt;
+}
+
+/*
+ * 2*a - b, extrapolation of geometric_symmetry
+ */
+__host__ __device__ inline gd_metric_pt_t
+gd_metric_extrap(gd_metric_pt_t a, gd_metric_pt_t b)
+{
+  gd_metric_pt_t mt;
+
+  mt.jac    = 2*a.jac    - b.jac;
+  mt.xi_x   = 2*a.xi_x   - b.xi_x;
+  mt.xi_y   = 2*a.xi_y   - b.xi_y;
+  mt.xi_z   = 2*a.xi_z   - b.xi_z;
+  mt.eta_x  = 2*a.eta_x  - b.eta_x;
+  mt.eta_y  = 2*a.eta_y  - b.eta_y;
+  mt.eta_z  = 2*a.eta_z  - b.eta_z;
+  mt.zeta_x = 2*a.zeta_x - b.zeta_x;
+  mt.zeta_y = 2*a.zeta_y - b.zeta_y;
+  mt.zeta_z = 2*a.zeta_z - b.zeta_z;
+
+  return mt;
+}
+
+/*
+ * ghost points follow the order of geometric_symmetry: x, then y, then z
+ */
+__host__ __device__ inline gd_metric_pt_t
+gd_metric_point_x(gd_metric_t *m, int i, int j, int k)
+{
+  size_t iptr_jk = j * m->siz_iy + k * m->siz_iz;
+
+  if (i < m->ni1 || i > m->ni2)
+  {
+    int i0 = (i < m->ni1) ? m->ni1 : m->ni2;
+    return gd_metric_extrap(
+             gd_metric_point(m->x3d, m->y3d, m->z3d, i0 + iptr_jk,
+                             m->siz_iy, m->siz_iz),
+             gd_metric_point(m->x3d, m->y3d, m->z3d, (2*i0-i) + iptr_jk,
+                             m->siz_iy, m->siz_iz));
+  }
+
+  return gd_metric_point(m->x3d, m->y3d, m->z3d, i + iptr_jk,
+                         m->siz_iy, m->siz_iz);
+}
+
+__host__ __device__ inline gd_metric_pt_t
+gd_metric_point_y(gd_metric_t *m, int i, int j, int k)
+{
+  if (j < m->nj1 || j > m->nj2)
+  {
+    int j0 = (j < m->nj1) ? m->nj1 : m->nj2;
+    return gd_metric_extrap(gd_metric_point_x(m, i, j0, k),
+                            gd_metric_point_x(m, i, 2*j0-j, k));
+  }
+
+  return gd_metric_point_x(m, i, j, k);
+}
+
+__host__ __device__ inline gd_metric_pt_t
+gd_metric_point_z(gd_metric_t *m, int i, int j, int k)
+{
+  if (k < m->nk1 || k > m->nk2)
+  {
+    int k0 = (k < m->nk1) ? m->nk1 : m->nk2;
+    return gd_metric_extrap(gd_metric_point_y(m, i, j, k0),
+                            gd_metric_point_y(m, i, j, 2*k0-k));
+  }
+
+  return gd_metric_point_y(m, i, j, k);
+}
+
+/*
+ * metric at iptr, loaded if stored, else derived from coords
+ */
+__host__ __device__ inline gd_metric_pt_t
+gd_metric_get(gd_metric_t *m, size_t iptr)
+{
+  gd_metric_pt_t mt;
+
+  if (m->is_recompute == 0)
+  {
+    mt.jac    = m->jac   [iptr];
+    mt.xi_x   = m->xi_x  [iptr];
+    mt.xi_y   = m->xi_y  [iptr];
+    mt.xi_z   = m->xi_z  [iptr];
+    mt.eta_x  = m->eta_x [iptr];
+    mt.eta_y  = m->eta_y [iptr];
+    mt.eta_z  = m->eta_z [iptr];
+    mt.zeta_x = m->zeta_x[iptr];
+    mt.zeta_y = m->zeta_y[iptr];
+    mt.zeta_z = m->zeta_z[iptr];
+    return mt;
+  }
+
+  int i = iptr % m->siz_iy;
+  int j = (iptr / m->siz_iy) % m->ny;
+  int k = iptr / m->siz_iz;
+
+  if (   i >= m->ni1 && i <= m->ni2
+      && j >= m->nj1 && j <= m->nj2
+      && k >= m->nk1 && k <= m->nk2)
+  {
+    return gd_metric_point(m->x3d, m->y3d, m->z3d, iptr, m->siz_iy, m->siz_iz);
+  }
+
+  return gd_metric_point_z(m, i, j, k);
+}
 
 /*************************************************
  * function prototype
@@ -127,6 +327,14 @@ int
 gd_curv_metric_cal(gd_t    *gd,
                    gd_metric_t *metric);
 
+int
+gd_metric_recompute_report(gd_metric_t *metric, gd_metric_t *metric_d,
+                           MPI_Comm comm, int myid);
+
+__global__ void
+gd_metric_bench_gpu(gd_metric_t metric_d, size_t iptr_beg, size_t num_of_pt,
+                    float *sum_d);
+
 int
 gd_exchange(gd_t *gd,
             float *g3d,
@@ -140,13 +348,21 @@ mirror_symmetry(gd_t *gd, float *v4d, int ncmp);
 int
 geometric_symmetry(gd_t *gd, float *v4d, int ncmp);
 
+float
+gd_stretch_offset(int n, float dh, gd_stretch_t *stretch);
+
 int
 gd_curv_gen_fault(gd_t *gd,
                   int  number_fault, 
                   int  *fault_x_index,
                   float dh,
+                  gd_stretch_t *stretch,
                   char *fault_coord_dir);
 
+int
+gd_curv_stretch_report(gd_t *gd, int number_fault, int *fault_x_index,
+                       float dh, gd_stretch_t *stretch, int myid);
+
 int
 nc_read_fault_geometry(float *fault_x, float *fault_y, float *fault_z, 
                        char *in_grid_fault_nc, gd_t *gd);
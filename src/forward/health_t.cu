@@ -0,0 +1,625 @@
+/*******************************************************************************
+ * in-situ health monitor: NaN/Inf, max |V| and energy of wavefield
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "constants.h"
+#include "health_t.h"
+#include "cuda_common.h"
+
+#define HEALTH_BLOCK_SIZE 256
+
+/*
+ * key of max |V|, positive float keeps order of its bits.
+ *  index of the max is found by a second pass, so it is not limited to 32 bits
+ */
+
+__host__ __device__ static unsigned long long
+health_vmax_key(float v)
+{
+  unsigned int vbits;
+  memcpy(&vbits, &v, sizeof(float));
+  return (unsigned long long) vbits;
+}
+
+__host__ __device__ static float
+health_key_to_vmax(unsigned long long key)
+{
+  unsigned int vbits = (unsigned int) key;
+  float v;
+  memcpy(&v, &vbits, sizeof(float));
+  return v;
+}
+
+/*
+ * values of one point: return 1 if any component is NaN/Inf
+ *  ek = 0.5 rho |V|^2 jac
+ *  es = 1/(4 mu) [T:T - lam/(3 lam + 2 mu) tr(T)^2] jac, tr(T)^2/(18 lam) jac for fluid
+ */
+
+__host__ __device__ static int
+health_point(float *w, size_t iptr, size_t siz_icmp, int ncmp,
+             size_t Vx_pos, size_t Vy_pos, size_t Vz_pos,
+             size_t Txx_pos, size_t Tyy_pos, size_t Tzz_pos,
+             size_t Tyz_pos, size_t Txz_pos, size_t Txy_pos,
+             float slw, float lam, float mu, float jac, int has_media,
+             float *vabs, double *ek, double *es)
+{
+  for (int icmp=0; icmp < ncmp; icmp++) {
+    if (!isfinite(w[icmp*siz_icmp + iptr])) return 1;
+  }
+
+  float Vx = w[Vx_pos + iptr];
+  float Vy = w[Vy_pos + iptr];
+  float Vz = w[Vz_pos + iptr];
+  float v2 = Vx*Vx + Vy*Vy + Vz*Vz;
+
+  *vabs = sqrtf(v2);
+  *ek   = 0.0;
+  *es   = 0.0;
+
+  if (has_media == 0) return 0;
+
+  if (slw > 0.0) *ek = 0.5 * v2 / slw * jac;
+
+  float Txx = w[Txx_pos + iptr];
+  float Tyy = w[Tyy_pos + iptr];
+  float Tzz = w[Tzz_pos + iptr];
+  float Tyz = w[Tyz_pos + iptr];
+  float Txz = w[Txz_pos + iptr];
+  float Txy = w[Txy_pos + iptr];
+
+  double trs = (double) Txx + Tyy + Tzz;
+  double ss  = (double) Txx*Txx + (double) Tyy*Tyy + (double) Tzz*Tzz
+             + 2.0 * ((double) Tyz*Tyz + (double) Txz*Txz + (double) Txy*Txy);
+
+  if (mu > 0.0) {
+    *es = (ss - lam / (3.0*lam + 2.0*mu) * trs * trs) / (4.0 * mu) * jac;
+  } else if (lam > 0.0) {
+    *es = trs * trs / (18.0 * lam) * jac;
+  }
+
+  return 0;
+}
+
+/*
+ * combine values of two threads, used as MPI_Op
+ */
+
+static void
+health_val_op(void *in, void *inout, int *len, MPI_Datatype *dtype)
+{
+  double *a = (double *) in;
+  double *b = (double *) inout;
+
+  for (int n=0; n < *len; n++)
+  {
+    b[HEALTH_NAN]       += a[HEALTH_NAN];
+    b[HEALTH_FAULT_NAN] += a[HEALTH_FAULT_NAN];
+    b[HEALTH_EK]        += a[HEALTH_EK];
+    b[HEALTH_ES]        += a[HEALTH_ES];
+
+    if (a[HEALTH_VMAX] > b[HEALTH_VMAX]) {
+      for (int i=HEALTH_VMAX; i <= HEALTH_VMAX_K; i++) b[i] = a[i];
+    }
+    if (a[HEALTH_FAULT_VMAX] > b[HEALTH_FAULT_VMAX]) {
+      b[HEALTH_FAULT_VMAX] = a[HEALTH_FAULT_VMAX];
+    }
+
+    a += HEALTH_NUM_VAL;
+    b += HEALTH_NUM_VAL;
+  }
+}
+
+int
+health_init(health_t *health, int check_every, float max_velocity, int use_host,
+            int myid, char *output_dir)
+{
+  health->enable       = (check_every > 0) ? 1 : 0;
+  health->check_every  = check_every;
+  health->use_host     = use_host;
+  health->max_velocity = max_velocity;
+  health->myid         = myid;
+  health->fp           = NULL;
+  health->red_d        = NULL;
+  health->energy_d     = NULL;
+  health->resid        = NULL;
+
+  for (int i=0; i < HEALTH_NUM_VAL; i++) health->val[i] = 0.0;
+
+  if (health->enable == 0) return 0;
+
+  if (use_host == 0)
+  {
+    health->red_d    = (unsigned long long *) cuda_malloc(sizeof(unsigned long long)*HEALTH_NUM_RED);
+    health->energy_d = (double *) cuda_malloc(sizeof(double)*2);
+  }
+
+  MPI_Type_contiguous(HEALTH_NUM_VAL, MPI_DOUBLE, &(health->val_type));
+  MPI_Type_commit(&(health->val_type));
+  MPI_Op_create(health_val_op, 1, &(health->val_op));
+
+  if (myid == 0)
+  {
+    char ou_file[CONST_MAX_STRLEN];
+    sprintf(ou_file, "%s/health.txt", output_dir);
+    health->fp = fopen(ou_file, "w");
+    if (health->fp == NULL) {
+      fprintf(stderr,"Error: can't create health file %s\n", ou_file);
+      fflush(stderr);
+      exit(1);
+    }
+    fprintf(health->fp, "# it t nan fault_nan vmax rank gi gj gk fault_vmax ek es etotal\n");
+  }
+
+  return 0;
+}
+
+/*
+ * local values by device reduction
+ */
+
+int
+health_cal_device(health_t *health, float *w_d, float *f_d,
+                  gd_t *gd, gd_t gd_d, wav_t *wav, fault_wav_t *FW,
+                  md_t md_d, gd_metric_t metric_d, double *val)
+{
+  unsigned long long red[HEALTH_NUM_RED];
+  double energy[2];
+
+  CUDACHECK(cudaMemset(health->red_d, 0, sizeof(unsigned long long)*HEALTH_NUM_RED));
+  CUDACHECK(cudaMemset(health->red_d + HEALTH_RED_VMAX_IPTR, 0xff, sizeof(unsigned long long)));
+  CUDACHECK(cudaMemset(health->energy_d, 0, sizeof(double)*2));
+
+  // only iso media has energy
+  float *lam3d = NULL;
+  float *mu3d  = NULL;
+  if (md_d.medium_type == CONST_MEDIUM_ELASTIC_ISO) {
+    lam3d = md_d.lambda;
+    mu3d  = md_d.mu;
+  }
+
+  {
+    size_t siz_vol = (size_t) gd->ni * gd->nj * gd->nk;
+    dim3 block(HEALTH_BLOCK_SIZE);
+    dim3 grid;
+    grid.x = (siz_vol + block.x - 1) / block.x;
+    if (grid.x > 4096) grid.x = 4096;
+    health_wav_gpu <<<grid, block>>> (w_d, *wav, gd_d,
+                                      md_d.rho, lam3d, mu3d,
+                                      md_d.mat_id, md_d.mat_nbyte, metric_d,
+                                      health->red_d, health->energy_d);
+    // first point of max |V|, same as host loop
+    health_vmax_loc_gpu <<<grid, block>>> (w_d, *wav, gd_d, health->red_d);
+  }
+
+  if (FW->number_fault > 0)
+  {
+    size_t siz_slice = (size_t) gd->nj * gd->nk;
+    dim3 block(HEALTH_BLOCK_SIZE);
+    dim3 grid;
+    grid.x = (siz_slice + block.x - 1) / block.x;
+    health_fault_gpu <<<grid, block>>> (f_d, FW->ncmp, FW->siz_ilevel, FW->number_fault,
+                                        FW->Vx_pos, FW->Vy_pos, FW->Vz_pos,
+                                        gd_d, health->red_d);
+  }
+
+  CUDACHECK(cudaMemcpy(red, health->red_d, sizeof(unsigned long long)*HEALTH_NUM_RED,
+                       cudaMemcpyDeviceToHost));
+  CUDACHECK(cudaMemcpy(energy, health->energy_d, sizeof(double)*2,
+                       cudaMemcpyDeviceToHost));
+
+  // no finite point
+  size_t iptr = 0;
+  if (red[HEALTH_RED_VMAX_IPTR] != ~0ULL) iptr = (size_t) red[HEALTH_RED_VMAX_IPTR];
+
+  val[HEALTH_NAN]        = (double) red[HEALTH_RED_NAN];
+  val[HEALTH_FAULT_NAN]  = (double) red[HEALTH_RED_FAULT_NAN];
+  val[HEALTH_EK]         = energy[0];
+  val[HEALTH_ES]         = energy[1];
+  val[HEALTH_VMAX]       = health_key_to_vmax(red[HEALTH_RED_VMAX]);
+  val[HEALTH_VMAX_RANK]  = health->myid;
+  val[HEALTH_VMAX_I]     = (double) (iptr % gd->siz_iy - gd->ni1 + gd->gni1);
+  val[HEALTH_VMAX_J]     = (double) ((iptr % gd->siz_iz) / gd->siz_iy - gd->nj1 + gd->gnj1);
+  val[HEALTH_VMAX_K]     = (double) (iptr / gd->siz_iz - gd->nk1 + gd->gnk1);
+  val[HEALTH_FAULT_VMAX] = health_key_to_vmax(red[HEALTH_RED_FAULT_VMAX]);
+
+  return 0;
+}
+
+/*
+ * local values by serial loop of host arrays, same as device
+ */
+
+int
+health_cal_host(float *w, float *f,
+                gd_t *gd, wav_t *wav, fault_wav_t *FW,
+                md_t *md, gd_metric_t *metric, double *val)
+{
+  int has_media = (md->medium_type == CONST_MEDIUM_ELASTIC_ISO) ? 1 : 0;
+
+  double nan_count = 0.0;
+  double ek_sum = 0.0;
+  double es_sum = 0.0;
+  float  vmax = 0.0;
+  size_t iptr_vmax = 0;
+
+  for (int k = gd->nk1; k <= gd->nk2; k++) {
+    for (int j = gd->nj1; j <= gd->nj2; j++) {
+      for (int i = gd->ni1; i <= gd->ni2; i++)
+      {
+        size_t iptr = i + j * gd->siz_iy + k * gd->siz_iz;
+        size_t iptr_md = md_mat_iptr(md->mat_id, md->mat_nbyte, iptr);
+        float  vabs;
+        double ek, es;
+        int is_nan = health_point(w, iptr, wav->siz_icmp, wav->ncmp,
+                        wav->Vx_pos, wav->Vy_pos, wav->Vz_pos,
+                        wav->Txx_pos, wav->Tyy_pos, wav->Tzz_pos,
+                        wav->Tyz_pos, wav->Txz_pos, wav->Txy_pos,
+                        md->rho[iptr_md],
+                        has_media ? md->lambda[iptr_md] : 0.0,
+                        has_media ? md->mu[iptr_md] : 0.0,
+                        metric->jac[iptr], has_media,
+                        &vabs, &ek, &es);
+        if (is_nan == 1) {
+          nan_count += 1.0;
+          continue;
+        }
+        if (vabs > vmax) {
+          vmax = vabs;
+          iptr_vmax = iptr;
+        }
+        ek_sum += ek;
+        es_sum += es;
+      }
+    }
+  }
+
+  double fault_nan = 0.0;
+  float  fault_vmax = 0.0;
+  size_t siz_slice_yz = FW->siz_slice_yz;
+  for (int id=0; id < FW->number_fault; id++)
+  {
+    float *f_thisone = f + id * FW->siz_ilevel;
+    for (int k = gd->nk1; k <= gd->nk2; k++) {
+      for (int j = gd->nj1; j <= gd->nj2; j++)
+      {
+        size_t iptr_f = j + k * gd->ny;
+        for (int ivar=0; ivar < 2*FW->ncmp; ivar++) {
+          if (!isfinite(f_thisone[iptr_f + ivar * siz_slice_yz])) fault_nan += 1.0;
+        }
+        // minus and plus side
+        for (int iside=0; iside < 2; iside++)
+        {
+          size_t iptr_s = iptr_f + iside * siz_slice_yz;
+          float Vx = f_thisone[FW->Vx_pos + iptr_s];
+          float Vy = f_thisone[FW->Vy_pos + iptr_s];
+          float Vz = f_thisone[FW->Vz_pos + iptr_s];
+          float vabs = sqrtf(Vx*Vx + Vy*Vy + Vz*Vz);
+          if (vabs > fault_vmax) fault_vmax = vabs;
+        }
+      }
+    }
+  }
+
+  val[HEALTH_NAN]        = nan_count;
+  val[HEALTH_FAULT_NAN]  = fault_nan;
+  val[HEALTH_EK]         = ek_sum;
+  val[HEALTH_ES]         = es_sum;
+  val[HEALTH_VMAX]       = vmax;
+  val[HEALTH_VMAX_I]     = (double) (iptr_vmax % gd->siz_iy - gd->ni1 + gd->gni1);
+  val[HEALTH_VMAX_J]     = (double) ((iptr_vmax % gd->siz_iz) / gd->siz_iy - gd->nj1 + gd->gnj1);
+  val[HEALTH_VMAX_K]     = (double) (iptr_vmax / gd->siz_iz - gd->nk1 + gd->gnk1);
+  val[HEALTH_FAULT_VMAX] = fault_vmax;
+
+  return 0;
+}
+
+/*
+ * check at this step, return 1 if run should stop. all threads get same
+ *  global values so they stop together
+ */
+
+int
+health_check(health_t *health, int it, float t,
+             float *w_d, float *f_d,
+             gd_t *gd, gd_t gd_d, wav_t *wav, fault_wav_t *FW,
+             md_t *md, md_t md_d, gd_metric_t *metric, gd_metric_t metric_d,
+             MPI_Comm comm)
+{
+  if (health->enable == 0 || it % health->check_every != 0) return 0;
+
+  double val[HEALTH_NUM_VAL];
+
+  if (health->use_host == 1)
+  {
+    // host media and metric may be released after upload
+    if (health->resid != NULL) {
+      resid_get(health->resid, md->v4d);
+      resid_get(health->resid, metric->v4d);
+    }
+    // level 0 of host arrays is used as buffer
+    CUDACHECK(cudaMemcpy(wav->v5d, w_d, sizeof(float)*wav->siz_ilevel,
+                         cudaMemcpyDeviceToHost));
+    CUDACHECK(cudaMemcpy(FW->v5d, f_d, sizeof(float)*FW->siz_ilevel*FW->number_fault,
+                         cudaMemcpyDeviceToHost));
+    health_cal_host(wav->v5d, FW->v5d, gd, wav, FW, md, metric, val);
+    val[HEALTH_VMAX_RANK] = health->myid;
+  }
+  else
+  {
+    health_cal_device(health, w_d, f_d, gd, gd_d, wav, FW, md_d, metric_d, val);
+  }
+
+  MPI_Allreduce(val, health->val, 1, health->val_type, health->val_op, comm);
+
+  double *g = health->val;
+
+  if (health->myid == 0)
+  {
+    fprintf(health->fp, "%d %g %.0f %.0f %g %d %d %d %d %g %g %g %g\n",
+            it, t, g[HEALTH_NAN], g[HEALTH_FAULT_NAN],
+            g[HEALTH_VMAX], (int) g[HEALTH_VMAX_RANK],
+            (int) g[HEALTH_VMAX_I], (int) g[HEALTH_VMAX_J], (int) g[HEALTH_VMAX_K],
+            g[HEALTH_FAULT_VMAX], g[HEALTH_EK], g[HEALTH_ES],
+            g[HEALTH_EK] + g[HEALTH_ES]);
+    fflush(health->fp);
+  }
+
+  int is_stop = 0;
+
+  if (g[HEALTH_NAN] > 0.0 || g[HEALTH_FAULT_NAN] > 0.0)
+  {
+    if (health->myid == 0) {
+      fprintf(stderr,"ERROR: %.0f NaN/Inf points in wavefield and %.0f in fault at it=%d, t=%g\n",
+              g[HEALTH_NAN], g[HEALTH_FAULT_NAN], it, t);
+    }
+    is_stop = 1;
+  }
+
+  float vmax = g[HEALTH_VMAX] > g[HEALTH_FAULT_VMAX] ? g[HEALTH_VMAX] : g[HEALTH_FAULT_VMAX];
+  if (health->max_velocity > 0.0 && vmax > health->max_velocity)
+  {
+    if (health->myid == 0) {
+      fprintf(stderr,"ERROR: max |V|=%g (fault %g) exceeds %g at it=%d, t=%g,"
+                     " thread %d global index (%d,%d,%d)\n",
+              g[HEALTH_VMAX], g[HEALTH_FAULT_VMAX], health->max_velocity, it, t,
+              (int) g[HEALTH_VMAX_RANK],
+              (int) g[HEALTH_VMAX_I], (int) g[HEALTH_VMAX_J], (int) g[HEALTH_VMAX_K]);
+    }
+    is_stop = 1;
+  }
+
+  if (is_stop == 1 && health->myid == 0) {
+    fprintf(stderr,"ERROR: stop time loop, see health.txt in output dir\n");
+    fflush(stderr);
+  }
+
+  return is_stop;
+}
+
+int
+health_free(health_t *health)
+{
+  if (health->enable == 0) return 0;
+
+  if (health->red_d    != NULL) CUDACHECK(cudaFree(health->red_d));
+  if (health->energy_d != NULL) CUDACHECK(cudaFree(health->energy_d));
+  if (health->fp != NULL) fclose(health->fp);
+
+  MPI_Op_free(&(health->val_op));
+  MPI_Type_free(&(health->val_type));
+
+  health->enable = 0;
+
+  return 0;
+}
+
+/*
+ * volume reduction, one atomic per block
+ */
+
+__global__ void
+health_wav_gpu(float *w, wav_t wav_d, gd_t gd_d,
+               float *slw3d, float *lam3d, float *mu3d,
+               void *mat_id, int mat_nbyte, gd_metric_t metric_d,
+               unsigned long long *red_d, double *energy_d)
+{
+  __shared__ unsigned long long s_nan[HEALTH_BLOCK_SIZE];
+  __shared__ unsigned long long s_key[HEALTH_BLOCK_SIZE];
+  __shared__ double s_ek[HEALTH_BLOCK_SIZE];
+  __shared__ double s_es[HEALTH_BLOCK_SIZE];
+
+  int ni = gd_d.ni;
+  int nj = gd_d.nj;
+  int nk = gd_d.nk;
+  size_t siz_vol = (size_t) ni * nj * nk;
+  int has_media = (lam3d != NULL) ? 1 : 0;
+
+  unsigned long long nan_count = 0;
+  unsigned long long key = 0;
+  double ek_sum = 0.0;
+  double es_sum = 0.0;
+
+  for (size_t n = blockIdx.x * blockDim.x + threadIdx.x; n < siz_vol;
+       n += (size_t) gridDim.x * blockDim.x)
+  {
+    size_t i = n % ni;
+    size_t j = (n / ni) % nj;
+    size_t k = n / ((size_t) ni * nj);
+    size_t iptr = (i + gd_d.ni1) + (j + gd_d.nj1) * gd_d.siz_iy + (k + gd_d.nk1) * gd_d.siz_iz;
+    size_t iptr_md = md_mat_iptr(mat_id, mat_nbyte, iptr);
+
+    float  vabs;
+    double ek, es;
+    int is_nan = health_point(w, iptr, wav_d.siz_icmp, wav_d.ncmp,
+                    wav_d.Vx_pos, wav_d.Vy_pos, wav_d.Vz_pos,
+                    wav_d.Txx_pos, wav_d.Tyy_pos, wav_d.Tzz_pos,
+                    wav_d.Tyz_pos, wav_d.Txz_pos, wav_d.Txy_pos,
+                    slw3d[iptr_md],
+                    has_media ? lam3d[iptr_md] : 0.0,
+                    has_media ? mu3d[iptr_md]  : 0.0,
+                    gd_metric_get(&metric_d, iptr).jac, has_media,
+                    &vabs, &ek, &es);
+    if (is_nan == 1) {
+      nan_count += 1;
+      continue;
+    }
+    unsigned long long key_this = health_vmax_key(vabs);
+    if (key_this > key) key = key_this;
+    ek_sum += ek;
+    es_sum += es;
+  }
+
+  int tid = threadIdx.x;
+  s_nan[tid] = nan_count;
+  s_key[tid] = key;
+  s_ek [tid] = ek_sum;
+  s_es [tid] = es_sum;
+  __syncthreads();
+
+  for (int s = blockDim.x / 2; s > 0; s >>= 1)
+  {
+    if (tid < s) {
+      s_nan[tid] += s_nan[tid + s];
+      if (s_key[tid + s] > s_key[tid]) s_key[tid] = s_key[tid + s];
+      s_ek [tid] += s_ek [tid + s];
+      s_es [tid] += s_es [tid + s];
+    }
+    __syncthreads();
+  }
+
+  if (tid == 0)
+  {
+    atomicAdd(red_d + HEALTH_RED_NAN, s_nan[0]);
+    atomicMax(red_d + HEALTH_RED_VMAX, s_key[0]);
+    atomicAdd(energy_d + 0, s_ek[0]);
+    atomicAdd(energy_d + 1, s_es[0]);
+  }
+}
+
+/*
+ * min index of finite points whose |V| is the max of first pass
+ */
+
+__global__ void
+health_vmax_loc_gpu(float *w, wav_t wav_d, gd_t gd_d, unsigned long long *red_d)
+{
+  __shared__ unsigned long long s_iptr[HEALTH_BLOCK_SIZE];
+
+  int ni = gd_d.ni;
+  int nj = gd_d.nj;
+  int nk = gd_d.nk;
+  size_t siz_vol = (size_t) ni * nj * nk;
+  unsigned long long key_max = red_d[HEALTH_RED_VMAX];
+
+  unsigned long long iptr_min = ~0ULL;
+
+  for (size_t n = blockIdx.x * blockDim.x + threadIdx.x; n < siz_vol;
+       n += (size_t) gridDim.x * blockDim.x)
+  {
+    size_t i = n % ni;
+    size_t j = (n / ni) % nj;
+    size_t k = n / ((size_t) ni * nj);
+    size_t iptr = (i + gd_d.ni1) + (j + gd_d.nj1) * gd_d.siz_iy + (k + gd_d.nk1) * gd_d.siz_iz;
+
+    // no media, only |V|
+    float  vabs;
+    double ek, es;
+    int is_nan = health_point(w, iptr, wav_d.siz_icmp, wav_d.ncmp,
+                    wav_d.Vx_pos, wav_d.Vy_pos, wav_d.Vz_pos,
+                    wav_d.Txx_pos, wav_d.Tyy_pos, wav_d.Tzz_pos,
+                    wav_d.Tyz_pos, wav_d.Txz_pos, wav_d.Txy_pos,
+                    0.0, 0.0, 0.0, 0.0, 0,
+                    &vabs, &ek, &es);
+    if (is_nan == 0 && health_vmax_key(vabs) == key_max && iptr < iptr_min) {
+      iptr_min = iptr;
+    }
+  }
+
+  int tid = threadIdx.x;
+  s_iptr[tid] = iptr_min;
+  __syncthreads();
+
+  for (int s = blockDim.x / 2; s > 0; s >>= 1)
+  {
+    if (tid < s && s_iptr[tid + s] < s_iptr[tid]) {
+      s_iptr[tid] = s_iptr[tid + s];
+    }
+    __syncthreads();
+  }
+
+  if (tid == 0) {
+    atomicMin(red_d + HEALTH_RED_VMAX_IPTR, s_iptr[0]);
+  }
+}
+
+/*
+ * fault split nodes, all vars checked, |V| of both sides
+ */
+
+__global__ void
+health_fault_gpu(float *f, int ncmp, size_t siz_ilevel, int number_fault,
+                 size_t Vx_pos, size_t Vy_pos, size_t Vz_pos, gd_t gd_d,
+                 unsigned long long *red_d)
+{
+  __shared__ unsigned long long s_nan[HEALTH_BLOCK_SIZE];
+  __shared__ unsigned long long s_key[HEALTH_BLOCK_SIZE];
+
+  int nj = gd_d.nj;
+  int nk = gd_d.nk;
+  size_t siz_slice_yz = gd_d.siz_slice_yz;
+  size_t n = blockIdx.x * blockDim.x + threadIdx.x;
+
+  unsigned long long nan_count = 0;
+  unsigned long long key = 0;
+
+  if (n < (size_t) nj * nk)
+  {
+    size_t iptr_f = (n % nj + gd_d.nj1) + (n / nj + gd_d.nk1) * gd_d.ny;
+    for (int id=0; id < number_fault; id++)
+    {
+      float *f_thisone = f + id * siz_ilevel;
+      for (int ivar=0; ivar < 2*ncmp; ivar++) {
+        if (!isfinite(f_thisone[iptr_f + ivar * siz_slice_yz])) nan_count += 1;
+      }
+      // minus and plus side
+      for (int iside=0; iside < 2; iside++)
+      {
+        size_t iptr_s = iptr_f + iside * siz_slice_yz;
+        float Vx = f_thisone[Vx_pos + iptr_s];
+        float Vy = f_thisone[Vy_pos + iptr_s];
+        float Vz = f_thisone[Vz_pos + iptr_s];
+        float vabs = sqrtf(Vx*Vx + Vy*Vy + Vz*Vz);
+        if (isfinite(vabs)) {
+          unsigned long long key_this = health_vmax_key(vabs);
+          if (key_this > key) key = key_this;
+        }
+      }
+    }
+  }
+
+  int tid = threadIdx.x;
+  s_nan[tid] = nan_count;
+  s_key[tid] = key;
+  __syncthreads();
+
+  for (int s = blockDim.x / 2; s > 0; s >>= 1)
+  {
+    if (tid < s) {
+      s_nan[tid] += s_nan[tid + s];
+      if (s_key[tid + s] > s_key[tid]) s_key[tid] = s_key[tid + s];
+    }
+    __syncthreads();
+  }
+
+  if (tid == 0)
+  {
+    atomicAdd(red_d + HEALTH_RED_FAULT_NAN, s_nan[0]);
+    atomicMax(red_d + HEALTH_RED_FAULT_VMAX, s_key[0]);
+  }
+}
@@ -0,0 +1,105 @@
+#ifndef HEALTH_T_H
+#define HEALTH_T_H
+
+#include <stdio.h>
+#include <mpi.h>
+
+#include "gd_t.h"
+#include "md_t.h"
+#include "wav_t.h"
+#include "fault_wav_t.h"
+#include "resid_t.h"
+
+/*************************************************
+ * in-situ health monitor of wavefield
+ *  NaN/Inf count, max |V| with location, kinetic and strain energy of
+ *  volume, NaN/Inf count and max |V| of fault split nodes.
+ *  local values are reduced over all threads by one MPI_Allreduce
+ *************************************************/
+
+// layout of reduced values
+#define HEALTH_NAN         0 // sum
+#define HEALTH_FAULT_NAN   1 // sum
+#define HEALTH_EK          2 // sum
+#define HEALTH_ES          3 // sum
+#define HEALTH_VMAX        4 // max, with following location
+#define HEALTH_VMAX_RANK   5
+#define HEALTH_VMAX_I      6
+#define HEALTH_VMAX_J      7
+#define HEALTH_VMAX_K      8
+#define HEALTH_FAULT_VMAX  9 // max
+#define HEALTH_NUM_VAL    10
+
+// device partial results
+#define HEALTH_RED_NAN        0
+#define HEALTH_RED_FAULT_NAN  1
+#define HEALTH_RED_VMAX       2 // bits of |V|
+#define HEALTH_RED_FAULT_VMAX 3
+#define HEALTH_RED_VMAX_IPTR  4 // min local index of max |V|, second pass
+#define HEALTH_NUM_RED        5
+
+typedef struct
+{
+  int enable;
+  int check_every;   // number of steps
+  int use_host;      // 1: copy to host and check there
+  float max_velocity; // abort if max |V| larger, <= 0 to disable
+
+  int myid;
+  FILE *fp; // time series, only thread 0
+
+  unsigned long long *red_d;
+  double *energy_d;
+
+  MPI_Datatype val_type;
+  MPI_Op       val_op;
+
+  double val[HEALTH_NUM_VAL]; // global values of last check
+
+  // host media and metric are got through residency if not NULL
+  resid_t *resid;
+} health_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+health_init(health_t *health, int check_every, float max_velocity, int use_host,
+            int myid, char *output_dir);
+
+int
+health_cal_device(health_t *health, float *w_d, float *f_d,
+                  gd_t *gd, gd_t gd_d, wav_t *wav, fault_wav_t *FW,
+                  md_t md_d, gd_metric_t metric_d, double *val);
+
+int
+health_cal_host(float *w, float *f,
+                gd_t *gd, wav_t *wav, fault_wav_t *FW,
+                md_t *md, gd_metric_t *metric, double *val);
+
+int
+health_check(health_t *health, int it, float t,
+             float *w_d, float *f_d,
+             gd_t *gd, gd_t gd_d, wav_t *wav, fault_wav_t *FW,
+             md_t *md, md_t md_d, gd_metric_t *metric, gd_metric_t metric_d,
+             MPI_Comm comm);
+
+int
+health_free(health_t *health);
+
+__global__ void
+health_wav_gpu(float *w, wav_t wav_d, gd_t gd_d,
+               float *slw3d, float *lam3d, float *mu3d,
+               void *mat_id, int mat_nbyte, gd_metric_t metric_d,
+               unsigned long long *red_d, double *energy_d);
+
+__global__ void
+health_vmax_loc_gpu(float *w, wav_t wav_d, gd_t gd_d, unsigned long long *red_d);
+
+__global__ void
+health_fault_gpu(float *f, int ncmp, size_t siz_ilevel, int number_fault,
+                 size_t Vx_pos, size_t Vy_pos, size_t Vz_pos, gd_t gd_d,
+                 unsigned long long *red_d);
+
+#endif
@@ -0,0 +1,286 @@
+/*******************************************************************************
+ * in-situ ground motion intensity measures of free surface
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "constants.h"
+#include "im_t.h"
+#include "cuda_common.h"
+
+int
+im_init(im_t *im, int enable, int num_of_period, float *period, float damping,
+        int max_husid, float dt, gd_t *gd)
+{
+  im->enable        = enable;
+  im->num_of_period = num_of_period;
+  im->damping       = damping;
+  im->dt            = dt;
+
+  if (im->enable == 0) return 0;
+
+  im->siz_slice    = (size_t) gd->nx * gd->ny;
+  im->num_of_layer = IM_PSA + num_of_period;
+
+  // halving needs even number
+  im->max_husid    = max_husid < 4 ? 4 : max_husid + max_husid % 2;
+  im->husid_every  = 1;
+  im->num_of_husid = 0;
+  im->num_of_step  = 0;
+
+  im->period = (float *) malloc((num_of_period + 1) * sizeof(float));
+  float *coef = (float *) malloc((num_of_period + 1) * IM_NUM_COEF * sizeof(float));
+  for (int ip=0; ip < num_of_period; ip++)
+  {
+    im->period[ip] = period[ip];
+    im_set_coef(period[ip], damping, dt, coef + ip * IM_NUM_COEF);
+  }
+
+  size_t siz_slice = im->siz_slice;
+  size_t siz_state = sizeof(float) * num_of_period * IM_NUM_STATE * siz_slice;
+  im->coef_d  = (float *) cuda_malloc(sizeof(float) * (num_of_period + 1) * IM_NUM_COEF);
+  im->state_d = (float *) cuda_malloc(siz_state + sizeof(float));
+  im->im_d    = (float *) cuda_malloc(sizeof(float) * im->num_of_layer * siz_slice);
+  im->husid_d = (float *) cuda_malloc(sizeof(float) * im->max_husid * siz_slice);
+  im->im      = (float *) malloc(sizeof(float) * im->num_of_layer * siz_slice);
+
+  CUDACHECK(cudaMemcpy(im->coef_d, coef, sizeof(float) * num_of_period * IM_NUM_COEF,
+                       cudaMemcpyHostToDevice));
+  CUDACHECK(cudaMemset(im->state_d, 0, siz_state));
+  CUDACHECK(cudaMemset(im->im_d, 0, sizeof(float) * im->num_of_layer * siz_slice));
+  free(coef);
+
+  return 0;
+}
+
+/*
+ * exact step of u'' + 2*h*w*u' + w^2*u = -a for a linear in the step,
+ *  [u v](n+1) = A [u v](n) + B [a(n) a(n+1)]. Nigam and Jennings, 1969
+ */
+
+int
+im_set_coef(float period, float damping, float dt, float *coef)
+{
+  double w   = 2.0 * PI / period;
+  double h   = damping;
+  double sq  = sqrt(1.0 - h * h);
+  double wd  = w * sq;
+  double E   = exp(-h * w * dt);
+  double S   = sin(wd * dt);
+  double C   = cos(wd * dt);
+  double w2  = w * w;
+  double w3  = w2 * w;
+  double c1  = (2.0 * h * h - 1.0) / (w2 * dt);
+  double c2  = 2.0 * h / (w3 * dt);
+
+  double A11 = E * (h / sq * S + C);
+  double A12 = E * S / wd;
+  double A21 = -w / sq * E * S;
+  double A22 = E * (C - h / sq * S);
+
+  double B11 = E * ((c1 + h / w) * S / wd + (c2 + 1.0 / w2) * C) - c2;
+  double B12 = -E * (c1 * S / wd + c2 * C) - 1.0 / w2 + c2;
+  double B21 = E * ((c1 + h / w) * (C - h / sq * S) - (c2 + 1.0 / w2) * (wd * S + h * w * C))
+             + 1.0 / (w2 * dt);
+  double B22 = -E * (c1 * (C - h / sq * S) - c2 * (wd * S + h * w * C)) - 1.0 / (w2 * dt);
+
+  coef[0] = A11; coef[1] = A12; coef[2] = A21; coef[3] = A22;
+  coef[4] = B11; coef[5] = B12; coef[6] = B21; coef[7] = B22;
+  coef[8] = w2;
+
+  return 0;
+}
+
+/*
+ * after w_end of step it is ready, with PG_calcu_gpu
+ */
+
+int
+im_keep(im_t *im, int it, float *w_end_d, float *w_pre_d, gd_t *gd, gd_t gd_d)
+{
+  if (im->enable == 0) return 0;
+
+  dim3 block(8,8);
+  dim3 grid;
+  grid.x = (gd->ni + block.x - 1) / block.x;
+  grid.y = (gd->nj + block.y - 1) / block.y;
+  im_calcu_gpu <<<grid, block>>> (w_end_d, w_pre_d, gd_d, *im, im->dt);
+  im->num_of_step = it + 1;
+
+  // Husid curve after step it, sample n is after step (n+1)*husid_every-1
+  if ((it + 1) % im->husid_every == 0)
+  {
+    im_husid_put_gpu <<<grid, block>>> (gd_d, *im, im->num_of_husid);
+    im->num_of_husid += 1;
+    if (im->num_of_husid == im->max_husid)
+    {
+      im_husid_halve_gpu <<<grid, block>>> (gd_d, *im);
+      im->num_of_husid = im->max_husid / 2;
+      im->husid_every *= 2;
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * duration from kept Husid samples and the final Arias intensity, then
+ *  layers to host
+ */
+
+int
+im_finish(im_t *im, gd_t *gd, gd_t gd_d)
+{
+  if (im->enable == 0) return 0;
+
+  dim3 block(8,8);
+  dim3 grid;
+  grid.x = (gd->ni + block.x - 1) / block.x;
+  grid.y = (gd->nj + block.y - 1) / block.y;
+  im_duration_gpu <<<grid, block>>> (gd_d, *im, im->husid_every * im->dt,
+                                     im->num_of_step * im->dt);
+
+  CUDACHECK(cudaMemcpy(im->im, im->im_d, sizeof(float) * im->num_of_layer * im->siz_slice,
+                       cudaMemcpyDeviceToHost));
+
+  return 0;
+}
+
+int
+im_free(im_t *im)
+{
+  if (im->enable == 0) return 0;
+
+  CUDACHECK(cudaFree(im->coef_d));
+  CUDACHECK(cudaFree(im->state_d));
+  CUDACHECK(cudaFree(im->im_d));
+  CUDACHECK(cudaFree(im->husid_d));
+  free(im->im);
+  free(im->period);
+
+  im->enable = 0;
+
+  return 0;
+}
+
+__global__ void
+im_calcu_gpu(float *w_end, float *w_pre, gd_t gd_d, im_t im, float dt)
+{
+  size_t ix = blockIdx.x * blockDim.x + threadIdx.x;
+  size_t iy = blockIdx.y * blockDim.y + threadIdx.y;
+
+  if (ix < gd_d.ni && iy < gd_d.nj)
+  {
+    size_t siz_slice = im.siz_slice;
+    size_t siz_icmp  = gd_d.siz_icmp;
+    size_t iptr  = (ix + gd_d.ni1) + (iy + gd_d.nj1) * gd_d.siz_iy + gd_d.nk2 * gd_d.siz_iz;
+    size_t iptr1 = (ix + gd_d.ni1) + (iy + gd_d.nj1) * gd_d.siz_iy;
+
+    // Vx, Vy are cmp 0 and 1 of w
+    float ax = (w_end[iptr           ] - w_pre[iptr           ]) / dt;
+    float ay = (w_end[iptr + siz_icmp] - w_pre[iptr + siz_icmp]) / dt;
+    float a2 = ax * ax + ay * ay;
+
+    im.im_d[IM_CAV  *siz_slice + iptr1] += sqrtf(a2) * dt;
+    im.im_d[IM_ARIAS*siz_slice + iptr1] += (float) (PI / (2.0 * IM_GRAVITY)) * a2 * dt;
+
+    for (int ip=0; ip < im.num_of_period; ip++)
+    {
+      float *c  = im.coef_d  + ip * IM_NUM_COEF;
+      float *st = im.state_d + ip * IM_NUM_STATE * siz_slice + iptr1;
+      float ux = st[0*siz_slice], uy = st[1*siz_slice];
+      float vx = st[2*siz_slice], vy = st[3*siz_slice];
+      float ax0 = st[4*siz_slice], ay0 = st[5*siz_slice];
+
+      float ux1 = c[0] * ux + c[1] * vx + c[4] * ax0 + c[5] * ax;
+      float vx1 = c[2] * ux + c[3] * vx + c[6] * ax0 + c[7] * ax;
+      float uy1 = c[0] * uy + c[1] * vy + c[4] * ay0 + c[5] * ay;
+      float vy1 = c[2] * uy + c[3] * vy + c[6] * ay0 + c[7] * ay;
+
+      st[0*siz_slice] = ux1; st[1*siz_slice] = uy1;
+      st[2*siz_slice] = vx1; st[3*siz_slice] = vy1;
+      st[4*siz_slice] = ax;  st[5*siz_slice] = ay;
+
+      // pseudo acceleration along the direction of horizontal motion
+      float psa = c[8] * sqrtf(ux1 * ux1 + uy1 * uy1);
+      float *PSA = im.im_d + (IM_PSA + ip) * siz_slice + iptr1;
+      if (*PSA < psa) *PSA = psa;
+    }
+  }
+}
+
+__global__ void
+im_husid_put_gpu(gd_t gd_d, im_t im, int islot)
+{
+  size_t ix = blockIdx.x * blockDim.x + threadIdx.x;
+  size_t iy = blockIdx.y * blockDim.y + threadIdx.y;
+
+  if (ix < gd_d.ni && iy < gd_d.nj)
+  {
+    size_t iptr1 = (ix + gd_d.ni1) + (iy + gd_d.nj1) * gd_d.siz_iy;
+    im.husid_d[islot * im.siz_slice + iptr1] = im.im_d[IM_ARIAS * im.siz_slice + iptr1];
+  }
+}
+
+/*
+ * keep samples 1, 3, 5 ... as 0, 1, 2 ..., at twice the interval
+ */
+
+__global__ void
+im_husid_halve_gpu(gd_t gd_d, im_t im)
+{
+  size_t ix = blockIdx.x * blockDim.x + threadIdx.x;
+  size_t iy = blockIdx.y * blockDim.y + threadIdx.y;
+
+  if (ix < gd_d.ni && iy < gd_d.nj)
+  {
+    size_t iptr1 = (ix + gd_d.ni1) + (iy + gd_d.nj1) * gd_d.siz_iy;
+    for (int n=0; n < im.max_husid / 2; n++) {
+      im.husid_d[n * im.siz_slice + iptr1] = im.husid_d[(2*n+1) * im.siz_slice + iptr1];
+    }
+  }
+}
+
+/*
+ * times of 5% and 95% of final Arias intensity, linear between samples.
+ *  curve starts from 0 at time 0 and ends at the final value at t_end
+ */
+
+__global__ void
+im_duration_gpu(gd_t gd_d, im_t im, float dt_husid, float t_end)
+{
+  size_t ix = blockIdx.x * blockDim.x + threadIdx.x;
+  size_t iy = blockIdx.y * blockDim.y + threadIdx.y;
+
+  if (ix < gd_d.ni && iy < gd_d.nj)
+  {
+    size_t iptr1 = (ix + gd_d.ni1) + (iy + gd_d.nj1) * gd_d.siz_iy;
+    float Ia_end = im.im_d[IM_ARIAS * im.siz_slice + iptr1];
+    float level[2] = { 0.05f * Ia_end, 0.95f * Ia_end };
+    float t_level[2] = { 0.0f, 0.0f };
+
+    if (Ia_end > 0.0f)
+    {
+      for (int m=0; m < 2; m++)
+      {
+        float t0 = 0.0f, I0 = 0.0f;
+        float t1 = 0.0f, I1 = Ia_end;
+        for (int n=0; n <= im.num_of_husid; n++)
+        {
+          // last point is the final value
+          t1 = (n < im.num_of_husid) ? (n + 1) * dt_husid : t_end;
+          I1 = (n < im.num_of_husid) ? im.husid_d[n * im.siz_slice + iptr1] : Ia_end;
+          if (I1 >= level[m]) break;
+          t0 = t1;
+          I0 = I1;
+        }
+        t_level[m] = (I1 > I0) ? t0 + (level[m] - I0) / (I1 - I0) * (t1 - t0) : t0;
+      }
+    }
+
+    im.im_d[IM_D5_95 * im.siz_slice + iptr1] = t_level[1] - t_level[0];
+  }
+}
@@ -0,0 +1,86 @@
+#ifndef IM_T_H
+#define IM_T_H
+
+#include "gd_t.h"
+
+/*************************************************
+ * ground motion intensity measures of free surface, beyond PGV/PGA/PGD
+ *  horizontal acceleration ax, ay = dV/dt of each step drives a damped
+ *  oscillator of each period, advanced by the exact recursion of
+ *  Nigam and Jennings for piecewise linear input. PSA is the peak of
+ *  w^2 * |(ux,uy)| over time, the largest over all horizontal directions.
+ *  CAV is integral of |(ax,ay)|, Arias intensity pi/(2g) * integral of
+ *  ax^2+ay^2. significant duration D5-95 is found at end from samples
+ *  of the Husid curve: max_husid samples are kept, when full every
+ *  other one is dropped and the sample interval is doubled, so the
+ *  resolution is at least 1/max_husid of run time
+ *************************************************/
+
+#define IM_GRAVITY  9.81
+
+// layers of im
+#define IM_CAV      0
+#define IM_ARIAS    1
+#define IM_D5_95    2
+#define IM_PSA      3  // first period
+
+#define IM_NUM_COEF  9 // A11 A12 A21 A22 B11 B12 B21 B22 w^2
+#define IM_NUM_STATE 6 // ux uy vx vy ax_pre ay_pre
+
+typedef struct
+{
+  int    enable;
+  int    num_of_period;
+  float *period;
+  float  damping;
+  float  dt;
+
+  size_t siz_slice;  // nx * ny, same as PG
+  int    num_of_layer;
+
+  // Husid curve samples
+  int    max_husid;
+  int    husid_every;  // steps between samples
+  int    num_of_husid;
+  int    num_of_step;  // steps done
+
+  float *coef_d;   // [num_of_period][IM_NUM_COEF]
+  float *state_d;  // [num_of_period*IM_NUM_STATE][siz_slice]
+  float *im_d;     // [num_of_layer][siz_slice]
+  float *husid_d;  // [max_husid][siz_slice]
+  float *im;       // host copy for output
+} im_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+im_init(im_t *im, int enable, int num_of_period, float *period, float damping,
+        int max_husid, float dt, gd_t *gd);
+
+int
+im_set_coef(float period, float damping, float dt, float *coef);
+
+int
+im_keep(im_t *im, int it, float *w_end_d, float *w_pre_d, gd_t *gd, gd_t gd_d);
+
+int
+im_finish(im_t *im, gd_t *gd, gd_t gd_d);
+
+int
+im_free(im_t *im);
+
+__global__ void
+im_calcu_gpu(float *w_end, float *w_pre, gd_t gd_d, im_t im, float dt);
+
+__global__ void
+im_husid_put_gpu(gd_t gd_d, im_t im, int islot);
+
+__global__ void
+im_husid_halve_gpu(gd_t gd_d, im_t im);
+
+__global__ void
+im_duration_gpu(gd_t gd_d, im_t im, float dt_husid, float t_end);
+
+#endif
@@ -25,6 +25,11 @@ int
 io_recv_read_locate(gd_t      *gd,
                     iorecv_t  *iorecv,
                     int       nt_total,
+                    int       decimation,
+                    int       stream_every,
+                    float     dt,
+                    int       num_of_freq,
+                    float     *freq,
                     int       num_of_vars,
                     int       num_of_mpiprocs_z,
                     char      *in_filenm,
@@ -291,15 +296,26 @@ io_recv_read_locate(gd_t      *gd,
  
   iorecv->total_number = nr_this;
   iorecv->recvone      = recvone;
-  iorecv->max_nt       = nt_total;
+  iorecv->max_nt       = decim_nt_out(decimation, nt_total);
   iorecv->ncmp         = num_of_vars;
 
-  // malloc seismo
+  // streamed seismo keep a ring of samples
+  seis_store_init(&iorecv->store, stream_every, DECIM_HALF_LEN_OUT+1,
+                  nr_this * num_of_vars, iorecv->max_nt);
+  iorecv->nt_buff      = iorecv->store.nt_buff;
+
+  // malloc seismo, kept at decimated rate
   for (int ir=0; ir < iorecv->total_number; ir++)
   {
     recvone = iorecv->recvone + ir;
-    recvone->seismo = (float *) malloc(num_of_vars * nt_total * sizeof(float));
+    recvone->seismo = (float *) malloc(num_of_vars * iorecv->nt_buff * sizeof(float));
+    for (int icmp=0; icmp < num_of_vars; icmp++) {
+      iorecv->store.trace[ir*num_of_vars+icmp] = recvone->seismo + icmp * iorecv->nt_buff;
+    }
   }
+  decim_init(&iorecv->decim, decimation, nr_this * num_of_vars, nt_total,
+             iorecv->nt_buff);
+  spec_init(&iorecv->spec, num_of_freq, freq, dt, nr_this * num_of_vars);
   free(all_index);
   free(all_inc);
   free(all_coords);
@@ -313,6 +329,8 @@ io_line_locate(gd_t *gd,
                ioline_t *ioline,
                int    num_of_vars,
                int    nt_total,
+               int    decimation,
+               int    stream_every,
                int    number_of_receiver_line,
                int   *receiver_line_index_start,
                int   *receiver_line_index_incre,
@@ -323,7 +341,7 @@ io_line_locate(gd_t *gd,
 
   // init
   ioline->num_of_lines  = 0;
-  ioline->max_nt        = nt_total;
+  ioline->max_nt        = decim_nt_out(decimation, nt_total);
   ioline->ncmp          = num_of_vars;
 
   // alloc as max num to keep nr and seq values, easy for second round
@@ -358,6 +376,14 @@ io_line_locate(gd_t *gd,
     }
   }
 
+  int num_of_recv = 0;
+  for (int n=0; n < ioline->num_of_lines; n++) {
+    num_of_recv += ioline->line_nr[n];
+  }
+  seis_store_init(&ioline->store, stream_every, DECIM_HALF_LEN_OUT+1,
+                  num_of_recv * num_of_vars, ioline->max_nt);
+  ioline->nt_buff = ioline->store.nt_buff;
+
   // alloc
   if (ioline->num_of_lines>0)
   {
@@ -382,10 +408,21 @@ io_line_locate(gd_t *gd,
       ioline->recv_y[n] = (float *)malloc( nr * sizeof(float) );
       ioline->recv_z[n] = (float *)malloc( nr * sizeof(float) );
       ioline->recv_seismo[n] = (float *)malloc(
-                                nr * num_of_vars * nt_total * sizeof(float) );
+                                nr * num_of_vars * ioline->nt_buff * sizeof(float) );
     }
   }
 
+  // traces of receivers in line order
+  int itrace = 0;
+  for (int n=0; n < ioline->num_of_lines; n++) {
+    for (int itr=0; itr < ioline->line_nr[n] * num_of_vars; itr++) {
+      ioline->store.trace[itrace] = ioline->recv_seismo[n] + itr * ioline->nt_buff;
+      itrace += 1;
+    }
+  }
+  decim_init(&ioline->decim, decimation, num_of_recv * num_of_vars, nt_total,
+             ioline->nt_buff);
+
   // second run for value
   //  only loop lines in this thread
   for (int m=0; m < ioline->num_of_lines; m++)
@@ -426,13 +463,14 @@ io_line_locate(gd_t *gd,
 
 int
 io_recv_keep(iorecv_t *iorecv, float *w_pre_d, 
-             float *buff, int it, int ncmp, size_t siz_icmp)
+             float *buff, int it, int ncmp, size_t siz_icmp,
+             mem_pool_t *pool_d)
 {
   float Lx1, Lx2, Ly1, Ly2, Lz1, Lz2;
   //CONST_2_NDIM = 8, use 8 points interp
   int size = sizeof(float)*ncmp*CONST_2_NDIM;
-  float *buff_d = (float *) cuda_malloc(size);
-  size_t *indx1d_d = (size_t *) cuda_malloc(sizeof(size_t)*CONST_2_NDIM);
+  float *buff_d = (float *) mem_pool_malloc(pool_d, size);
+  size_t *indx1d_d = (size_t *) mem_pool_malloc(pool_d, sizeof(size_t)*CONST_2_NDIM);
   dim3 block(32);
   dim3 grid;
   grid.x = (ncmp+block.x-1)/block.x;
@@ -451,32 +489,41 @@ io_recv_keep(iorecv_t *iorecv, float *w_pre_d,
     CUDACHECK(cudaMemcpy(buff,buff_d,size,cudaMemcpyDeviceToHost));
     for (int icmp=0; icmp < ncmp; icmp++)
     {
-      int iptr_sta = icmp * iorecv->max_nt + it;
-      this_recv->seismo[iptr_sta] =  buff[CONST_2_NDIM*icmp + 0] * Lx1 * Ly1 * Lz1
-                                   + buff[CONST_2_NDIM*icmp + 1] * Lx2 * Ly1 * Lz1
-                                   + buff[CONST_2_NDIM*icmp + 2] * Lx1 * Ly2 * Lz1
-                                   + buff[CONST_2_NDIM*icmp + 3] * Lx2 * Ly2 * Lz1
-                                   + buff[CONST_2_NDIM*icmp + 5] * Lx1 * Ly1 * Lz2
-                                   + buff[CONST_2_NDIM*icmp + 5] * Lx2 * Ly1 * Lz2
-                                   + buff[CONST_2_NDIM*icmp + 6] * Lx1 * Ly2 * Lz2
-                                   + buff[CONST_2_NDIM*icmp + 7] * Lx2 * Ly2 * Lz2;
+      float v =  buff[CONST_2_NDIM*icmp + 0] * Lx1 * Ly1 * Lz1
+               + buff[CONST_2_NDIM*icmp + 1] * Lx2 * Ly1 * Lz1
+               + buff[CONST_2_NDIM*icmp + 2] * Lx1 * Ly2 * Lz1
+               + buff[CONST_2_NDIM*icmp + 3] * Lx2 * Ly2 * Lz1
+               + buff[CONST_2_NDIM*icmp + 5] * Lx1 * Ly1 * Lz2
+               + buff[CONST_2_NDIM*icmp + 5] * Lx2 * Ly1 * Lz2
+               + buff[CONST_2_NDIM*icmp + 6] * Lx1 * Ly2 * Lz2
+               + buff[CONST_2_NDIM*icmp + 7] * Lx2 * Ly2 * Lz2;
+      decim_push(&iorecv->decim, n*ncmp+icmp, it, v,
+                 this_recv->seismo + icmp * iorecv->nt_buff);
+      if (iorecv->spec.enable == 1) {
+        spec_push(&iorecv->spec, n*ncmp+icmp, v);
+      }
     }
   }
-  CUDACHECK(cudaFree(buff_d));
-  CUDACHECK(cudaFree(indx1d_d));
+  mem_pool_free(pool_d, buff_d);
+  mem_pool_free(pool_d, indx1d_d);
+  iorecv->spec.num_of_step = it + 1;
+
+  seis_store_put(&iorecv->store, decim_num_ready(&iorecv->decim, it+1));
 
   return 0;
 }
 
 int
 io_line_keep(ioline_t *ioline, float *w_pre_d,
-             float *buff, int it, int ncmp, size_t siz_icmp)
+             float *buff, int it, int ncmp, size_t siz_icmp,
+             mem_pool_t *pool_d)
 {
   int size = sizeof(float)*ncmp;
-  float *buff_d = (float *) cuda_malloc(size);
+  float *buff_d = (float *) mem_pool_malloc(pool_d, size);
   dim3 block(32);
   dim3 grid;
   grid.x = (ncmp+block.x-1)/block.x;
+  int itrace = 0;
   for (int n=0; n < ioline->num_of_lines; n++)
   {
     int   *this_line_iptr   = ioline->recv_iptr[n];
@@ -485,17 +532,20 @@ io_line_keep(ioline_t *ioline, float *w_pre_d,
     for (int ir=0; ir < ioline->line_nr[n]; ir++)
     {
       int iptr = this_line_iptr[ir];
-      float *this_seismo = this_line_seismo + ir * ioline->max_nt * ncmp;
+      float *this_seismo = this_line_seismo + ir * ioline->nt_buff * ncmp;
       io_recv_line_pack_buff<<<grid, block>>>(w_pre_d, buff_d, ncmp, siz_icmp, iptr);
       CUDACHECK(cudaMemcpy(buff,buff_d,size,cudaMemcpyDeviceToHost));
       for (int icmp=0; icmp < ncmp; icmp++)
       {
-        int iptr_seismo = icmp * ioline->max_nt + it;
-        this_seismo[iptr_seismo] = buff[icmp];
+        decim_push(&ioline->decim, itrace+icmp, it, buff[icmp],
+                   this_seismo + icmp * ioline->nt_buff);
       }
+      itrace += ncmp;
     }
   }
-  CUDACHECK(cudaFree(buff_d));
+  mem_pool_free(pool_d, buff_d);
+
+  seis_store_put(&ioline->store, decim_num_ready(&ioline->decim, it+1));
 
   return 0;
 }
@@ -574,6 +624,30 @@ io_recv_line_pack_buff(float *var, float *buff_d, int ncmp, size_t siz_icmp, int
   }
 }
 
+/*
+ * full traces of one station, seismo itself or read from trace store
+ *  into buff when streamed
+ */
+
+static float *
+io_seismo_get(seis_store_t *store, float *seismo, int itrace0, int ntrace,
+              float *buff)
+{
+  if (store->enable == 0) return seismo;
+
+  seis_store_read(store, itrace0, ntrace, buff);
+
+  return buff;
+}
+
+static float *
+io_seismo_get_buff(seis_store_t *store, int ntrace, int max_nt)
+{
+  if (store->enable == 0) return NULL;
+
+  return (float *) malloc((size_t) ntrace * max_nt * sizeof(float));
+}
+
 int
 io_recv_output_sac(iorecv_t *iorecv,
                    float dt,
@@ -588,17 +662,22 @@ io_recv_output_sac(iorecv_t *iorecv,
   float evt_z = 0.0;
   float evt_d = 0.0;
   char ou_file[CONST_MAX_STRLEN];
+  // sample spacing of decimated trace
+  float dt_out = dt * iorecv->decim.factor;
+  float *buff = io_seismo_get_buff(&iorecv->store, num_of_vars, iorecv->max_nt);
 
   for (int ir=0; ir < iorecv->total_number; ir++)
   {
     iorecv_one_t *this_recv = iorecv->recvone + ir;
+    float *seismo = io_seismo_get(&iorecv->store, this_recv->seismo,
+                                  ir*num_of_vars, num_of_vars, buff);
 
     //fprintf(stdout,"=== Debug: num_of_vars=%d\n",num_of_vars);fflush(stdout);
     for (int icmp=0; icmp < num_of_vars; icmp++)
     {
       //fprintf(stdout,"=== Debug: icmp=%d\n",icmp);fflush(stdout);
 
-      float *this_trace = this_recv->seismo + icmp * iorecv->max_nt;
+      float *this_trace = seismo + icmp * iorecv->max_nt;
 
       sprintf(ou_file,"%s/%s.%s.sac", output_dir, 
                       this_recv->name, cmp_name[icmp]);
@@ -609,9 +688,10 @@ io_recv_output_sac(iorecv_t *iorecv,
             this_trace,
             evt_x, evt_y, evt_z, evt_d,
             this_recv->x, this_recv->y, this_recv->z,
-            dt, dt, iorecv->max_nt, err_message);
+            dt_out, dt_out, iorecv->max_nt, err_message);
     }
   }
+  if (buff != NULL) free(buff);
 
   return 0;
 }
@@ -620,10 +700,194 @@ io_recv_output_sac(iorecv_t *iorecv,
 //   do not find a better file to hold this func
 //   temporarily put here
 
+/*
+ * keep media of each station, host media may be released during simulation
+ */
+
+int
+io_recv_set_media_el_iso(iorecv_t *iorecv,
+                         float *lam3d,
+                         float *mu3d)
+{
+  for (int ir=0; ir < iorecv->total_number; ir++)
+  {
+    iorecv_one_t *this_recv = iorecv->recvone + ir;
+    size_t iptr = this_recv->indx1d[0];
+
+    this_recv->lam = lam3d[iptr];
+    this_recv->mu  =  mu3d[iptr];
+  }
+
+  return 0;
+}
+
+/*
+ * stress cmps 3 to 8 of seismo to strain in place
+ */
+
+int
+io_recv_strain_el_iso(float lam, float mu, float *seismo, int max_nt)
+{
+  // cmp seq hard-coded, need to revise in the future
+  float *Txx = seismo + 3 * max_nt;
+  float *Tyy = seismo + 4 * max_nt;
+  float *Tzz = seismo + 5 * max_nt;
+  float *Tyz = seismo + 6 * max_nt;
+  float *Txz = seismo + 7 * max_nt;
+  float *Txy = seismo + 8 * max_nt;
+
+  float E1 = (lam + mu) / (mu * ( 3.0 * lam + 2.0 * mu));
+  float E2 = - lam / ( 2.0 * mu * (3.0 * lam + 2.0 * mu));
+  float E3 = 1.0 / mu;
+
+  // conver to strain per time step
+  for (int it = 0; it < max_nt; it++)
+  {
+    float E0 = E2 * (Txx[it] + Tyy[it] + Tzz[it]);
+
+    Txx[it] = E0 - (E2 - E1) * Txx[it];
+    Tyy[it] = E0 - (E2 - E1) * Tyy[it];
+    Tzz[it] = E0 - (E2 - E1) * Tzz[it];
+    Tyz[it] = 0.5 * E3 * Tyz[it];
+    Txz[it] = 0.5 * E3 * Txz[it];
+    Txy[it] = 0.5 * E3 * Txy[it];
+  }
+
+  return 0;
+}
+
+/*
+ * Fourier amplitude spectra of stations in output_dir/recv_spectra.nc,
+ *  from running spectra, gathered to thread 0 in order of threads
+ */
+
+int
+io_recv_spectrum_write(iorecv_t *iorecv, char **cmp_name,
+                       char *output_dir, MPI_Comm comm, int myid)
+{
+  spec_t *spec = &iorecv->spec;
+  if (spec->enable == 0) return 0;
+
+  int nprocs;
+  MPI_Comm_size(comm, &nprocs);
+
+  int ncmp  = iorecv->ncmp;
+  int nfreq = spec->num_of_freq;
+  int num_of_sta = iorecv->total_number;
+  int siz_sta = ncmp * nfreq;
+
+  io_archive_sta_t *sta = (io_archive_sta_t *) calloc(num_of_sta + 1, sizeof(io_archive_sta_t));
+  float *amp = (float *) malloc(((size_t) num_of_sta * siz_sta + 1) * sizeof(float));
+  for (int ir=0; ir < num_of_sta; ir++)
+  {
+    iorecv_one_t *this_recv = iorecv->recvone + ir;
+    snprintf(sta[ir].name, IO_ARCHIVE_NAME_STRLEN, "%s", this_recv->name);
+    sta[ir].x = this_recv->x;
+    sta[ir].y = this_recv->y;
+    sta[ir].z = this_recv->z;
+    for (int icmp=0; icmp < ncmp; icmp++) {
+      spec_amp(spec, ir*ncmp+icmp, amp + (size_t) (ir*ncmp+icmp) * nfreq);
+    }
+  }
+
+  //-- gather to thread 0
+  int *num_of_sta_thread = (int *) malloc(nprocs * sizeof(int));
+  int *nbyte  = (int *) malloc(nprocs * sizeof(int));
+  int *displs = (int *) malloc(nprocs * sizeof(int));
+  int *nval   = (int *) malloc(nprocs * sizeof(int));
+  int *displs_val = (int *) malloc(nprocs * sizeof(int));
+  int num_of_sta_all = 0;
+  io_archive_sta_t *sta_all = NULL;
+  float *amp_all = NULL;
+
+  MPI_Gather(&num_of_sta, 1, MPI_INT, num_of_sta_thread, 1, MPI_INT, 0, comm);
+  if (myid == 0)
+  {
+    for (int r=0; r < nprocs; r++) {
+      nbyte [r] = num_of_sta_thread[r] * sizeof(io_archive_sta_t);
+      displs[r] = num_of_sta_all * sizeof(io_archive_sta_t);
+      nval  [r] = num_of_sta_thread[r] * siz_sta;
+      displs_val[r] = num_of_sta_all * siz_sta;
+      num_of_sta_all += num_of_sta_thread[r];
+    }
+    sta_all = (io_archive_sta_t *) malloc((num_of_sta_all + 1) * sizeof(io_archive_sta_t));
+    amp_all = (float *) malloc(((size_t) num_of_sta_all * siz_sta + 1) * sizeof(float));
+  }
+  MPI_Gatherv(sta, num_of_sta * sizeof(io_archive_sta_t), MPI_BYTE,
+              sta_all, nbyte, displs, MPI_BYTE, 0, comm);
+  MPI_Gatherv(amp, num_of_sta * siz_sta, MPI_FLOAT,
+              amp_all, nval, displs_val, MPI_FLOAT, 0, comm);
+
+  //-- write on thread 0
+  if (myid == 0 && num_of_sta_all > 0)
+  {
+    char ou_file[CONST_MAX_STRLEN];
+    sprintf(ou_file, "%s/recv_spectra.nc", output_dir);
+
+    int ncid, ierr;
+    int dimid[3], dimid_str, dimid2[2];
+    int varid_name, varid_xyz[3], varid_cmp_name, varid_freq, varid_amp;
+    ierr = nc_create(ou_file, NC_CLOBBER | NC_64BIT_OFFSET, &ncid); handle_nc_err(ierr);
+    ierr = nc_def_dim(ncid, "name_strlen", IO_ARCHIVE_NAME_STRLEN, &dimid_str); handle_nc_err(ierr);
+    ierr = nc_def_dim(ncid, "station", num_of_sta_all, &dimid[0]); handle_nc_err(ierr);
+    ierr = nc_def_dim(ncid, "component", ncmp, &dimid[1]); handle_nc_err(ierr);
+    ierr = nc_def_dim(ncid, "frequency", nfreq, &dimid[2]); handle_nc_err(ierr);
+
+    dimid2[0] = dimid[0]; dimid2[1] = dimid_str;
+    ierr = nc_def_var(ncid, "name", NC_CHAR, 2, dimid2, &varid_name); handle_nc_err(ierr);
+    ierr = nc_def_var(ncid, "x", NC_FLOAT, 1, dimid, &varid_xyz[0]); handle_nc_err(ierr);
+    ierr = nc_def_var(ncid, "y", NC_FLOAT, 1, dimid, &varid_xyz[1]); handle_nc_err(ierr);
+    ierr = nc_def_var(ncid, "z", NC_FLOAT, 1, dimid, &varid_xyz[2]); handle_nc_err(ierr);
+    dimid2[0] = dimid[1];
+    ierr = nc_def_var(ncid, "component_name", NC_CHAR, 2, dimid2, &varid_cmp_name); handle_nc_err(ierr);
+    ierr = nc_def_var(ncid, "frequency", NC_FLOAT, 1, dimid+2, &varid_freq); handle_nc_err(ierr);
+    ierr = nc_def_var(ncid, "amplitude", NC_FLOAT, 3, dimid, &varid_amp); handle_nc_err(ierr);
+    nc_put_att_float(ncid, varid_amp, "delta", NC_FLOAT, 1, &(spec->dt));
+    nc_put_att_int(ncid, varid_amp, "number_of_samples", NC_INT, 1, &(spec->num_of_step));
+    ierr = nc_enddef(ncid); handle_nc_err(ierr);
+
+    char *str = (char *) malloc(IO_ARCHIVE_NAME_STRLEN);
+    for (int i=0; i < num_of_sta_all; i++)
+    {
+      size_t start[2] = { (size_t)i, 0 };
+      size_t count[2] = { 1, IO_ARCHIVE_NAME_STRLEN };
+      ierr = nc_put_vara_text(ncid, varid_name, start, count, sta_all[i].name); handle_nc_err(ierr);
+      ierr = nc_put_var1_float(ncid, varid_xyz[0], start, &(sta_all[i].x)); handle_nc_err(ierr);
+      ierr = nc_put_var1_float(ncid, varid_xyz[1], start, &(sta_all[i].y)); handle_nc_err(ierr);
+      ierr = nc_put_var1_float(ncid, varid_xyz[2], start, &(sta_all[i].z)); handle_nc_err(ierr);
+    }
+    for (int icmp=0; icmp < ncmp; icmp++)
+    {
+      memset(str, 0, IO_ARCHIVE_NAME_STRLEN);
+      strncpy(str, cmp_name[icmp], IO_ARCHIVE_NAME_STRLEN-1);
+      size_t start[2] = { (size_t)icmp, 0 };
+      size_t count[2] = { 1, IO_ARCHIVE_NAME_STRLEN };
+      ierr = nc_put_vara_text(ncid, varid_cmp_name, start, count, str); handle_nc_err(ierr);
+    }
+    free(str);
+    ierr = nc_put_var_float(ncid, varid_freq, spec->freq); handle_nc_err(ierr);
+    ierr = nc_put_var_float(ncid, varid_amp, amp_all); handle_nc_err(ierr);
+
+    ierr = nc_close(ncid); handle_nc_err(ierr);
+  }
+
+  if (myid == 0) {
+    free(sta_all);
+    free(amp_all);
+  }
+  free(sta);
+  free(amp);
+  free(num_of_sta_thread);
+  free(nbyte);
+  free(displs);
+  free(nval);
+  free(displs_val);
+
+  return 0;
+}
+
 int
 io_recv_output_sac_el_iso_strain(iorecv_t *iorecv,
-                     float *lam3d,
-                     float *mu3d,
                      float dt,
                      char *output_dir,
                      char *err_message)
@@ -634,71 +898,58 @@ io_recv_output_sac_el_iso_strain(iorecv_t *iorecv,
   float evt_z = 0.0;
   float evt_d = 0.0;
   char ou_file[CONST_MAX_STRLEN];
+  // sample spacing of decimated trace
+  float dt_out = dt * iorecv->decim.factor;
+  float *buff = io_seismo_get_buff(&iorecv->store, iorecv->ncmp, iorecv->max_nt);
 
   for (int ir=0; ir < iorecv->total_number; ir++)
   {
     iorecv_one_t *this_recv = iorecv->recvone + ir;
-    size_t iptr = this_recv->indx1d[0];
+    float *seismo = io_seismo_get(&iorecv->store, this_recv->seismo,
+                                  ir*iorecv->ncmp, iorecv->ncmp, buff);
 
-    float lam = lam3d[iptr];
-    float mu  =  mu3d[iptr];
+    io_recv_strain_el_iso(this_recv->lam, this_recv->mu, seismo, iorecv->max_nt);
 
     // cmp seq hard-coded, need to revise in the future
-    float *Txx = this_recv->seismo + 3 * iorecv->max_nt;
-    float *Tyy = this_recv->seismo + 4 * iorecv->max_nt;
-    float *Tzz = this_recv->seismo + 5 * iorecv->max_nt;
-    float *Tyz = this_recv->seismo + 6 * iorecv->max_nt;
-    float *Txz = this_recv->seismo + 7 * iorecv->max_nt;
-    float *Txy = this_recv->seismo + 8 * iorecv->max_nt;
-
-    float E1 = (lam + mu) / (mu * ( 3.0 * lam + 2.0 * mu));
-    float E2 = - lam / ( 2.0 * mu * (3.0 * lam + 2.0 * mu));
-    float E3 = 1.0 / mu;
-
-    // conver to strain per time step
-    for (int it = 0; it < iorecv->max_nt; it++)
-    {
-      float E0 = E2 * (Txx[it] + Tyy[it] + Tzz[it]);
-
-      Txx[it] = E0 - (E2 - E1) * Txx[it];
-      Tyy[it] = E0 - (E2 - E1) * Tyy[it];
-      Tzz[it] = E0 - (E2 - E1) * Tzz[it];
-      Tyz[it] = 0.5 * E3 * Tyz[it];
-      Txz[it] = 0.5 * E3 * Txz[it];
-      Txy[it] = 0.5 * E3 * Txy[it];
-    }
+    float *Txx = seismo + 3 * iorecv->max_nt;
+    float *Tyy = seismo + 4 * iorecv->max_nt;
+    float *Tzz = seismo + 5 * iorecv->max_nt;
+    float *Tyz = seismo + 6 * iorecv->max_nt;
+    float *Txz = seismo + 7 * iorecv->max_nt;
+    float *Txy = seismo + 8 * iorecv->max_nt;
 
     // output to sca file
     sprintf(ou_file,"%s/%s.%s.sac", output_dir, this_recv->name, "Exx");
     sacExport1C1R(ou_file,Txx,evt_x, evt_y, evt_z, evt_d,
           this_recv->x, this_recv->y, this_recv->z,
-          dt, dt, iorecv->max_nt, err_message);
+          dt_out, dt_out, iorecv->max_nt, err_message);
 
     sprintf(ou_file,"%s/%s.%s.sac", output_dir, this_recv->name, "Eyy");
     sacExport1C1R(ou_file,Tyy,evt_x, evt_y, evt_z, evt_d,
           this_recv->x, this_recv->y, this_recv->z,
-          dt, dt, iorecv->max_nt, err_message);
+          dt_out, dt_out, iorecv->max_nt, err_message);
 
     sprintf(ou_file,"%s/%s.%s.sac", output_dir, this_recv->name, "Ezz");
     sacExport1C1R(ou_file,Tzz,evt_x, evt_y, evt_z, evt_d,
           this_recv->x, this_recv->y, this_recv->z,
-          dt, dt, iorecv->max_nt, err_message);
+          dt_out, dt_out, iorecv->max_nt, err_message);
 
     sprintf(ou_file,"%s/%s.%s.sac", output_dir, this_recv->name, "Eyz");
     sacExport1C1R(ou_file,Tyz,evt_x, evt_y, evt_z, evt_d,
           this_recv->x, this_recv->y, this_recv->z,
-          dt, dt, iorecv->max_nt, err_message);
+          dt_out, dt_out, iorecv->max_nt, err_message);
 
     sprintf(ou_file,"%s/%s.%s.sac", output_dir, this_recv->name, "Exz");
     sacExport1C1R(ou_file,Txz,evt_x, evt_y, evt_z, evt_d,
           this_recv->x, this_recv->y, this_recv->z,
-          dt, dt, iorecv->max_nt, err_message);
+          dt_out, dt_out, iorecv->max_nt, err_message);
 
     sprintf(ou_file,"%s/%s.%s.sac", output_dir, this_recv->name, "Exy");
     sacExport1C1R(ou_file,Txy,evt_x, evt_y, evt_z, evt_d,
           this_recv->x, this_recv->y, this_recv->z,
-          dt, dt, iorecv->max_nt, err_message);
+          dt_out, dt_out, iorecv->max_nt, err_message);
   } // loop ir
+  if (buff != NULL) free(buff);
 
   return 0;
 }
@@ -753,7 +1004,11 @@ io_line_output_sac(ioline_t *ioline,
   float evt_z = 0.0;
   float evt_d = 0.0;
   char ou_file[CONST_MAX_STRLEN];
+  // sample spacing of decimated trace
+  float dt_out = dt * ioline->decim.factor;
   char err_message[CONST_MAX_STRLEN];
+  float *buff = io_seismo_get_buff(&ioline->store, ioline->ncmp, ioline->max_nt);
+  int itrace = 0;
   
   for (int n=0; n < ioline->num_of_lines; n++)
   {
@@ -762,7 +1017,10 @@ io_line_output_sac(ioline_t *ioline,
 
     for (int ir=0; ir < ioline->line_nr[n]; ir++)
     {
-      float *this_seismo = this_line_seismo + ir * ioline->max_nt * ioline->ncmp;
+      float *this_seismo = io_seismo_get(&ioline->store,
+                              this_line_seismo + ir * ioline->nt_buff * ioline->ncmp,
+                              itrace, ioline->ncmp, buff);
+      itrace += ioline->ncmp;
 
       for (int icmp=0; icmp < ioline->ncmp; icmp++)
       {
@@ -778,10 +1036,279 @@ io_line_output_sac(ioline_t *ioline,
               ioline->recv_x[n][ir],
               ioline->recv_y[n][ir],
               ioline->recv_z[n][ir],
-              dt, dt, ioline->max_nt, err_message);
+              dt_out, dt_out, ioline->max_nt, err_message);
       } // icmp
     } // ir
   } // line
+  if (buff != NULL) free(buff);
+
+  return 0;
+}
+
+/*
+ * all station traces of the run in output_dir/seismo_archive.nc instead
+ *  of sac files. stations of each kind are ordered by thread, tables are
+ *  gathered to thread 0, which receives and writes traces station by
+ *  station, so its memory does not grow with number of stations.
+ *  sac files are made from it by tools/archive_to_sac
+ */
+
+int
+io_seismo_archive_write(iorecv_t *iorecv, ioline_t *ioline,
+                        io_fault_recv_t *io_fault_recv,
+                        float dt, char **cmp_name, int is_el_iso,
+                        char *output_dir, MPI_Comm comm, int myid)
+{
+  int nprocs;
+  MPI_Comm_size(comm, &nprocs);
+
+  char fault_cmp_name[9][CONST_MAX_STRLEN] = {"Tn","Ts1","Ts2",
+                                              "Vs", "Vs1","Vs2",
+                                              "Slip", "Slip1", "Slip2"};
+
+  io_archive_kind_t kd[IO_ARCHIVE_NUM_KIND];
+  memset(kd, 0, sizeof(kd));
+
+  //-- stations of this thread
+  sprintf(kd[0].kind, "recv");
+  kd[0].num_of_sta = iorecv->total_number;
+  kd[0].ncmp       = iorecv->ncmp;
+  kd[0].max_nt     = iorecv->max_nt;
+  kd[0].delta      = dt * iorecv->decim.factor;
+  kd[0].store      = &iorecv->store;
+  kd[0].has_strain = is_el_iso;
+
+  sprintf(kd[1].kind, "line");
+  kd[1].num_of_sta = 0;
+  for (int n=0; n < ioline->num_of_lines; n++) {
+    kd[1].num_of_sta += ioline->line_nr[n];
+  }
+  kd[1].ncmp       = ioline->ncmp;
+  kd[1].max_nt     = ioline->max_nt;
+  kd[1].delta      = dt * ioline->decim.factor;
+  kd[1].store      = &ioline->store;
+
+  sprintf(kd[2].kind, "fault_recv");
+  kd[2].num_of_sta = io_fault_recv->total_number;
+  kd[2].ncmp       = io_fault_recv->ncmp;
+  kd[2].max_nt     = io_fault_recv->max_nt;
+  kd[2].delta      = dt * io_fault_recv->decim.factor;
+  kd[2].store      = &io_fault_recv->store;
+
+  for (int m=0; m < IO_ARCHIVE_NUM_KIND; m++)
+  {
+    kd[m].sta    = (io_archive_sta_t *) calloc(kd[m].num_of_sta + 1, sizeof(io_archive_sta_t));
+    kd[m].seismo = (float **) malloc((kd[m].num_of_sta + 1) * sizeof(float *));
+  }
+
+  for (int ir=0; ir < iorecv->total_number; ir++)
+  {
+    iorecv_one_t *this_recv = iorecv->recvone + ir;
+    io_archive_sta_t *sta = kd[0].sta + ir;
+    snprintf(sta->name, IO_ARCHIVE_NAME_STRLEN, "%s", this_recv->name);
+    sta->x   = this_recv->x;
+    sta->y   = this_recv->y;
+    sta->z   = this_recv->z;
+    sta->lam = this_recv->lam;
+    sta->mu  = this_recv->mu;
+    kd[0].seismo[ir] = this_recv->seismo;
+  }
+
+  int ista = 0;
+  for (int n=0; n < ioline->num_of_lines; n++)
+  {
+    for (int ir=0; ir < ioline->line_nr[n]; ir++)
+    {
+      io_archive_sta_t *sta = kd[1].sta + ista;
+      snprintf(sta->name, IO_ARCHIVE_NAME_STRLEN, "%s.no%d",
+               ioline->line_name[n], ioline->recv_seq[n][ir]);
+      sta->x = ioline->recv_x[n][ir];
+      sta->y = ioline->recv_y[n][ir];
+      sta->z = ioline->recv_z[n][ir];
+      kd[1].seismo[ista] = ioline->recv_seismo[n] + ir * ioline->nt_buff * ioline->ncmp;
+      ista += 1;
+    }
+  }
+
+  for (int ir=0; ir < io_fault_recv->total_number; ir++)
+  {
+    io_fault_recv_one_t *this_recv = io_fault_recv->fault_recvone + ir;
+    io_archive_sta_t *sta = kd[2].sta + ir;
+    snprintf(sta->name, IO_ARCHIVE_NAME_STRLEN, "%s", this_recv->name);
+    sta->x = this_recv->x;
+    sta->y = this_recv->y;
+    sta->z = this_recv->z;
+    kd[2].seismo[ir] = this_recv->seismo;
+  }
+
+  //-- gather tables to thread 0
+  int *nbyte      = (int *) malloc(nprocs * sizeof(int));
+  int *displs     = (int *) malloc(nprocs * sizeof(int));
+  for (int m=0; m < IO_ARCHIVE_NUM_KIND; m++)
+  {
+    kd[m].num_of_sta_all = 0;
+    kd[m].num_of_sta_thread = (int *) malloc(nprocs * sizeof(int));
+    MPI_Gather(&(kd[m].num_of_sta), 1, MPI_INT, kd[m].num_of_sta_thread, 1, MPI_INT, 0, comm);
+    if (myid == 0)
+    {
+      for (int r=0; r < nprocs; r++) {
+        nbyte [r] = kd[m].num_of_sta_thread[r] * sizeof(io_archive_sta_t);
+        displs[r] = kd[m].num_of_sta_all * sizeof(io_archive_sta_t);
+        kd[m].num_of_sta_all += kd[m].num_of_sta_thread[r];
+      }
+      kd[m].sta_all = (io_archive_sta_t *) malloc((kd[m].num_of_sta_all + 1)
+                                                   * sizeof(io_archive_sta_t));
+    }
+    MPI_Gatherv(kd[m].sta, kd[m].num_of_sta * sizeof(io_archive_sta_t), MPI_BYTE,
+                kd[m].sta_all, nbyte, displs, MPI_BYTE, 0, comm);
+  }
+
+  //-- define file on thread 0
+  int ncid = -1;
+  if (myid == 0)
+  {
+    char ou_file[CONST_MAX_STRLEN];
+    sprintf(ou_file, "%s/seismo_archive.nc", output_dir);
+
+    int ierr = nc_create(ou_file, NC_CLOBBER | NC_64BIT_OFFSET, &ncid); handle_nc_err(ierr);
+    int dimid_str;
+    ierr = nc_def_dim(ncid, "name_strlen", IO_ARCHIVE_NAME_STRLEN, &dimid_str); handle_nc_err(ierr);
+
+    for (int m=0; m < IO_ARCHIVE_NUM_KIND; m++)
+    {
+      io_archive_kind_t *k = kd + m;
+      if (k->num_of_sta_all == 0) continue;
+
+      char name[CONST_MAX_STRLEN];
+      int dimid[3], dimid_str2[2], varid;
+      sprintf(name, "%s_station", k->kind);
+      ierr = nc_def_dim(ncid, name, k->num_of_sta_all, &dimid[0]); handle_nc_err(ierr);
+      sprintf(name, "%s_component", k->kind);
+      ierr = nc_def_dim(ncid, name, k->ncmp, &dimid[1]); handle_nc_err(ierr);
+      sprintf(name, "%s_time", k->kind);
+      ierr = nc_def_dim(ncid, name, k->max_nt, &dimid[2]); handle_nc_err(ierr);
+
+      dimid_str2[0] = dimid[0]; dimid_str2[1] = dimid_str;
+      sprintf(name, "%s_name", k->kind);
+      ierr = nc_def_var(ncid, name, NC_CHAR, 2, dimid_str2, &(k->varid_name)); handle_nc_err(ierr);
+      sprintf(name, "%s_x", k->kind);
+      ierr = nc_def_var(ncid, name, NC_FLOAT, 1, dimid, &(k->varid_xyz[0])); handle_nc_err(ierr);
+      sprintf(name, "%s_y", k->kind);
+      ierr = nc_def_var(ncid, name, NC_FLOAT, 1, dimid, &(k->varid_xyz[1])); handle_nc_err(ierr);
+      sprintf(name, "%s_z", k->kind);
+      ierr = nc_def_var(ncid, name, NC_FLOAT, 1, dimid, &(k->varid_xyz[2])); handle_nc_err(ierr);
+      dimid_str2[0] = dimid[1];
+      sprintf(name, "%s_component_name", k->kind);
+      ierr = nc_def_var(ncid, name, NC_CHAR, 2, dimid_str2, &(k->varid_cmp_name)); handle_nc_err(ierr);
+      sprintf(name, "%s_seismo", k->kind);
+      ierr = nc_def_var(ncid, name, NC_FLOAT, 3, dimid, &(k->varid_seismo)); handle_nc_err(ierr);
+      nc_put_att_float(ncid, k->varid_seismo, "delta", NC_FLOAT, 1, &(k->delta));
+
+      if (k->has_strain == 1)
+      {
+        sprintf(name, "%s_strain_component", k->kind);
+        ierr = nc_def_dim(ncid, name, 6, &dimid[1]); handle_nc_err(ierr);
+        sprintf(name, "%s_strain", k->kind);
+        ierr = nc_def_var(ncid, name, NC_FLOAT, 3, dimid, &(k->varid_strain)); handle_nc_err(ierr);
+        nc_put_att_float(ncid, k->varid_strain, "delta", NC_FLOAT, 1, &(k->delta));
+      }
+    }
+    ierr = nc_enddef(ncid); handle_nc_err(ierr);
+
+    //-- tables
+    char *str = (char *) malloc(IO_ARCHIVE_NAME_STRLEN);
+    for (int m=0; m < IO_ARCHIVE_NUM_KIND; m++)
+    {
+      io_archive_kind_t *k = kd + m;
+      if (k->num_of_sta_all == 0) continue;
+
+      for (int i=0; i < k->num_of_sta_all; i++)
+      {
+        size_t start[2] = { (size_t)i, 0 };
+        size_t count[2] = { 1, IO_ARCHIVE_NAME_STRLEN };
+        ierr = nc_put_vara_text(ncid, k->varid_name, start, count, k->sta_all[i].name);
+        handle_nc_err(ierr);
+        ierr = nc_put_var1_float(ncid, k->varid_xyz[0], start, &(k->sta_all[i].x)); handle_nc_err(ierr);
+        ierr = nc_put_var1_float(ncid, k->varid_xyz[1], start, &(k->sta_all[i].y)); handle_nc_err(ierr);
+        ierr = nc_put_var1_float(ncid, k->varid_xyz[2], start, &(k->sta_all[i].z)); handle_nc_err(ierr);
+      }
+      for (int icmp=0; icmp < k->ncmp; icmp++)
+      {
+        memset(str, 0, IO_ARCHIVE_NAME_STRLEN);
+        strncpy(str, (m == 2) ? fault_cmp_name[icmp] : cmp_name[icmp], IO_ARCHIVE_NAME_STRLEN-1);
+        size_t start[2] = { (size_t)icmp, 0 };
+        size_t count[2] = { 1, IO_ARCHIVE_NAME_STRLEN };
+        ierr = nc_put_vara_text(ncid, k->varid_cmp_name, start, count, str); handle_nc_err(ierr);
+      }
+      if (k->has_strain == 1) {
+        nc_put_att_text(ncid, k->varid_strain, "component_name", 24, "Exx Eyy Ezz Eyz Exz Exy ");
+      }
+    }
+    free(str);
+  }
+
+  //-- traces, thread by thread in order of stations
+  for (int m=0; m < IO_ARCHIVE_NUM_KIND; m++)
+  {
+    io_archive_kind_t *k = kd + m;
+    size_t siz_sta = (size_t) k->ncmp * k->max_nt;
+    float *buff = (float *) malloc((siz_sta + 1) * sizeof(float));
+
+    if (myid == 0)
+    {
+      int ista_all = 0;
+      for (int r=0; r < nprocs; r++)
+      {
+        for (int i=0; i < k->num_of_sta_thread[r]; i++)
+        {
+          if (r == 0) {
+            float *seismo = io_seismo_get(k->store, k->seismo[i], i * k->ncmp, k->ncmp, buff);
+            if (seismo != buff) memcpy(buff, seismo, siz_sta * sizeof(float));
+          } else {
+            MPI_Recv(buff, siz_sta, MPI_FLOAT, r, m, comm, MPI_STATUS_IGNORE);
+          }
+
+          size_t start[3] = { (size_t)ista_all, 0, 0 };
+          size_t count[3] = { 1, (size_t)k->ncmp, (size_t)k->max_nt };
+          int ierr = nc_put_vara_float(ncid, k->varid_seismo, start, count, buff);
+          handle_nc_err(ierr);
+
+          if (k->has_strain == 1)
+          {
+            io_archive_sta_t *sta = k->sta_all + ista_all;
+            io_recv_strain_el_iso(sta->lam, sta->mu, buff, k->max_nt);
+            count[1] = 6;
+            ierr = nc_put_vara_float(ncid, k->varid_strain, start, count, buff + 3 * k->max_nt);
+            handle_nc_err(ierr);
+          }
+          ista_all += 1;
+        }
+      }
+    }
+    else
+    {
+      for (int i=0; i < k->num_of_sta; i++)
+      {
+        float *seismo = io_seismo_get(k->store, k->seismo[i], i * k->ncmp, k->ncmp, buff);
+        MPI_Send(seismo, siz_sta, MPI_FLOAT, 0, m, comm);
+      }
+    }
+    free(buff);
+  }
+
+  if (myid == 0) {
+    int ierr = nc_close(ncid); handle_nc_err(ierr);
+  }
+
+  for (int m=0; m < IO_ARCHIVE_NUM_KIND; m++)
+  {
+    free(kd[m].sta);
+    free(kd[m].seismo);
+    free(kd[m].num_of_sta_thread);
+    if (myid == 0) free(kd[m].sta_all);
+  }
+  free(nbyte);
+  free(displs);
 
   return 0;
 }
@@ -899,7 +1426,7 @@ io_slice_locate(gd_t  *gd,
 int
 io_slice_nc_create(ioslice_t *ioslice, 
                   int num_of_vars, char **w3d_name,
-                  int ni, int nj, int nk,
+                  int ni, int nj, int nk, int *g_start,
                   int *topoid, ioslice_nc_t *ioslice_nc)
 {
   int ierr = 0;
@@ -950,6 +1477,8 @@ io_slice_nc_create(ioslice_t *ioslice,
                    NC_INT,1,ioslice->slice_x_indx+n);
     nc_put_att_int(ioslice_nc->ncid_slx[n],NC_GLOBAL,"coords_of_mpi_topo",
                    NC_INT,3,topoid);
+    nc_put_att_int(ioslice_nc->ncid_slx[n],NC_GLOBAL,"global_index_of_first_physical_points",
+                   NC_INT,CONST_NDIM,g_start);
     // end def
     ierr = nc_enddef(ioslice_nc->ncid_slx[n]); handle_nc_err(ierr);
   }
@@ -976,6 +1505,8 @@ io_slice_nc_create(ioslice_t *ioslice,
                    NC_INT,1,ioslice->slice_y_indx+n);
     nc_put_att_int(ioslice_nc->ncid_sly[n],NC_GLOBAL,"coords_of_mpi_topo",
                    NC_INT,3,topoid);
+    nc_put_att_int(ioslice_nc->ncid_sly[n],NC_GLOBAL,"global_index_of_first_physical_points",
+                   NC_INT,CONST_NDIM,g_start);
     // end def
     ierr = nc_enddef(ioslice_nc->ncid_sly[n]); handle_nc_err(ierr);
   }
@@ -1002,6 +1533,8 @@ io_slice_nc_create(ioslice_t *ioslice,
                    NC_INT,1,ioslice->slice_z_indx+n);
     nc_put_att_int(ioslice_nc->ncid_slz[n],NC_GLOBAL,"coords_of_mpi_topo",
                    NC_INT,3,topoid);
+    nc_put_att_int(ioslice_nc->ncid_slz[n],NC_GLOBAL,"global_index_of_first_physical_points",
+                   NC_INT,CONST_NDIM,g_start);
     // end def
     ierr = nc_enddef(ioslice_nc->ncid_slz[n]); handle_nc_err(ierr);
   }
@@ -1009,6 +1542,60 @@ io_slice_nc_create(ioslice_t *ioslice,
   return ierr;
 }
 
+/*
+ * open existing slice files to continue writing after restart
+ */
+
+int
+io_slice_nc_reopen(ioslice_t *ioslice, 
+                   int num_of_vars, char **w3d_name,
+                   ioslice_nc_t *ioslice_nc)
+{
+  int ierr = 0;
+
+  int num_of_slice[] = { ioslice->num_of_slice_x,
+                         ioslice->num_of_slice_y,
+                         ioslice->num_of_slice_z };
+
+  ioslice_nc->num_of_slice_x = num_of_slice[0];
+  ioslice_nc->num_of_slice_y = num_of_slice[1];
+  ioslice_nc->num_of_slice_z = num_of_slice[2];
+  ioslice_nc->num_of_vars    = num_of_vars   ;
+
+  // malloc vars
+  ioslice_nc->ncid_slx = (int *)malloc(num_of_slice[0]*sizeof(int));
+  ioslice_nc->ncid_sly = (int *)malloc(num_of_slice[1]*sizeof(int));
+  ioslice_nc->ncid_slz = (int *)malloc(num_of_slice[2]*sizeof(int));
+
+  ioslice_nc->timeid_slx = (int *)malloc(num_of_slice[0]*sizeof(int));
+  ioslice_nc->timeid_sly = (int *)malloc(num_of_slice[1]*sizeof(int));
+  ioslice_nc->timeid_slz = (int *)malloc(num_of_slice[2]*sizeof(int));
+
+  ioslice_nc->varid_slx = (int *)malloc(num_of_vars*num_of_slice[0]*sizeof(int));
+  ioslice_nc->varid_sly = (int *)malloc(num_of_vars*num_of_slice[1]*sizeof(int));
+  ioslice_nc->varid_slz = (int *)malloc(num_of_vars*num_of_slice[2]*sizeof(int));
+
+  char **fname [] = { ioslice->slice_x_fname, ioslice->slice_y_fname, ioslice->slice_z_fname };
+  int   *ncid  [] = { ioslice_nc->ncid_slx,   ioslice_nc->ncid_sly,   ioslice_nc->ncid_slz   };
+  int   *timeid[] = { ioslice_nc->timeid_slx, ioslice_nc->timeid_sly, ioslice_nc->timeid_slz };
+  int   *varid [] = { ioslice_nc->varid_slx,  ioslice_nc->varid_sly,  ioslice_nc->varid_slz  };
+
+  for (int idim=0; idim<CONST_NDIM; idim++)
+  {
+    for (int n=0; n<num_of_slice[idim]; n++)
+    {
+      ierr = nc_open(fname[idim][n], NC_WRITE, &ncid[idim][n]); handle_nc_err(ierr);
+      ierr = nc_inq_varid(ncid[idim][n], "time", &timeid[idim][n]); handle_nc_err(ierr);
+      for (int ivar=0; ivar<num_of_vars; ivar++) {
+        ierr = nc_inq_varid(ncid[idim][n], w3d_name[ivar],
+                            &varid[idim][ivar+n*num_of_vars]); handle_nc_err(ierr);
+      }
+    }
+  }
+
+  return ierr;
+}
+
 int
 io_slice_nc_put(ioslice_t    *ioslice,
                 ioslice_nc_t *ioslice_nc,
@@ -1016,7 +1603,8 @@ io_slice_nc_put(ioslice_t    *ioslice,
                 float *w_pre_d,
                 float *buff,
                 int   it,
-                float time)
+                float time,
+                mem_pool_t *pool_d)
 {
   int ierr = 0;
 
@@ -1048,7 +1636,7 @@ io_slice_nc_put(ioslice_t    *ioslice,
     int i = ioslice->slice_x_indx[n];
     size_t size = sizeof(float) * nj * nk; 
     float *buff_d;
-    buff_d = (float *) cuda_malloc(size);
+    buff_d = (float *) mem_pool_malloc(pool_d, size);
     dim3 block(8,8);
     dim3 grid;
     grid.x = (nj+block.x-1)/block.x;
@@ -1063,7 +1651,7 @@ io_slice_nc_put(ioslice_t    *ioslice,
                         ioslice_nc->varid_slx[n*num_of_vars + ivar],
                         startp, countp, buff);
     }
-    CUDACHECK(cudaFree(buff_d));
+    mem_pool_free(pool_d, buff_d);
   }
   // slice y
   for (int n=0; n < ioslice_nc->num_of_slice_y; n++)
@@ -1078,7 +1666,7 @@ io_slice_nc_put(ioslice_t    *ioslice,
     int j = ioslice->slice_y_indx[n];
     int size = sizeof(float) * ni * nk; 
     float *buff_d;
-    buff_d = (float *) cuda_malloc(size);
+    buff_d = (float *) mem_pool_malloc(pool_d, size);
     dim3 block(8,8);
     dim3 grid;
     grid.x = (ni+block.x-1)/block.x;
@@ -1093,7 +1681,7 @@ io_slice_nc_put(ioslice_t    *ioslice,
                         ioslice_nc->varid_sly[n*num_of_vars + ivar],
                         startp, countp, buff);
     }
-    CUDACHECK(cudaFree(buff_d));
+    mem_pool_free(pool_d, buff_d);
   }
 
   // slice z
@@ -1109,7 +1697,7 @@ io_slice_nc_put(ioslice_t    *ioslice,
     int k = ioslice->slice_z_indx[n];
     int size = sizeof(float) * ni * nj; 
     float *buff_d;
-    buff_d = (float *) cuda_malloc(size);
+    buff_d = (float *) mem_pool_malloc(pool_d, size);
     dim3 block(8,8);
     dim3 grid;
     grid.x = (ni+block.x-1)/block.x;
@@ -1124,7 +1712,7 @@ io_slice_nc_put(ioslice_t    *ioslice,
                           ioslice_nc->varid_slz[n*num_of_vars + ivar],
                           startp, countp, buff);
     }
-    CUDACHECK(cudaFree(buff_d));
+    mem_pool_free(pool_d, buff_d);
   }
 
   return ierr;
@@ -1143,8 +1731,12 @@ io_snapshot_locate(gd_t *gd,
                     int *snapshot_save_velocity,
                     int *snapshot_save_stress,
                     int *snapshot_save_strain,
+                    float *snapshot_compress_error_abs,
+                    float *snapshot_compress_error_rel,
+                    int   snapshot_compress_threads,
                     char *output_fname_part,
-                    char *output_dir)
+                    char *output_dir,
+                    MPI_Comm comm)
 {
   // malloc to max, num of snap will not be large
   if (number_of_snapshot > 0)
@@ -1165,6 +1757,9 @@ io_snapshot_locate(gd_t *gd,
     iosnap->out_vel    = (int *) malloc(number_of_snapshot * sizeof(int));
     iosnap->out_stress = (int *) malloc(number_of_snapshot * sizeof(int));
     iosnap->out_strain = (int *) malloc(number_of_snapshot * sizeof(int));
+    iosnap->zerr_abs   = (float *) malloc(number_of_snapshot * sizeof(float));
+    iosnap->zerr_rel   = (float *) malloc(number_of_snapshot * sizeof(float));
+    iosnap->zcomm      = (MPI_Comm *) malloc(number_of_snapshot * sizeof(MPI_Comm));
 
     iosnap->i1_to_glob = (int *) malloc(number_of_snapshot * sizeof(int));
     iosnap->j1_to_glob = (int *) malloc(number_of_snapshot * sizeof(int));
@@ -1174,6 +1769,7 @@ io_snapshot_locate(gd_t *gd,
   // init
 
   iosnap->siz_max_wrk = 0;
+  iosnap->num_of_zthread = snapshot_compress_threads;
 
   int isnap = 0;
 
@@ -1229,8 +1825,17 @@ io_snapshot_locate(gd_t *gd,
       if (gi > gd->gni2) break;
     }
 
+    int is_in_this = (ngi>0 && ngj>0 && ngk>0) ? 1 : 0;
+
+    // relative error bound is of value range over threads of snapshot,
+    //  split by all threads in same order of snapshots
+    MPI_Comm zcomm = MPI_COMM_NULL;
+    if (snapshot_compress_error_abs[n] <= 0.0 && snapshot_compress_error_rel[n] > 0.0) {
+      MPI_Comm_split(comm, is_in_this == 1 ? n : MPI_UNDEFINED, 0, &zcomm);
+    }
+
     // if in this proc
-    if (ngi>0 && ngj>0 && ngk>0)
+    if (is_in_this == 1)
     {
       iosnap->i1[isnap]  = gd_info_indx_glphy2lcext_i(gi1, gd);
       iosnap->j1[isnap]  = gd_info_indx_glphy2lcext_j(gj1, gd);
@@ -1249,6 +1854,10 @@ io_snapshot_locate(gd_t *gd,
       iosnap->out_stress[isnap] = snapshot_save_stress[n];
       iosnap->out_strain[isnap] = snapshot_save_strain[n];
 
+      iosnap->zerr_abs[isnap] = snapshot_compress_error_abs[n];
+      iosnap->zerr_rel[isnap] = snapshot_compress_error_rel[n];
+      iosnap->zcomm   [isnap] = zcomm;
+
       iosnap->i1_to_glob[isnap] = i_in_nc;
       iosnap->j1_to_glob[isnap] = j_in_nc;
       iosnap->k1_to_glob[isnap] = k_in_nc;
@@ -1271,9 +1880,43 @@ io_snapshot_locate(gd_t *gd,
   return 0;
 }
 
+// components in order of buff, V, T and E
+static const char *io_snap_cmp_name[] = {
+  "Vx", "Vy", "Vz",
+  "Txx", "Tyy", "Tzz", "Txz", "Tyz", "Txy",
+  "Exx", "Eyy", "Ezz", "Exz", "Eyz", "Exy" };
+
+static int
+io_snap_zsnap_init(iosnap_t *iosnap, iosnap_nc_t *iosnap_nc, int n)
+{
+  int is_cmp_out[ZSNAP_MAX_CMP];
+  for (int icmp=0; icmp < ZSNAP_MAX_CMP; icmp++)
+  {
+    if (icmp < CONST_NDIM) {
+      is_cmp_out[icmp] = iosnap->out_vel[n];
+    } else if (icmp < CONST_NDIM + CONST_NDIM_2) {
+      is_cmp_out[icmp] = iosnap->out_stress[n];
+    } else {
+      is_cmp_out[icmp] = iosnap->out_strain[n];
+    }
+  }
+
+  zsnap_init(iosnap_nc->zsnap + n, iosnap->zerr_abs[n], iosnap->zerr_rel[n],
+             iosnap->num_of_zthread,
+             iosnap->ni[n], iosnap->nj[n], iosnap->nk[n], is_cmp_out,
+             iosnap->zcomm[n]);
+
+  return 0;
+}
+
+/*
+ * compressed snapshot has fixed time dim of all frames, unwritten
+ *  frames keep fill value of zstart
+ */
 
 int
-io_snap_nc_create(iosnap_t *iosnap, iosnap_nc_t *iosnap_nc, int *topoid)
+io_snap_nc_create(iosnap_t *iosnap, iosnap_nc_t *iosnap_nc, int *topoid,
+                  int nt_total)
 {
   int ierr = 0;
 
@@ -1294,6 +1937,8 @@ io_snap_nc_create(iosnap_t *iosnap, iosnap_nc_t *iosnap_nc, int *topoid)
     iosnap_nc->cur_it[n] = 0;
   }
 
+  iosnap_nc->zsnap = (zsnap_t *)malloc(num_of_snap*sizeof(zsnap_t));
+
   int *ncid   = iosnap_nc->ncid;
   int *timeid = iosnap_nc->timeid;
   int *varid_V = iosnap_nc->varid_V;
@@ -1317,8 +1962,23 @@ io_snap_nc_create(iosnap_t *iosnap, iosnap_nc_t *iosnap_nc, int *topoid)
     int snap_out_T = iosnap->out_stress[n];
     int snap_out_E = iosnap->out_strain[n];
 
-    ierr = nc_create(snap_fname[n], NC_CLOBBER, &ncid[n]);       handle_nc_err(ierr);
-    ierr = nc_def_dim(ncid[n], "time", NC_UNLIMITED, &dimid[0]); handle_nc_err(ierr);
+    io_snap_zsnap_init(iosnap, iosnap_nc, n);
+    zsnap_t *zsnap = iosnap_nc->zsnap + n;
+
+    // zdata of compressed frames may pass 4 GiB, so 64 bit data format
+    size_t snap_nt = NC_UNLIMITED;
+    int cmode = NC_CLOBBER;
+    if (zsnap->enable == 1) {
+      cmode = NC_CLOBBER | NC_64BIT_DATA;
+      int snap_nt_total = (nt_total - iosnap->it1[n]) / iosnap->dit[n];
+      snap_nt = snap_nt_total > 0 ? snap_nt_total + 1 : 1;
+      snap_out_V = 0;
+      snap_out_T = 0;
+      snap_out_E = 0;
+    }
+
+    ierr = nc_create(snap_fname[n], cmode, &ncid[n]);            handle_nc_err(ierr);
+    ierr = nc_def_dim(ncid[n], "time", snap_nt, &dimid[0]);      handle_nc_err(ierr);
     ierr = nc_def_dim(ncid[n], "k", snap_nk     , &dimid[1]);    handle_nc_err(ierr);
     ierr = nc_def_dim(ncid[n], "j", snap_nj     , &dimid[2]);    handle_nc_err(ierr);
     ierr = nc_def_dim(ncid[n], "i", snap_ni     , &dimid[3]);    handle_nc_err(ierr);
@@ -1346,6 +2006,8 @@ io_snap_nc_create(iosnap_t *iosnap, iosnap_nc_t *iosnap_nc, int *topoid)
        ierr = nc_def_var(ncid[n],"Eyz",NC_FLOAT,4,dimid,&varid_E[n*CONST_NDIM_2+4]); handle_nc_err(ierr);
        ierr = nc_def_var(ncid[n],"Exy",NC_FLOAT,4,dimid,&varid_E[n*CONST_NDIM_2+5]); handle_nc_err(ierr);
     }
+    // coded components
+    zsnap_def(zsnap, ncid[n], dimid[0], io_snap_cmp_name);
     // attribute: index in output snapshot, index w ghost in thread
     int g_start[] = { iosnap->i1_to_glob[n],
                       iosnap->j1_to_glob[n],
@@ -1369,8 +2031,105 @@ io_snap_nc_create(iosnap_t *iosnap, iosnap_nc_t *iosnap_nc, int *topoid)
   return ierr;
 }
 
+/*
+ * open existing snapshot files after restart, cur_it is restored
+ *  from checkpoint
+ */
+
+int
+io_snap_nc_reopen(iosnap_t *iosnap, iosnap_nc_t *iosnap_nc)
+{
+  int ierr = 0;
+
+  int num_of_snap = iosnap->num_of_snap;
+  char **snap_fname = iosnap->fname;
+
+  iosnap_nc->num_of_snap = num_of_snap;
+  iosnap_nc->ncid = (int *)malloc(num_of_snap*sizeof(int));
+  iosnap_nc->timeid = (int *)malloc(num_of_snap*sizeof(int));
+
+  iosnap_nc->varid_V = (int *)malloc(num_of_snap*CONST_NDIM*sizeof(int));
+  iosnap_nc->varid_T = (int *)malloc(num_of_snap*CONST_NDIM_2*sizeof(int));
+  iosnap_nc->varid_E = (int *)malloc(num_of_snap*CONST_NDIM_2*sizeof(int));
+
+  iosnap_nc->cur_it = (int *)malloc(num_of_snap*sizeof(int));
+  for (int n=0; n<num_of_snap; n++) {
+    iosnap_nc->cur_it[n] = 0;
+  }
+
+  iosnap_nc->zsnap = (zsnap_t *)malloc(num_of_snap*sizeof(zsnap_t));
+
+  int *ncid   = iosnap_nc->ncid;
+  int *timeid = iosnap_nc->timeid;
+
+  const char *name_V[] = {"Vx", "Vy", "Vz"};
+  const char *name_T[] = {"Txx", "Tyy", "Tzz", "Txz", "Tyz", "Txy"};
+  const char *name_E[] = {"Exx", "Eyy", "Ezz", "Exz", "Eyz", "Exy"};
+
+  for (int n=0; n<num_of_snap; n++)
+  {
+    ierr = nc_open(snap_fname[n], NC_WRITE, &ncid[n]);       handle_nc_err(ierr);
+    ierr = nc_inq_varid(ncid[n], "time", &timeid[n]);       handle_nc_err(ierr);
+
+    io_snap_zsnap_init(iosnap, iosnap_nc, n);
+    if (iosnap_nc->zsnap[n].enable == 1) {
+      zsnap_inq(iosnap_nc->zsnap + n, ncid[n], io_snap_cmp_name);
+      continue;
+    }
+
+    if (iosnap->out_vel[n]==1) {
+      for (int i=0; i<CONST_NDIM; i++) {
+        ierr = nc_inq_varid(ncid[n], name_V[i], &iosnap_nc->varid_V[n*CONST_NDIM+i]);
+        handle_nc_err(ierr);
+      }
+    }
+    if (iosnap->out_stress[n]==1) {
+      for (int i=0; i<CONST_NDIM_2; i++) {
+        ierr = nc_inq_varid(ncid[n], name_T[i], &iosnap_nc->varid_T[n*CONST_NDIM_2+i]);
+        handle_nc_err(ierr);
+      }
+    }
+    if (iosnap->out_strain[n]==1) {
+      for (int i=0; i<CONST_NDIM_2; i++) {
+        ierr = nc_inq_varid(ncid[n], name_E[i], &iosnap_nc->varid_E[n*CONST_NDIM_2+i]);
+        handle_nc_err(ierr);
+      }
+    }
+  }
+
+  return ierr;
+}
+
+
+/*
+ * one component of frame, to nc or to staging of compressor
+ */
+
+static int
+io_snap_put_cmp(iosnap_nc_t *iosnap_nc, int n, int icmp,
+                size_t *startp, size_t *countp, float *var)
+{
+  int ierr = 0;
+
+  if (iosnap_nc->zsnap[n].enable == 1)
+  {
+    float *frame = zsnap_frame(iosnap_nc->zsnap + n, icmp);
+    memcpy(frame, var, iosnap_nc->zsnap[n].siz_frame * sizeof(float));
+    return ierr;
+  }
 
+  int varid;
+  if (icmp < CONST_NDIM) {
+    varid = iosnap_nc->varid_V[n*CONST_NDIM + icmp];
+  } else if (icmp < CONST_NDIM + CONST_NDIM_2) {
+    varid = iosnap_nc->varid_T[n*CONST_NDIM_2 + icmp - CONST_NDIM];
+  } else {
+    varid = iosnap_nc->varid_E[n*CONST_NDIM_2 + icmp - CONST_NDIM - CONST_NDIM_2];
+  }
+  ierr = nc_put_vara_float(iosnap_nc->ncid[n], varid, startp, countp, var);
 
+  return ierr;
+}
 
 /*
  * 
@@ -1381,12 +2140,14 @@ io_snap_nc_put(iosnap_t *iosnap,
                iosnap_nc_t *iosnap_nc,
                gd_t    *gd,
                md_t    *md,
+               resid_t *resid,
                wav_t   *wav,
                float *w_pre_d,
                float *buff,
                int   nt_total,
                int   it,
-               float time)
+               float time,
+               mem_pool_t *pool_d)
 {
   int ierr = 0;
 
@@ -1427,10 +2188,13 @@ io_snap_nc_put(iosnap_t *iosnap,
       size_t countp[] = { 1, snap_nk, snap_nj, snap_ni };
       size_t start_tdim = iosnap_nc->cur_it[n];
 
+      // previous coded frame out before staging this one
+      zsnap_write(iosnap_nc->zsnap + n, iosnap_nc->ncid[n]);
+
       // put time var
       nc_put_var1_float(iosnap_nc->ncid[n],iosnap_nc->timeid[n],&start_tdim,&time);
       int size = sizeof(float)*snap_max_num;
-      buff_d = (float *) cuda_malloc(size);
+      buff_d = (float *) mem_pool_malloc(pool_d, size);
       dim3 block(8,8,8);
       dim3 grid;
       grid.x = (snap_ni+block.x-1)/block.x;
@@ -1444,22 +2208,19 @@ io_snap_nc_put(iosnap_t *iosnap,
                  siz_iy,siz_iz,snap_i1,snap_ni,snap_di,snap_j1,snap_nj,
                  snap_dj,snap_k1,snap_nk,snap_dk,buff_d);
         CUDACHECK(cudaMemcpy(buff+0*siz_icmp,buff_d,size,cudaMemcpyDeviceToHost));
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_V[n*CONST_NDIM+0],
-              startp,countp,buff+0*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,0,startp,countp,buff+0*siz_icmp);
 
         io_snap_pack_buff<<<grid, block>>> (w_pre_d + wav->Vy_pos,
                  siz_iy,siz_iz,snap_i1,snap_ni,snap_di,snap_j1,snap_nj,
                  snap_dj,snap_k1,snap_nk,snap_dk,buff_d);
         CUDACHECK(cudaMemcpy(buff+1*siz_icmp,buff_d,size,cudaMemcpyDeviceToHost));
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_V[n*CONST_NDIM+1],
-              startp,countp,buff+1*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,1,startp,countp,buff+1*siz_icmp);
 
         io_snap_pack_buff<<<grid, block>>> (w_pre_d + wav->Vz_pos,
                  siz_iy,siz_iz,snap_i1,snap_ni,snap_di,snap_j1,snap_nj,
                  snap_dj,snap_k1,snap_nk,snap_dk,buff_d);
         CUDACHECK(cudaMemcpy(buff+2*siz_icmp,buff_d,size,cudaMemcpyDeviceToHost));
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_V[n*CONST_NDIM+2],
-              startp,countp,buff+2*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,2,startp,countp,buff+2*siz_icmp);
       }
 
       if (snap_out_T==1)
@@ -1468,43 +2229,37 @@ io_snap_nc_put(iosnap_t *iosnap,
                  siz_iy,siz_iz,snap_i1,snap_ni,snap_di,snap_j1,snap_nj,
                  snap_dj,snap_k1,snap_nk,snap_dk,buff_d);
         CUDACHECK(cudaMemcpy(buff+3*siz_icmp,buff_d,size,cudaMemcpyDeviceToHost));
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_T[n*CONST_NDIM_2+0],
-              startp,countp,buff+3*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,3,startp,countp,buff+3*siz_icmp);
 
         io_snap_pack_buff<<<grid, block>>> (w_pre_d + wav->Tyy_pos,
                  siz_iy,siz_iz,snap_i1,snap_ni,snap_di,snap_j1,snap_nj,
                  snap_dj,snap_k1,snap_nk,snap_dk,buff_d);
         CUDACHECK(cudaMemcpy(buff+4*siz_icmp,buff_d,size,cudaMemcpyDeviceToHost));
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_T[n*CONST_NDIM_2+1],
-              startp,countp,buff+4*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,4,startp,countp,buff+4*siz_icmp);
         
         io_snap_pack_buff<<<grid, block>>> (w_pre_d + wav->Tzz_pos,
                  siz_iy,siz_iz,snap_i1,snap_ni,snap_di,snap_j1,snap_nj,
                  snap_dj,snap_k1,snap_nk,snap_dk,buff_d);
         CUDACHECK(cudaMemcpy(buff+5*siz_icmp,buff_d,size,cudaMemcpyDeviceToHost));
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_T[n*CONST_NDIM_2+2],
-              startp,countp,buff+5*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,5,startp,countp,buff+5*siz_icmp);
         
         io_snap_pack_buff<<<grid, block>>> (w_pre_d + wav->Txz_pos,
                  siz_iy,siz_iz,snap_i1,snap_ni,snap_di,snap_j1,snap_nj,
                  snap_dj,snap_k1,snap_nk,snap_dk,buff_d);
         CUDACHECK(cudaMemcpy(buff+6*siz_icmp,buff_d,size,cudaMemcpyDeviceToHost));
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_T[n*CONST_NDIM_2+3],
-              startp,countp,buff+6*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,6,startp,countp,buff+6*siz_icmp);
 
         io_snap_pack_buff<<<grid, block>>> (w_pre_d + wav->Tyz_pos,
                  siz_iy,siz_iz,snap_i1,snap_ni,snap_di,snap_j1,snap_nj,
                  snap_dj,snap_k1,snap_nk,snap_dk,buff_d);
         CUDACHECK(cudaMemcpy(buff+7*siz_icmp,buff_d,size,cudaMemcpyDeviceToHost));
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_T[n*CONST_NDIM_2+4],
-              startp,countp,buff+7*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,7,startp,countp,buff+7*siz_icmp);
 
         io_snap_pack_buff<<<grid, block>>> (w_pre_d + wav->Txy_pos,
                  siz_iy,siz_iz,snap_i1,snap_ni,snap_di,snap_j1,snap_nj,
                  snap_dj,snap_k1,snap_nk,snap_dk,buff_d);
         CUDACHECK(cudaMemcpy(buff+8*siz_icmp,buff_d,size,cudaMemcpyDeviceToHost));
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_T[n*CONST_NDIM_2+5],
-              startp,countp,buff+8*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,8,startp,countp,buff+8*siz_icmp);
       }
       if (snap_out_E==1)
       {
@@ -1540,8 +2295,10 @@ io_snap_nc_put(iosnap_t *iosnap,
                    snap_dj,snap_k1,snap_nk,snap_dk,buff_d);
           CUDACHECK(cudaMemcpy(buff+8*siz_icmp,buff_d,size,cudaMemcpyDeviceToHost));
         }
-        // convert to strain
+        // convert to strain, host media may be released after upload
+        resid_get(resid, md->v4d);
         io_snap_stress_to_strain_eliso(md->lambda,md->mu,
+                                       md->mat_id,md->mat_nbyte,
                                        buff + 3*siz_icmp,   //Txx
                                        buff + 4*siz_icmp,   //Tyy
                                        buff + 5*siz_icmp,   //Tzz
@@ -1557,24 +2314,21 @@ io_snap_nc_put(iosnap_t *iosnap,
                                        siz_iy,siz_iz,snap_i1,snap_ni,snap_di,snap_j1,snap_nj,
                                        snap_dj,snap_k1,snap_nk,snap_dk);
         // export
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_E[n*CONST_NDIM_2+0],
-              startp,countp,buff + 9*siz_icmp);
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_E[n*CONST_NDIM_2+1],
-              startp,countp,buff + 10*siz_icmp);
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_E[n*CONST_NDIM_2+2],
-              startp,countp,buff + 11*siz_icmp);
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_E[n*CONST_NDIM_2+3],
-              startp,countp,buff + 12*siz_icmp);
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_E[n*CONST_NDIM_2+4],
-              startp,countp,buff + 13*siz_icmp);
-        nc_put_vara_float(iosnap_nc->ncid[n],iosnap_nc->varid_E[n*CONST_NDIM_2+5],
-              startp,countp,buff + 14*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,9,startp,countp,buff + 9*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,10,startp,countp,buff + 10*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,11,startp,countp,buff + 11*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,12,startp,countp,buff + 12*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,13,startp,countp,buff + 13*siz_icmp);
+        io_snap_put_cmp(iosnap_nc,n,14,startp,countp,buff + 14*siz_icmp);
 
       }
 
+      // coded in background till next output
+      zsnap_start(iosnap_nc->zsnap + n, iosnap_nc->cur_it[n]);
+
       iosnap_nc->cur_it[n] += 1;
 
-      CUDACHECK(cudaFree(buff_d));
+      mem_pool_free(pool_d, buff_d);
     } // if it
   } // loop snap
 
@@ -1584,6 +2338,8 @@ io_snap_nc_put(iosnap_t *iosnap,
 int
 io_snap_stress_to_strain_eliso(float *lam3d,
                                float *mu3d,
+                               void  *mat_id,
+                               int    mat_nbyte,
                                float *Txx,
                                float *Tyy,
                                float *Tzz,
@@ -1609,7 +2365,7 @@ io_snap_stress_to_strain_eliso(float *lam3d,
                                int increk)
 {
   size_t iptr_snap=0;
-  size_t i,j,k,iptr,iptr_j,iptr_k;
+  size_t i,j,k,iptr,iptr_j,iptr_k,iptr_md;
   float lam,mu,E1,E2,E3,E0;
 
   for (int n3=0; n3<countk; n3++)
@@ -1627,8 +2383,9 @@ io_snap_stress_to_strain_eliso(float *lam3d,
         iptr = i + iptr_j;
         iptr_snap = n1 + n2 * counti + n3 * counti * countj;
 
-        lam = lam3d[iptr];
-        mu  =  mu3d[iptr];
+        iptr_md = md_mat_iptr(mat_id, mat_nbyte, iptr);
+        lam = lam3d[iptr_md];
+        mu  =  mu3d[iptr_md];
         
         E1 = (lam + mu) / (mu * ( 3.0 * lam + 2.0 * mu));
         E2 = - lam / ( 2.0 * mu * (3.0 * lam + 2.0 * mu));
@@ -1733,12 +2490,30 @@ io_slice_nc_close(ioslice_nc_t *ioslice_nc)
   return 0;
 }
 
+/*
+ * write coded frames still staged, before checkpoint and close
+ */
+
+int
+io_snap_nc_flush(iosnap_nc_t *iosnap_nc)
+{
+  for (int n=0; n < iosnap_nc->num_of_snap; n++)
+  {
+    zsnap_write(iosnap_nc->zsnap + n, iosnap_nc->ncid[n]);
+  }
+
+  return 0;
+}
+
 int
 io_snap_nc_close(iosnap_nc_t *iosnap_nc)
 {
+  io_snap_nc_flush(iosnap_nc);
+
   for (int n=0; n < iosnap_nc->num_of_snap; n++)
   {
     nc_close(iosnap_nc->ncid[n]);
+    zsnap_free(iosnap_nc->zsnap + n);
   }
 
   return 0;
@@ -1824,11 +2599,12 @@ iorecv_print(iorecv_t *iorecv)
 }
 
 int
-PG_slice_output(float *PG, gd_t *gd, char *output_dir, char *frame_coords, int *topoid)
+PG_slice_output(float *PG, gd_t *gd, im_t *im, char *output_dir, char *frame_coords, int *topoid)
 {
   // output one time z slice
   // used for PGV PGA and PGD
   // cmp is PGV PGA PGD, component x, y, z
+  // CAV, Arias, D5_95 and PSA of each period are added if im is enabled
   int nx = gd->nx; 
   int ny = gd->ny;
   int ni = gd->ni; 
@@ -1855,6 +2631,26 @@ PG_slice_output(float *PG, gd_t *gd, char *output_dir, char *frame_coords, int *
   {
     if(nc_def_var(ncid, PG_cmp[i], NC_FLOAT,2,dimid, &varid[i])) handle_nc_err(ierr);
   }
+  int num_of_im = (im->enable == 1) ? im->num_of_layer : 0;
+  int *varid_im = (int *) malloc((num_of_im + 1) * sizeof(int));
+  for (int n=0; n<num_of_im; n++)
+  {
+    char im_name[CONST_MAX_STRLEN];
+    if (n == IM_CAV) {
+      sprintf(im_name, "CAV");
+    } else if (n == IM_ARIAS) {
+      sprintf(im_name, "Arias");
+    } else if (n == IM_D5_95) {
+      sprintf(im_name, "D5_95");
+    } else {
+      sprintf(im_name, "PSA_%gs", im->period[n-IM_PSA]);
+    }
+    ierr = nc_def_var(ncid, im_name, NC_FLOAT, 2, dimid, &varid_im[n]); handle_nc_err(ierr);
+    if (n >= IM_PSA) {
+      nc_put_att_float(ncid, varid_im[n], "period", NC_FLOAT, 1, &(im->period[n-IM_PSA]));
+      nc_put_att_float(ncid, varid_im[n], "damping", NC_FLOAT, 1, &(im->damping));
+    }
+  }
   int g_start[2] = {gni1,gnj1}; 
   int phy_size[2] = {ni,nj}; 
   nc_put_att_int(ncid,NC_GLOBAL,"global_index_of_first_physical_points",
@@ -1872,6 +2668,11 @@ PG_slice_output(float *PG, gd_t *gd, char *output_dir, char *frame_coords, int *
   float *ptr = PG + i*nx*ny; 
   ierr = nc_put_var_float(ncid,varid[i],ptr);
   }
+  for (int n=0; n<num_of_im; n++)
+  {
+    ierr = nc_put_var_float(ncid, varid_im[n], im->im + n*im->siz_slice); handle_nc_err(ierr);
+  }
+  free(varid_im);
   // close file
   ierr = nc_close(ncid); handle_nc_err(ierr);
 
@@ -1948,9 +2749,165 @@ io_fault_locate(gd_t *gd,
   return ierr;
 }
 
+/*
+ * move located nc files to another dir, file names are kept
+ */
+
+static void
+io_fname_set_dir(char *fname, char *output_dir)
+{
+  char base[CONST_MAX_STRLEN];
+  char *p = strrchr(fname, '/');
+  sprintf(base, "%s", p == NULL ? fname : p+1);
+  sprintf(fname, "%s/%s", output_dir, base);
+}
+
+int
+io_output_set_dir(iofault_t *iofault, ioslice_t *ioslice, iosnap_t *iosnap,
+                  char *output_dir)
+{
+  for (int i=0; i<iofault->number_fault; i++) {
+    io_fname_set_dir(iofault->fault_fname[i], output_dir);
+  }
+  for (int n=0; n<ioslice->num_of_slice_x; n++) {
+    io_fname_set_dir(ioslice->slice_x_fname[n], output_dir);
+  }
+  for (int n=0; n<ioslice->num_of_slice_y; n++) {
+    io_fname_set_dir(ioslice->slice_y_fname[n], output_dir);
+  }
+  for (int n=0; n<ioslice->num_of_slice_z; n++) {
+    io_fname_set_dir(ioslice->slice_z_fname[n], output_dir);
+  }
+  for (int n=0; n<iosnap->num_of_snap; n++) {
+    io_fname_set_dir(iosnap->fname[n], output_dir);
+  }
+
+  return 0;
+}
+
+/*
+ * zero seismo of stations and lines before another run
+ */
+
+int
+io_seismo_reset(iorecv_t *iorecv, ioline_t *ioline, io_fault_recv_t *io_fault_recv)
+{
+  for (int ir=0; ir<iorecv->total_number; ir++) {
+    memset(iorecv->recvone[ir].seismo, 0,
+           sizeof(float)*iorecv->ncmp*iorecv->nt_buff);
+  }
+  for (int n=0; n<ioline->num_of_lines; n++) {
+    memset(ioline->recv_seismo[n], 0,
+           sizeof(float)*ioline->line_nr[n]*ioline->ncmp*ioline->nt_buff);
+  }
+  for (int ir=0; ir<io_fault_recv->total_number; ir++) {
+    memset(io_fault_recv->fault_recvone[ir].seismo, 0,
+           sizeof(float)*io_fault_recv->ncmp*io_fault_recv->nt_buff);
+  }
+  io_fault_recv_share_clear(io_fault_recv);
+  decim_reset(&iorecv->decim);
+  decim_reset(&ioline->decim);
+  decim_reset(&io_fault_recv->decim);
+  seis_store_reset(&iorecv->store);
+  seis_store_reset(&ioline->store);
+  seis_store_reset(&io_fault_recv->store);
+  spec_reset(&iorecv->spec);
+
+  return 0;
+}
+
+/*
+ * last samples of decimated seismo, after all steps are kept and
+ *  shared fault stations reduced, then the last blocks of trace stores
+ */
+
+int
+io_seismo_finish(iorecv_t *iorecv, ioline_t *ioline, io_fault_recv_t *io_fault_recv,
+                 int nt_total)
+{
+  for (int ir=0; ir<iorecv->total_number; ir++) {
+    for (int icmp=0; icmp<iorecv->ncmp; icmp++) {
+      decim_finish_trace(&iorecv->decim, ir*iorecv->ncmp+icmp, nt_total,
+                         iorecv->recvone[ir].seismo + icmp*iorecv->nt_buff);
+    }
+  }
+
+  int itrace = 0;
+  for (int n=0; n<ioline->num_of_lines; n++) {
+    for (int ir=0; ir<ioline->line_nr[n]; ir++) {
+      float *this_seismo = ioline->recv_seismo[n] + ir * ioline->nt_buff * ioline->ncmp;
+      for (int icmp=0; icmp<ioline->ncmp; icmp++) {
+        decim_finish_trace(&ioline->decim, itrace, nt_total,
+                           this_seismo + icmp*ioline->nt_buff);
+        itrace += 1;
+      }
+    }
+  }
+
+  for (int ir=0; ir<io_fault_recv->total_number; ir++) {
+    for (int icmp=0; icmp<io_fault_recv->ncmp; icmp++) {
+      decim_finish_trace(&io_fault_recv->decim, ir*io_fault_recv->ncmp+icmp, nt_total,
+                         io_fault_recv->fault_recvone[ir].seismo + icmp*io_fault_recv->nt_buff);
+    }
+  }
+
+  seis_store_put(&iorecv->store, iorecv->max_nt);
+  seis_store_put(&ioline->store, ioline->max_nt);
+  seis_store_put(&io_fault_recv->store, io_fault_recv->max_nt);
+
+  return 0;
+}
+
+/*
+ * trace stores of this run in output_dir, kept samples are loaded from
+ *  checkpoint before open at restart
+ */
+
+int
+io_seismo_stream_open(iorecv_t *iorecv, ioline_t *ioline, io_fault_recv_t *io_fault_recv,
+                      char *output_dir, int myid, int is_restart)
+{
+  char fname[CONST_MAX_STRLEN];
+
+  sprintf(fname, "%s/store_recv_rank%d.bin", output_dir, myid);
+  seis_store_open(&iorecv->store, fname, is_restart);
+
+  sprintf(fname, "%s/store_line_rank%d.bin", output_dir, myid);
+  seis_store_open(&ioline->store, fname, is_restart);
+
+  sprintf(fname, "%s/store_fault_recv_rank%d.bin", output_dir, myid);
+  seis_store_open(&io_fault_recv->store, fname, is_restart);
+
+  return 0;
+}
+
+/*
+ * written blocks are on disk, before checkpoint
+ */
+
+int
+io_seismo_stream_wait(iorecv_t *iorecv, ioline_t *ioline, io_fault_recv_t *io_fault_recv)
+{
+  seis_store_wait(&iorecv->store);
+  seis_store_wait(&ioline->store);
+  seis_store_wait(&io_fault_recv->store);
+
+  return 0;
+}
+
+int
+io_seismo_stream_close(iorecv_t *iorecv, ioline_t *ioline, io_fault_recv_t *io_fault_recv)
+{
+  seis_store_close(&iorecv->store);
+  seis_store_close(&ioline->store);
+  seis_store_close(&io_fault_recv->store);
+
+  return 0;
+}
+
 int
 io_fault_nc_create(iofault_t *iofault, 
-                   int ni, int nj, int nk,
+                   int ni, int nj, int nk, int *g_start,
                    int *topoid, iofault_nc_t *iofault_nc)
 {
   int ierr = 0;
@@ -2016,6 +2973,8 @@ io_fault_nc_create(iofault_t *iofault,
                    NC_INT,1,iofault->fault_local_index+i);
     nc_put_att_int(iofault_nc->ncid[i],NC_GLOBAL,"coords_of_mpi_topo",
                    NC_INT,3,topoid);
+    nc_put_att_int(iofault_nc->ncid[i],NC_GLOBAL,"global_index_of_first_physical_points",
+                   NC_INT,CONST_NDIM,g_start);
 
     ierr = nc_enddef(iofault_nc->ncid[i]); handle_nc_err(ierr);
   }
@@ -2023,6 +2982,39 @@ io_fault_nc_create(iofault_t *iofault,
   return ierr;
 }
 
+/*
+ * open existing fault files to continue writing after restart
+ */
+
+int
+io_fault_nc_reopen(iofault_t *iofault, iofault_nc_t *iofault_nc)
+{
+  int ierr = 0;
+  int number_fault = iofault->number_fault;
+
+  iofault_nc->number_fault = number_fault;
+  int num_of_vars  = 20;  // same as io_fault_nc_create
+  iofault_nc->num_of_vars = num_of_vars;
+
+  iofault_nc->ncid   = (int *)malloc(number_fault*sizeof(int));
+  iofault_nc->varid  = (int *)malloc(num_of_vars*number_fault*sizeof(int));
+
+  const char *var_name[] = {"time", "Tn", "Ts1", "Ts2", "Vs", "Vs1", "Vs2",
+                            "Slip", "Slip1", "Slip2", "Peak_vs", "Init_t0"};
+
+  for (int i=0; i<number_fault; i++)
+  {
+    ierr = nc_open(iofault->fault_fname[i], NC_WRITE, &(iofault_nc->ncid[i])); handle_nc_err(ierr);
+    for (int ivar=0; ivar<12; ivar++) {
+      ierr = nc_inq_varid(iofault_nc->ncid[i], var_name[ivar],
+                          &(iofault_nc->varid[ivar+i*num_of_vars]));
+      handle_nc_err(ierr);
+    }
+  }
+
+  return ierr;
+}
+
 int
 io_fault_nc_put(iofault_nc_t *iofault_nc,
                 gd_t     *gd,
@@ -2030,7 +3022,8 @@ io_fault_nc_put(iofault_nc_t *iofault_nc,
                 fault_t  F_d,
                 float *buff,
                 int   it,
-                float time)
+                float time,
+                mem_pool_t *pool_d)
 {
   int ierr = 0;
 
@@ -2039,7 +3032,7 @@ io_fault_nc_put(iofault_nc_t *iofault_nc,
   int   ny  = gd->ny;
   size_t size = sizeof(float) * nj * nk; 
   float *buff_d;
-  buff_d = (float *) cuda_malloc(size);
+  buff_d = (float *) mem_pool_malloc(pool_d, size);
 
   size_t startp[] = { it, 0, 0 };
   size_t countp[] = { 1, nk, nj};
@@ -2093,7 +3086,7 @@ io_fault_nc_put(iofault_nc_t *iofault_nc,
     nc_put_vara_float(iofault_nc->ncid[id], iofault_nc->varid[9+id*num_of_vars], startp, countp, buff); 
   }
 
-  CUDACHECK(cudaFree(buff_d));
+  mem_pool_free(pool_d, buff_d);
   return ierr;
 }
 
@@ -2102,7 +3095,8 @@ io_fault_end_t_nc_put(iofault_nc_t *iofault_nc,
                       gd_t     *gd,
                       fault_t  *F,
                       fault_t  F_d,
-                      float *buff)
+                      float *buff,
+                      mem_pool_t *pool_d)
 {
   int ierr = 0;
 
@@ -2111,7 +3105,7 @@ io_fault_end_t_nc_put(iofault_nc_t *iofault_nc,
   int ny  = gd->ny;
   size_t size = sizeof(float) * nj * nk; 
   float *buff_d;
-  buff_d = (float *) cuda_malloc(size);
+  buff_d = (float *) mem_pool_malloc(pool_d, size);
 
   size_t startp[] = {  0, 0 };
   size_t countp[] = { nk, nj};
@@ -2133,7 +3127,7 @@ io_fault_end_t_nc_put(iofault_nc_t *iofault_nc,
     CUDACHECK(cudaMemcpy(buff,buff_d,size,cudaMemcpyDeviceToHost));
     nc_put_vara_float(iofault_nc->ncid[id], iofault_nc->varid[11+id*num_of_vars], startp, countp, buff); 
   }
-  CUDACHECK(cudaFree(buff_d));
+  mem_pool_free(pool_d, buff_d);
 
   return ierr;
 }
@@ -2165,14 +3159,20 @@ io_fault_nc_close(iofault_nc_t *iofault_nc)
 
 /*
  * read in station list file and locate station
+ *  point n of the 2x2 stencil is (j + n%2, k + n/2), points of zero
+ *  weight are not used. a station is kept by the thread of its point 0,
+ *  other threads with points of a shared station keep a part of it
  */
 int
 io_fault_recv_read_locate(gd_t      *gd,
                           io_fault_recv_t  *io_fault_recv,
                           int       nt_total,
+                          int       decimation,
+                          int       stream_every,
                           int       num_of_vars,
                           int       *fault_indx,
                           char      *in_filenm,
+                          int       reduce_every,
                           MPI_Comm  comm,
                           int       myid)
 {
@@ -2180,7 +3180,14 @@ io_fault_recv_read_locate(gd_t      *gd,
   char line[500];
 
   io_fault_recv->total_number = 0;
-  io_fault_recv->flag_swap = 0;
+  io_fault_recv->num_of_part  = 0;
+  io_fault_recv->num_of_share = 0;
+  io_fault_recv->reduce_every = reduce_every > 0 ? reduce_every : 1;
+  io_fault_recv->nt_share     = 0;
+  io_fault_recv->it_share     = 0;
+  io_fault_recv->fault_recvone  = NULL;
+  io_fault_recv->fault_recvpart = NULL;
+  io_fault_recv->share_buff     = NULL;
   if (!(fp = fopen (in_filenm, "rt")))
 	{
     fprintf(stdout,"#########         ########\n");
@@ -2193,92 +3200,86 @@ io_fault_recv_read_locate(gd_t      *gd,
 
   int total_point_y = gd->total_point_y;
   int total_point_z = gd->total_point_z;
-  int gnj2 = gd->gnj2;
-  int gnk2 = gd->gnk2;
   // number of station
   int num_recv;
 
   io_get_nextline(fp, line, 500);
   sscanf(line, "%d", &num_recv);
 
-  io_fault_recv_one_t *fault_recvone = (io_fault_recv_one_t *)malloc(num_recv * sizeof(io_fault_recv_one_t));
+  io_fault_recv_one_t *fault_recvall = (io_fault_recv_one_t *)malloc(num_recv * sizeof(io_fault_recv_one_t));
+  int *is_share_this = (int *) malloc(num_recv * sizeof(int));
+  int *is_share      = (int *) malloc(num_recv * sizeof(int));
 
   // read coord and locate
 
   int ir=0;
   int nr_this = 0; // in this thread
+  int nr_part = 0; // points of station of other thread
 
   int f_id;  //fault_id
   int ix, iy, iz; // global index
-  float rx, ry, rz; //coords
-  float rx_inc, ry_inc, rz_inc; //increment
+  float ry, rz; //coords
+  float ry_inc, rz_inc; //increment
 
   for (ir=0; ir<num_recv; ir++)
   {
+    io_fault_recv_one_t *this_recv = fault_recvall + ir;
+
     // read one line
     io_get_nextline(fp, line, 500);
 
     // get values
     sscanf(line, "%s %d %g %g", 
-           fault_recvone[ir].name, &f_id, &ry, &rz);
+           this_recv->name, &f_id, &ry, &rz);
 
     // need minus 1, due to C is start from 0
     f_id = f_id - 1;
     ry = ry-1;
     rz = rz-1;
     ix = fault_indx[f_id];
-    rx_inc = 0;
 
     // do not take nearest value, but use smaller value
     iy = floor(ry);
     iz = floor(rz);
     ry_inc = ry - iy;
     rz_inc = rz - iz;
-    // check recv in ghost region
-    // if there is a point, perform fault variable exchange
-    // exchange 1 point for interp
-    if(iy == gnj2 && ry_inc >0)
-    {
-      io_fault_recv->flag_swap = 1;
-    }
-    if(iz == gnk2 && rz_inc >0)
+
+    this_recv->i = ix;
+    this_recv->j = iy;
+    this_recv->k = iz;
+    this_recv->di = 0.0;
+    this_recv->dj = ry_inc;
+    this_recv->dk = rz_inc;
+    this_recv->f_id = f_id;
+    this_recv->ishare = -1;
+    this_recv->seismo = NULL;
+
+    // points of stencil in this thread
+    int num_mine = 0;
+    int num_used = 0;
+    for (int n=0; n < 4; n++)
     {
-      io_fault_recv->flag_swap = 1;
+      int is_used = 1;
+      if (n % 2 == 1 && ry_inc <= 0) is_used = 0;
+      if (n / 2 == 1 && rz_inc <= 0) is_used = 0;
+      this_recv->is_mine[n] = 0;
+      if (is_used == 1) {
+        num_used += 1;
+        this_recv->is_mine[n] = gd_info_gindx_is_inner(ix, iy + n % 2, iz + n / 2, gd);
+        num_mine += this_recv->is_mine[n];
+      }
     }
+    is_share_this[ir] = (num_mine > 0 && num_mine < num_used) ? 1 : 0;
 
-    if (gd_info_gindx_is_inner(ix,iy,iz,gd) == 1)
+    if (num_mine > 0)
     {
-      // convert to local index without ghost
-      int i_local = gd_info_indx_glphy2lcext_j(ix,gd);
-      int j_local = gd_info_indx_glphy2lcext_j(iy,gd);
-      int k_local = gd_info_indx_glphy2lcext_k(iz,gd);
-
-      rx = gd_coord_get_x(gd,i_local,j_local,k_local);
-      ry = gd_coord_get_y(gd,i_local,j_local,k_local);
-      rz = gd_coord_get_z(gd,i_local,j_local,k_local);
-
-      io_fault_recv_one_t *this_recv = fault_recvone + nr_this;
-
-      sprintf(this_recv->name, "%s", fault_recvone[ir].name);
-      // get coord
-      this_recv->x = rx;
-      this_recv->y = ry;
-      this_recv->z = rz;
-      // set point
-      this_recv->i=i_local;
-      this_recv->j=j_local;
-      this_recv->k=k_local;
-      this_recv->di = rx_inc;
-      this_recv->dj = ry_inc;
-      this_recv->dk = rz_inc;
-      this_recv->f_id = f_id;
-
-      this_recv->indx1d[0] = j_local     + k_local * gd->ny;
-      this_recv->indx1d[1] = (j_local+1) + k_local * gd->ny;
-      this_recv->indx1d[2] = j_local     + (k_local+1) * gd->ny;
-      this_recv->indx1d[3] = (j_local+1) + (k_local+1) * gd->ny;
-      nr_this += 1;
+      if (this_recv->is_mine[0] == 1) {
+        nr_this += 1;
+      } else {
+        nr_part += 1;
+      }
     }
+
     if(myid==0)
     {
       if(iy<0 || iy>total_point_y-1 || iz<0 || iz>total_point_z-1 )
@@ -2292,61 +3293,252 @@ io_fault_recv_read_locate(gd_t      *gd,
     }
   }
 
-
   fclose(fp);
- 
-  io_fault_recv->total_number  = nr_this;
-  io_fault_recv->fault_recvone = fault_recvone;
-  io_fault_recv->max_nt        = nt_total;
-  io_fault_recv->ncmp          = num_of_vars;
 
-  // malloc seismo
+  // same index of shared stations in all threads
+  MPI_Allreduce(is_share_this, is_share, num_recv, MPI_INT, MPI_MAX, comm);
+
+  io_fault_recv_one_t *fault_recvone  = (io_fault_recv_one_t *)malloc((nr_this+1) * sizeof(io_fault_recv_one_t));
+  io_fault_recv_one_t *fault_recvpart = (io_fault_recv_one_t *)malloc((nr_part+1) * sizeof(io_fault_recv_one_t));
+
+  int num_of_share = 0;
+  nr_this = 0;
+  nr_part = 0;
+  for (ir=0; ir<num_recv; ir++)
+  {
+    io_fault_recv_one_t *this_recv = fault_recvall + ir;
+
+    if (is_share[ir] == 1) {
+      this_recv->ishare = num_of_share;
+      num_of_share += 1;
+    }
+
+    int num_mine = this_recv->is_mine[0] + this_recv->is_mine[1]
+                 + this_recv->is_mine[2] + this_recv->is_mine[3];
+    if (num_mine == 0) continue;
+
+    // convert to local index without ghost, point 0 could be in ghost
+    //  for part of station
+    int i_local = gd_info_indx_glphy2lcext_i(this_recv->i,gd);
+    int j_local = gd_info_indx_glphy2lcext_j(this_recv->j,gd);
+    int k_local = gd_info_indx_glphy2lcext_k(this_recv->k,gd);
+
+    this_recv->i = i_local;
+    this_recv->j = j_local;
+    this_recv->k = k_local;
+
+    this_recv->indx1d[0] = j_local     + k_local * gd->ny;
+    this_recv->indx1d[1] = (j_local+1) + k_local * gd->ny;
+    this_recv->indx1d[2] = j_local     + (k_local+1) * gd->ny;
+    this_recv->indx1d[3] = (j_local+1) + (k_local+1) * gd->ny;
+
+    if (this_recv->is_mine[0] == 1)
+    {
+      // get coord
+      this_recv->x = gd_coord_get_x(gd,i_local,j_local,k_local);
+      this_recv->y = gd_coord_get_y(gd,i_local,j_local,k_local);
+      this_recv->z = gd_coord_get_z(gd,i_local,j_local,k_local);
+      fault_recvone[nr_this] = *this_recv;
+      nr_this += 1;
+    }
+    else
+    {
+      this_recv->x = 0.0;
+      this_recv->y = 0.0;
+      this_recv->z = 0.0;
+      fault_recvpart[nr_part] = *this_recv;
+      nr_part += 1;
+    }
+  }
+
+  free(fault_recvall);
+  free(is_share_this);
+  free(is_share);
+ 
+  io_fault_recv->total_number   = nr_this;
+  io_fault_recv->fault_recvone  = fault_recvone;
+  io_fault_recv->num_of_part    = nr_part;
+  io_fault_recv->fault_recvpart = fault_recvpart;
+  io_fault_recv->num_of_share   = num_of_share;
+  io_fault_recv->max_nt         = decim_nt_out(decimation, nt_total);
+  io_fault_recv->ncmp           = num_of_vars;
+
+  // streamed seismo keep a ring of samples, unshared stations are
+  //  ahead of shared ones by the steps not yet reduced
+  int nt_lag = DECIM_HALF_LEN_OUT + 1
+             + io_fault_recv->reduce_every / (decimation > 1 ? decimation : 1) + 1;
+  seis_store_init(&io_fault_recv->store, stream_every, nt_lag,
+                  nr_this * num_of_vars, io_fault_recv->max_nt);
+  io_fault_recv->nt_buff        = io_fault_recv->store.nt_buff;
+
+  // malloc seismo, kept at decimated rate
   for (int ir=0; ir < io_fault_recv->total_number; ir++)
   {
     fault_recvone = io_fault_recv->fault_recvone + ir;
-    fault_recvone->seismo = (float *) malloc(num_of_vars * nt_total * sizeof(float));
+    fault_recvone->seismo = (float *) malloc(num_of_vars * io_fault_recv->nt_buff * sizeof(float));
+    for (int icmp=0; icmp < num_of_vars; icmp++) {
+      io_fault_recv->store.trace[ir*num_of_vars+icmp] = fault_recvone->seismo
+                                                      + icmp * io_fault_recv->nt_buff;
+    }
   }
+  decim_init(&io_fault_recv->decim, decimation, nr_this * num_of_vars, nt_total,
+             io_fault_recv->nt_buff);
+
+  // weighted values of shared stations of reduce_every steps
+  if (num_of_share > 0)
+  {
+    size_t siz_share = (size_t) io_fault_recv->reduce_every * num_of_share * num_of_vars * 4;
+    io_fault_recv->share_buff = (float *) malloc(siz_share * sizeof(float));
+    io_fault_recv_share_clear(io_fault_recv);
+  }
+
+  return 0;
+}
+
+/*
+ * -0.0 is the exact identity of sum, the only point value of a slot
+ *  is not changed by the reduction
+ */
+
+int
+io_fault_recv_share_clear(io_fault_recv_t *io_fault_recv)
+{
+  if (io_fault_recv->share_buff != NULL)
+  {
+    size_t siz_share = (size_t) io_fault_recv->reduce_every * io_fault_recv->num_of_share
+                     * io_fault_recv->ncmp * 4;
+    for (size_t i=0; i < siz_share; i++) {
+      io_fault_recv->share_buff[i] = -0.0f;
+    }
+  }
+  io_fault_recv->nt_share = 0;
+
   return 0;
 }
 
+/*
+ * interp of station by points in this thread. shared stations put
+ *  weighted values of their points to share_buff, which is summed over
+ *  threads every reduce_every steps. must be called by all threads
+ */
+
 int
 io_fault_recv_keep(io_fault_recv_t *io_fault_recv, fault_t F_d, 
-                   float *buff, int it, size_t siz_slice_yz)
+                   float *buff, int it, size_t siz_slice_yz,
+                   mem_pool_t *pool_d, MPI_Comm comm)
 {
-  float Ly1, Ly2, Lz1, Lz2;
+  float Ly[2], Lz[2];
   int ncmp = F_d.ncmp-2; //0-8 variable 
   int size = sizeof(float)*4*ncmp;
-  float *buff_d = (float *) cuda_malloc(size);
-  size_t *indx1d_d = (size_t *) cuda_malloc(sizeof(size_t)*4);
-  int iptr_sta;
+  float *buff_d = (float *) mem_pool_malloc(pool_d, size);
+  size_t *indx1d_d = (size_t *) mem_pool_malloc(pool_d, sizeof(size_t)*4);
   dim3 block(32);
   dim3 grid;
   grid.x = (ncmp+block.x-1)/block.x;
 
-  for (int n=0; n < io_fault_recv->total_number; n++)
+  if (io_fault_recv->nt_share == 0) io_fault_recv->it_share = it;
+
+  int num_of_recv = io_fault_recv->total_number + io_fault_recv->num_of_part;
+  for (int n=0; n < num_of_recv; n++)
   {
-    io_fault_recv_one_t *this_recv = io_fault_recv->fault_recvone + n;
+    io_fault_recv_one_t *this_recv = (n < io_fault_recv->total_number)
+                                   ? io_fault_recv->fault_recvone  + n
+                                   : io_fault_recv->fault_recvpart + n - io_fault_recv->total_number;
     int id = this_recv->f_id;
 
     size_t *indx1d = this_recv->indx1d;
     CUDACHECK(cudaMemcpy(indx1d_d,indx1d,sizeof(size_t)*4,cudaMemcpyHostToDevice));
 
     // get coef of linear interp
-    Ly2 = this_recv->dj; Ly1 = 1.0 - Ly2;
-    Lz2 = this_recv->dk; Lz1 = 1.0 - Lz2;
+    Ly[1] = this_recv->dj; Ly[0] = 1.0 - Ly[1];
+    Lz[1] = this_recv->dk; Lz[0] = 1.0 - Lz[1];
 
     io_fault_recv_interp_pack_buff<<<grid, block>>> (id, F_d, buff_d, ncmp, siz_slice_yz, indx1d_d);
     CUDACHECK(cudaMemcpy(buff,buff_d,size,cudaMemcpyDeviceToHost));
-    for (int icmp=0; icmp < ncmp; icmp++)
+    if (this_recv->ishare < 0)
+    {
+      for (int icmp=0; icmp < ncmp; icmp++)
+      {
+        float v =  buff[4*icmp+0] * Ly[0] * Lz[0]
+                 + buff[4*icmp+1] * Ly[1] * Lz[0]
+                 + buff[4*icmp+2] * Ly[0] * Lz[1]
+                 + buff[4*icmp+3] * Ly[1] * Lz[1];
+        decim_push(&io_fault_recv->decim, n*ncmp+icmp, it, v,
+                   this_recv->seismo + icmp * io_fault_recv->nt_buff);
+      }
+    }
+    else
     {
-      iptr_sta = icmp * io_fault_recv->max_nt + it;
-      this_recv->seismo[iptr_sta] = buff[4*icmp+0] * Ly1 * Lz1
-                                  + buff[4*icmp+1] * Ly2 * Lz1
-                                  + buff[4*icmp+2] * Ly1 * Lz2
-                                  + buff[4*icmp+3] * Ly2 * Lz2;
+      float *slot = io_fault_recv->share_buff
+                  + ((size_t) io_fault_recv->nt_share * io_fault_recv->num_of_share
+                     + this_recv->ishare) * ncmp * 4;
+      for (int icmp=0; icmp < ncmp; icmp++) {
+        for (int m=0; m < 4; m++) {
+          if (this_recv->is_mine[m] == 1) {
+            slot[4*icmp+m] = buff[4*icmp+m] * Ly[m%2] * Lz[m/2];
+          }
+        }
+      }
+    }
+  }
+  mem_pool_free(pool_d, buff_d);
+  mem_pool_free(pool_d, indx1d_d);
+
+  if (io_fault_recv->num_of_share > 0)
+  {
+    io_fault_recv->nt_share += 1;
+    if (io_fault_recv->nt_share == io_fault_recv->reduce_every) {
+      io_fault_recv_reduce(io_fault_recv, comm);
+    }
+  }
+
+  // steps not reduced are the last nt_share ones
+  seis_store_put(&io_fault_recv->store,
+                 decim_num_ready(&io_fault_recv->decim, it+1 - io_fault_recv->nt_share));
+
+  return 0;
+}
+
+/*
+ * sum weighted values of buffered steps over threads, the thread of
+ *  each shared station adds its 4 points in the order of unshared ones.
+ *  called by all threads, also before checkpoint and at the end
+ */
+
+int
+io_fault_recv_reduce(io_fault_recv_t *io_fault_recv, MPI_Comm comm)
+{
+  if (io_fault_recv->num_of_share == 0 || io_fault_recv->nt_share == 0) return 0;
+
+  int ncmp = io_fault_recv->ncmp;
+  int num_of_share = io_fault_recv->num_of_share;
+  int siz_share = io_fault_recv->nt_share * num_of_share * ncmp * 4;
+
+  MPI_Allreduce(MPI_IN_PLACE, io_fault_recv->share_buff, siz_share,
+                MPI_FLOAT, MPI_SUM, comm);
+
+  for (int n=0; n < io_fault_recv->total_number; n++)
+  {
+    io_fault_recv_one_t *this_recv = io_fault_recv->fault_recvone + n;
+    if (this_recv->ishare < 0) continue;
+
+    for (int istep=0; istep < io_fault_recv->nt_share; istep++)
+    {
+      float *slot = io_fault_recv->share_buff
+                  + ((size_t) istep * num_of_share + this_recv->ishare) * ncmp * 4;
+      // steps pushed in order, after the ones before it_share
+      for (int icmp=0; icmp < ncmp; icmp++)
+      {
+        float v = slot[4*icmp+0] + slot[4*icmp+1]
+                + slot[4*icmp+2] + slot[4*icmp+3];
+        decim_push(&io_fault_recv->decim, n*ncmp+icmp, io_fault_recv->it_share + istep, v,
+                   this_recv->seismo + icmp * io_fault_recv->nt_buff);
+      }
     }
   }
 
+  io_fault_recv_share_clear(io_fault_recv);
+
   return 0;
 }
 
@@ -2378,20 +3570,25 @@ io_fault_recv_output_sac(io_fault_recv_t *io_fault_recv,
   float evt_z = 0.0;
   float evt_d = 0.0;
   char ou_file[CONST_MAX_STRLEN];
+  // sample spacing of decimated trace
+  float dt_out = dt * io_fault_recv->decim.factor;
   char cmp_name[num_of_vars][CONST_MAX_STRLEN] = {"Tn","Ts1","Ts2",
                                                   "Vs", "Vs1","Vs2",
                                                   "Slip", "Slip1", "Slip2"};
+  float *buff = io_seismo_get_buff(&io_fault_recv->store, num_of_vars, io_fault_recv->max_nt);
 
   for (int ir=0; ir < io_fault_recv->total_number; ir++)
   {
     io_fault_recv_one_t *this_recv = io_fault_recv->fault_recvone + ir;
+    float *seismo = io_seismo_get(&io_fault_recv->store, this_recv->seismo,
+                                  ir*num_of_vars, num_of_vars, buff);
 
     //fprintf(stdout,"=== Debug: num_of_vars=%d\n",num_of_vars);fflush(stdout);
     for (int icmp=0; icmp < num_of_vars; icmp++)
     {
       //fprintf(stdout,"=== Debug: icmp=%d\n",icmp);fflush(stdout);
 
-      float *this_trace = this_recv->seismo + icmp * io_fault_recv->max_nt;
+      float *this_trace = seismo + icmp * io_fault_recv->max_nt;
 
       sprintf(ou_file,"%s/fault_%s.%s.sac", output_dir, 
                       this_recv->name, cmp_name[icmp]);
@@ -2402,9 +3599,10 @@ io_fault_recv_output_sac(io_fault_recv_t *io_fault_recv,
             this_trace,
             evt_x, evt_y, evt_z, evt_d,
             this_recv->x, this_recv->y, this_recv->z,
-            dt, dt, io_fault_recv->max_nt, err_message);
+            dt_out, dt_out, io_fault_recv->max_nt, err_message);
     }
   }
+  if (buff != NULL) free(buff);
 
   return 0;
 }
@@ -6,6 +6,13 @@
 #include "gd_t.h"
 #include "md_t.h"
 #include "wav_t.h"
+#include "mem_pool.h"
+#include "decim_t.h"
+#include "seis_store_t.h"
+#include "spec_t.h"
+#include "im_t.h"
+#include "zsnap_t.h"
+#include "resid_t.h"
 
 /*************************************************
  * structure
@@ -26,6 +33,9 @@ typedef struct
   int   j;
   int   k;
   size_t   indx1d[CONST_2_NDIM];
+  // media at station, kept after host media released
+  float lam;
+  float mu;
   float *seismo;
   char  name[CONST_MAX_STRLEN];
 } iorecv_one_t;
@@ -33,9 +43,13 @@ typedef struct
 typedef struct
 {
   int                 total_number;
-  int                 max_nt;
+  int                 max_nt; // samples kept, after decimation
+  int                 nt_buff; // samples in seismo, ring of them if streamed
   int                 ncmp;
   iorecv_one_t *recvone;
+  decim_t             decim;  // trace ir*ncmp+icmp
+  seis_store_t        store;
+  spec_t              spec;   // trace ir*ncmp+icmp, all steps
 } iorecv_t;
 
 // single station
@@ -52,6 +66,9 @@ typedef struct
   int   k;
   int   f_id;  // fault id
   size_t   indx1d[4];
+  // shared station has stencil points in more than one thread
+  int   ishare;     // index of shared station, -1 if not shared
+  int   is_mine[4]; // stencil point used and in this thread
   float *seismo;
   char  name[CONST_MAX_STRLEN];
 } io_fault_recv_one_t;
@@ -59,18 +76,33 @@ typedef struct
 typedef struct
 {
   int  total_number;
-  int  max_nt;
+  int  max_nt; // samples kept, after decimation
+  int  nt_buff; // samples in seismo, ring of them if streamed
   int  ncmp;
-  int  flag_swap; 
   io_fault_recv_one_t *fault_recvone;
+  decim_t decim; // trace ir*ncmp+icmp of fault_recvone
+  seis_store_t store;
+  // shared stations of other threads with points in this thread
+  int  num_of_part;
+  io_fault_recv_one_t *fault_recvpart;
+  // weighted point values of shared stations, [step][ishare][icmp][point]
+  //  summed over threads every reduce_every steps
+  int  num_of_share;
+  int  reduce_every;
+  int  nt_share; // steps in share_buff
+  int  it_share; // step of first one
+  float *share_buff;
 } io_fault_recv_t;
 
 // line output
 typedef struct
 {
   int     num_of_lines; 
-  int     max_nt;
+  int     max_nt; // samples kept, after decimation
+  int     nt_buff; // samples in seismo, ring of them if streamed
   int     ncmp;
+  decim_t decim;  // traces of receivers in line order, ncmp each
+  seis_store_t store;
 
   int    *line_nr; // number of receivers, for name from input file
   int    *line_seq; // line number, for name from input file
@@ -86,6 +118,43 @@ typedef struct
   char   **line_name;
 } ioline_t;
 
+// station table of seismo archive
+#define IO_ARCHIVE_NAME_STRLEN 128
+#define IO_ARCHIVE_NUM_KIND    3 // recv, line, fault_recv
+
+typedef struct
+{
+  char  name[IO_ARCHIVE_NAME_STRLEN];
+  float x;
+  float y;
+  float z;
+  float lam; // for strain
+  float mu;
+} io_archive_sta_t;
+
+typedef struct
+{
+  char   kind[CONST_MAX_STRLEN];
+  int    ncmp;
+  int    max_nt;
+  float  delta;
+  int    has_strain;
+  // this thread
+  int    num_of_sta;
+  io_archive_sta_t *sta;
+  float **seismo;
+  seis_store_t *store;
+  // all threads, on thread 0
+  int   *num_of_sta_thread;
+  int    num_of_sta_all;
+  io_archive_sta_t *sta_all;
+  int    varid_name;
+  int    varid_xyz[3];
+  int    varid_cmp_name;
+  int    varid_seismo;
+  int    varid_strain;
+} io_archive_kind_t;
+
 // fault output
 typedef struct
 {
@@ -139,6 +208,13 @@ typedef struct
   int *out_stress;
   int *out_strain;
 
+  // error bound of compressed frames, both 0 for plain float
+  float *zerr_abs;
+  float *zerr_rel;
+  int    num_of_zthread;
+  // threads of each snapshot, MPI_COMM_NULL if error bound is not relative
+  MPI_Comm *zcomm;
+
   int *i1_to_glob;
   int *j1_to_glob;
   int *k1_to_glob;
@@ -188,6 +264,7 @@ typedef struct
   int *varid_T;  // [num_of_snap*CONST_NDIM_2];
   int *varid_E;  // [num_of_snap*CONST_NDIM_2];
   int *cur_it ;  // [num_of_snap];
+  zsnap_t *zsnap; // [num_of_snap];
 }
 iosnap_nc_t;
 
@@ -198,6 +275,11 @@ int
 io_recv_read_locate(gd_t *gd,
                     iorecv_t  *iorecv,
                     int       nt_total,
+                    int       decimation,
+                    int       stream_every,
+                    float     dt,
+                    int       num_of_freq,
+                    float     *freq,
                     int       num_of_vars,
                     int       num_of_mpiprocs_z,
                     char      *in_filenm,
@@ -209,6 +291,8 @@ io_line_locate(gd_t *gd,
                ioline_t *ioline,
                int    num_of_vars,
                int    nt_total,
+               int    decimation,
+               int    stream_every,
                int    number_of_receiver_line,
                int   *receiver_line_index_start,
                int   *receiver_line_index_incre,
@@ -217,11 +301,13 @@ io_line_locate(gd_t *gd,
 
 int
 io_recv_keep(iorecv_t *iorecv, float *w_pre_d,
-             float* buff, int it, int ncmp, size_t siz_icmp);
+             float* buff, int it, int ncmp, size_t siz_icmp,
+             mem_pool_t *pool_d);
 
 int
 io_line_keep(ioline_t *ioline, float *w_pre_d,
-             float *buff, int it, int ncmp, size_t siz_icmp);
+             float *buff, int it, int ncmp, size_t siz_icmp,
+             mem_pool_t *pool_d);
 
 int
 io_slice_locate(gd_t  *gd,
@@ -238,9 +324,14 @@ io_slice_locate(gd_t  *gd,
 int
 io_slice_nc_create(ioslice_t *ioslice, 
                   int num_of_vars, char **w3d_name,
-                  int ni, int nj, int nk,
+                  int ni, int nj, int nk, int *g_start,
                   int *topoid, ioslice_nc_t *ioslice_nc);
 
+int
+io_slice_nc_reopen(ioslice_t *ioslice, 
+                   int num_of_vars, char **w3d_name,
+                   ioslice_nc_t *ioslice_nc);
+
 int
 io_slice_nc_put(ioslice_t    *ioslice,
                 ioslice_nc_t *ioslice_nc,
@@ -248,7 +339,8 @@ io_slice_nc_put(ioslice_t    *ioslice,
                 float *w_pre_d,
                 float *buff,
                 int   it,
-                float time);
+                float time,
+                mem_pool_t *pool_d);
 
 int
 io_snapshot_locate(gd_t *gd,
@@ -263,27 +355,39 @@ io_snapshot_locate(gd_t *gd,
                     int *snapshot_save_velocity,
                     int *snapshot_save_stress,
                     int *snapshot_save_strain,
+                    float *snapshot_compress_error_abs,
+                    float *snapshot_compress_error_rel,
+                    int   snapshot_compress_threads,
                     char *output_fname_part,
-                    char *output_dir);
+                    char *output_dir,
+                    MPI_Comm comm);
+
+int
+io_snap_nc_create(iosnap_t *iosnap, iosnap_nc_t *iosnap_nc, int *topoid,
+                  int nt_total);
 
 int
-io_snap_nc_create(iosnap_t *iosnap, iosnap_nc_t *iosnap_nc, int *topoid);
+io_snap_nc_reopen(iosnap_t *iosnap, iosnap_nc_t *iosnap_nc);
 
 int
 io_snap_nc_put(iosnap_t *iosnap,
                iosnap_nc_t *iosnap_nc,
                gd_t    *gd,
                md_t    *md,
+               resid_t *resid,
                wav_t   *wav,
                float *w_pre_d,
                float *buff,
                int   nt_total,
                int   it,
-               float time);
+               float time,
+               mem_pool_t *pool_d);
 
 int
 io_snap_stress_to_strain_eliso(float *lam3d,
                                float *mu3d,
+                               void  *mat_id,
+                               int    mat_nbyte,
                                float *Txx,
                                float *Tyy,
                                float *Tzz,
@@ -335,6 +439,9 @@ io_snap_pack_buff(float *var,
 int
 io_slice_nc_close(ioslice_nc_t *ioslice_nc);
 
+int
+io_snap_nc_flush(iosnap_nc_t *iosnap_nc);
+
 int
 io_snap_nc_close(iosnap_nc_t *iosnap_nc);
 
@@ -365,9 +472,25 @@ io_recv_output_sac(iorecv_t *iorecv,
                    char *output_dir,
                    char *err_message);
 int
+io_recv_set_media_el_iso(iorecv_t *iorecv,
+                         float *lam3d,
+                         float *mu3d);
+
+int
+io_recv_strain_el_iso(float lam, float mu, float *seismo, int max_nt);
+
+int
+io_seismo_archive_write(iorecv_t *iorecv, ioline_t *ioline,
+                        io_fault_recv_t *io_fault_recv,
+                        float dt, char **cmp_name, int is_el_iso,
+                        char *output_dir, MPI_Comm comm, int myid);
+
+int
+io_recv_spectrum_write(iorecv_t *iorecv, char **cmp_name,
+                       char *output_dir, MPI_Comm comm, int myid);
+
+int
 io_recv_output_sac_el_iso_strain(iorecv_t *iorecv,
-                   float * lam3d,
-                   float * mu3d,
                    float dt,
                    char *output_dir,
                    char *err_message);
@@ -414,7 +537,7 @@ int
 iorecv_print(iorecv_t *iorecv);
 
 int
-PG_slice_output(float *PG,  gd_t *gd, char *output_dir, char *frame_coords, int* topoid);
+PG_slice_output(float *PG,  gd_t *gd, im_t *im, char *output_dir, char *frame_coords, int* topoid);
 
 int
 io_get_nextline(FILE *fp, char *str, int length);
@@ -427,11 +550,35 @@ io_fault_locate(gd_t *gd,
                 char *output_fname_part,
                 char *output_dir);
 
+int
+io_output_set_dir(iofault_t *iofault, ioslice_t *ioslice, iosnap_t *iosnap,
+                  char *output_dir);
+
+int
+io_seismo_reset(iorecv_t *iorecv, ioline_t *ioline, io_fault_recv_t *io_fault_recv);
+
+int
+io_seismo_finish(iorecv_t *iorecv, ioline_t *ioline, io_fault_recv_t *io_fault_recv,
+                 int nt_total);
+
+int
+io_seismo_stream_open(iorecv_t *iorecv, ioline_t *ioline, io_fault_recv_t *io_fault_recv,
+                      char *output_dir, int myid, int is_restart);
+
+int
+io_seismo_stream_wait(iorecv_t *iorecv, ioline_t *ioline, io_fault_recv_t *io_fault_recv);
+
+int
+io_seismo_stream_close(iorecv_t *iorecv, ioline_t *ioline, io_fault_recv_t *io_fault_recv);
+
 int
 io_fault_nc_create(iofault_t *iofault, 
-                   int ni, int nj, int nk,
+                   int ni, int nj, int nk, int *g_start,
                    int *topoid, iofault_nc_t *iofault_nc);
 
+int
+io_fault_nc_reopen(iofault_t *iofault, iofault_nc_t *iofault_nc);
+
 int
 io_fault_nc_put(iofault_nc_t *iofault_nc,
                 gd_t     *gd,
@@ -439,14 +586,16 @@ io_fault_nc_put(iofault_nc_t *iofault_nc,
                 fault_t  F_d,
                 float *buff,
                 int   it,
-                float time);
+                float time,
+                mem_pool_t *pool_d);
 
 int
 io_fault_end_t_nc_put(iofault_nc_t *iofault_nc,
                       gd_t     *gd,
                       fault_t  *F,
                       fault_t  F_d,
-                      float *buff);
+                      float *buff,
+                      mem_pool_t *pool_d);
 
 __global__ void
 io_fault_pack_buff(int nj, int nk, int ny,
@@ -460,15 +609,25 @@ int
 io_fault_recv_read_locate(gd_t      *gd,
                           io_fault_recv_t  *io_fault_recv,
                           int       nt_total,
+                          int       decimation,
+                          int       stream_every,
                           int       num_of_vars,
                           int       *fault_indx,
                           char      *in_filenm,
+                          int       reduce_every,
                           MPI_Comm  comm,
                           int       myid);
 
+int
+io_fault_recv_share_clear(io_fault_recv_t *io_fault_recv);
+
 int
 io_fault_recv_keep(io_fault_recv_t *io_fault_recv, fault_t F_d, 
-                   float *buff, int it, size_t siz_slice_yz);
+                   float *buff, int it, size_t siz_slice_yz,
+                   mem_pool_t *pool_d, MPI_Comm comm);
+
+int
+io_fault_recv_reduce(io_fault_recv_t *io_fault_recv, MPI_Comm comm);
 
 __global__ void
 io_fault_recv_interp_pack_buff(
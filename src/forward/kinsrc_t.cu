@@ -0,0 +1,528 @@
+/*******************************************************************************
+ * in-situ kinematic source of subfaults from dynamic rupture
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "constants.h"
+#include "kinsrc_t.h"
+#include "moment_t.h"
+#include "cuda_common.h"
+
+/*
+ * global index range of subfault isub of n points from g1 to g2, the
+ *  last one takes the rest
+ */
+
+static void
+kinsrc_sub_range(int g1, int g2, int npt, int nsub, int isub, int *s1, int *s2)
+{
+  *s1 = g1 + isub * npt;
+  *s2 = (isub == nsub - 1) ? g2 : *s1 + npt - 1;
+}
+
+int
+kinsrc_init(kinsrc_t *kinsrc, int enable, int *subfault_points, int sample_every,
+            float time_length, float dt, float t0, int nt_total, int *fault_grid,
+            gd_t *gd, gd_metric_t metric_d, fault_coef_t *FC, fault_coef_t FC_d,
+            MPI_Comm comm, int myid)
+{
+  kinsrc->enable       = (enable == 1 && FC->number_fault > 0) ? 1 : 0;
+  kinsrc->myid         = myid;
+  kinsrc->sample_every = sample_every > 0 ? sample_every : 1;
+  kinsrc->nt_total     = nt_total;
+  kinsrc->nt_sample    = (nt_total + kinsrc->sample_every - 1) / kinsrc->sample_every;
+  kinsrc->dt           = dt;
+  kinsrc->t0           = t0;
+  kinsrc->time_length  = time_length;
+  kinsrc->number_fault = 0;
+  kinsrc->num_of_sub   = 0;
+  kinsrc->num_of_loc   = 0;
+  kinsrc->is_beg       = 0;
+  kinsrc->num_of_row   = 0;
+  kinsrc->series       = NULL;
+
+  if (kinsrc->enable == 0) return 0;
+
+  int number_fault = FC->number_fault;
+  kinsrc->number_fault = number_fault;
+  kinsrc->num_sub_j = (int *) malloc(number_fault * sizeof(int));
+  kinsrc->num_sub_k = (int *) malloc(number_fault * sizeof(int));
+
+  // local physical points in global index
+  int gj1 = gd->gnj1, gj2 = gd->gnj1 + gd->nj - 1;
+  int gk1 = gd->gnk1, gk2 = gd->gnk1 + gd->nk - 1;
+
+  int num_of_sub = 0;
+  for (int id=0; id < number_fault; id++)
+  {
+    int *g = fault_grid + 4 * id;
+    int nsub_j = (g[1] - g[0] + 1) / subfault_points[0];
+    int nsub_k = (g[3] - g[2] + 1) / subfault_points[1];
+    kinsrc->num_sub_j[id] = nsub_j > 1 ? nsub_j : 1;
+    kinsrc->num_sub_k[id] = nsub_k > 1 ? nsub_k : 1;
+    num_of_sub += kinsrc->num_sub_j[id] * kinsrc->num_sub_k[id];
+  }
+  kinsrc->num_of_sub = num_of_sub;
+
+  // subfaults with points in this thread
+  kinsrc->loc = (int *) malloc((num_of_sub + 1) * KINSRC_NUM_LOC * sizeof(int));
+  int isub = 0;
+  for (int id=0; id < number_fault; id++)
+  {
+    int *g = fault_grid + 4 * id;
+    for (int kk=0; kk < kinsrc->num_sub_k[id]; kk++)
+    {
+      for (int jj=0; jj < kinsrc->num_sub_j[id]; jj++, isub++)
+      {
+        int j1, j2, k1, k2;
+        kinsrc_sub_range(g[0], g[1], subfault_points[0], kinsrc->num_sub_j[id], jj, &j1, &j2);
+        kinsrc_sub_range(g[2], g[3], subfault_points[1], kinsrc->num_sub_k[id], kk, &k1, &k2);
+        if (j1 < gj1) j1 = gj1;
+        if (j2 > gj2) j2 = gj2;
+        if (k1 < gk1) k1 = gk1;
+        if (k2 > gk2) k2 = gk2;
+        if (j1 > j2 || k1 > k2) continue;
+
+        int *lc = kinsrc->loc + kinsrc->num_of_loc * KINSRC_NUM_LOC;
+        lc[0] = id;
+        lc[1] = isub;
+        lc[2] = j1 - gd->gnj1 + gd->nj1;
+        lc[3] = j2 - gd->gnj1 + gd->nj1;
+        lc[4] = k1 - gd->gnk1 + gd->nk1;
+        lc[5] = k2 - gd->gnk1 + gd->nk1;
+        kinsrc->num_of_loc += 1;
+      }
+    }
+  }
+  kinsrc->loc_d = (int *) cuda_malloc(sizeof(int) * (kinsrc->num_of_loc + 1) * KINSRC_NUM_LOC);
+  CUDACHECK(cudaMemcpy(kinsrc->loc_d, kinsrc->loc,
+                       sizeof(int) * kinsrc->num_of_loc * KINSRC_NUM_LOC,
+                       cudaMemcpyHostToDevice));
+
+  // same area element and mu as moment rate
+  size_t siz_slice_yz = gd->siz_slice_yz;
+  float *dA_d   = (float *) cuda_malloc(sizeof(float) * siz_slice_yz * number_fault);
+  kinsrc->muA_d = (float *) cuda_malloc(sizeof(float) * siz_slice_yz * number_fault);
+
+  dim3 block(8,8);
+  dim3 grid;
+  grid.x = (gd->nj+block.x-1)/block.x;
+  grid.y = (gd->nk+block.y-1)/block.y;
+  for (int id=0; id < number_fault; id++)
+  {
+    int i0 = FC->fault_index[id] + 3; //fault plane x index with ghost
+    moment_area_gpu <<<grid, block>>> (*gd, metric_d, i0,
+                                       FC_d.fault_coef_one[id].mu_f,
+                                       dA_d + id * siz_slice_yz,
+                                       kinsrc->muA_d + id * siz_slice_yz);
+  }
+  float *dA  = (float *) malloc(sizeof(float) * siz_slice_yz * number_fault);
+  float *muA = (float *) malloc(sizeof(float) * siz_slice_yz * number_fault);
+  CUDACHECK(cudaMemcpy(dA, dA_d, sizeof(float) * siz_slice_yz * number_fault,
+                       cudaMemcpyDeviceToHost));
+  CUDACHECK(cudaMemcpy(muA, kinsrc->muA_d, sizeof(float) * siz_slice_yz * number_fault,
+                       cudaMemcpyDeviceToHost));
+  CUDACHECK(cudaFree(dA_d));
+
+  // geometry from host coords and fault coef, before they are released
+  double *geo = (double *) calloc(num_of_sub * KINSRC_NUM_GEO, sizeof(double));
+  for (int n=0; n < kinsrc->num_of_loc; n++)
+  {
+    int *lc = kinsrc->loc + n * KINSRC_NUM_LOC;
+    int id  = lc[0];
+    int i0  = FC->fault_index[id] + 3;
+    fault_coef_one_t *FC_thisone = FC->fault_coef_one + id;
+    double *v = geo + lc[1] * KINSRC_NUM_GEO;
+    for (int k=lc[4]; k <= lc[5]; k++)
+    {
+      for (int j=lc[2]; j <= lc[3]; j++)
+      {
+        size_t iptr   = i0 + j * gd->siz_iy + k * gd->siz_iz;
+        size_t iptr_f = j + k * gd->ny;
+        double area = dA[id * siz_slice_yz + iptr_f];
+        v[KINSRC_AREA] += area;
+        v[KINSRC_MUA ] += muA[id * siz_slice_yz + iptr_f];
+        v[KINSRC_X   ] += area * gd->x3d[iptr];
+        v[KINSRC_Y   ] += area * gd->y3d[iptr];
+        v[KINSRC_Z   ] += area * gd->z3d[iptr];
+        for (int i=0; i < 3; i++) {
+          v[KINSRC_S1+i] += area * FC_thisone->vec_s1[iptr_f*3+i];
+          v[KINSRC_S2+i] += area * FC_thisone->vec_s2[iptr_f*3+i];
+        }
+      }
+    }
+  }
+  free(dA);
+  free(muA);
+
+  kinsrc->geo = (double *) calloc(num_of_sub * KINSRC_NUM_GEO, sizeof(double));
+  MPI_Reduce(geo, kinsrc->geo, num_of_sub * KINSRC_NUM_GEO, MPI_DOUBLE, MPI_SUM, 0, comm);
+  free(geo);
+
+  size_t siz_buff = sizeof(double) * KINSRC_FLUSH_EVERY * num_of_sub * KINSRC_NUM_RATE;
+  kinsrc->rate_d   = (double *) cuda_malloc(siz_buff);
+  kinsrc->rate     = (double *) malloc(siz_buff);
+  kinsrc->rate_sum = (double *) malloc(siz_buff);
+  CUDACHECK(cudaMemset(kinsrc->rate_d, 0, siz_buff));
+
+  if (myid == 0)
+  {
+    kinsrc->series = (double *) calloc((size_t) kinsrc->nt_sample * num_of_sub * KINSRC_NUM_RATE,
+                                       sizeof(double));
+    if (kinsrc->series == NULL) {
+      fprintf(stderr,"Error: can't alloc kinematic source series of %d samples, %d subfaults\n",
+              kinsrc->nt_sample, num_of_sub);
+      fflush(stderr);
+      exit(1);
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * after fault_var_update of step it. sample n sums steps
+ *  n*sample_every to (n+1)*sample_every-1. all threads must call it
+ */
+
+int
+kinsrc_keep(kinsrc_t *kinsrc, int it, gd_t gd_d, fault_t F_d, MPI_Comm comm)
+{
+  if (kinsrc->enable == 0) return 0;
+
+  int isamp = it / kinsrc->sample_every;
+  if (kinsrc->num_of_row > 0 && isamp - kinsrc->is_beg >= KINSRC_FLUSH_EVERY) {
+    kinsrc_flush(kinsrc, comm);
+  }
+  if (kinsrc->num_of_row == 0) kinsrc->is_beg = isamp;
+
+  int irow = isamp - kinsrc->is_beg;
+  double *rate_d = kinsrc->rate_d + (size_t) irow * kinsrc->num_of_sub * KINSRC_NUM_RATE;
+  if (kinsrc->num_of_loc > 0)
+  {
+    dim3 block(KINSRC_BLOCK_SIZE);
+    dim3 grid(kinsrc->num_of_loc);
+    kinsrc_rate_gpu <<<grid, block>>> (gd_d, F_d, kinsrc->loc_d, kinsrc->muA_d, rate_d);
+  }
+  kinsrc->num_of_row = irow + 1;
+
+  return 0;
+}
+
+/*
+ * add buffered rows summed over threads to series, a sample cut by
+ *  flush gets the rest later. called when buffer is full, before
+ *  checkpoint and at end. all threads must call it
+ */
+
+int
+kinsrc_flush(kinsrc_t *kinsrc, MPI_Comm comm)
+{
+  if (kinsrc->enable == 0 || kinsrc->num_of_row == 0) return 0;
+
+  int num_of_val = kinsrc->num_of_row * kinsrc->num_of_sub * KINSRC_NUM_RATE;
+  CUDACHECK(cudaMemcpy(kinsrc->rate, kinsrc->rate_d, sizeof(double)*num_of_val,
+                       cudaMemcpyDeviceToHost));
+  CUDACHECK(cudaMemset(kinsrc->rate_d, 0, sizeof(double)*num_of_val));
+
+  MPI_Reduce(kinsrc->rate, kinsrc->rate_sum, num_of_val, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+  if (kinsrc->myid == 0)
+  {
+    double *series = kinsrc->series
+                   + (size_t) kinsrc->is_beg * kinsrc->num_of_sub * KINSRC_NUM_RATE;
+    for (int n=0; n < num_of_val; n++) {
+      series[n] += kinsrc->rate_sum[n];
+    }
+  }
+
+  kinsrc->num_of_row = 0;
+
+  return 0;
+}
+
+/*
+ * slip and onset at end of run, thread 0 writes source file and table
+ *  of subfaults. all threads must call it
+ */
+
+int
+kinsrc_finish(kinsrc_t *kinsrc, gd_t gd_d, fault_t F_d, MPI_Comm comm,
+              char *output_dir)
+{
+  if (kinsrc->enable == 0) return 0;
+
+  kinsrc_flush(kinsrc, comm);
+
+  int num_of_sub = kinsrc->num_of_sub;
+  size_t siz_end = sizeof(double) * (kinsrc->num_of_loc + 1) * KINSRC_NUM_END;
+  double *end_d = (double *) cuda_malloc(siz_end);
+  double *end   = (double *) malloc(siz_end);
+  if (kinsrc->num_of_loc > 0)
+  {
+    dim3 block(KINSRC_BLOCK_SIZE);
+    dim3 grid(kinsrc->num_of_loc);
+    kinsrc_end_gpu <<<grid, block>>> (gd_d, F_d, kinsrc->loc_d, kinsrc->muA_d, end_d);
+  }
+  CUDACHECK(cudaMemcpy(end, end_d, siz_end, cudaMemcpyDeviceToHost));
+  CUDACHECK(cudaFree(end_d));
+
+  double *slip  = (double *) calloc(num_of_sub * 3, sizeof(double));
+  double *onset = (double *) malloc(num_of_sub * sizeof(double));
+  for (int n=0; n < num_of_sub; n++) onset[n] = KINSRC_NO_ONSET;
+  for (int n=0; n < kinsrc->num_of_loc; n++)
+  {
+    int isub = kinsrc->loc[n * KINSRC_NUM_LOC + 1];
+    double *v = end + n * KINSRC_NUM_END;
+    for (int i=0; i < 3; i++) slip[isub*3+i] += v[KINSRC_SLIP+i];
+    if (v[KINSRC_ONSET] < onset[isub]) onset[isub] = v[KINSRC_ONSET];
+  }
+  free(end);
+
+  double *slip_sum  = (double *) malloc(num_of_sub * 3 * sizeof(double));
+  double *onset_min = (double *) malloc(num_of_sub * sizeof(double));
+  MPI_Reduce(slip , slip_sum , num_of_sub * 3, MPI_DOUBLE, MPI_SUM, 0, comm);
+  MPI_Reduce(onset, onset_min, num_of_sub    , MPI_DOUBLE, MPI_MIN, 0, comm);
+  free(slip);
+  free(onset);
+
+  if (kinsrc->myid == 0)
+  {
+    char ou_file[CONST_MAX_STRLEN];
+    int  sample_every = kinsrc->sample_every;
+    float dt_sample   = sample_every * kinsrc->dt;
+
+    // stf of same length for all sources, as src_export.m
+    int stf_nt = kinsrc->nt_sample;
+    if (kinsrc->time_length > 0.0) {
+      stf_nt = (int) ceil(kinsrc->time_length / dt_sample);
+    }
+
+    int num_of_src = 0;
+    for (int isub=0; isub < num_of_sub; isub++) {
+      if (onset_min[isub] < KINSRC_NO_ONSET) num_of_src += 1;
+    }
+
+    sprintf(ou_file, "%s/kinematic_source_subfault.txt", output_dir);
+    FILE *fp_sub = fopen(ou_file, "w");
+    sprintf(ou_file, "%s/kinematic_source.src", output_dir);
+    FILE *fp = fopen(ou_file, "w");
+    if (fp == NULL || fp_sub == NULL) {
+      fprintf(stderr,"Error: can't create kinematic source file %s\n", ou_file);
+      fflush(stderr);
+      exit(1);
+    }
+
+    // discrete stf, moment by strike/dip/rake and mu D A, coords
+    fprintf(fp, "dynsrc\n");
+    fprintf(fp, "%d\n", num_of_src);
+    fprintf(fp, "%d %g %d\n", 1, dt_sample, stf_nt);
+    fprintf(fp, "%d %d\n", 2, 1);
+    fprintf(fp, "%d %d\n", 1, 0);
+
+    fprintf(fp_sub, "# fault subfault_j subfault_k x y z strike dip area(m^2) mu(Pa)"
+                    " onset(s) slip(m) rake M0(N*m)\n");
+
+    float *strike = (float *) malloc(num_of_sub * sizeof(float));
+    float *dip    = (float *) malloc(num_of_sub * sizeof(float));
+    int isub = 0;
+    for (int id=0; id < kinsrc->number_fault; id++)
+    {
+      for (int kk=0; kk < kinsrc->num_sub_k[id]; kk++)
+      {
+        for (int jj=0; jj < kinsrc->num_sub_j[id]; jj++, isub++)
+        {
+          double *g  = kinsrc->geo + isub * KINSRC_NUM_GEO;
+          double *s  = slip_sum + isub * 3;
+          double  A  = g[KINSRC_AREA];
+          double  mu = g[KINSRC_MUA] / A;
+
+          // angles of mean strike and dip vectors, as creat_value_file.m
+          double *s1 = g + KINSRC_S1;
+          double *s2 = g + KINSRC_S2;
+          double s2_norm = sqrt(s2[0]*s2[0] + s2[1]*s2[1] + s2[2]*s2[2]);
+          strike[isub] = 90.0 - atan2(s1[1], s1[0]) * 180.0 / PI;
+          dip   [isub] = asin(s2[2] / s2_norm) * 180.0 / PI;
+
+          int is_rup = onset_min[isub] < KINSRC_NO_ONSET ? 1 : 0;
+          fprintf(fp_sub, "%d %d %d %g %g %g %g %g %g %g %g %g %g %g\n",
+                  id, jj, kk, g[KINSRC_X]/A, g[KINSRC_Y]/A, g[KINSRC_Z]/A,
+                  strike[isub], dip[isub], A, mu,
+                  is_rup == 1 ? kinsrc->t0 + onset_min[isub] : -1.0,
+                  s[KINSRC_SLIP] / g[KINSRC_MUA],
+                  atan2(s[KINSRC_SLIP2], s[KINSRC_SLIP1]) * 180.0 / PI,
+                  s[KINSRC_SLIP]);
+
+          if (is_rup == 1) {
+            fprintf(fp, "%g %g %g\n", g[KINSRC_X]/A, g[KINSRC_Y]/A, g[KINSRC_Z]/A);
+          }
+        }
+      }
+    }
+
+    // stf of each source starts at sample of its onset
+    for (isub=0; isub < num_of_sub; isub++)
+    {
+      if (onset_min[isub] >= KINSRC_NO_ONSET) continue;
+
+      double *g  = kinsrc->geo + isub * KINSRC_NUM_GEO;
+      double  A  = g[KINSRC_AREA];
+      double  mu = g[KINSRC_MUA] / A;
+
+      // Init_t0 is time after step it
+      int it_onset = (int) (onset_min[isub] / kinsrc->dt + 0.5) - 1;
+      int m0 = (it_onset > 0 ? it_onset : 0) / sample_every;
+      fprintf(fp, "%g\n", kinsrc->t0 + m0 * dt_sample);
+
+      for (int m=m0; m < m0 + stf_nt; m++)
+      {
+        double D = 0.0, rake = 0.0;
+        if (m < kinsrc->nt_sample)
+        {
+          double *r = kinsrc->series + ((size_t) m * num_of_sub + isub) * KINSRC_NUM_RATE;
+          int nstep = kinsrc->nt_total - m * sample_every;
+          if (nstep > sample_every) nstep = sample_every;
+          // mean slip rate of sample, mu*D*A is moment rate
+          D    = r[KINSRC_RATE] / nstep / g[KINSRC_MUA];
+          rake = atan2(r[KINSRC_RATE2], r[KINSRC_RATE1]) * 180.0 / PI;
+        }
+        fprintf(fp, "%g %g %g %g %g %g\n", strike[isub], dip[isub], rake, mu, D, A);
+      }
+    }
+
+    fclose(fp);
+    fclose(fp_sub);
+    free(strike);
+    free(dip);
+
+    fprintf(stdout, "kinematic source of %d subfaults, %d ruptured\n",
+            num_of_sub, num_of_src);
+  }
+
+  free(slip_sum);
+  free(onset_min);
+
+  return 0;
+}
+
+int
+kinsrc_free(kinsrc_t *kinsrc)
+{
+  if (kinsrc->enable == 0) return 0;
+
+  free(kinsrc->num_sub_j);
+  free(kinsrc->num_sub_k);
+  free(kinsrc->loc);
+  free(kinsrc->geo);
+  CUDACHECK(cudaFree(kinsrc->loc_d));
+  CUDACHECK(cudaFree(kinsrc->muA_d));
+  CUDACHECK(cudaFree(kinsrc->rate_d));
+  free(kinsrc->rate);
+  free(kinsrc->rate_sum);
+  if (kinsrc->series != NULL) free(kinsrc->series);
+
+  kinsrc->enable = 0;
+
+  return 0;
+}
+
+/*
+ * one block per subfault of this thread, adds moment rate of this step
+ *  to the row of its sample
+ */
+
+__global__ void
+kinsrc_rate_gpu(gd_t gd_d, fault_t F, int *loc, float *muA, double *rate)
+{
+  __shared__ double s_val[KINSRC_NUM_RATE][KINSRC_BLOCK_SIZE];
+
+  int *lc = loc + blockIdx.x * KINSRC_NUM_LOC;
+  int id  = lc[0];
+  int nj  = lc[3] - lc[2] + 1;
+  int npt = nj * (lc[5] - lc[4] + 1);
+  fault_one_t *F_thisone = F.fault_one + id;
+  float *muA_f = muA + id * gd_d.siz_slice_yz;
+
+  double v[KINSRC_NUM_RATE] = {0.0, 0.0, 0.0};
+  for (int n = threadIdx.x; n < npt; n += blockDim.x)
+  {
+    size_t iptr_f = (n % nj + lc[2]) + (n / nj + lc[4]) * gd_d.ny;
+    double m = muA_f[iptr_f];
+    v[KINSRC_RATE ] += m * F_thisone->Vs [iptr_f];
+    v[KINSRC_RATE1] += m * F_thisone->Vs1[iptr_f];
+    v[KINSRC_RATE2] += m * F_thisone->Vs2[iptr_f];
+  }
+
+  int tid = threadIdx.x;
+  for (int i=0; i < KINSRC_NUM_RATE; i++) s_val[i][tid] = v[i];
+  __syncthreads();
+
+  for (int s = blockDim.x / 2; s > 0; s >>= 1)
+  {
+    if (tid < s) {
+      for (int i=0; i < KINSRC_NUM_RATE; i++) s_val[i][tid] += s_val[i][tid + s];
+    }
+    __syncthreads();
+  }
+
+  // one block per subfault, no atomic
+  if (tid == 0)
+  {
+    for (int i=0; i < KINSRC_NUM_RATE; i++) rate[lc[1] * KINSRC_NUM_RATE + i] += s_val[i][0];
+  }
+}
+
+/*
+ * slip sums and first onset of one subfault of this thread, one row per block
+ */
+
+__global__ void
+kinsrc_end_gpu(gd_t gd_d, fault_t F, int *loc, float *muA, double *end)
+{
+  __shared__ double s_val[KINSRC_NUM_END][KINSRC_BLOCK_SIZE];
+
+  int *lc = loc + blockIdx.x * KINSRC_NUM_LOC;
+  int id  = lc[0];
+  int nj  = lc[3] - lc[2] + 1;
+  int npt = nj * (lc[5] - lc[4] + 1);
+  fault_one_t *F_thisone = F.fault_one + id;
+  float *muA_f = muA + id * gd_d.siz_slice_yz;
+
+  double v[KINSRC_NUM_END] = {0.0, 0.0, 0.0, KINSRC_NO_ONSET};
+  for (int n = threadIdx.x; n < npt; n += blockDim.x)
+  {
+    size_t iptr_f = (n % nj + lc[2]) + (n / nj + lc[4]) * gd_d.ny;
+    double m = muA_f[iptr_f];
+    v[KINSRC_SLIP ] += m * F_thisone->Slip [iptr_f];
+    v[KINSRC_SLIP1] += m * F_thisone->Slip1[iptr_f];
+    v[KINSRC_SLIP2] += m * F_thisone->Slip2[iptr_f];
+    if (F_thisone->init_t0_flag[iptr_f] == 1 && F_thisone->Init_t0[iptr_f] < v[KINSRC_ONSET]) {
+      v[KINSRC_ONSET] = F_thisone->Init_t0[iptr_f];
+    }
+  }
+
+  int tid = threadIdx.x;
+  for (int i=0; i < KINSRC_NUM_END; i++) s_val[i][tid] = v[i];
+  __syncthreads();
+
+  for (int s = blockDim.x / 2; s > 0; s >>= 1)
+  {
+    if (tid < s)
+    {
+      for (int i=0; i < KINSRC_ONSET; i++) s_val[i][tid] += s_val[i][tid + s];
+      if (s_val[KINSRC_ONSET][tid + s] < s_val[KINSRC_ONSET][tid]) {
+        s_val[KINSRC_ONSET][tid] = s_val[KINSRC_ONSET][tid + s];
+      }
+    }
+    __syncthreads();
+  }
+
+  if (tid == 0)
+  {
+    for (int i=0; i < KINSRC_NUM_END; i++) end[blockIdx.x * KINSRC_NUM_END + i] = s_val[i][0];
+  }
+}
@@ -0,0 +1,112 @@
+#ifndef KINSRC_T_H
+#define KINSRC_T_H
+
+#include <mpi.h>
+
+#include "gd_t.h"
+#include "fault_info.h"
+
+/*************************************************
+ * in-situ kinematic source of faults
+ *  points of fault_grid are tiled into subfaults of nj x nk points, the
+ *  last subfault of each direction takes the rest. at each step moment
+ *  rate sum(mu*Vs*dA) and its strike and dip parts sum(mu*Vs1*dA),
+ *  sum(mu*Vs2*dA) of each subfault are reduced on device, one block per
+ *  subfault of this thread, into samples of sample_every steps. buffer
+ *  is summed over threads by MPI_Reduce when full and added to the
+ *  series kept by thread 0. at end onset (first Init_t0), slip and rake
+ *  of subfaults are reduced, and thread 0 writes kinematic_source.src of
+ *  discrete stf by strike/dip/rake and mu D A, same as src_export.m of
+ *  post_proc, and a table of subfaults
+ *************************************************/
+
+// moment rate of a sample
+#define KINSRC_RATE      0
+#define KINSRC_RATE1     1 // strike part
+#define KINSRC_RATE2     2 // dip part
+#define KINSRC_NUM_RATE  3
+
+// geometry, sums over points
+#define KINSRC_AREA      0
+#define KINSRC_MUA       1
+#define KINSRC_X         2 // dA * coord
+#define KINSRC_Y         3
+#define KINSRC_Z         4
+#define KINSRC_S1        5 // dA * vec_s1, 3 cmp
+#define KINSRC_S2        8 // dA * vec_s2, 3 cmp
+#define KINSRC_NUM_GEO  11
+
+// end of run
+#define KINSRC_SLIP      0 // mu * Slip * dA
+#define KINSRC_SLIP1     1
+#define KINSRC_SLIP2     2
+#define KINSRC_ONSET     3 // first Init_t0 of ruptured points
+#define KINSRC_NUM_END   4
+
+// subfault of this thread: fault, subfault, j1, j2, k1, k2 with ghost
+#define KINSRC_NUM_LOC   6
+
+#define KINSRC_NO_ONSET    1.0e30
+#define KINSRC_FLUSH_EVERY 64 // samples in buffer
+#define KINSRC_BLOCK_SIZE  128
+
+typedef struct
+{
+  int   enable;
+  int   myid;
+  int   sample_every; // steps of one sample
+  int   nt_total;
+  int   nt_sample;
+  float dt;
+  float t0;
+  float time_length;  // of stf, <= 0 to end of run
+
+  int  number_fault;
+  int *num_sub_j;  // of each fault
+  int *num_sub_k;
+  int  num_of_sub; // of all faults
+
+  int    num_of_loc;
+  int   *loc;      // [num_of_loc][KINSRC_NUM_LOC]
+  int   *loc_d;
+  float *muA_d;    // [number_fault][siz_slice_yz]
+  double *geo;     // [num_of_sub][KINSRC_NUM_GEO], summed on thread 0
+
+  int     is_beg;     // sample of first row in buffer
+  int     num_of_row; // rows in buffer
+  double *rate_d;     // [KINSRC_FLUSH_EVERY][num_of_sub][KINSRC_NUM_RATE]
+  double *rate;
+  double *rate_sum;
+  double *series;     // [nt_sample][num_of_sub][KINSRC_NUM_RATE], thread 0
+} kinsrc_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+kinsrc_init(kinsrc_t *kinsrc, int enable, int *subfault_points, int sample_every,
+            float time_length, float dt, float t0, int nt_total, int *fault_grid,
+            gd_t *gd, gd_metric_t metric_d, fault_coef_t *FC, fault_coef_t FC_d,
+            MPI_Comm comm, int myid);
+
+int
+kinsrc_keep(kinsrc_t *kinsrc, int it, gd_t gd_d, fault_t F_d, MPI_Comm comm);
+
+int
+kinsrc_flush(kinsrc_t *kinsrc, MPI_Comm comm);
+
+int
+kinsrc_finish(kinsrc_t *kinsrc, gd_t gd_d, fault_t F_d, MPI_Comm comm,
+              char *output_dir);
+
+int
+kinsrc_free(kinsrc_t *kinsrc);
+
+__global__ void
+kinsrc_rate_gpu(gd_t gd_d, fault_t F, int *loc, float *muA, double *rate);
+
+__global__ void
+kinsrc_end_gpu(gd_t gd_d, fault_t F, int *loc, float *muA, double *end);
+
+#endif
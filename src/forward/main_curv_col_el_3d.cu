@@ -22,179 +22,75 @@
 #include "media_discrete_model.h"
 #include "drv_rk_curv_col.h"
 #include "cuda_common.h"
-
-int main(int argc, char** argv)
+#include "plan_mem.h"
+#include "prof_t.h"
+#include "chkpt_t.h"
+#include "drv_ensemble.h"
+#include "setup_graph.h"
+#include "alloc.h"
+
+/*
+ * set-up tasks run by setup_graph, no MPI inside
+ */
+
+typedef struct
 {
-  int gpu_id_start;
-  char *par_fname;
-  char err_message[CONST_MAX_STRLEN];
-
-  //-------------------------------------------------------------------------------
-  // start MPI and read par
-  //-------------------------------------------------------------------------------
-
-  // init MPI
-
-  int myid, mpi_size;
-  MPI_Init(&argc, &argv);
-  MPI_Comm comm = MPI_COMM_WORLD;
-  MPI_Comm_rank(comm, &myid);
-  MPI_Comm_size(comm, &mpi_size);
+  par_t   *par;
+  blk_t   *blk;
+  chkpt_t *chkpt;
+  int      myid;
 
-  // get commond-line argument
-  if (myid==0) 
-  {
-    // argc checking
-    if (argc < 3) {
-      fprintf(stdout,"usage: cgfdm3d_elastic <par_file> \n");
-      MPI_Finalize();
-      exit(1);
-    }
+  gd_metric_t metric_d; // device copy uploaded by metric_upload
+} setup_ctx_t;
 
-    par_fname = argv[1];
+static int
+setup_task_minmax(void *arg)
+{
+  setup_ctx_t *ctx = (setup_ctx_t *) arg;
 
-    if (argc >= 3) {
-      gpu_id_start = atoi(argv[2]); // gpu_id_start number
-      fprintf(stdout,"gpu_id_start=%d\n",gpu_id_start ); fflush(stdout);
-    }
-    MPI_Bcast(&gpu_id_start, 1, MPI_INT, 0, comm);
-  }
-  else
-  {
-    MPI_Bcast(&gpu_id_start, 1, MPI_INT, 0, comm);
+  // cal min/max of this thread
+  gd_curv_set_minmax(ctx->blk->gd);
+  if (ctx->myid==0) {
+    fprintf(stdout,"calculated min/max of grid/tile/cell\n"); 
+    fflush(stdout);
   }
 
-  //-------------------------------------------------------------------------------
-  // initial gpu device after start MPI
-  //-------------------------------------------------------------------------------
-  setDeviceBeforeInit(gpu_id_start);
-
-  if (myid==0) fprintf(stdout,"comm=%d, size=%d\n", comm, mpi_size); 
-  if (myid==0) fprintf(stdout,"par file =  %s\n", par_fname); 
-
-  // read par
-  par_t *par = (par_t *) malloc(sizeof(par_t));
-  par_mpi_get(par_fname, myid, comm, par);
-  if (myid==0) par_print(par);
-
-  //-------------------------------------------------------------------------------
-  // init blk_t
-  //-------------------------------------------------------------------------------
-
-  if (myid==0) fprintf(stdout,"create blk ...\n"); 
-
-  // malloc blk
-  blk_t *blk = (blk_t *) malloc(sizeof(blk_t));
-
-  // malloc inner vars
-  blk_init(blk, myid);
-
-  fd_t            *fd            = blk->fd    ;
-  mympi_t         *mympi         = blk->mympi ;
-  gd_t            *gd            = blk->gd;
-  gd_metric_t     *gd_metric     = blk->gd_metric;
-  md_t            *md            = blk->md;
-  wav_t           *wav           = blk->wav;
-  bdryfree_t      *bdryfree      = blk->bdryfree;
-  bdrypml_t       *bdrypml       = blk->bdrypml;
-  bdryexp_t       *bdryexp       = blk->bdryexp;
-  iorecv_t        *iorecv        = blk->iorecv;
-  io_fault_recv_t *io_fault_recv = blk->io_fault_recv;
-  ioline_t        *ioline        = blk->ioline;
-  iofault_t       *iofault       = blk->iofault;
-  ioslice_t       *ioslice       = blk->ioslice;
-  iosnap_t        *iosnap        = blk->iosnap;
-  fault_t         *fault         = blk->fault;
-  fault_coef_t    *fault_coef    = blk->fault_coef;
-  fault_wav_t     *fault_wav     = blk->fault_wav;
-
-  // set up fd_t
-  if (myid==0) fprintf(stdout,"set scheme ...\n"); 
-  fd_set_macdrp(fd);
-
-  // set mpi
-  if (myid==0) fprintf(stdout,"set mpi topo ...\n"); 
-  mympi_set(mympi,
-            par->number_of_mpiprocs_x,
-            par->number_of_mpiprocs_y,
-            par->number_of_mpiprocs_z,
-            comm,
-            myid);
-
-  // set gdinfo
-  gd_info_set(gd, mympi,
-              par->number_of_total_grid_points_x,
-              par->number_of_total_grid_points_y,
-              par->number_of_total_grid_points_z,
-              par->bdry_has_cfspml,
-              par->abs_num_of_layers,
-              fd->fdx_nghosts,
-              fd->fdy_nghosts,
-              fd->fdz_nghosts);
-              
-
-  // set str in blk
-  blk_set_output(blk, mympi,
-                 par->output_dir,
-                 par->grid_export_dir,
-                 par->media_export_dir);
-
-  //-------------------------------------------------------------------------------
-  //-- grid generation or import
-  //-------------------------------------------------------------------------------
-
-  if (myid==0) fprintf(stdout,"allocate grid vars ...\n"); 
-
-  // malloc var in gd
-  gd_curv_init(gd);
-
-  // malloc var in gd_metric
-  gd_curv_metric_init(gd, gd_metric);
-
-  // generate grid coord
-  switch (par->grid_generation_itype)
-  {
-    case FAULT_PLANE : {
-
-      if (myid==0) fprintf(stdout,"gerate grid using fault plane...\n"); 
-      gd_curv_gen_fault(gd, par->number_fault, par->fault_x_index, par->dh, par->fault_coord_dir);
-      if (myid==0) fprintf(stdout,"exchange coords ...\n"); 
-      gd_exchange(gd,gd->v4d,gd->ncmp,mympi->neighid,mympi->topocomm);
-
-      break;
-    }
+  return 0;
+}
 
-    case GRID_IMPORT : {
+static int
+setup_task_coord_export(void *arg)
+{
+  setup_ctx_t *ctx = (setup_ctx_t *) arg;
+  blk_t *blk = ctx->blk;
 
-      if (myid==0) fprintf(stdout,"import grid ...\n"); 
-      gd_curv_coord_import(gd, blk->output_fname_part, par->grid_import_dir);
-      if (myid==0) fprintf(stdout,"exchange coords ...\n"); 
-      gd_exchange(gd,gd->v4d,gd->ncmp,mympi->neighid,mympi->topocomm);
+  if (ctx->myid==0) fprintf(stdout,"export coord to file ...\n"); 
+  gd_curv_coord_export(blk->gd,
+                       blk->output_fname_part,
+                       blk->grid_export_dir);
 
-      break;
-    }
-  }
+  return 0;
+}
 
-  // cal min/max of this thread
-  gd_curv_set_minmax(gd);
-  if (myid==0) {
-    fprintf(stdout,"calculated min/max of grid/tile/cell\n"); 
-    fflush(stdout);
-  }
+static int
+setup_task_metric(void *arg)
+{
+  setup_ctx_t *ctx = (setup_ctx_t *) arg;
+  par_t       *par       = ctx->par;
+  blk_t       *blk       = ctx->blk;
+  gd_t        *gd        = blk->gd;
+  gd_metric_t *gd_metric = blk->gd_metric;
+  int          myid      = ctx->myid;
 
-  // output
-  if (par->is_export_grid==1)
+  // cal metrics and output for QC
+  if (par->checkpoint_restart == 1)
   {
-    if (myid==0) fprintf(stdout,"export coord to file ...\n"); 
-    gd_curv_coord_export(gd,
-                         blk->output_fname_part,
-                         blk->grid_export_dir);
-  } else {
-    if (myid==0) fprintf(stdout,"do not export coord\n"); 
+    if (myid==0) fprintf(stdout,"load metrics from checkpoint ...\n"); 
+    // error is returned to main thread by setup_graph_wait
+    return chkpt_read_one(ctx->chkpt, "setup", "metric", gd_metric->v4d,
+                          sizeof(float)*gd_metric->siz_icmp*gd_metric->ncmp);
   }
-  fprintf(stdout, " --> done\n"); fflush(stdout);
 
-  // cal metrics and output for QC
   switch (par->metric_method_itype)
   {
     case PAR_METRIC_CALCULATE : {
@@ -212,30 +108,52 @@ int main(int argc, char** argv)
       break;
     }
   }
-  if (myid==0) { fprintf(stdout, " --> done\n"); fflush(stdout); }
 
-  // export metric
-  if (par->is_export_metric==1)
-  {
-    if (myid==0) fprintf(stdout,"export metric to file ...\n"); 
-    gd_curv_metric_export(gd,gd_metric,
-                          blk->output_fname_part,
-                          blk->grid_export_dir);
-  } else {
-    if (myid==0) fprintf(stdout,"do not export metric\n"); 
-  }
-  if (myid==0) { fprintf(stdout, " --> done\n"); fflush(stdout); }
+  return 0;
+}
 
-  //-------------------------------------------------------------------------------
-  //-- media generation or import
-  //-------------------------------------------------------------------------------
+static int
+setup_task_metric_upload(void *arg)
+{
+  setup_ctx_t *ctx = (setup_ctx_t *) arg;
 
-  // allocate media vars
-  if (myid==0) {fprintf(stdout,"allocate media vars ...\n"); fflush(stdout);}
-  md_init(gd, md, par->media_itype, par->visco_itype);
+  init_metric_device(ctx->blk->gd_metric, &(ctx->metric_d), ctx->par->metric_recompute);
+
+  return 0;
+}
+
+static int
+setup_task_metric_export(void *arg)
+{
+  setup_ctx_t *ctx = (setup_ctx_t *) arg;
+  blk_t *blk = ctx->blk;
+
+  if (ctx->myid==0) fprintf(stdout,"export metric to file ...\n"); 
+  gd_curv_metric_export(blk->gd, blk->gd_metric,
+                        blk->output_fname_part,
+                        blk->grid_export_dir);
+
+  return 0;
+}
+
+static int
+setup_task_media(void *arg)
+{
+  setup_ctx_t *ctx = (setup_ctx_t *) arg;
+  par_t *par  = ctx->par;
+  blk_t *blk  = ctx->blk;
+  gd_t  *gd   = blk->gd;
+  md_t  *md   = blk->md;
+  int    myid = ctx->myid;
 
-  time_t t_start_md = time(NULL);
   // read or discrete velocity model
+  if (par->checkpoint_restart == 1)
+  {
+    if (myid==0) fprintf(stdout,"load media from checkpoint ...\n"); 
+    return chkpt_read_one(ctx->chkpt, "setup", "media", md->v4d,
+                          sizeof(float)*md->siz_icmp*md->ncmp);
+  }
+
   switch (par->media_input_itype)
   {
     case PAR_MEDIA_CODE : {
@@ -451,23 +369,284 @@ int main(int argc, char** argv)
       break;
     } 
   }
+  return 0;
+}
 
-  MPI_Barrier(comm);
-  time_t t_end_md = time(NULL);
-  
-  if (myid==0) {
-    fprintf(stdout,"media Time of time :%f s \n", difftime(t_end_md,t_start_md));
+static int
+setup_task_media_export(void *arg)
+{
+  setup_ctx_t *ctx = (setup_ctx_t *) arg;
+  blk_t *blk = ctx->blk;
+
+  if (ctx->myid==0) fprintf(stdout,"export discrete medium to file ...\n"); 
+  md_export(blk->gd, blk->md,
+            blk->output_fname_part,
+            blk->media_export_dir);
+
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  int gpu_id_start;
+  char *par_fname;
+  char err_message[CONST_MAX_STRLEN];
+
+  //-------------------------------------------------------------------------------
+  // start MPI and read par
+  //-------------------------------------------------------------------------------
+
+  // init MPI
+
+  int myid, mpi_size;
+  MPI_Init(&argc, &argv);
+  MPI_Comm comm = MPI_COMM_WORLD;
+  MPI_Comm_rank(comm, &myid);
+  MPI_Comm_size(comm, &mpi_size);
+
+  // dry run to estimate memory and cost, no gpu needed
+  int is_plan = 0;
+
+  // get commond-line argument
+  if (myid==0) 
+  {
+    // argc checking
+    if (argc < 3) {
+      fprintf(stdout,"usage: cgfdm3d_elastic <par_file> <gpu_id_start|--plan> \n");
+      MPI_Finalize();
+      exit(1);
+    }
+
+    par_fname = argv[1];
+
+    for (int i=2; i<argc; i++) {
+      if (strcmp(argv[i], "--plan") == 0) is_plan = 1;
+    }
+
+    if (argc >= 3 && is_plan == 0) {
+      gpu_id_start = atoi(argv[2]); // gpu_id_start number
+      fprintf(stdout,"gpu_id_start=%d\n",gpu_id_start ); fflush(stdout);
+    }
+    MPI_Bcast(&gpu_id_start, 1, MPI_INT, 0, comm);
   }
-  // export grid media
-  if (par->is_export_media==1)
+  else
   {
-    if (myid==0) fprintf(stdout,"export discrete medium to file ...\n"); 
+    MPI_Bcast(&gpu_id_start, 1, MPI_INT, 0, comm);
+  }
+  MPI_Bcast(&is_plan, 1, MPI_INT, 0, comm);
+
+  //-------------------------------------------------------------------------------
+  // initial gpu device after start MPI
+  //-------------------------------------------------------------------------------
+  if (is_plan == 0) setDeviceBeforeInit(gpu_id_start);
+
+  if (myid==0) fprintf(stdout,"comm=%d, size=%d\n", comm, mpi_size); 
+  if (myid==0) fprintf(stdout,"par file =  %s\n", par_fname); 
+
+  // read par
+  par_t *par = (par_t *) malloc(sizeof(par_t));
+  par_mpi_get(par_fname, myid, comm, par);
+  if (myid==0) par_print(par);
 
-    md_export(gd, md,
-              blk->output_fname_part,
-              blk->media_export_dir);
-  } else {
-    if (myid==0) fprintf(stdout,"do not export medium\n"); 
+  // only print memory and cost plan, then exit
+  if (is_plan == 1)
+  {
+    plan_mem_run(par, myid);
+    MPI_Finalize();
+    return 0;
+  }
+
+  // timing of set-up and time loop scopes
+  prof_t prof;
+  prof_init(&prof, par->profile_timing, 1);
+
+  // event trace of a window of steps
+  trace_t trace;
+  trace_init(&trace, par->trace_step_start, par->trace_step_count,
+             par->trace_buffer_size, comm, myid);
+  if (trace.enable == 1) prof.trace = &trace;
+
+  // checkpoint/restart, wall time counts from here
+  chkpt_t chkpt;
+  chkpt_init(&chkpt, par->checkpoint_every_number_of_steps,
+             par->checkpoint_wall_time, par->checkpoint_on_signal,
+             par->checkpoint_dir, myid, prof_wtime());
+
+  //-------------------------------------------------------------------------------
+  // init blk_t
+  //-------------------------------------------------------------------------------
+
+  if (myid==0) fprintf(stdout,"create blk ...\n"); 
+
+  // malloc blk
+  blk_t *blk = (blk_t *) malloc(sizeof(blk_t));
+
+  // malloc inner vars
+  blk_init(blk, myid);
+
+  fd_t            *fd            = blk->fd    ;
+  mympi_t         *mympi         = blk->mympi ;
+  gd_t            *gd            = blk->gd;
+  gd_metric_t     *gd_metric     = blk->gd_metric;
+  md_t            *md            = blk->md;
+  wav_t           *wav           = blk->wav;
+  bdryfree_t      *bdryfree      = blk->bdryfree;
+  bdrypml_t       *bdrypml       = blk->bdrypml;
+  bdryexp_t       *bdryexp       = blk->bdryexp;
+  iorecv_t        *iorecv        = blk->iorecv;
+  io_fault_recv_t *io_fault_recv = blk->io_fault_recv;
+  ioline_t        *ioline        = blk->ioline;
+  iofault_t       *iofault       = blk->iofault;
+  ioslice_t       *ioslice       = blk->ioslice;
+  iosnap_t        *iosnap        = blk->iosnap;
+  fault_t         *fault         = blk->fault;
+  fault_coef_t    *fault_coef    = blk->fault_coef;
+  fault_wav_t     *fault_wav     = blk->fault_wav;
+
+  // set up fd_t
+  if (myid==0) fprintf(stdout,"set scheme ...\n"); 
+  fd_set_macdrp(fd);
+
+  // set mpi
+  if (myid==0) fprintf(stdout,"set mpi topo ...\n"); 
+  mympi_set(mympi,
+            par->number_of_mpiprocs_x,
+            par->number_of_mpiprocs_y,
+            par->number_of_mpiprocs_z,
+            comm,
+            myid);
+
+  // set gdinfo
+  gd_info_set(gd, mympi,
+              par->number_of_total_grid_points_x,
+              par->number_of_total_grid_points_y,
+              par->number_of_total_grid_points_z,
+              par->bdry_has_cfspml,
+              par->abs_num_of_layers,
+              fd->fdx_nghosts,
+              fd->fdy_nghosts,
+              fd->fdz_nghosts);
+              
+
+  // set str in blk
+  blk_set_output(blk, mympi,
+                 par->output_dir,
+                 par->grid_export_dir,
+                 par->media_export_dir);
+
+  //-------------------------------------------------------------------------------
+  //-- grid generation or import
+  //-------------------------------------------------------------------------------
+
+  if (myid==0) fprintf(stdout,"allocate grid vars ...\n"); 
+
+  // malloc var in gd
+  gd_curv_init(gd);
+
+  // malloc var in gd_metric
+  gd_curv_metric_init(gd, gd_metric);
+
+  // generate grid coord
+  if (par->checkpoint_restart == 1)
+  {
+    if (myid==0) fprintf(stdout,"load coords from checkpoint ...\n"); 
+    if (chkpt_read_one(&chkpt, "setup", "coord", gd->v4d,
+                       sizeof(float)*gd->siz_icmp*gd->ncmp) != 0) {
+      MPI_Abort(MPI_COMM_WORLD,1);
+    }
+  }
+  else
+  {
+    switch (par->grid_generation_itype)
+    {
+      case FAULT_PLANE : {
+
+        if (myid==0) fprintf(stdout,"gerate grid using fault plane...\n"); 
+        gd_stretch_t stretch;
+        stretch.itype         = par->grid_stretch_itype;
+        stretch.uniform_cells = par->grid_stretch_uniform_cells;
+        stretch.ratio         = par->grid_stretch_ratio;
+        stretch.width         = par->grid_stretch_width;
+        stretch.max_factor    = par->grid_stretch_max_factor;
+        gd_curv_gen_fault(gd, par->number_fault, par->fault_x_index, par->dh,
+                          &stretch, par->fault_coord_dir);
+        gd_curv_stretch_report(gd, par->number_fault, par->fault_x_index, par->dh,
+                               &stretch, myid);
+        if (myid==0) fprintf(stdout,"exchange coords ...\n"); 
+        gd_exchange(gd,gd->v4d,gd->ncmp,mympi->neighid,mympi->topocomm);
+
+        break;
+      }
+
+      case GRID_IMPORT : {
+
+        if (myid==0) fprintf(stdout,"import grid ...\n"); 
+        gd_curv_coord_import(gd, blk->output_fname_part, par->grid_import_dir);
+        if (myid==0) fprintf(stdout,"exchange coords ...\n"); 
+        gd_exchange(gd,gd->v4d,gd->ncmp,mympi->neighid,mympi->topocomm);
+
+        break;
+      }
+    }
+  }
+
+
+  //-------------------------------------------------------------------------------
+  //-- set-up tasks after coords are final: metric and media run side by
+  //-- side, exports write in background, metric is uploaded when ready
+  //-------------------------------------------------------------------------------
+
+  // allocate media vars
+  if (myid==0) {fprintf(stdout,"allocate media vars ...\n"); fflush(stdout);}
+  md_init(gd, md, par->media_itype, par->visco_itype);
+
+  setup_ctx_t setup_ctx;
+  setup_ctx.par   = par;
+  setup_ctx.blk   = blk;
+  setup_ctx.chkpt = &chkpt;
+  setup_ctx.myid  = myid;
+
+  setup_graph_t setup_graph;
+  setup_graph_init(&setup_graph, par->setup_num_of_threads, myid);
+
+  int is_metric_io = (par->checkpoint_restart == 1 ||
+                      par->metric_method_itype == PAR_METRIC_IMPORT) ? 1 : 0;
+  int is_media_io  = (par->checkpoint_restart == 1 ||
+                      par->media_input_itype == PAR_MEDIA_IMPORT) ? 1 : 0;
+
+  // order of adding is the serial order and the priority of ready tasks
+  int id_minmax = setup_graph_add(&setup_graph, "minmax",
+                                  setup_task_minmax, &setup_ctx, 0, 0, NULL);
+  int id_metric = setup_graph_add(&setup_graph, "metric",
+                                  setup_task_metric, &setup_ctx, is_metric_io, 0, NULL);
+  // grid and bin media use min/max of grid
+  int id_media  = setup_graph_add(&setup_graph, "media",
+                                  setup_task_media, &setup_ctx, is_media_io, 1, &id_minmax);
+  // recompute mode only uploads coords
+  int id_metric_upload = setup_graph_add(&setup_graph, "metric_upload",
+                                  setup_task_metric_upload, &setup_ctx, 0,
+                                  par->metric_recompute == 1 ? 0 : 1, &id_metric);
+  int id_export[3] = {-1, -1, -1};
+  if (par->is_export_grid==1) {
+    id_export[0] = setup_graph_add(&setup_graph, "coord_export",
+                                   setup_task_coord_export, &setup_ctx, 1, 0, NULL);
+  }
+  if (par->is_export_metric==1) {
+    id_export[1] = setup_graph_add(&setup_graph, "metric_export",
+                                   setup_task_metric_export, &setup_ctx, 1, 1, &id_metric);
+  }
+  if (par->is_export_media==1) {
+    id_export[2] = setup_graph_add(&setup_graph, "media_export",
+                                   setup_task_media_export, &setup_ctx, 1, 1, &id_media);
+  }
+
+  setup_graph_start(&setup_graph);
+
+  setup_graph_wait(&setup_graph, id_media);
+  MPI_Barrier(comm);
+  
+  if (myid==0) {
+    fprintf(stdout,"media Time of time :%f s \n", setup_graph_duration(&setup_graph, id_media));
   }
 
   //-------------------------------------------------------------------------------
@@ -541,8 +720,21 @@ int main(int argc, char** argv)
   //-- fault init
   //-------------------------------------------------------------------------------
 
+  setup_graph_wait(&setup_graph, id_metric);
+
+  prof_beg(&prof, PROF_FAULT_COEF);
   fault_coef_init(fault_coef, gd, par->number_fault, par->fault_x_index); 
-  fault_coef_cal(gd, gd_metric, md, fault_coef);
+  if (par->checkpoint_restart == 1)
+  {
+    chkpt_reset(&chkpt);
+    chkpt_add_fault_coef(&chkpt, gd, fault_coef);
+    if (chkpt_read(&chkpt, "setup") != 0) MPI_Abort(MPI_COMM_WORLD,1);
+  }
+  else
+  {
+    fault_coef_cal(gd, gd_metric, md, fault_coef);
+  }
+  prof_end(&prof, PROF_FAULT_COEF);
   fault_init(fault, gd, par->number_fault, par->fault_x_index);
   fault_set(fault, fault_coef, gd, par->bdry_has_free, par->fault_grid, par->init_stress_dir);
   fault_wav_init(gd, fault_wav, par->number_fault, par->fault_x_index, fd->num_rk_stages);
@@ -562,7 +754,10 @@ int main(int argc, char** argv)
 
   // receiver: need to do
   io_recv_read_locate(gd, iorecv,
-                      nt_total, wav->ncmp, 
+                      nt_total, par->in_station_decimation,
+                      par->seismo_stream_every, dt,
+                      par->in_station_spectrum_num_of_freq,
+                      par->in_station_spectrum_freq, wav->ncmp, 
                       par->number_of_mpiprocs_z,
                       par->in_station_file,
                       comm, myid);
@@ -570,18 +765,16 @@ int main(int argc, char** argv)
   // Tn Ts1 Ts2 Vs Vs1 Vs2 Slip Slip1 Slip2
   int fault_ncmp = fault->ncmp - 2;  //=9
   io_fault_recv_read_locate(gd, io_fault_recv,
-                            nt_total, fault_ncmp, 
+                            nt_total, par->fault_station_decimation,
+                            par->seismo_stream_every, fault_ncmp, 
                             par->fault_x_index,
                             par->fault_station_file,
+                            par->fault_station_reduce_every,
                             comm, myid);
-  // receive flag_exchange_var from each proc
-  int sendbuf = io_fault_recv->flag_swap;
-  MPI_Allreduce(&sendbuf,&io_fault_recv->flag_swap,1,MPI_INT,MPI_MAX,comm);
-  if(myid == 0 && io_fault_recv->flag_swap == 1)
+  if(myid == 0 && io_fault_recv->num_of_share > 0)
   {
-    fprintf(stdout,"########################################################\n");
-    fprintf(stdout,"have fault recv in ghost region, need exchange fault var\n");
-    fprintf(stdout,"########################################################\n");
+    fprintf(stdout,"%d fault recv over threads, reduced each %d steps\n",
+            io_fault_recv->num_of_share, io_fault_recv->reduce_every);
     fflush(stdout);
   }
 
@@ -589,6 +782,8 @@ int main(int argc, char** argv)
   io_line_locate(gd, ioline,
                  wav->ncmp,
                  nt_total,
+                 par->receiver_line_decimation,
+                 par->seismo_stream_every,
                  par->number_of_receiver_line,
                  par->receiver_line_index_start,
                  par->receiver_line_index_incre,
@@ -625,8 +820,12 @@ int main(int argc, char** argv)
                      par->snapshot_save_velocity,
                      par->snapshot_save_stress,
                      par->snapshot_save_strain,
+                     par->snapshot_compress_error_abs,
+                     par->snapshot_compress_error_rel,
+                     par->snapshot_compress_threads,
                      blk->output_fname_part,
-                     blk->output_dir);
+                     blk->output_dir,
+                     comm);
 
   //-------------------------------------------------------------------------------
   //-- absorbing boundary etc auxiliary variables
@@ -677,13 +876,6 @@ int main(int argc, char** argv)
                   wav->ncmp);
   macdrp_fault_mesg_init(mympi, fd, gd->nj, gd->nk,
                   fault_wav->ncmp, par->number_fault); 
-  // output 9 varialbe, need -2
-  if(io_fault_recv->flag_swap == 1)
-  {
-    int ncmp_out = fault->ncmp-2;
-    macdrp_fault_output_mesg_init(mympi, fd, gd->nj, gd->nk,
-                    ncmp_out, par->number_fault);
-  }
 
   //-------------------------------------------------------------------------------
   //-- qc
@@ -701,43 +893,117 @@ int main(int argc, char** argv)
   //-- slover
   //-------------------------------------------------------------------------------
   
+  // exports read media before converting rho
+  setup_graph_finish(&setup_graph);
+  setup_graph_report(&setup_graph, comm);
+  prof_add(&prof, PROF_METRIC,
+           setup_graph.t_start + setup_graph.task[id_metric].t_beg,
+           setup_graph.t_start + setup_graph.task[id_metric].t_end);
+  prof_add(&prof, PROF_MEDIA,
+           setup_graph.t_start + setup_graph.task[id_media].t_beg,
+           setup_graph.t_start + setup_graph.task[id_media].t_end);
+
+  // keep set-up for restart, media before converting rho
+  if (chkpt.enable == 1 && par->checkpoint_restart == 0)
+  {
+    if (myid==0) fprintf(stdout,"write set-up checkpoint ...\n"); 
+    chkpt_reset(&chkpt);
+    chkpt_add(&chkpt, "coord",  gd->v4d, sizeof(float)*gd->siz_icmp*gd->ncmp, 0);
+    chkpt_add(&chkpt, "metric", gd_metric->v4d,
+              sizeof(float)*gd_metric->siz_icmp*gd_metric->ncmp, 0);
+    chkpt_add(&chkpt, "media",  md->v4d, sizeof(float)*md->siz_icmp*md->ncmp, 0);
+    chkpt_add_fault_coef(&chkpt, gd, fault_coef);
+    chkpt_write(&chkpt, "setup", 0, nt_total, dt, 0);
+  }
+
   // convert rho to 1 / rho to reduce number of arithmetic cal
   md_rho_to_slow(md->rho, md->siz_icmp);
 
+  // keep station media before host media released in solver
+  if(md->medium_type == CONST_MEDIUM_ELASTIC_ISO) {
+    io_recv_set_media_el_iso(iorecv, md->lambda, md->mu);
+  }
+
+  // piecewise-constant media as material id and table
+  md_mat_compress(md, par->media_max_material);
+  md_mat_report(md, comm, myid);
+
   if (myid==0) fprintf(stdout,"start solver ...\n"); 
   
+  // single run, or members of ensemble one by one on same set-up
+  int num_of_member = 1;
+  if (par->number_of_ensemble_member > 0) num_of_member = par->number_of_ensemble_member;
+  int is_unhealthy = 0;
+  // steps run by all members, for rate of point updates
+  double num_of_step_all = 0.0;
+
   time_t t_start = time(NULL);
 
-  drv_rk_curv_col_allstep(fd,gd,gd_metric,md,par,
-                          bdryfree,bdrypml,bdryexp,wav,mympi,
-                          fault_coef,fault,fault_wav,
-                          iorecv,ioline,iofault,ioslice,iosnap,
-                          io_fault_recv,
-                          dt,nt_total,t0,
-                          blk->output_fname_part,
-                          blk->output_dir);
+  for (int iens=0; iens<num_of_member; iens++)
+  {
+    if (par->number_of_ensemble_member > 0) {
+      drv_ensemble_set_member(blk, par, iens, comm, myid);
+    }
+
+    int num_of_step;
+    int is_unhealthy_member = drv_rk_curv_col_allstep(fd,gd,gd_metric,&(setup_ctx.metric_d),md,par,
+                                             bdryfree,bdrypml,bdryexp,wav,mympi,
+                                             fault_coef,fault,fault_wav,
+                                             iorecv,ioline,iofault,ioslice,iosnap,
+                                             io_fault_recv,
+                                             &prof,
+                                             &chkpt,
+                                             dt,nt_total,t0,
+                                             blk->output_fname_part,
+                                             blk->output_dir,
+                                             &num_of_step);
+    if (is_unhealthy_member == 1) is_unhealthy = 1;
+    num_of_step_all += num_of_step;
+
+    //-------------------------------------------------------------------------------
+    //-- save station and line seismo to archive or sac
+    //-------------------------------------------------------------------------------
+    if (par->seismo_output_archive == 1)
+    {
+      io_seismo_archive_write(iorecv, ioline, io_fault_recv, dt, wav->cmp_name,
+                              md->medium_type == CONST_MEDIUM_ELASTIC_ISO ? 1 : 0,
+                              blk->output_dir, comm, myid);
+    }
+    else
+    {
+      io_recv_output_sac(iorecv,dt,wav->ncmp,wav->cmp_name,
+                          blk->output_dir,err_message);
+
+      io_fault_recv_output_sac(io_fault_recv,dt,fault_ncmp,
+                               blk->output_dir,err_message);
+
+      if(md->medium_type == CONST_MEDIUM_ELASTIC_ISO) {
+        io_recv_output_sac_el_iso_strain(iorecv,dt,
+                          blk->output_dir,err_message);
+      }
+
+      io_line_output_sac(ioline,dt,wav->cmp_name,blk->output_dir);
+    }
+    io_recv_spectrum_write(iorecv, wav->cmp_name, blk->output_dir, comm, myid);
+  }
 
   time_t t_end = time(NULL);
+
+  dealloc_metric_device(setup_ctx.metric_d);
   
   if (myid==0) {
     fprintf(stdout,"\n\nRuning Time of time :%f s \n", difftime(t_end,t_start));
   }
 
-  //-------------------------------------------------------------------------------
-  //-- save station and line seismo to sac
-  //-------------------------------------------------------------------------------
-  io_recv_output_sac(iorecv,dt,wav->ncmp,wav->cmp_name,
-                      blk->output_dir,err_message);
+  // min/avg/max of scopes over all threads and members
+  prof_report(&prof, (double) gd->ni * gd->nj * gd->nk * num_of_step_all,
+              comm, myid, par->output_dir);
+  prof_free(&prof);
 
-  io_fault_recv_output_sac(io_fault_recv,dt,fault_ncmp,
-                           blk->output_dir,err_message);
+  trace_write(&trace, par->output_dir);
+  trace_free(&trace);
 
-  if(md->medium_type == CONST_MEDIUM_ELASTIC_ISO) {
-    io_recv_output_sac_el_iso_strain(iorecv,md->lambda,md->mu,dt,
-                      blk->output_dir,err_message);
-  }
-
-  io_line_output_sac(ioline,dt,wav->cmp_name,blk->output_dir);
+  chkpt_free(&chkpt);
 
   //-------------------------------------------------------------------------------
   //-- postprocess
@@ -745,5 +1011,6 @@ int main(int argc, char** argv)
 
   MPI_Finalize();
 
-  return 0;
+  // output before stop is kept, but mark the run as failed
+  return is_unhealthy;
 }
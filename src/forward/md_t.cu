@@ -219,6 +219,12 @@ md_init(gd_t *gd, md_t *md, int media_type, int visco_type)
   md->cmp_pos  = cmp_pos;
   md->cmp_name = cmp_name;
 
+  // not compressed until md_mat_compress
+  md->mat_nbyte  = 0;
+  md->num_of_mat = 0;
+  md->mat_id     = NULL;
+  md->siz_mat    = md->siz_icmp;
+
   return ierr;
 }
 
@@ -581,6 +587,184 @@ md_rho_to_slow(float *rho, size_t siz_icmp)
   return ierr;
 }
 
+/*
+ * replace per-point media by material id and a table of unique values,
+ *  done only if number of unique tuples of all vars is not larger
+ *  than max_of_mat and memory is saved. return 0 if compressed
+ */
+
+static void
+md_mat_remap(float **p, float *v4d, size_t siz_icmp, int ncmp,
+             float *tab, size_t num_of_mat)
+{
+  if (*p < v4d || *p >= v4d + siz_icmp * ncmp) return;
+
+  size_t icmp = (*p - v4d) / siz_icmp;
+  *p = tab + icmp * num_of_mat;
+}
+
+int
+md_mat_compress(md_t *md, int max_of_mat)
+{
+  size_t siz_icmp = md->siz_icmp;
+  int    ncmp     = md->ncmp;
+
+  if (max_of_mat <= 0 || md->mat_nbyte > 0) return -1;
+
+  // open addressing, at most half full
+  size_t siz_hash = 1;
+  while (siz_hash < 2 * (size_t) max_of_mat) siz_hash *= 2;
+
+  int   *hash = (int   *) malloc(siz_hash * sizeof(int));
+  float *tup  = (float *) malloc((size_t) max_of_mat * ncmp * sizeof(float));
+  unsigned short *id = (unsigned short *) malloc(siz_icmp * sizeof(unsigned short));
+  if (hash == NULL || tup == NULL || id == NULL) {
+    fprintf(stderr,"Error: can't malloc in md_mat_compress\n");
+    fflush(stderr);
+    exit(1);
+  }
+
+  for (size_t n=0; n<siz_hash; n++) hash[n] = -1;
+
+  float val[ncmp];
+  int num_of_mat = 0;
+  int is_ok = 1;
+
+  for (size_t iptr=0; iptr<siz_icmp; iptr++)
+  {
+    // fnv-1a of bits of all vars
+    unsigned int h = 2166136261u;
+    for (int icmp=0; icmp<ncmp; icmp++) {
+      unsigned int b;
+      val[icmp] = md->v4d[icmp * siz_icmp + iptr];
+      memcpy(&b, val + icmp, sizeof(unsigned int));
+      h = (h ^ b) * 16777619u;
+    }
+
+    size_t slot = h & (siz_hash - 1);
+    while (hash[slot] >= 0 &&
+           memcmp(tup + (size_t) hash[slot] * ncmp, val, ncmp * sizeof(float)) != 0)
+    {
+      slot = (slot + 1) & (siz_hash - 1);
+    }
+
+    // new material
+    if (hash[slot] < 0)
+    {
+      if (num_of_mat == max_of_mat) {
+        is_ok = 0;
+        break;
+      }
+      hash[slot] = num_of_mat;
+      memcpy(tup + (size_t) num_of_mat * ncmp, val, ncmp * sizeof(float));
+      num_of_mat += 1;
+    }
+
+    id[iptr] = (unsigned short) hash[slot];
+  }
+
+  free(hash);
+
+  // no gain if almost all points differ
+  size_t nbyte_id = (num_of_mat <= 256) ? 1 : 2;
+  if (siz_icmp * nbyte_id + (size_t) num_of_mat * ncmp * sizeof(float)
+      >= siz_icmp * ncmp * sizeof(float))
+  {
+    is_ok = 0;
+  }
+
+  if (is_ok == 0) {
+    free(tup);
+    free(id);
+    return -1;
+  }
+
+  // table of each var, same layout as v4d
+  float *tab = (float *) malloc((size_t) num_of_mat * ncmp * sizeof(float));
+  for (int m=0; m<num_of_mat; m++) {
+    for (int icmp=0; icmp<ncmp; icmp++) {
+      tab[icmp * num_of_mat + m] = tup[(size_t) m * ncmp + icmp];
+    }
+  }
+  free(tup);
+
+  // 8-bit id if enough
+  if (nbyte_id == 1)
+  {
+    unsigned char *id1 = (unsigned char *) malloc(siz_icmp * sizeof(unsigned char));
+    for (size_t iptr=0; iptr<siz_icmp; iptr++) {
+      id1[iptr] = (unsigned char) id[iptr];
+    }
+    free(id);
+    md->mat_id    = id1;
+    md->mat_nbyte = 1;
+  } else {
+    md->mat_id    = id;
+    md->mat_nbyte = 2;
+  }
+
+  // view pointers into table
+  float *v4d = md->v4d;
+  float **p[] = {&md->rho, &md->kappa, &md->lambda, &md->mu, &md->Qs,
+                 &md->c11, &md->c12, &md->c13, &md->c14, &md->c15, &md->c16,
+                           &md->c22, &md->c23, &md->c24, &md->c25, &md->c26,
+                                     &md->c33, &md->c34, &md->c35, &md->c36,
+                                               &md->c44, &md->c45, &md->c46,
+                                                         &md->c55, &md->c56,
+                                                                   &md->c66};
+  for (int n=0; n < (int) (sizeof(p) / sizeof(p[0])); n++) {
+    md_mat_remap(p[n], v4d, siz_icmp, ncmp, tab, num_of_mat);
+  }
+  for (int icmp=0; icmp<ncmp; icmp++) {
+    md->cmp_pos[icmp] = icmp * num_of_mat;
+  }
+
+  free(v4d);
+  md->v4d        = tab;
+  md->num_of_mat = num_of_mat;
+  md->siz_mat    = num_of_mat;
+
+  return 0;
+}
+
+/*
+ * memory saved and media bytes loaded per point, over all threads
+ */
+
+int
+md_mat_report(md_t *md, MPI_Comm comm, int myid)
+{
+  double nbyte_loc[5], nbyte_all[5];
+
+  size_t nbyte_full = md->siz_icmp * md->ncmp * sizeof(float);
+  size_t nbyte_comp = md->siz_icmp * md->mat_nbyte
+                    + md->siz_mat  * md->ncmp * sizeof(float);
+
+  // table is small and stays in cache, only id is loaded per point
+  size_t nbyte_pt = (md->mat_nbyte > 0) ? md->mat_nbyte : md->ncmp * sizeof(float);
+
+  nbyte_loc[0] = (double) nbyte_full;
+  nbyte_loc[1] = (double) ((md->mat_nbyte > 0) ? nbyte_comp : nbyte_full);
+  nbyte_loc[2] = (double) md->siz_icmp;
+  nbyte_loc[3] = (double) (md->siz_icmp * nbyte_pt);
+  nbyte_loc[4] = (md->mat_nbyte > 0) ? 1.0 : 0.0;
+
+  MPI_Reduce(nbyte_loc, nbyte_all, 5, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+  if (myid == 0)
+  {
+    fprintf(stdout,"media as material id on %d threads:\n", (int) nbyte_all[4]);
+    fprintf(stdout,"  memory %f MB -> %f MB, saved %f MB\n",
+            nbyte_all[0] / 1048576.0, nbyte_all[1] / 1048576.0,
+            (nbyte_all[0] - nbyte_all[1]) / 1048576.0);
+    fprintf(stdout,"  media bytes loaded per point %f -> %f\n",
+            nbyte_all[0] / nbyte_all[2], nbyte_all[3] / nbyte_all[2]);
+    fflush(stdout);
+  }
+
+  return 0;
+}
+
 int
 md_ac_Vp_to_kappa(float *rho, float *kappa, size_t siz_icmp)
 {
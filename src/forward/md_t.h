@@ -61,8 +61,27 @@ typedef struct {
   int visco_type;
   float visco_Qs_freq;
 
+  // material id of piecewise-constant media,
+  //  media vars keep one value per material instead of per point
+  int    mat_nbyte;  // 0: not compressed, 1 or 2: bytes of each id
+  int    num_of_mat;
+  void  *mat_id;     // siz_icmp ids
+  size_t siz_mat;    // number of values of each var, siz_icmp or num_of_mat
+
 } md_t;
 
+/*
+ * index into media vars of point iptr
+ */
+
+__host__ __device__ inline size_t
+md_mat_iptr(void *mat_id, int mat_nbyte, size_t iptr)
+{
+  if (mat_nbyte == 1) return ((unsigned char  *) mat_id)[iptr];
+  if (mat_nbyte == 2) return ((unsigned short *) mat_id)[iptr];
+  return iptr;
+}
+
 /*************************************************
  * function prototype
  *************************************************/
@@ -94,4 +113,10 @@ md_gen_uniform_el_aniso(md_t *md);
 int
 md_rho_to_slow(float *rho, size_t siz_icmp);
 
+int
+md_mat_compress(md_t *md, int max_of_mat);
+
+int
+md_mat_report(md_t *md, MPI_Comm comm, int myid);
+
 #endif
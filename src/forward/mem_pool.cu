@@ -0,0 +1,268 @@
+/*******************************************************************************
+ * size-class memory pool for device and pinned host temporary buffers
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef MEM_POOL_HOST_ONLY
+#include <cuda_runtime.h>
+#endif
+
+#include "mem_pool.h"
+
+/*
+ * allocate and free from system according to kind of pool
+ */
+
+static void *
+mem_pool_sys_malloc(int kind, size_t nbyte)
+{
+  void *p = NULL;
+
+#ifdef MEM_POOL_HOST_ONLY
+  (void) kind;
+  p = malloc(nbyte);
+#else
+  cudaError_t err;
+  if (kind == MEM_POOL_DEVICE) {
+    err = cudaMalloc(&p, nbyte);
+  } else {
+    err = cudaMallocHost(&p, nbyte);
+  }
+  if (err != cudaSuccess) {
+    fprintf(stderr,"Error: %s, code: %d, reason: %s\n",
+            kind == MEM_POOL_DEVICE ? "cudaMalloc" : "cudaMallocHost",
+            err, cudaGetErrorString(err));
+    p = NULL;
+  }
+#endif
+
+  return p;
+}
+
+static void
+mem_pool_sys_free(int kind, void *p)
+{
+#ifdef MEM_POOL_HOST_ONLY
+  (void) kind;
+  free(p);
+#else
+  if (kind == MEM_POOL_DEVICE) {
+    cudaFree(p);
+  } else {
+    cudaFreeHost(p);
+  }
+#endif
+}
+
+int
+mem_pool_init(mem_pool_t *pool, int kind, const char *name)
+{
+  pool->kind = kind;
+  strncpy(pool->name, name, MEM_POOL_NAME_STRLEN-1);
+  pool->name[MEM_POOL_NAME_STRLEN-1] = '\0';
+
+  for (int n=0; n < MEM_POOL_NUM_CLASS; n++) {
+    pool->free_list[n] = NULL;
+  }
+  for (int n=0; n < MEM_POOL_HASH_SIZE; n++) {
+    pool->used_hash[n] = NULL;
+  }
+
+  pool->nbyte_reserved    = 0;
+  pool->nbyte_in_use      = 0;
+  pool->nbyte_high_water  = 0;
+  pool->num_of_malloc     = 0;
+  pool->num_of_sys_malloc = 0;
+
+  return 0;
+}
+
+/*
+ * block size of class
+ */
+
+size_t
+mem_pool_class_size(int iclass)
+{
+  if (iclass < MEM_POOL_NUM_COARSE) {
+    return (size_t) 1 << (iclass + MEM_POOL_MIN_SHIFT);
+  }
+
+  int m = iclass - MEM_POOL_NUM_COARSE;
+  int ioct = m >> MEM_POOL_FINE_BITS;
+  size_t nstep = ((size_t) 1 << MEM_POOL_FINE_BITS) + (m & ((1 << MEM_POOL_FINE_BITS) - 1));
+
+  return nstep << (MEM_POOL_FINE_SHIFT - MEM_POOL_FINE_BITS + ioct);
+}
+
+/*
+ * smallest class whose block size >= nbyte
+ */
+
+int
+mem_pool_size_class(size_t nbyte)
+{
+  int iclass = 0;
+
+  while (mem_pool_class_size(iclass) < nbyte && iclass < MEM_POOL_NUM_CLASS-1) {
+    iclass += 1;
+  }
+
+  return iclass;
+}
+
+/*
+ * bucket of block in use, pointers are aligned to at least 256 bytes
+ */
+
+static int
+mem_pool_hash(void *ptr)
+{
+  uintptr_t p = (uintptr_t) ptr >> MEM_POOL_MIN_SHIFT;
+
+  return (int) ((p ^ (p >> 8) ^ (p >> 16)) & (MEM_POOL_HASH_SIZE - 1));
+}
+
+void *
+mem_pool_malloc(mem_pool_t *pool, size_t nbyte)
+{
+  int iclass = mem_pool_size_class(nbyte);
+  size_t siz_blk = mem_pool_class_size(iclass);
+
+  if (siz_blk < nbyte) {
+    fprintf(stderr,"Error: size %zu is too large for pool %s\n", nbyte, pool->name);
+    fflush(stderr);
+    exit(1);
+  }
+
+  mem_pool_blk_t *blk = pool->free_list[iclass];
+
+  if (blk != NULL)
+  {
+    // reuse
+    pool->free_list[iclass] = blk->next;
+  }
+  else
+  {
+    blk = (mem_pool_blk_t *) malloc(sizeof(mem_pool_blk_t));
+    if (blk == NULL) {
+      fprintf(stderr,"Error: can't malloc block info of pool %s\n", pool->name);
+      fflush(stderr);
+      exit(1);
+    }
+
+    blk->ptr = mem_pool_sys_malloc(pool->kind, siz_blk);
+    if (blk->ptr == NULL) {
+      fprintf(stderr,"Error: pool %s can't alloc %zu bytes, reserved=%zu, in use=%zu\n",
+              pool->name, siz_blk, pool->nbyte_reserved, pool->nbyte_in_use);
+      fflush(stderr);
+      exit(1);
+    }
+    blk->iclass = iclass;
+
+    pool->nbyte_reserved += siz_blk;
+    pool->num_of_sys_malloc += 1;
+  }
+
+  int ih = mem_pool_hash(blk->ptr);
+  blk->next = pool->used_hash[ih];
+  pool->used_hash[ih] = blk;
+
+  pool->nbyte_in_use += siz_blk;
+  if (pool->nbyte_in_use > pool->nbyte_high_water) {
+    pool->nbyte_high_water = pool->nbyte_in_use;
+  }
+  pool->num_of_malloc += 1;
+
+  return blk->ptr;
+}
+
+/*
+ * return block to free-list of its class
+ */
+
+int
+mem_pool_free(mem_pool_t *pool, void *ptr)
+{
+  if (ptr == NULL) return 0;
+
+  int ih = mem_pool_hash(ptr);
+  mem_pool_blk_t *prev = NULL;
+  mem_pool_blk_t *blk  = pool->used_hash[ih];
+
+  while (blk != NULL && blk->ptr != ptr) {
+    prev = blk;
+    blk  = blk->next;
+  }
+
+  if (blk == NULL) {
+    fprintf(stderr,"Error: %p is not allocated from pool %s\n", ptr, pool->name);
+    fflush(stderr);
+    return -1;
+  }
+
+  // remove from used bucket
+  if (prev == NULL) {
+    pool->used_hash[ih] = blk->next;
+  } else {
+    prev->next = blk->next;
+  }
+
+  blk->next = pool->free_list[blk->iclass];
+  pool->free_list[blk->iclass] = blk;
+
+  pool->nbyte_in_use -= mem_pool_class_size(blk->iclass);
+
+  return 0;
+}
+
+int
+mem_pool_print(mem_pool_t *pool, int myid)
+{
+  double MB = 1024.0 * 1024.0;
+
+  fprintf(stdout,"-> thread %d pool %s: high water=%.3f MB, reserved=%.3f MB, "
+                 "malloc=%zu, system malloc=%zu\n",
+          myid, pool->name, pool->nbyte_high_water / MB, pool->nbyte_reserved / MB,
+          pool->num_of_malloc, pool->num_of_sys_malloc);
+  fflush(stdout);
+
+  return 0;
+}
+
+/*
+ * free all blocks to system, including blocks still in use
+ */
+
+int
+mem_pool_destroy(mem_pool_t *pool)
+{
+  mem_pool_blk_t *blk;
+
+  for (int n=0; n < MEM_POOL_NUM_CLASS; n++)
+  {
+    while ((blk = pool->free_list[n]) != NULL) {
+      pool->free_list[n] = blk->next;
+      mem_pool_sys_free(pool->kind, blk->ptr);
+      free(blk);
+    }
+  }
+
+  for (int n=0; n < MEM_POOL_HASH_SIZE; n++)
+  {
+    while ((blk = pool->used_hash[n]) != NULL) {
+      pool->used_hash[n] = blk->next;
+      mem_pool_sys_free(pool->kind, blk->ptr);
+      free(blk);
+    }
+  }
+
+  pool->nbyte_reserved = 0;
+  pool->nbyte_in_use   = 0;
+
+  return 0;
+}
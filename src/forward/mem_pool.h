@@ -0,0 +1,78 @@
+#ifndef MEM_POOL_H
+#define MEM_POOL_H
+
+#include <stddef.h>
+
+/*************************************************
+ * size-class memory pool for temporary buffers
+ *  blocks are never returned to system until destroy, freed blocks are
+ *  kept in free-list of its size class and reused by next malloc.
+ *  compile with -DMEM_POOL_HOST_ONLY to use malloc for all kinds
+ *************************************************/
+
+#define MEM_POOL_DEVICE 1
+#define MEM_POOL_HOST   2 // pinned host memory
+
+// size class n < MEM_POOL_NUM_COARSE holds blocks of 2^(n+MEM_POOL_MIN_SHIFT)
+//  bytes, larger classes split each octave from 2^MEM_POOL_FINE_SHIFT into
+//  2^MEM_POOL_FINE_BITS steps, so a block is at most 1/4 larger than request
+#define MEM_POOL_MIN_SHIFT  8
+#define MEM_POOL_FINE_SHIFT 16
+#define MEM_POOL_FINE_BITS  2
+#define MEM_POOL_NUM_COARSE (MEM_POOL_FINE_SHIFT - MEM_POOL_MIN_SHIFT)
+#define MEM_POOL_NUM_CLASS  (MEM_POOL_NUM_COARSE + (32 << MEM_POOL_FINE_BITS))
+
+// blocks in use are hashed by pointer
+#define MEM_POOL_HASH_SIZE  256
+
+#define MEM_POOL_NAME_STRLEN 32
+
+typedef struct mem_pool_blk_t
+{
+  void *ptr;
+  int   iclass;
+  struct mem_pool_blk_t *next;
+} mem_pool_blk_t;
+
+typedef struct
+{
+  int  kind;
+  char name[MEM_POOL_NAME_STRLEN];
+
+  mem_pool_blk_t *free_list[MEM_POOL_NUM_CLASS];
+  mem_pool_blk_t *used_hash[MEM_POOL_HASH_SIZE];
+
+  // statistics
+  size_t nbyte_reserved;   // allocated from system
+  size_t nbyte_in_use;     // held by users
+  size_t nbyte_high_water; // max of nbyte_in_use
+  size_t num_of_malloc;    // calls of mem_pool_malloc
+  size_t num_of_sys_malloc;
+} mem_pool_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+mem_pool_init(mem_pool_t *pool, int kind, const char *name);
+
+int
+mem_pool_size_class(size_t nbyte);
+
+size_t
+mem_pool_class_size(int iclass);
+
+void *
+mem_pool_malloc(mem_pool_t *pool, size_t nbyte);
+
+int
+mem_pool_free(mem_pool_t *pool, void *ptr);
+
+int
+mem_pool_print(mem_pool_t *pool, int myid);
+
+int
+mem_pool_destroy(mem_pool_t *pool);
+
+#endif
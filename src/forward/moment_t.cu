@@ -0,0 +1,280 @@
+/*******************************************************************************
+ * in-situ moment rate, seismic moment and magnitude of faults
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "constants.h"
+#include "moment_t.h"
+#include "cuda_common.h"
+
+/*
+ * keep rows of steps before it_start of the interrupted run
+ */
+
+static FILE *
+moment_reopen(char *ou_file, int it_start)
+{
+  char tmp_file[CONST_MAX_STRLEN];
+  sprintf(tmp_file, "%s.tmp", ou_file);
+
+  FILE *fp_old = fopen(ou_file, "r");
+  FILE *fp     = fopen(tmp_file, "w");
+  if (fp == NULL) return NULL;
+
+  if (fp_old != NULL)
+  {
+    char line[CONST_MAX_STRLEN];
+    while (fgets(line, CONST_MAX_STRLEN, fp_old) != NULL)
+    {
+      int it;
+      if (line[0] == '#' || (sscanf(line, "%d", &it) == 1 && it < it_start)) {
+        fputs(line, fp);
+      }
+    }
+    fclose(fp_old);
+  }
+  fclose(fp);
+
+  if (rename(tmp_file, ou_file) != 0) return NULL;
+
+  return fopen(ou_file, "a");
+}
+
+int
+moment_init(moment_t *moment, int enable, int flush_every, float dt, float t0,
+            gd_t *gd, gd_t gd_d, gd_metric_t metric_d,
+            fault_coef_t *FC, fault_coef_t FC_d,
+            int it_start, int is_restart, int myid, char *output_dir)
+{
+  moment->enable       = (enable == 1 && FC->number_fault > 0) ? 1 : 0;
+  moment->flush_every  = flush_every > 0 ? flush_every : 1;
+  moment->myid         = myid;
+  moment->dt           = dt;
+  moment->t0           = t0;
+  moment->fp           = NULL;
+  moment->number_fault = 0;
+  moment->it_beg       = it_start;
+  moment->num_of_step  = 0;
+
+  if (moment->enable == 0) return 0;
+
+  int number_fault = FC->number_fault;
+  size_t siz_slice_yz = gd->siz_slice_yz;
+  moment->number_fault = number_fault;
+  moment->dA_d  = (float **) malloc(number_fault * sizeof(float *));
+  moment->muA_d = (float **) malloc(number_fault * sizeof(float *));
+
+  dim3 block(8,8);
+  dim3 grid;
+  grid.x = (gd->nj+block.x-1)/block.x;
+  grid.y = (gd->nk+block.y-1)/block.y;
+  for (int id=0; id < number_fault; id++)
+  {
+    moment->dA_d [id] = (float *) cuda_malloc(sizeof(float)*siz_slice_yz);
+    moment->muA_d[id] = (float *) cuda_malloc(sizeof(float)*siz_slice_yz);
+    int i0 = FC->fault_index[id] + 3; //fault plane x index with ghost
+    moment_area_gpu <<<grid, block>>> (gd_d, metric_d, i0,
+                                       FC_d.fault_coef_one[id].mu_f,
+                                       moment->dA_d[id], moment->muA_d[id]);
+  }
+
+  size_t siz_buff = sizeof(double) * moment->flush_every * MOMENT_NUM_VAL;
+  moment->val_d   = (double *) cuda_malloc(siz_buff);
+  moment->val     = (double *) malloc(siz_buff);
+  moment->val_sum = (double *) malloc(siz_buff);
+  CUDACHECK(cudaMemset(moment->val_d, 0, siz_buff));
+
+  if (myid == 0)
+  {
+    char ou_file[CONST_MAX_STRLEN];
+    sprintf(ou_file, "%s/moment_rate.txt", output_dir);
+    if (is_restart == 1) {
+      moment->fp = moment_reopen(ou_file, it_start);
+    } else {
+      moment->fp = fopen(ou_file, "w");
+      if (moment->fp != NULL) {
+        fprintf(moment->fp, "# it t moment_rate(N*m/s) M0(N*m) Mw"
+                            " area_slipping(m^2) area_ruptured(m^2) num_slipping\n");
+      }
+    }
+    if (moment->fp == NULL) {
+      fprintf(stderr,"Error: can't create moment rate file %s\n", ou_file);
+      fflush(stderr);
+      exit(1);
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * values after fault_var_update of step it, at t=t0+(it+1)*dt. buffer is
+ *  flushed when full, so all threads must call it
+ */
+
+int
+moment_keep(moment_t *moment, int it, gd_t *gd, gd_t gd_d, fault_t F_d,
+            MPI_Comm comm)
+{
+  if (moment->enable == 0) return 0;
+
+  if (moment->num_of_step == 0) moment->it_beg = it;
+
+  double *val_d = moment->val_d + moment->num_of_step * MOMENT_NUM_VAL;
+
+  size_t siz_slice = (size_t) gd->nj * gd->nk;
+  dim3 block(MOMENT_BLOCK_SIZE);
+  dim3 grid;
+  grid.x = (siz_slice + block.x - 1) / block.x;
+  for (int id=0; id < moment->number_fault; id++)
+  {
+    moment_cal_gpu <<<grid, block>>> (gd_d, id, F_d, moment->dA_d[id],
+                                      moment->muA_d[id], val_d);
+  }
+
+  moment->num_of_step += 1;
+  if (moment->num_of_step == moment->flush_every) {
+    moment_flush(moment, comm);
+  }
+
+  return 0;
+}
+
+/*
+ * sum buffered steps over threads and write them, called when buffer is
+ *  full, before checkpoint and at end. all threads must call it
+ */
+
+int
+moment_flush(moment_t *moment, MPI_Comm comm)
+{
+  if (moment->enable == 0 || moment->num_of_step == 0) return 0;
+
+  int num_of_val = moment->num_of_step * MOMENT_NUM_VAL;
+  CUDACHECK(cudaMemcpy(moment->val, moment->val_d, sizeof(double)*num_of_val,
+                       cudaMemcpyDeviceToHost));
+  CUDACHECK(cudaMemset(moment->val_d, 0, sizeof(double)*num_of_val));
+
+  MPI_Reduce(moment->val, moment->val_sum, num_of_val, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+  if (moment->myid == 0)
+  {
+    for (int n=0; n < moment->num_of_step; n++)
+    {
+      double *v = moment->val_sum + n * MOMENT_NUM_VAL;
+      int it = moment->it_beg + n;
+      // Hanks and Kanamori, M0 in N*m
+      double Mw = (v[MOMENT_M0] > 0.0) ? 2.0/3.0 * (log10(v[MOMENT_M0]) - 9.1) : 0.0;
+      fprintf(moment->fp, "%d %g %g %g %.4f %g %g %.0f\n",
+              it, moment->t0 + (it+1) * moment->dt, v[MOMENT_RATE], v[MOMENT_M0], Mw,
+              v[MOMENT_AREA_RUP], v[MOMENT_AREA_INIT], v[MOMENT_NUM_RUP]);
+    }
+    fflush(moment->fp);
+  }
+
+  moment->it_beg += moment->num_of_step;
+  moment->num_of_step = 0;
+
+  return 0;
+}
+
+int
+moment_free(moment_t *moment)
+{
+  if (moment->enable == 0) return 0;
+
+  for (int id=0; id < moment->number_fault; id++) {
+    CUDACHECK(cudaFree(moment->dA_d [id]));
+    CUDACHECK(cudaFree(moment->muA_d[id]));
+  }
+  free(moment->dA_d);
+  free(moment->muA_d);
+
+  CUDACHECK(cudaFree(moment->val_d));
+  free(moment->val);
+  free(moment->val_sum);
+  if (moment->fp != NULL) fclose(moment->fp);
+
+  moment->enable = 0;
+
+  return 0;
+}
+
+/*
+ * area element |r_eta x r_zeta| = jac * |grad xi| of unit index step
+ */
+
+__global__ void
+moment_area_gpu(gd_t gd_d, gd_metric_t metric_d, int i0, float *mu_f,
+                float *dA, float *muA)
+{
+  size_t iy = blockIdx.x * blockDim.x + threadIdx.x;
+  size_t iz = blockIdx.y * blockDim.y + threadIdx.y;
+  if (iy < gd_d.nj && iz < gd_d.nk)
+  {
+    int j = iy + gd_d.nj1;
+    int k = iz + gd_d.nk1;
+    size_t iptr   = i0 + j * gd_d.siz_iy + k * gd_d.siz_iz;
+    size_t iptr_f = j + k * gd_d.ny;
+
+    gd_metric_pt_t mt = gd_metric_get(&metric_d, iptr);
+    float area = mt.jac * sqrtf(mt.xi_x*mt.xi_x + mt.xi_y*mt.xi_y + mt.xi_z*mt.xi_z);
+    // minus and plus side
+    float mu = 0.5f * (mu_f[iptr_f] + mu_f[iptr_f + gd_d.siz_slice_yz]);
+
+    dA [iptr_f] = area;
+    muA[iptr_f] = mu * area;
+  }
+}
+
+/*
+ * one row of buffer, one atomic per value and block
+ */
+
+__global__ void
+moment_cal_gpu(gd_t gd_d, int id, fault_t F, float *dA, float *muA, double *val)
+{
+  __shared__ double s_val[MOMENT_NUM_VAL][MOMENT_BLOCK_SIZE];
+
+  int nj = gd_d.nj;
+  int nk = gd_d.nk;
+  size_t n = blockIdx.x * blockDim.x + threadIdx.x;
+  fault_one_t *F_thisone = F.fault_one + id;
+
+  double v[MOMENT_NUM_VAL] = {0.0, 0.0, 0.0, 0.0, 0.0};
+
+  if (n < (size_t) nj * nk)
+  {
+    size_t iptr_f = (n % nj + gd_d.nj1) + (n / nj + gd_d.nk1) * gd_d.ny;
+    v[MOMENT_RATE] = (double) muA[iptr_f] * F_thisone->Vs  [iptr_f];
+    v[MOMENT_M0  ] = (double) muA[iptr_f] * F_thisone->Slip[iptr_f];
+    if (F_thisone->flag_rup[iptr_f] == 1) {
+      v[MOMENT_AREA_RUP] = dA[iptr_f];
+      v[MOMENT_NUM_RUP ] = 1.0;
+    }
+    if (F_thisone->init_t0_flag[iptr_f] == 1) {
+      v[MOMENT_AREA_INIT] = dA[iptr_f];
+    }
+  }
+
+  int tid = threadIdx.x;
+  for (int i=0; i < MOMENT_NUM_VAL; i++) s_val[i][tid] = v[i];
+  __syncthreads();
+
+  for (int s = blockDim.x / 2; s > 0; s >>= 1)
+  {
+    if (tid < s) {
+      for (int i=0; i < MOMENT_NUM_VAL; i++) s_val[i][tid] += s_val[i][tid + s];
+    }
+    __syncthreads();
+  }
+
+  if (tid == 0)
+  {
+    for (int i=0; i < MOMENT_NUM_VAL; i++) atomicAdd(val + i, s_val[i][0]);
+  }
+}
@@ -0,0 +1,76 @@
+#ifndef MOMENT_T_H
+#define MOMENT_T_H
+
+#include <stdio.h>
+#include <mpi.h>
+
+#include "gd_t.h"
+#include "fault_info.h"
+
+/*************************************************
+ * in-situ moment rate of all faults at each step
+ *  moment rate sum(mu*Vs*dA), moment M0 sum(mu*Slip*dA), area of
+ *  points slipping now (flag_rup) and of points ruptured (init_t0_flag).
+ *  dA = jac*|grad xi| is the area element of fault plane, mu the mean
+ *  of two sides. values of each step are reduced on device into a
+ *  buffer, which is summed over threads by MPI_Reduce when full and
+ *  written with Mw by thread 0
+ *************************************************/
+
+#define MOMENT_RATE      0
+#define MOMENT_M0        1
+#define MOMENT_AREA_RUP  2
+#define MOMENT_AREA_INIT 3
+#define MOMENT_NUM_RUP   4
+#define MOMENT_NUM_VAL   5
+
+#define MOMENT_BLOCK_SIZE 256
+
+typedef struct
+{
+  int enable;
+  int flush_every; // steps in buffer
+  int myid;
+  float dt;
+  float t0;
+  FILE *fp; // time series, only thread 0
+
+  int number_fault;
+  float **dA_d;  // area element of each fault
+  float **muA_d; // mu * dA
+
+  int it_beg;      // step of first row in buffer
+  int num_of_step; // rows in buffer
+  double *val_d;   // [flush_every][MOMENT_NUM_VAL]
+  double *val;
+  double *val_sum;
+} moment_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+moment_init(moment_t *moment, int enable, int flush_every, float dt, float t0,
+            gd_t *gd, gd_t gd_d, gd_metric_t metric_d,
+            fault_coef_t *FC, fault_coef_t FC_d,
+            int it_start, int is_restart, int myid, char *output_dir);
+
+int
+moment_keep(moment_t *moment, int it, gd_t *gd, gd_t gd_d, fault_t F_d,
+            MPI_Comm comm);
+
+int
+moment_flush(moment_t *moment, MPI_Comm comm);
+
+int
+moment_free(moment_t *moment);
+
+__global__ void
+moment_area_gpu(gd_t gd_d, gd_metric_t metric_d, int i0, float *mu_f,
+                float *dA, float *muA);
+
+__global__ void
+moment_cal_gpu(gd_t gd_d, int id, fault_t F, float *dA, float *muA, double *val);
+
+#endif
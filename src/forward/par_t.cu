@@ -2,7 +2,7 @@
  * 
  */
 
-//#include <math.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -344,10 +344,52 @@ par_read_from_str(const char *str, par_t *par)
   //
   //-- grid
   //
+  par->grid_stretch_itype = CONST_STRETCH_NONE;
+  par->grid_stretch_uniform_cells = 0;
+  par->grid_stretch_ratio = 1.05;
+  par->grid_stretch_width = 20.0;
+  par->grid_stretch_max_factor = 4.0;
   if (item = cJSON_GetObjectItem(root, "grid_generation_method")) {
     // fault import
     if (subitem = cJSON_GetObjectItem(item, "fault_plane")) {
       par->grid_generation_itype = FAULT_PLANE;
+      // stretched x spacing away from faults
+      if (thirditem = cJSON_GetObjectItem(subitem, "x_stretch")) {
+        cJSON *stretchitem;
+        if (stretchitem = cJSON_GetObjectItem(thirditem, "type")) {
+          if (strcmp(stretchitem->valuestring, "geometric") == 0) {
+            par->grid_stretch_itype = CONST_STRETCH_GEOMETRIC;
+          } else if (strcmp(stretchitem->valuestring, "tanh") == 0) {
+            par->grid_stretch_itype = CONST_STRETCH_TANH;
+          } else if (strcmp(stretchitem->valuestring, "none") != 0) {
+            fprintf(stderr,"Error: unknown x_stretch type %s\n", stretchitem->valuestring);
+            fflush(stderr);
+            exit(1);
+          }
+        }
+        if (stretchitem = cJSON_GetObjectItem(thirditem, "uniform_cells")) {
+          par->grid_stretch_uniform_cells = stretchitem->valueint;
+        }
+        if (stretchitem = cJSON_GetObjectItem(thirditem, "ratio")) {
+          par->grid_stretch_ratio = stretchitem->valuedouble;
+        }
+        if (stretchitem = cJSON_GetObjectItem(thirditem, "transition_cells")) {
+          par->grid_stretch_width = stretchitem->valuedouble;
+        }
+        if (stretchitem = cJSON_GetObjectItem(thirditem, "max_factor")) {
+          par->grid_stretch_max_factor = stretchitem->valuedouble;
+        }
+        if (   par->grid_stretch_uniform_cells < 0
+            || par->grid_stretch_max_factor < 1.0
+            || (par->grid_stretch_itype == CONST_STRETCH_GEOMETRIC && par->grid_stretch_ratio <= 1.0)
+            || (par->grid_stretch_itype == CONST_STRETCH_TANH && par->grid_stretch_width <= 0.0))
+        {
+          fprintf(stderr,"Error: x_stretch needs uniform_cells >= 0, max_factor >= 1,"
+                         " ratio > 1 for geometric and transition_cells > 0 for tanh\n");
+          fflush(stderr);
+          exit(1);
+        }
+      }
       if (thirditem = cJSON_GetObjectItem(subitem, "fault_geometry_dir")) {
          sprintf(par->fault_coord_dir, "%s", thirditem->valuestring);
       }
@@ -398,6 +440,18 @@ par_read_from_str(const char *str, par_t *par)
      par->is_export_metric = item->valueint;
   }
 
+  // keep only coords on device and derive metric in kernels
+  par->metric_recompute = 0;
+  if (item = cJSON_GetObjectItem(root, "metric_recompute")) {
+     par->metric_recompute = item->valueint;
+  }
+  if (par->metric_recompute == 1 && par->metric_method_itype == PAR_METRIC_IMPORT) {
+    fprintf(stderr,"Error: metric_recompute derives metric from coords, "
+                   "can't be used with imported metric\n");
+    fflush(stderr);
+    exit(1);
+  }
+
   //
   //-- medium
   //
@@ -682,6 +736,17 @@ par_read_from_str(const char *str, par_t *par)
       sprintf(par->media_export_dir,"%s",item->valuestring);
   }
 
+  par->media_max_material = CONST_MAX_MATERIAL;
+  if (item = cJSON_GetObjectItem(root, "media_max_material")) {
+      par->media_max_material = item->valueint;
+  }
+  if (par->media_max_material > CONST_MAX_MATERIAL) {
+    fprintf(stderr,"Error: media_max_material=%d is larger than %d\n",
+            par->media_max_material, CONST_MAX_MATERIAL);
+    fflush(stderr);
+    exit(1);
+  }
+
   //
   //-- visco
   //
@@ -716,6 +781,129 @@ par_read_from_str(const char *str, par_t *par)
   if (item = cJSON_GetObjectItem(root, "fault_station_file")) {
     sprintf(par->fault_station_file, "%s", item->valuestring);
   }
+  // traces of stations and lines are lowpass filtered and kept every
+  //  number of steps, 1 keeps all steps
+  par->in_station_decimation = 1;
+  if (item = cJSON_GetObjectItem(root, "in_station_decimation")) {
+    par->in_station_decimation = item->valueint;
+  }
+  par->fault_station_decimation = 1;
+  if (item = cJSON_GetObjectItem(root, "fault_station_decimation")) {
+    par->fault_station_decimation = item->valueint;
+  }
+  par->receiver_line_decimation = 1;
+  if (item = cJSON_GetObjectItem(root, "receiver_line_decimation")) {
+    par->receiver_line_decimation = item->valueint;
+  }
+  // kept samples are written to trace store of each thread every number
+  //  of samples, 0 keeps all in memory until end
+  par->seismo_stream_every = 0;
+  if (item = cJSON_GetObjectItem(root, "seismo_stream_every")) {
+    par->seismo_stream_every = item->valueint;
+  }
+  // 1 for all traces in one seismo_archive.nc, 0 for sac files
+  par->seismo_output_archive = 0;
+  if (item = cJSON_GetObjectItem(root, "seismo_output_archive")) {
+    par->seismo_output_archive = item->valueint;
+  }
+  // running spectra of stations, none if not set
+  par->in_station_spectrum_num_of_freq = 0;
+  par->in_station_spectrum_freq = NULL;
+  if (item = cJSON_GetObjectItem(root, "in_station_spectrum_freq"))
+  {
+    par->in_station_spectrum_num_of_freq = cJSON_GetArraySize(item);
+    par->in_station_spectrum_freq = (float *)malloc(
+                      (par->in_station_spectrum_num_of_freq+1)*sizeof(float));
+    for (int i=0; i < par->in_station_spectrum_num_of_freq; i++) {
+      par->in_station_spectrum_freq[i] = cJSON_GetArrayItem(item, i)->valuedouble;
+    }
+  }
+  // shared fault stations are summed over threads each number of steps
+  par->fault_station_reduce_every = 100;
+  if (item = cJSON_GetObjectItem(root, "fault_station_reduce_every")) {
+    par->fault_station_reduce_every = item->valueint;
+  }
+  //-- sparse fault plane output
+  par->fault_output_sparse = 0;
+  if (item = cJSON_GetObjectItem(root, "fault_output_sparse")) {
+    par->fault_output_sparse = item->valueint;
+  }
+  par->fault_output_sparse_vs_threshold = 1.0e-3;
+  if (item = cJSON_GetObjectItem(root, "fault_output_sparse_vs_threshold")) {
+    par->fault_output_sparse_vs_threshold = item->valuedouble;
+  }
+  par->fault_output_sparse_tolerance = 1.0e-3;
+  if (item = cJSON_GetObjectItem(root, "fault_output_sparse_tolerance")) {
+    par->fault_output_sparse_tolerance = item->valuedouble;
+  }
+  par->fault_output_dense = 1;
+  if (item = cJSON_GetObjectItem(root, "fault_output_dense")) {
+    par->fault_output_dense = item->valueint;
+  }
+  //-- moment rate of faults
+  par->moment_rate_output = 0;
+  if (item = cJSON_GetObjectItem(root, "moment_rate_output")) {
+    par->moment_rate_output = item->valueint;
+  }
+  par->moment_rate_flush_every = 100;
+  if (item = cJSON_GetObjectItem(root, "moment_rate_flush_every")) {
+    par->moment_rate_flush_every = item->valueint;
+  }
+  //-- kinematic source of subfaults
+  par->kinematic_source_output = 0;
+  if (item = cJSON_GetObjectItem(root, "kinematic_source_output")) {
+    par->kinematic_source_output = item->valueint;
+  }
+  par->kinematic_source_subfault_points[0] = 10;
+  par->kinematic_source_subfault_points[1] = 10;
+  if (item = cJSON_GetObjectItem(root, "kinematic_source_subfault_points")) {
+    for (int i=0; i < 2; i++) {
+      par->kinematic_source_subfault_points[i] = cJSON_GetArrayItem(item, i)->valueint;
+      if (par->kinematic_source_subfault_points[i] < 1) {
+        fprintf(stderr,"Error: kinematic_source_subfault_points should be >= 1\n");
+        fflush(stderr);
+        exit(1);
+      }
+    }
+  }
+  par->kinematic_source_sample_every = 5;
+  if (item = cJSON_GetObjectItem(root, "kinematic_source_sample_every")) {
+    par->kinematic_source_sample_every = item->valueint;
+  }
+  par->kinematic_source_time_length = 0.0;
+  if (item = cJSON_GetObjectItem(root, "kinematic_source_time_length")) {
+    par->kinematic_source_time_length = item->valuedouble;
+  }
+  //-- intensity measures of free surface
+  par->im_output = 0;
+  if (item = cJSON_GetObjectItem(root, "im_output")) {
+    par->im_output = item->valueint;
+  }
+  if (item = cJSON_GetObjectItem(root, "im_psa_period"))
+  {
+    par->im_psa_num_of_period = cJSON_GetArraySize(item);
+    par->im_psa_period = (float *)malloc((par->im_psa_num_of_period+1)*sizeof(float));
+    for (int i=0; i < par->im_psa_num_of_period; i++) {
+      par->im_psa_period[i] = cJSON_GetArrayItem(item, i)->valuedouble;
+    }
+  }
+  else
+  {
+    // 20 periods from 0.05 to 10 s, even in log
+    par->im_psa_num_of_period = 20;
+    par->im_psa_period = (float *)malloc((par->im_psa_num_of_period+1)*sizeof(float));
+    for (int i=0; i < par->im_psa_num_of_period; i++) {
+      par->im_psa_period[i] = 0.05 * pow(200.0, i / 19.0);
+    }
+  }
+  par->im_psa_damping = 0.05;
+  if (item = cJSON_GetObjectItem(root, "im_psa_damping")) {
+    par->im_psa_damping = item->valuedouble;
+  }
+  par->im_husid_samples = 64;
+  if (item = cJSON_GetObjectItem(root, "im_husid_samples")) {
+    par->im_husid_samples = item->valueint;
+  }
 
   //-- receiver line
   if (item = cJSON_GetObjectItem(root, "receiver_line"))
@@ -802,6 +990,10 @@ par_read_from_str(const char *str, par_t *par)
   }
 
   // snapshot
+  par->snapshot_compress_threads = 4;
+  if (item = cJSON_GetObjectItem(root, "snapshot_compress_threads")) {
+    par->snapshot_compress_threads = item->valueint;
+  }
   if (item = cJSON_GetObjectItem(root, "snapshot"))
   {
     par->number_of_snapshot = cJSON_GetArraySize(item);
@@ -819,6 +1011,8 @@ par_read_from_str(const char *str, par_t *par)
     par->snapshot_save_velocity = (int *)malloc(par->number_of_snapshot*sizeof(int));
     par->snapshot_save_stress  = (int *)malloc(par->number_of_snapshot*sizeof(int));
     par->snapshot_save_strain = (int *)malloc(par->number_of_snapshot*sizeof(int));
+    par->snapshot_compress_error_abs = (float *)malloc(par->number_of_snapshot*sizeof(float));
+    par->snapshot_compress_error_rel = (float *)malloc(par->number_of_snapshot*sizeof(float));
     // name of snapshot
     par->snapshot_name = (char **)malloc(par->number_of_snapshot*sizeof(char*));
     for (int n=0; n<par->number_of_snapshot; n++) {
@@ -872,16 +1066,110 @@ par_read_from_str(const char *str, par_t *par)
       if (subitem = cJSON_GetObjectItem(snapitem, "save_strain")) {
         par->snapshot_save_strain[i] = subitem->valueint;
       }
+      par->snapshot_compress_error_abs[i] = 0.0;
+      if (subitem = cJSON_GetObjectItem(snapitem, "compress_error_abs")) {
+        par->snapshot_compress_error_abs[i] = subitem->valuedouble;
+      }
+      par->snapshot_compress_error_rel[i] = 0.0;
+      if (subitem = cJSON_GetObjectItem(snapitem, "compress_error_rel")) {
+        par->snapshot_compress_error_rel[i] = subitem->valuedouble;
+      }
     }
   }
 
   //-- misc
+  par->qc_check_nan_number_of_step = 0;
   if (item = cJSON_GetObjectItem(root, "check_nan_every_number_of_steps")) {
       par->qc_check_nan_number_of_step = item->valueint;
   }
+  par->health_max_velocity = 0.0;
+  if (item = cJSON_GetObjectItem(root, "health_max_velocity")) {
+      par->health_max_velocity = item->valuedouble;
+  }
+  par->health_check_on_host = 0;
+  if (item = cJSON_GetObjectItem(root, "health_check_on_host")) {
+      par->health_check_on_host = item->valueint;
+  }
   if (item = cJSON_GetObjectItem(root, "output_all")) {
       par->output_all = item->valueint;
   }
+  par->release_host_mirror = 1;
+  if (item = cJSON_GetObjectItem(root, "release_host_mirror")) {
+      par->release_host_mirror = item->valueint;
+  }
+  par->profile_timing = 0;
+  if (item = cJSON_GetObjectItem(root, "profile_timing")) {
+      par->profile_timing = item->valueint;
+  }
+  par->trace_step_start = 0;
+  if (item = cJSON_GetObjectItem(root, "trace_step_start")) {
+      par->trace_step_start = item->valueint;
+  }
+  par->trace_step_count = 0;
+  if (item = cJSON_GetObjectItem(root, "trace_step_count")) {
+      par->trace_step_count = item->valueint;
+  }
+  par->trace_buffer_size = 1048576;
+  if (item = cJSON_GetObjectItem(root, "trace_buffer_size")) {
+      par->trace_buffer_size = item->valueint;
+  }
+  par->rk_fuse_update = 1;
+  if (item = cJSON_GetObjectItem(root, "rk_fuse_update")) {
+      par->rk_fuse_update = item->valueint;
+  }
+  par->setup_num_of_threads = 3;
+  if (item = cJSON_GetObjectItem(root, "setup_num_of_threads")) {
+      par->setup_num_of_threads = item->valueint;
+  }
+
+  //-- checkpoint
+  par->checkpoint_every_number_of_steps = 0;
+  if (item = cJSON_GetObjectItem(root, "checkpoint_every_number_of_steps")) {
+      par->checkpoint_every_number_of_steps = item->valueint;
+  }
+  par->checkpoint_wall_time = 0.0;
+  if (item = cJSON_GetObjectItem(root, "checkpoint_wall_time")) {
+      par->checkpoint_wall_time = item->valuedouble;
+  }
+  par->checkpoint_on_signal = 0;
+  if (item = cJSON_GetObjectItem(root, "checkpoint_on_signal")) {
+      par->checkpoint_on_signal = item->valueint;
+  }
+  sprintf(par->checkpoint_dir,"%s",par->output_dir);
+  if (item = cJSON_GetObjectItem(root, "checkpoint_dir")) {
+      sprintf(par->checkpoint_dir,"%s",item->valuestring);
+  }
+  par->checkpoint_restart = 0;
+  if (item = cJSON_GetObjectItem(root, "checkpoint_restart")) {
+      par->checkpoint_restart = item->valueint;
+  }
+
+  //-- ensemble of init stress and friction, run one by one on same set-up
+  par->number_of_ensemble_member = 0;
+  if (item = cJSON_GetObjectItem(root, "ensemble"))
+  {
+    par->number_of_ensemble_member = cJSON_GetArraySize(item);
+    par->ensemble_init_stress_dir = (char **)malloc(par->number_of_ensemble_member*sizeof(char*));
+    par->ensemble_output_dir      = (char **)malloc(par->number_of_ensemble_member*sizeof(char*));
+    for (int n=0; n<par->number_of_ensemble_member; n++) {
+      par->ensemble_init_stress_dir[n] = (char *)malloc(PAR_MAX_STRLEN*sizeof(char));
+      par->ensemble_output_dir     [n] = (char *)malloc(PAR_MAX_STRLEN*sizeof(char));
+    }
+
+    for (int i=0; i < par->number_of_ensemble_member; i++)
+    {
+      lineitem = cJSON_GetArrayItem(item, i);
+
+      sprintf(par->ensemble_init_stress_dir[i],"%s",par->init_stress_dir);
+      if (subitem = cJSON_GetObjectItem(lineitem, "fault_init_stress_dir")) {
+        sprintf(par->ensemble_init_stress_dir[i],"%s",subitem->valuestring);
+      }
+      sprintf(par->ensemble_output_dir[i],"%s/member%d",par->output_dir,i);
+      if (subitem = cJSON_GetObjectItem(lineitem, "output_dir")) {
+        sprintf(par->ensemble_output_dir[i],"%s",subitem->valuestring);
+      }
+    }
+  }
 
   //if (item = cJSON_GetObjectItem(root, "grid_name")) {
   //    sprintf(par->grid_name,"%s",item->valuestring);
@@ -901,6 +1189,15 @@ par_read_from_str(const char *str, par_t *par)
     MPI_Abort(MPI_COMM_WORLD,1);
   }
 
+  // dump of one member would be overwritten by next one
+  if (par->number_of_ensemble_member > 0 &&
+      (par->checkpoint_every_number_of_steps > 0 || par->checkpoint_wall_time > 0.0 ||
+       par->checkpoint_on_signal == 1 || par->checkpoint_restart == 1))
+  {
+    fprintf(stderr, "ERROR: checkpoint is not supported in ensemble mode\n");
+    MPI_Abort(MPI_COMM_WORLD,1);
+  }
+
   return ierr;
 }
 
@@ -1025,14 +1322,21 @@ par_print(par_t *par)
   fprintf(stdout, " number_of_total_grid_points_x = %-10d\n", par->number_of_total_grid_points_x);
   fprintf(stdout, " number_of_total_grid_points_y = %-10d\n", par->number_of_total_grid_points_y);
   fprintf(stdout, " number_of_total_grid_points_z = %-10d\n", par->number_of_total_grid_points_z);
+  if (par->grid_stretch_itype != CONST_STRETCH_NONE) {
+    fprintf(stdout, " x_stretch type = %d, uniform_cells = %d, ratio = %f, transition_cells = %f, max_factor = %f\n",
+            par->grid_stretch_itype, par->grid_stretch_uniform_cells, par->grid_stretch_ratio,
+            par->grid_stretch_width, par->grid_stretch_max_factor);
+  }
 
   fprintf(stdout, " metric_method_itype = %d\n", par->metric_method_itype);
+  fprintf(stdout, " metric_recompute = %d\n", par->metric_recompute);
 
   fprintf(stdout, "-------------------------------------------------------\n");
   fprintf(stdout, "--> media info.\n");
   fprintf(stdout, "-------------------------------------------------------\n");
   fprintf(stdout, " media_type = %s\n", par->media_type);
   fprintf(stdout, " media_export_dir = %s\n", par->media_export_dir);
+  fprintf(stdout, " media_max_material = %d\n", par->media_max_material);
 
   if (par->media_input_itype == PAR_MEDIA_CODE) {
     fprintf(stdout, "\n --> uniform media by code\n");
@@ -1066,6 +1370,46 @@ par_print(par_t *par)
 
   fprintf(stdout, "--> station list file:\n");
   fprintf(stdout, " in_station_file = %s\n", par->in_station_file);
+  fprintf(stdout, " fault_station_file = %s\n", par->fault_station_file);
+  fprintf(stdout, " fault_station_reduce_every = %d\n", par->fault_station_reduce_every);
+  fprintf(stdout, " in_station_decimation = %d\n", par->in_station_decimation);
+  fprintf(stdout, " fault_station_decimation = %d\n", par->fault_station_decimation);
+  fprintf(stdout, " receiver_line_decimation = %d\n", par->receiver_line_decimation);
+  fprintf(stdout, " seismo_stream_every = %d\n", par->seismo_stream_every);
+  fprintf(stdout, " seismo_output_archive = %d\n", par->seismo_output_archive);
+  if (par->in_station_spectrum_num_of_freq > 0) {
+    fprintf(stdout, " in_station_spectrum_freq =");
+    for (int i=0; i < par->in_station_spectrum_num_of_freq; i++) {
+      fprintf(stdout, " %g", par->in_station_spectrum_freq[i]);
+    }
+    fprintf(stdout, "\n");
+  }
+  fprintf(stdout, "--> fault plane output:\n");
+  fprintf(stdout, " fault_output_sparse = %d\n", par->fault_output_sparse);
+  if (par->fault_output_sparse == 1) {
+    fprintf(stdout, " fault_output_sparse_vs_threshold = %g\n", par->fault_output_sparse_vs_threshold);
+    fprintf(stdout, " fault_output_sparse_tolerance = %g\n", par->fault_output_sparse_tolerance);
+  }
+  fprintf(stdout, " fault_output_dense = %d\n", par->fault_output_dense);
+  fprintf(stdout, " moment_rate_output = %d\n", par->moment_rate_output);
+  fprintf(stdout, " moment_rate_flush_every = %d\n", par->moment_rate_flush_every);
+  fprintf(stdout, " kinematic_source_output = %d\n", par->kinematic_source_output);
+  if (par->kinematic_source_output == 1) {
+    fprintf(stdout, " kinematic_source_subfault_points = %d %d\n",
+            par->kinematic_source_subfault_points[0], par->kinematic_source_subfault_points[1]);
+    fprintf(stdout, " kinematic_source_sample_every = %d\n", par->kinematic_source_sample_every);
+    fprintf(stdout, " kinematic_source_time_length = %g\n", par->kinematic_source_time_length);
+  }
+  fprintf(stdout, " im_output = %d\n", par->im_output);
+  if (par->im_output == 1) {
+    fprintf(stdout, " im_psa_period =");
+    for (int i=0; i < par->im_psa_num_of_period; i++) {
+      fprintf(stdout, " %g", par->im_psa_period[i]);
+    }
+    fprintf(stdout, "\n");
+    fprintf(stdout, " im_psa_damping = %g\n", par->im_psa_damping);
+    fprintf(stdout, " im_husid_samples = %d\n", par->im_husid_samples);
+  }
 
   fprintf(stdout, "--> recivers lines:\n");
   fprintf(stdout, "number_of_receiver_line=%d\n", par->number_of_receiver_line);
@@ -1126,12 +1470,42 @@ par_print(par_t *par)
              par->snapshot_index_incre[n*3+2],
              par->snapshot_time_start[n],
              par->snapshot_time_incre[n]);
+         if (par->snapshot_compress_error_abs[n] > 0.0 ||
+             par->snapshot_compress_error_rel[n] > 0.0) {
+           fprintf(stdout, "       compress_error_abs=%g, compress_error_rel=%g\n",
+               par->snapshot_compress_error_abs[n],
+               par->snapshot_compress_error_rel[n]);
+         }
       }
+      fprintf(stdout, "snapshot_compress_threads=%d\n", par->snapshot_compress_threads);
   }
 
   fprintf(stdout, "--> qc parameters:\n");
   fprintf(stdout, "check_nan_every_number_of_steps=%d\n", par->qc_check_nan_number_of_step);
+  fprintf(stdout, "health_max_velocity=%g\n", par->health_max_velocity);
+  fprintf(stdout, "health_check_on_host=%d\n", par->health_check_on_host);
   fprintf(stdout, "output_all=%d\n", par->output_all);
+  fprintf(stdout, "release_host_mirror=%d\n", par->release_host_mirror);
+  fprintf(stdout, "profile_timing=%d\n", par->profile_timing);
+  fprintf(stdout, "trace_step_start=%d\n", par->trace_step_start);
+  fprintf(stdout, "trace_step_count=%d\n", par->trace_step_count);
+  fprintf(stdout, "trace_buffer_size=%d\n", par->trace_buffer_size);
+  fprintf(stdout, "rk_fuse_update=%d\n", par->rk_fuse_update);
+  fprintf(stdout, "setup_num_of_threads=%d\n", par->setup_num_of_threads);
+
+  fprintf(stdout, "--> checkpoint parameters:\n");
+  fprintf(stdout, "checkpoint_every_number_of_steps=%d\n", par->checkpoint_every_number_of_steps);
+  fprintf(stdout, "checkpoint_wall_time=%g\n", par->checkpoint_wall_time);
+  fprintf(stdout, "checkpoint_on_signal=%d\n", par->checkpoint_on_signal);
+  fprintf(stdout, "checkpoint_dir=%s\n", par->checkpoint_dir);
+  fprintf(stdout, "checkpoint_restart=%d\n", par->checkpoint_restart);
+
+  fprintf(stdout, "--> ensemble members:\n");
+  fprintf(stdout, "number_of_ensemble_member=%d\n", par->number_of_ensemble_member);
+  for (int n=0; n<par->number_of_ensemble_member; n++) {
+    fprintf(stdout, "%6d init_stress_dir=%s output_dir=%s\n", n,
+            par->ensemble_init_stress_dir[n], par->ensemble_output_dir[n]);
+  }
 
   return ierr;
 }
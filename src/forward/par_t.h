@@ -101,9 +101,17 @@ typedef struct{
   char init_stress_dir[PAR_MAX_STRLEN];
   float dh;
 
+  // stretched x spacing of fault plane grid
+  int   grid_stretch_itype;
+  int   grid_stretch_uniform_cells;
+  float grid_stretch_ratio;
+  float grid_stretch_width;
+  float grid_stretch_max_factor;
+
   // metric
   int metric_method_itype;
   int is_export_metric;
+  int metric_recompute;
   char metric_export_dir[PAR_MAX_STRLEN];
   char metric_import_dir[PAR_MAX_STRLEN];
 
@@ -121,6 +129,9 @@ typedef struct{
   char media_import_dir[PAR_MAX_STRLEN];
   char media_input_file[PAR_MAX_STRLEN];
 
+  // store piecewise-constant media as material id, 0 to disable
+  int media_max_material;
+
   // medium in bin file
   int bin_size[CONST_NDIM];
   int bin_order[CONST_NDIM];
@@ -189,6 +200,45 @@ typedef struct{
   // receiver
   char in_station_file[PAR_MAX_STRLEN];
   char fault_station_file[PAR_MAX_STRLEN];
+  // steps between sums of fault stations over threads
+  int  fault_station_reduce_every;
+  // steps between kept samples of traces, anti-alias filtered
+  int  in_station_decimation;
+  int  fault_station_decimation;
+  int  receiver_line_decimation;
+  // samples of station traces kept in memory before written to disk,
+  //  0 keeps full traces
+  int  seismo_stream_every;
+  // 1 for one netcdf archive of all traces, 0 for sac files
+  int  seismo_output_archive;
+  // Fourier amplitude of station traces at frequencies, running over
+  //  all steps, to recv_spectra.nc
+  int    in_station_spectrum_num_of_freq;
+  float *in_station_spectrum_freq;
+  // fault plane: 1 for sparse frames of points with Vs > threshold or
+  //  values changed more than relative tolerance, 0 for dense nc frames
+  int   fault_output_sparse;
+  float fault_output_sparse_vs_threshold;
+  float fault_output_sparse_tolerance;
+  // 0 to skip time frames of fault plane, e.g. with kinematic source
+  int   fault_output_dense;
+  // moment rate, M0, Mw and rupture area of faults to moment_rate.txt,
+  //  written each number of steps
+  int moment_rate_output;
+  int moment_rate_flush_every;
+  // kinematic source of subfaults of nj x nk points of fault_grid,
+  //  stf sampled each number of steps, to kinematic_source.src
+  int   kinematic_source_output;
+  int   kinematic_source_subfault_points[2];
+  int   kinematic_source_sample_every;
+  float kinematic_source_time_length; // of stf, <= 0 to end of run
+  // PSA of periods, CAV, Arias intensity and D5-95 of free surface,
+  //  added to PG_V_A_D file
+  int    im_output;
+  int    im_psa_num_of_period;
+  float *im_psa_period;
+  float  im_psa_damping;
+  int    im_husid_samples;  // samples of Husid curve kept for duration
   // line
   int number_of_receiver_line;
   int *receiver_line_index_start;
@@ -215,10 +265,48 @@ typedef struct{
   int *snapshot_save_velocity;
   int *snapshot_save_stress;
   int *snapshot_save_strain;
+  // error bound of compressed frames, abs or rel to value range of
+  //  frame over all threads of the snapshot, 0 for plain float
+  float *snapshot_compress_error_abs;
+  float *snapshot_compress_error_rel;
+  // host threads of compression
+  int snapshot_compress_threads;
 
   // misc
   int qc_check_nan_number_of_step;
+  // health monitor: stop if max |V| larger, <= 0 to disable
+  float health_max_velocity;
+  // 1: check copied wavefield on host instead of device reduction
+  int health_check_on_host;
   int output_all;
+  // release host copy of media, metric, coord and fault coef after upload
+  int release_host_mirror;
+  // timing of set-up and time loop scopes, written to prof_timing.json
+  int profile_timing;
+  // event trace of steps [trace_step_start, trace_step_start+trace_step_count)
+  int trace_step_start;
+  int trace_step_count;
+  int trace_buffer_size;
+  // 1: update all arrays of a rk stage by one fused launch; 0: one
+  //  launch per array. same results, ablexp is applied after the stages
+  int rk_fuse_update;
+  // threads running set-up tasks (metric, media, exports) side by side,
+  //  0 to run them one by one
+  int setup_num_of_threads;
+
+  // checkpoint each number of steps, and dump then stop at wall time
+  //  (seconds since start) or SIGUSR1/SIGTERM
+  int   checkpoint_every_number_of_steps;
+  float checkpoint_wall_time;
+  int   checkpoint_on_signal;
+  char  checkpoint_dir[PAR_MAX_STRLEN];
+  // 1: skip set-up and continue time loop from checkpoint_dir
+  int   checkpoint_restart;
+
+  // members differ in init stress and friction, 0 for single run
+  int    number_of_ensemble_member;
+  char **ensemble_init_stress_dir;
+  char **ensemble_output_dir;
 } par_t;
 
 int
@@ -0,0 +1,438 @@
+/*******************************************************************************
+ * pre-flight memory and cost planner
+ *  estimate per-thread host/device memory, halo size and flops from par only,
+ *  without allocating the large arrays and without any gpu
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "fdlib_mem.h"
+#include "io_funcs.h"
+#include "plan_mem.h"
+
+/*
+ * number of stations in station file, 0 if not exist
+ */
+
+int
+plan_mem_station_number(char *in_filenm)
+{
+  FILE *fp;
+  char line[500];
+  int num_recv = 0;
+
+  if (!(fp = fopen(in_filenm, "rt"))) {
+    return 0;
+  }
+
+  io_get_nextline(fp, line, 500);
+  sscanf(line, "%d", &num_recv);
+  fclose(fp);
+
+  return num_recv;
+}
+
+int
+plan_mem_add(plan_mem_t *plan, char *name, size_t nbyte_host, size_t nbyte_dev)
+{
+  int n = plan->num_of_item;
+
+  if (n >= PLAN_MEM_MAX_ITEM) {
+    fprintf(stderr,"Error: too many items in plan_mem, increase PLAN_MEM_MAX_ITEM\n");
+    fflush(stderr);
+    exit(1);
+  }
+
+  strncpy(plan->item_name[n], name, PLAN_MEM_NAME_STRLEN-1);
+  plan->item_name[n][PLAN_MEM_NAME_STRLEN-1] = '\0';
+  plan->item_host[n] = nbyte_host;
+  plan->item_dev [n] = nbyte_dev;
+
+  plan->host_total += nbyte_host;
+  plan->dev_total  += nbyte_dev;
+
+  plan->num_of_item += 1;
+
+  return 0;
+}
+
+/*
+ * follow the sizes used by *_init, bdry_*_set, macdrp_*mesg_init and
+ *  init_*_device of one thread
+ */
+
+int
+plan_mem_one(plan_mem_t *plan,
+             par_t *par,
+             fd_t *fd,
+             mympi_t *mympi,
+             int num_recv,
+             int num_fault_recv,
+             int nt_total)
+{
+  gd_t gd;
+
+  memset(&gd, 0, sizeof(gd_t));
+  gd_info_set(&gd, mympi,
+              par->number_of_total_grid_points_x,
+              par->number_of_total_grid_points_y,
+              par->number_of_total_grid_points_z,
+              par->bdry_has_cfspml,
+              par->abs_num_of_layers,
+              fd->fdx_nghosts,
+              fd->fdy_nghosts,
+              fd->fdz_nghosts);
+
+  int ni = gd.ni;
+  int nj = gd.nj;
+  int nk = gd.nk;
+  int nx = gd.nx;
+  int ny = gd.ny;
+  int nz = gd.nz;
+  size_t siz_iz   = gd.siz_iz;
+  size_t siz_icmp = gd.siz_icmp;
+
+  fdlib_mem_free_2l_char(gd.index_name, CONST_NDIM, "plan_mem_one");
+
+  memset(plan, 0, sizeof(plan_mem_t));
+  plan->myid = mympi->myid;
+  for (int i=0; i<CONST_NDIM; i++) plan->topoid[i] = mympi->topoid[i];
+  for (int i=0; i<CONST_NDIM_2; i++) plan->neighid[i] = mympi->neighid[i];
+  plan->ni = ni; plan->nj = nj; plan->nk = nk;
+  plan->nx = nx; plan->ny = ny; plan->nz = nz;
+
+  int nlevel = fd->num_rk_stages;
+  int number_fault = par->number_fault;
+  int wav_ncmp = 9;
+  int fault_ncmp = 11;
+  int fault_out_ncmp = fault_ncmp - 2;
+  size_t siz_f = sizeof(float);
+  size_t siz_slice_yz = ny * nz;
+
+  int is_top_free = (par->bdry_has_free == 1
+                     && par->free_is_sides[CONST_NDIM-1][1] == 1
+                     && mympi->neighid[5] == MPI_PROC_NULL) ? 1 : 0;
+
+  //-- grid, device only keeps grid info
+  plan_mem_add(plan, "grid coord + AABB", 9 * siz_icmp * siz_f, 0);
+
+  //-- metric, or coords on device when metric is recomputed
+  if (par->metric_recompute == 1) {
+    plan_mem_add(plan, "metric", 10 * siz_icmp * siz_f, 3 * siz_icmp * siz_f);
+  } else {
+    plan_mem_add(plan, "metric", 10 * siz_icmp * siz_f, 10 * siz_icmp * siz_f);
+  }
+
+  //-- media, same ncmp as md_init
+  int md_ncmp;
+  if (par->media_itype == CONST_MEDIUM_ACOUSTIC_ISO) {
+    md_ncmp = 2;
+  } else if (par->media_itype == CONST_MEDIUM_ELASTIC_ISO) {
+    md_ncmp = 3;
+  } else if (par->media_itype == CONST_MEDIUM_ELASTIC_VTI) {
+    md_ncmp = 6;
+  } else {
+    md_ncmp = 22;
+  }
+  int md_ncmp_host = md_ncmp;
+  if (par->visco_itype == CONST_VISCO_GRAVES_QS) {
+    md_ncmp_host += 1;
+  }
+  plan_mem_add(plan, "media", md_ncmp_host * siz_icmp * siz_f,
+                              md_ncmp * siz_icmp * siz_f);
+
+  //-- wavefield, host copy is kept as io buffer
+  size_t siz_wav = wav_ncmp * siz_icmp * nlevel * siz_f;
+  plan_mem_add(plan, "wavefield", siz_wav, siz_wav);
+
+  //-- pml auxvar, each side is shrinked to num_of_layers+1
+  if (par->bdry_has_cfspml == 1)
+  {
+    size_t siz_pml = 0;
+    size_t siz_coef = 0;
+    int is_enable_pml = 0;
+    for (int idim=0; idim<CONST_NDIM; idim++)
+    {
+      for (int iside=0; iside<2; iside++)
+      {
+        int ind_1d = iside + idim * 2;
+        int is_sides = par->cfspml_is_sides[idim][iside];
+        int nlay = par->abs_num_of_layers[idim][iside];
+        if (mympi->neighid[ind_1d] != MPI_PROC_NULL) {
+          is_sides = 0;
+          nlay = 0;
+        }
+        if (is_sides == 1) {
+          is_enable_pml = 1;
+          siz_coef += 3 * (nlay + 1) * siz_f;
+        }
+        size_t npts = (idim == 0) ? (size_t)(nlay+1) * nj * nk
+                    : ((idim == 1) ? (size_t)ni * (nlay+1) * nk
+                                   : (size_t)ni * nj * (nlay+1));
+        siz_pml += npts * wav_ncmp * nlevel * siz_f;
+      }
+    }
+    plan_mem_add(plan, "pml auxvar", siz_pml + siz_coef,
+                 is_enable_pml == 1 ? siz_pml + siz_coef : 0);
+  }
+
+  //-- ablexp
+  if (par->bdry_has_ablexp == 1)
+  {
+    plan_mem_add(plan, "ablexp coef", (nx + ny + nz) * siz_f,
+                                      (nx + ny + nz) * siz_f);
+  }
+
+  //-- free surface matrix and PGV/PGA/PGD
+  if (par->bdry_has_free == 1)
+  {
+    plan_mem_add(plan, "free surface matrix",
+                 2 * siz_iz * CONST_NDIM * CONST_NDIM * siz_f,
+                 is_top_free == 1 ? 2 * siz_iz * CONST_NDIM * CONST_NDIM * siz_f : 0);
+  }
+  if (is_top_free == 1)
+  {
+    plan_mem_add(plan, "PGV/PGA/PGD",
+                 CONST_NDIM_5 * siz_iz * siz_f,
+                 (CONST_NDIM_5 + CONST_NDIM) * siz_iz * siz_f);
+  }
+
+  //-- fault
+  // fault_coef: 28 3x3 matrix, lam/mu/rho on 2 sides, 3 vectors, 3 et,
+  //  and 14 3x3 matrix on free surface line
+  size_t siz_fault_coef = ((28 * 9 + 3 * 2 + 3 * 3 + 3) * siz_slice_yz
+                           + 14 * 9 * ny) * siz_f * number_fault;
+  plan_mem_add(plan, "fault coef", siz_fault_coef, siz_fault_coef);
+
+  // fault_t: T0, friction, output, tT as float; 7 int flags
+  size_t siz_fault = ((7 + fault_ncmp + 3) * siz_f + 7 * sizeof(int))
+                     * siz_slice_yz * number_fault;
+  plan_mem_add(plan, "fault var", siz_fault, siz_fault);
+
+  // fault_wav_t: 2 sides levels, T1 on 7 points, hT1 and mT1
+  size_t siz_fault_wav = (2 * siz_slice_yz * wav_ncmp * nlevel
+                          + 3 * 7 * siz_slice_yz + 6 * siz_slice_yz)
+                         * siz_f * number_fault;
+  plan_mem_add(plan, "fault wavefield", siz_fault_wav, siz_fault_wav);
+
+  //-- mpi mesg, same as macdrp_mesg_init and macdrp_fault_mesg_init
+  size_t siz_sbuff = 0, siz_rbuff = 0;
+  size_t siz_sbuff_fault = 0, siz_rbuff_fault = 0;
+  size_t halo_size = 0;
+  for (int ipair = 0; ipair < fd->num_of_pairs; ipair++)
+  {
+    for (int istage = 0; istage < fd->num_rk_stages; istage++)
+    {
+      fd_op_t *fdy_op = fd->pair_fdy_op[ipair][istage];
+      fd_op_t *fdz_op = fd->pair_fdz_op[ipair][istage];
+
+      size_t len_y = fdy_op->left_len + fdy_op->right_len;
+      size_t len_z = fdz_op->left_len + fdz_op->right_len;
+
+      size_t siz_s = (ni * nk * len_y + ni * nj * len_z) * wav_ncmp;
+      size_t siz_s_fault = (nk * len_y + nj * len_z) * 2 * wav_ncmp * number_fault;
+
+      if (siz_s > siz_sbuff) siz_sbuff = siz_s;
+      if (siz_s > siz_rbuff) siz_rbuff = siz_s;
+      if (siz_s_fault > siz_sbuff_fault) siz_sbuff_fault = siz_s_fault;
+      if (siz_s_fault > siz_rbuff_fault) siz_rbuff_fault = siz_s_fault;
+
+      // only sides with neighbour transfer data, count send and recv
+      int num_side_y = (mympi->neighid[2] != MPI_PROC_NULL)
+                     + (mympi->neighid[3] != MPI_PROC_NULL);
+      int num_side_z = (mympi->neighid[4] != MPI_PROC_NULL)
+                     + (mympi->neighid[5] != MPI_PROC_NULL);
+      size_t siz_y = len_y * num_side_y;
+      size_t siz_z = len_z * num_side_z;
+      halo_size += (ni * nk * siz_y + ni * nj * siz_z) * wav_ncmp
+                 + (nk * siz_y + nj * siz_z) * 2 * wav_ncmp * number_fault;
+    }
+  }
+  plan_mem_add(plan, "mpi mesg", 0,
+               (siz_sbuff + siz_rbuff) * sizeof(float));
+  plan_mem_add(plan, "mpi mesg fault", 0,
+               (siz_sbuff_fault + siz_rbuff_fault) * sizeof(float));
+  if (num_fault_recv > 0)
+  {
+    size_t siz_out = 2 * (nj + nk) * fault_out_ncmp * number_fault;
+    plan_mem_add(plan, "mpi mesg fault out(max)", 0,
+                 2 * siz_out * sizeof(float));
+  }
+
+  //-- io, receivers are bounded by all stations in this thread
+  if (num_recv > 0) {
+    plan_mem_add(plan, "recv seismo(max)",
+                 (size_t) num_recv * wav_ncmp * nt_total * siz_f, 0);
+  }
+  if (num_fault_recv > 0) {
+    plan_mem_add(plan, "fault recv seismo(max)",
+                 (size_t) num_fault_recv * fault_out_ncmp * nt_total * siz_f, 0);
+  }
+  if (par->number_of_receiver_line > 0)
+  {
+    size_t num_line_recv = 0;
+    for (int n=0; n < par->number_of_receiver_line; n++) {
+      num_line_recv += par->receiver_line_count[n];
+    }
+    plan_mem_add(plan, "line seismo(max)",
+                 num_line_recv * wav_ncmp * nt_total * siz_f, 0);
+  }
+
+  // temporary device buffer in io_slice_nc_put and io_snap_nc_put
+  size_t siz_io_tmp = 0;
+  if (par->number_of_slice_x > 0 && (size_t) nj * nk > siz_io_tmp) siz_io_tmp = nj * nk;
+  if (par->number_of_slice_y > 0 && (size_t) ni * nk > siz_io_tmp) siz_io_tmp = ni * nk;
+  if (par->number_of_slice_z > 0 && (size_t) ni * nj > siz_io_tmp) siz_io_tmp = ni * nj;
+  for (int n=0; n < par->number_of_snapshot; n++)
+  {
+    size_t snap_ni = par->snapshot_index_count[3*n+0] < ni ? par->snapshot_index_count[3*n+0] : ni;
+    size_t snap_nj = par->snapshot_index_count[3*n+1] < nj ? par->snapshot_index_count[3*n+1] : nj;
+    size_t snap_nk = par->snapshot_index_count[3*n+2] < nk ? par->snapshot_index_count[3*n+2] : nk;
+    if (snap_ni * snap_nj * snap_nk > siz_io_tmp) siz_io_tmp = snap_ni * snap_nj * snap_nk;
+  }
+  // taken from pool, in block of its size class
+  if (siz_io_tmp > 0) {
+    plan_mem_add(plan, "io temporary", 0,
+                 mem_pool_class_size(mem_pool_size_class(siz_io_tmp * siz_f)));
+  }
+
+  //-- per step cost, average over pairs
+  plan->halo_bytes = halo_size * sizeof(float) / fd->num_of_pairs;
+  plan->point_updates = (double) ni * nj * nk;
+  plan->flops = (double) fd->num_rk_stages
+                * ( plan->point_updates * (PLAN_FLOP_PER_POINT_STAGE + PLAN_FLOP_PER_POINT_RK_UPDATE)
+                   + (double) nj * nk * number_fault * PLAN_FLOP_PER_FAULT_POINT_STAGE);
+
+  return 0;
+}
+
+int
+plan_mem_print(plan_mem_t *plan)
+{
+  double MB = 1024.0 * 1024.0;
+
+  fprintf(stdout,"-> thread %d, topoid=[%d,%d,%d], ni=%d, nj=%d, nk=%d\n",
+          plan->myid, plan->topoid[0], plan->topoid[1], plan->topoid[2],
+          plan->ni, plan->nj, plan->nk);
+  fprintf(stdout,"   %-26s %14s %14s\n", "allocation", "host(MB)", "device(MB)");
+  for (int n=0; n < plan->num_of_item; n++)
+  {
+    fprintf(stdout,"   %-26s %14.2f %14.2f\n", plan->item_name[n],
+            plan->item_host[n] / MB, plan->item_dev[n] / MB);
+  }
+  fprintf(stdout,"   %-26s %14.2f %14.2f\n", "total",
+          plan->host_total / MB, plan->dev_total / MB);
+  fprintf(stdout,"   halo per step = %.3f MB, flops per step = %.3f GFLOP\n",
+          plan->halo_bytes / MB, plan->flops * 1.0e-9);
+  fflush(stdout);
+
+  return 0;
+}
+
+/*
+ * loop all threads of the cartesian topo in root, print table
+ */
+
+int
+plan_mem_run(par_t *par, int myid)
+{
+  if (myid != 0) return 0;
+
+  int nprocx = par->number_of_mpiprocs_x;
+  int nprocy = par->number_of_mpiprocs_y;
+  int nprocz = par->number_of_mpiprocs_z;
+
+  fd_t *fd = (fd_t *) malloc(sizeof(fd_t));
+  fd_set_macdrp(fd);
+
+  // dt may be set later by stability check, use input values if possible
+  int nt_total = par->number_of_time_steps + 1;
+  if (par->number_of_time_steps < 0)
+  {
+    if (par->size_of_time_step > 0.0 && par->time_window_length > 0.0) {
+      nt_total = (int) (par->time_window_length / par->size_of_time_step + 0.5);
+    } else {
+      fprintf(stdout,"-> nt_total is unknown before dt estimation, use 1 step for io\n");
+      nt_total = 1;
+    }
+  }
+  int num_recv = plan_mem_station_number(par->in_station_file);
+  int num_fault_recv = plan_mem_station_number(par->fault_station_file);
+
+  double MB = 1024.0 * 1024.0;
+  double host_sum = 0.0, dev_sum = 0.0, flops_sum = 0.0, points_sum = 0.0;
+  size_t halo_max = 0;
+  plan_mem_t plan;
+  plan_mem_t plan_max;
+  plan_max.dev_total = 0;
+  plan_max.num_of_item = 0;
+
+  fprintf(stdout,"\n");
+  fprintf(stdout,"-------------------------------------------------------\n");
+  fprintf(stdout,"--> memory and cost plan:\n");
+  fprintf(stdout,"-------------------------------------------------------\n");
+  fprintf(stdout," nt_total=%d, num_recv<=%d, num_fault_recv<=%d\n",
+          nt_total, num_recv, num_fault_recv);
+  fprintf(stdout," %6s %12s %6s %6s %6s %12s %12s %12s %12s\n",
+          "id", "topoid", "ni", "nj", "nk",
+          "host(MB)", "device(MB)", "halo(MB)", "GFLOP/step");
+
+  mympi_t mympi;
+  memset(&mympi, 0, sizeof(mympi_t));
+  mympi.nprocx = nprocx;
+  mympi.nprocy = nprocy;
+  mympi.nprocz = nprocz;
+
+  for (int px=0; px < nprocx; px++) {
+  for (int py=0; py < nprocy; py++) {
+  for (int pz=0; pz < nprocz; pz++)
+  {
+    // same order as MPI_Cart_create, last dim varies first
+    mympi.myid = (px * nprocy + py) * nprocz + pz;
+    mympi.topoid[0] = px;
+    mympi.topoid[1] = py;
+    mympi.topoid[2] = pz;
+    mympi.neighid[0] = (px > 0       ) ? mympi.myid - nprocy * nprocz : MPI_PROC_NULL;
+    mympi.neighid[1] = (px < nprocx-1) ? mympi.myid + nprocy * nprocz : MPI_PROC_NULL;
+    mympi.neighid[2] = (py > 0       ) ? mympi.myid - nprocz : MPI_PROC_NULL;
+    mympi.neighid[3] = (py < nprocy-1) ? mympi.myid + nprocz : MPI_PROC_NULL;
+    mympi.neighid[4] = (pz > 0       ) ? mympi.myid - 1 : MPI_PROC_NULL;
+    mympi.neighid[5] = (pz < nprocz-1) ? mympi.myid + 1 : MPI_PROC_NULL;
+
+    plan_mem_one(&plan, par, fd, &mympi, num_recv, num_fault_recv, nt_total);
+
+    fprintf(stdout," %6d %4d,%3d,%3d %6d %6d %6d %12.2f %12.2f %12.3f %12.3f\n",
+            plan.myid, px, py, pz, plan.ni, plan.nj, plan.nk,
+            plan.host_total / MB, plan.dev_total / MB,
+            plan.halo_bytes / MB, plan.flops * 1.0e-9);
+
+    host_sum   += plan.host_total;
+    dev_sum    += plan.dev_total;
+    flops_sum  += plan.flops;
+    points_sum += plan.point_updates;
+    if (plan.halo_bytes > halo_max) halo_max = plan.halo_bytes;
+    if (plan.dev_total >= plan_max.dev_total) {
+      memcpy(&plan_max, &plan, sizeof(plan_mem_t));
+    }
+  }
+  }
+  }
+
+  fprintf(stdout,"-------------------------------------------------------\n");
+  fprintf(stdout,"--> thread with max device memory:\n");
+  plan_mem_print(&plan_max);
+  fprintf(stdout,"-------------------------------------------------------\n");
+  fprintf(stdout," all threads: host=%.2f GB, device=%.2f GB\n",
+          host_sum / (MB * 1024.0), dev_sum / (MB * 1024.0));
+  fprintf(stdout," max halo per step in one thread = %.3f MB\n", halo_max / MB);
+  fprintf(stdout," grid point updates per step = %.0f\n", points_sum);
+  fprintf(stdout," flops per step = %.3f GFLOP, total = %.3f TFLOP\n",
+          flops_sum * 1.0e-9, flops_sum * nt_total * 1.0e-12);
+  fprintf(stdout,"-------------------------------------------------------\n");
+  fflush(stdout);
+
+  return 0;
+}
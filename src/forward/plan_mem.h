@@ -0,0 +1,78 @@
+#ifndef PLAN_MEM_H
+#define PLAN_MEM_H
+
+#include "constants.h"
+#include "par_t.h"
+#include "fd_t.h"
+#include "mympi_t.h"
+#include "gd_t.h"
+
+/*************************************************
+ * structure
+ *************************************************/
+
+#define PLAN_MEM_MAX_ITEM    24
+#define PLAN_MEM_NAME_STRLEN 32
+
+// rough operation counts of the kernels, only used for planning
+//  iso elastic rhs: 27 five-point derivatives + metric/constitutive combination
+#define PLAN_FLOP_PER_POINT_STAGE        400
+//  wav_update + wav_update_end for 9 components
+#define PLAN_FLOP_PER_POINT_RK_UPDATE    36
+//  wave2fault + trial friction + fault2wave per split node
+#define PLAN_FLOP_PER_FAULT_POINT_STAGE  1200
+
+/*
+ * memory and cost estimation of one mpi thread
+ */
+
+typedef struct
+{
+  int myid;
+  int topoid[CONST_NDIM];
+  int neighid[CONST_NDIM_2];
+
+  int ni, nj, nk;
+  int nx, ny, nz;
+
+  // per allocation
+  int    num_of_item;
+  char   item_name[PLAN_MEM_MAX_ITEM][PLAN_MEM_NAME_STRLEN];
+  size_t item_host[PLAN_MEM_MAX_ITEM];
+  size_t item_dev [PLAN_MEM_MAX_ITEM];
+
+  size_t host_total;
+  size_t dev_total;
+
+  // per time step
+  size_t halo_bytes;
+  double flops;
+  double point_updates;
+} plan_mem_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+plan_mem_station_number(char *in_filenm);
+
+int
+plan_mem_add(plan_mem_t *plan, char *name, size_t nbyte_host, size_t nbyte_dev);
+
+int
+plan_mem_one(plan_mem_t *plan,
+             par_t *par,
+             fd_t *fd,
+             mympi_t *mympi,
+             int num_recv,
+             int num_fault_recv,
+             int nt_total);
+
+int
+plan_mem_print(plan_mem_t *plan);
+
+int
+plan_mem_run(par_t *par, int myid);
+
+#endif
@@ -0,0 +1,277 @@
+/*******************************************************************************
+ * timing of named scopes, aggregated over all threads at exit
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "constants.h"
+#include "prof_t.h"
+#include "cuda_common.h"
+
+static const char *prof_scope_name[PROF_NUM_SCOPE] = {
+  "metric",
+  "media",
+  "fault_coef",
+  "time_loop",
+  "rhs_inner",
+  "free_surface",
+  "pml",
+  "fault_velo_stress",
+  "friction",
+  "transform",
+  "rk_update",
+  "pack",
+  "unpack",
+  "mpi_wait",
+  "fault_update",
+  "surface_pg",
+  "recv_keep",
+  "io_slice",
+  "io_snap",
+  "io_fault",
+  "mpi_start",
+  "health",
+  "checkpoint"
+};
+
+int
+prof_init(prof_t *prof, int enable, int use_event)
+{
+  prof->enable    = enable;
+  prof->use_event = (enable == 1) ? use_event : 0;
+  prof->trace     = NULL;
+
+  for (int n=0; n < PROF_NUM_SCOPE; n++)
+  {
+    prof->count [n] = 0;
+    prof->t_host[n] = 0.0;
+    prof->t_dev [n] = 0.0;
+    prof->t_beg [n] = 0.0;
+    prof->num_pending[n] = 0;
+
+    if (prof->use_event == 1)
+    {
+      for (int m=0; m < PROF_MAX_PENDING; m++) {
+        CUDACHECK(cudaEventCreate(&(prof->ev_beg[n][m])));
+        CUDACHECK(cudaEventCreate(&(prof->ev_end[n][m])));
+      }
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * monotonic wall time in seconds
+ */
+
+double
+prof_wtime()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + 1.0e-9 * (double) ts.tv_nsec;
+}
+
+const char *
+prof_get_name(int iscope)
+{
+  return prof_scope_name[iscope];
+}
+
+/*
+ * add elapsed time of recorded event pairs of scope,
+ *  events are in order on default stream, last one is waited only
+ */
+
+static void
+prof_harvest(prof_t *prof, int iscope)
+{
+  int num = prof->num_pending[iscope];
+  if (num == 0) return;
+
+  CUDACHECK(cudaEventSynchronize(prof->ev_end[iscope][num-1]));
+
+  for (int m=0; m < num; m++)
+  {
+    float t_ms = 0.0;
+    CUDACHECK(cudaEventElapsedTime(&t_ms, prof->ev_beg[iscope][m], prof->ev_end[iscope][m]));
+    prof->t_dev[iscope] += 1.0e-3 * t_ms;
+  }
+  prof->num_pending[iscope] = 0;
+}
+
+void
+prof_beg(prof_t *prof, int iscope)
+{
+  if (prof->enable == 0 && prof->trace == NULL) return;
+
+  if (prof->use_event == 1)
+  {
+    // all pairs of scope used in this step
+    if (prof->num_pending[iscope] == PROF_MAX_PENDING) {
+      prof_harvest(prof, iscope);
+    }
+    CUDACHECK(cudaEventRecord(prof->ev_beg[iscope][prof->num_pending[iscope]], 0));
+  }
+
+  prof->t_beg[iscope] = prof_wtime();
+}
+
+void
+prof_end(prof_t *prof, int iscope)
+{
+  if (prof->enable == 0 && prof->trace == NULL) return;
+
+  double t_end = prof_wtime();
+
+  if (prof->trace != NULL) {
+    trace_add(prof->trace, iscope, prof->t_beg[iscope], t_end);
+  }
+
+  if (prof->enable == 0) return;
+
+  prof->t_host[iscope] += t_end - prof->t_beg[iscope];
+  prof->count [iscope] += 1;
+
+  if (prof->use_event == 1)
+  {
+    CUDACHECK(cudaEventRecord(prof->ev_end[iscope][prof->num_pending[iscope]], 0));
+    prof->num_pending[iscope] += 1;
+  }
+}
+
+/*
+ * add host time of a scope timed off the main thread, no device time
+ */
+
+void
+prof_add(prof_t *prof, int iscope, double t_beg, double t_end)
+{
+  if (prof->trace != NULL) {
+    trace_add(prof->trace, iscope, t_beg, t_end);
+  }
+
+  if (prof->enable == 0) return;
+
+  prof->t_host[iscope] += t_end - t_beg;
+  prof->count [iscope] += 1;
+}
+
+/*
+ * device time of scopes ended in this step, called after last stream
+ *  work of step, so only the first harvest waits
+ */
+
+void
+prof_step_end(prof_t *prof)
+{
+  if (prof->use_event == 0) return;
+
+  for (int n=0; n < PROF_NUM_SCOPE; n++) {
+    prof_harvest(prof, n);
+  }
+}
+
+/*
+ * min/avg/max over all threads, written by thread 0 to json file
+ */
+
+int
+prof_report(prof_t *prof, double point_updates,
+            MPI_Comm comm, int myid, char *output_dir)
+{
+  if (prof->enable == 0) return 0;
+
+  int nprocs;
+  MPI_Comm_size(comm, &nprocs);
+
+  if (prof->use_event == 1) {
+    for (int n=0; n < PROF_NUM_SCOPE; n++) {
+      prof_harvest(prof, n);
+    }
+  }
+
+  double host_min[PROF_NUM_SCOPE], host_max[PROF_NUM_SCOPE], host_sum[PROF_NUM_SCOPE];
+  double dev_min [PROF_NUM_SCOPE], dev_max [PROF_NUM_SCOPE], dev_sum [PROF_NUM_SCOPE];
+  int    count_max[PROF_NUM_SCOPE];
+  double point_updates_all;
+
+  MPI_Reduce(prof->t_host, host_min, PROF_NUM_SCOPE, MPI_DOUBLE, MPI_MIN, 0, comm);
+  MPI_Reduce(prof->t_host, host_max, PROF_NUM_SCOPE, MPI_DOUBLE, MPI_MAX, 0, comm);
+  MPI_Reduce(prof->t_host, host_sum, PROF_NUM_SCOPE, MPI_DOUBLE, MPI_SUM, 0, comm);
+  MPI_Reduce(prof->t_dev,  dev_min,  PROF_NUM_SCOPE, MPI_DOUBLE, MPI_MIN, 0, comm);
+  MPI_Reduce(prof->t_dev,  dev_max,  PROF_NUM_SCOPE, MPI_DOUBLE, MPI_MAX, 0, comm);
+  MPI_Reduce(prof->t_dev,  dev_sum,  PROF_NUM_SCOPE, MPI_DOUBLE, MPI_SUM, 0, comm);
+  MPI_Reduce(prof->count,  count_max, PROF_NUM_SCOPE, MPI_INT,   MPI_MAX, 0, comm);
+  MPI_Reduce(&point_updates, &point_updates_all, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+  if (myid != 0) return 0;
+
+  // slowest thread sets the pace
+  double t_loop = host_max[PROF_TIME_LOOP];
+  double updates_per_sec = (t_loop > 0.0) ? point_updates_all / t_loop : 0.0;
+
+  char ou_file[CONST_MAX_STRLEN];
+  sprintf(ou_file, "%s/prof_timing.json", output_dir);
+
+  FILE *fp = fopen(ou_file, "w");
+  if (fp == NULL) {
+    fprintf(stderr,"Error: can't create timing file %s\n", ou_file);
+    fflush(stderr);
+    return -1;
+  }
+
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"num_of_procs\": %d,\n", nprocs);
+  fprintf(fp, "  \"event_timing\": %d,\n", prof->use_event);
+  fprintf(fp, "  \"point_updates\": %.6e,\n", point_updates_all);
+  fprintf(fp, "  \"time_loop_seconds\": %.6f,\n", t_loop);
+  fprintf(fp, "  \"point_updates_per_second\": %.6e,\n", updates_per_sec);
+  fprintf(fp, "  \"scopes\": [\n");
+
+  int is_first = 1;
+  for (int n=0; n < PROF_NUM_SCOPE; n++)
+  {
+    if (count_max[n] == 0) continue;
+
+    if (is_first == 0) fprintf(fp, ",\n");
+    is_first = 0;
+
+    fprintf(fp, "    {\"name\": \"%s\", \"count\": %d,\n", prof_scope_name[n], count_max[n]);
+    fprintf(fp, "     \"host_min\": %.6f, \"host_avg\": %.6f, \"host_max\": %.6f,\n",
+                host_min[n], host_sum[n] / nprocs, host_max[n]);
+    fprintf(fp, "     \"device_min\": %.6f, \"device_avg\": %.6f, \"device_max\": %.6f}",
+                dev_min[n], dev_sum[n] / nprocs, dev_max[n]);
+  }
+  fprintf(fp, "\n  ]\n");
+  fprintf(fp, "}\n");
+
+  fclose(fp);
+
+  fprintf(stdout,"timing of %d scopes is written to %s\n", PROF_NUM_SCOPE, ou_file);
+  fprintf(stdout,"  time loop: %f s, %e point updates per second\n", t_loop, updates_per_sec);
+  fflush(stdout);
+
+  return 0;
+}
+
+int
+prof_free(prof_t *prof)
+{
+  if (prof->use_event == 1)
+  {
+    for (int n=0; n < PROF_NUM_SCOPE; n++) {
+      for (int m=0; m < PROF_MAX_PENDING; m++) {
+        CUDACHECK(cudaEventDestroy(prof->ev_beg[n][m]));
+        CUDACHECK(cudaEventDestroy(prof->ev_end[n][m]));
+      }
+    }
+  }
+  prof->use_event = 0;
+
+  return 0;
+}
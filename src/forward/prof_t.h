@@ -0,0 +1,99 @@
+#ifndef PROF_T_H
+#define PROF_T_H
+
+#include <mpi.h>
+#include <cuda_runtime.h>
+
+#include "trace_t.h"
+
+/*************************************************
+ * named timing scopes of set-up and time loop
+ *  host time from monotonic clock, device time from cuda events
+ *  recorded on default stream. time_loop encloses the loop scopes,
+ *  others are exclusive: a running scope is ended before another begins.
+ *  event pairs are kept until prof_step_end, which syncs once per step
+ *************************************************/
+
+// set-up
+#define PROF_METRIC        0
+#define PROF_MEDIA         1
+#define PROF_FAULT_COEF    2
+// time loop
+#define PROF_TIME_LOOP     3
+#define PROF_RHS_INNER     4
+#define PROF_FREE_SURFACE  5
+#define PROF_PML           6
+#define PROF_FAULT_RHS     7
+#define PROF_FRICTION      8
+#define PROF_TRANSFORM     9
+#define PROF_RK_UPDATE    10
+#define PROF_PACK         11
+#define PROF_UNPACK       12
+#define PROF_MPI_WAIT     13
+#define PROF_FAULT_UPDATE 14
+#define PROF_SURFACE_PG   15
+#define PROF_RECV_KEEP    16
+#define PROF_IO_SLICE     17
+#define PROF_IO_SNAP      18
+#define PROF_IO_FAULT     19
+#define PROF_MPI_START    20
+#define PROF_HEALTH       21
+#define PROF_CHKPT        22
+
+#define PROF_NUM_SCOPE    23
+
+// event pairs of a scope kept in a step, more are harvested early
+#define PROF_MAX_PENDING  32
+
+typedef struct
+{
+  int enable;
+  int use_event;
+
+  int    count [PROF_NUM_SCOPE];
+  double t_host[PROF_NUM_SCOPE]; // accumulated seconds
+  double t_dev [PROF_NUM_SCOPE];
+  double t_beg [PROF_NUM_SCOPE];
+
+  // event pairs recorded but elapsed time not added yet
+  int         num_pending[PROF_NUM_SCOPE];
+  cudaEvent_t ev_beg[PROF_NUM_SCOPE][PROF_MAX_PENDING];
+  cudaEvent_t ev_end[PROF_NUM_SCOPE][PROF_MAX_PENDING];
+
+  // scopes are also sent to tracer if not NULL
+  trace_t *trace;
+} prof_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+prof_init(prof_t *prof, int enable, int use_event);
+
+double
+prof_wtime();
+
+const char *
+prof_get_name(int iscope);
+
+void
+prof_beg(prof_t *prof, int iscope);
+
+void
+prof_end(prof_t *prof, int iscope);
+
+void
+prof_add(prof_t *prof, int iscope, double t_beg, double t_end);
+
+void
+prof_step_end(prof_t *prof);
+
+int
+prof_report(prof_t *prof, double point_updates,
+            MPI_Comm comm, int myid, char *output_dir);
+
+int
+prof_free(prof_t *prof);
+
+#endif
@@ -0,0 +1,406 @@
+/*******************************************************************************
+ * residency of host mirrors of device arrays
+ *  release host copies after upload to reduce host memory,
+ *  and refill them from device when needed
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <cuda_runtime.h>
+
+#include "resid_t.h"
+#include "cuda_common.h"
+
+int
+resid_init(resid_t *resid, int enable)
+{
+  resid->enable = enable;
+  resid->num_of_mirror = 0;
+  resid->max_of_mirror = 0;
+  resid->mirror = NULL;
+  resid->nbyte_released = 0;
+
+  return 0;
+}
+
+/*
+ * register a host block, return id of the mirror
+ */
+
+int
+resid_add(resid_t *resid, char *name, float *host, size_t siz_host, int is_drop)
+{
+  if (host == NULL || siz_host == 0) return -1;
+
+  if (resid->num_of_mirror == resid->max_of_mirror)
+  {
+    resid->max_of_mirror += 64;
+    resid->mirror = (resid_mirror_t *) realloc(resid->mirror,
+                          resid->max_of_mirror * sizeof(resid_mirror_t));
+    if (resid->mirror == NULL) {
+      fprintf(stderr,"Error: can't realloc mirror list in resid_add\n");
+      fflush(stderr);
+      exit(1);
+    }
+  }
+
+  int id = resid->num_of_mirror;
+  resid_mirror_t *m = resid->mirror + id;
+
+  strncpy(m->name, name, RESID_NAME_STRLEN-1);
+  m->name[RESID_NAME_STRLEN-1] = '\0';
+  m->host = host;
+  m->siz_host = siz_host;
+  m->num_of_seg = 0;
+  m->is_drop = is_drop;
+  m->is_resident = 1;
+  m->page_beg = NULL;
+  m->nbyte_page = 0;
+
+  resid->num_of_mirror += 1;
+
+  return id;
+}
+
+/*
+ * device copy of a piece of the host block
+ */
+
+int
+resid_add_seg(resid_t *resid, int id, float *host_seg, float *dev, size_t len)
+{
+  if (id < 0 || dev == NULL) return -1;
+
+  resid_mirror_t *m = resid->mirror + id;
+
+  if (m->num_of_seg >= RESID_MAX_SEG) {
+    fprintf(stderr,"Error: too many segments of %s in resid_add_seg\n", m->name);
+    fflush(stderr);
+    exit(1);
+  }
+
+  int n = m->num_of_seg;
+  m->seg_offset[n] = host_seg - m->host;
+  m->seg_len   [n] = len;
+  m->seg_dev   [n] = dev;
+  m->num_of_seg += 1;
+
+  return 0;
+}
+
+int
+resid_add_md(resid_t *resid, md_t *md, md_t *md_d)
+{
+  size_t siz_icmp = md->siz_mat;
+  int id = resid_add(resid, "media", md->v4d, siz_icmp * md->ncmp, 0);
+
+  // same arrays as init_md_device
+  if (md->medium_type == CONST_MEDIUM_ELASTIC_ISO)
+  {
+    resid_add_seg(resid, id, md->rho,    md_d->rho,    siz_icmp);
+    resid_add_seg(resid, id, md->lambda, md_d->lambda, siz_icmp);
+    resid_add_seg(resid, id, md->mu,     md_d->mu,     siz_icmp);
+  }
+  else if (md->medium_type == CONST_MEDIUM_ELASTIC_VTI)
+  {
+    resid_add_seg(resid, id, md->rho, md_d->rho, siz_icmp);
+    resid_add_seg(resid, id, md->c11, md_d->c11, siz_icmp);
+    resid_add_seg(resid, id, md->c33, md_d->c33, siz_icmp);
+    resid_add_seg(resid, id, md->c55, md_d->c55, siz_icmp);
+    resid_add_seg(resid, id, md->c66, md_d->c66, siz_icmp);
+    resid_add_seg(resid, id, md->c13, md_d->c13, siz_icmp);
+  }
+  else if (md->medium_type == CONST_MEDIUM_ELASTIC_ANISO)
+  {
+    float *h[22] = {md->rho,
+                    md->c11, md->c12, md->c13, md->c14, md->c15, md->c16,
+                             md->c22, md->c23, md->c24, md->c25, md->c26,
+                                      md->c33, md->c34, md->c35, md->c36,
+                                               md->c44, md->c45, md->c46,
+                                                        md->c55, md->c56,
+                                                                 md->c66};
+    float *d[22] = {md_d->rho,
+                    md_d->c11, md_d->c12, md_d->c13, md_d->c14, md_d->c15, md_d->c16,
+                               md_d->c22, md_d->c23, md_d->c24, md_d->c25, md_d->c26,
+                                          md_d->c33, md_d->c34, md_d->c35, md_d->c36,
+                                                     md_d->c44, md_d->c45, md_d->c46,
+                                                                md_d->c55, md_d->c56,
+                                                                           md_d->c66};
+    for (int n=0; n<22; n++) {
+      resid_add_seg(resid, id, h[n], d[n], siz_icmp);
+    }
+  }
+
+  return 0;
+}
+
+int
+resid_add_metric(resid_t *resid, gd_metric_t *metric, gd_metric_t *metric_d)
+{
+  size_t siz_icmp = metric->siz_icmp;
+  int id = resid_add(resid, "metric", metric->v4d, siz_icmp * metric->ncmp, 0);
+
+  // no device copy of metric, host one is kept
+  if (metric_d->is_recompute == 1) return 0;
+
+  resid_add_seg(resid, id, metric->jac,    metric_d->jac,    siz_icmp);
+  resid_add_seg(resid, id, metric->xi_x,   metric_d->xi_x,   siz_icmp);
+  resid_add_seg(resid, id, metric->xi_y,   metric_d->xi_y,   siz_icmp);
+  resid_add_seg(resid, id, metric->xi_z,   metric_d->xi_z,   siz_icmp);
+  resid_add_seg(resid, id, metric->eta_x,  metric_d->eta_x,  siz_icmp);
+  resid_add_seg(resid, id, metric->eta_y,  metric_d->eta_y,  siz_icmp);
+  resid_add_seg(resid, id, metric->eta_z,  metric_d->eta_z,  siz_icmp);
+  resid_add_seg(resid, id, metric->zeta_x, metric_d->zeta_x, siz_icmp);
+  resid_add_seg(resid, id, metric->zeta_y, metric_d->zeta_y, siz_icmp);
+  resid_add_seg(resid, id, metric->zeta_z, metric_d->zeta_z, siz_icmp);
+
+  return 0;
+}
+
+/*
+ * coords and AABB only have gdinfo on device, drop them,
+ *  except coords kept on device to recompute metric, and coords kept
+ *  on host if is_keep_coord for a later consumer, as dropped blocks
+ *  can't be fetched and their pages stay protected
+ */
+
+int
+resid_add_gd(resid_t *resid, gd_t *gd, gd_metric_t *metric_d, int is_keep_coord)
+{
+  size_t siz_icmp = gd->siz_icmp;
+
+  if (metric_d->is_recompute == 1)
+  {
+    int id = resid_add(resid, "coord", gd->v4d, siz_icmp * gd->ncmp, 0);
+    resid_add_seg(resid, id, gd->x3d, metric_d->x3d, siz_icmp);
+    resid_add_seg(resid, id, gd->y3d, metric_d->y3d, siz_icmp);
+    resid_add_seg(resid, id, gd->z3d, metric_d->z3d, siz_icmp);
+  } else if (is_keep_coord == 0) {
+    resid_add(resid, "coord",   gd->v4d, siz_icmp * gd->ncmp, 1);
+  }
+  resid_add(resid, "cell_xmin", gd->cell_xmin, siz_icmp, 1);
+  resid_add(resid, "cell_xmax", gd->cell_xmax, siz_icmp, 1);
+  resid_add(resid, "cell_ymin", gd->cell_ymin, siz_icmp, 1);
+  resid_add(resid, "cell_ymax", gd->cell_ymax, siz_icmp, 1);
+  resid_add(resid, "cell_zmin", gd->cell_zmin, siz_icmp, 1);
+  resid_add(resid, "cell_zmax", gd->cell_zmax, siz_icmp, 1);
+
+  return 0;
+}
+
+int
+resid_add_fault_coef(resid_t *resid, gd_t *gd,
+                     fault_coef_t *FC, fault_coef_t *FC_d)
+{
+  size_t ny = gd->ny;
+  size_t nz = gd->nz;
+
+  for (int id=0; id<FC->number_fault; id++)
+  {
+    fault_coef_one_t *h = FC->fault_coef_one + id;
+    fault_coef_one_t *d = FC_d->fault_coef_one + id;
+
+    // same arrays as init_fault_coef_device
+    float *h_yz[] = {h->D21_1, h->D22_1, h->D23_1, h->D31_1, h->D32_1, h->D33_1,
+                     h->D21_2, h->D22_2, h->D23_2, h->D31_2, h->D32_2, h->D33_2,
+                     h->matMin2Plus1, h->matMin2Plus2, h->matMin2Plus3,
+                     h->matMin2Plus4, h->matMin2Plus5,
+                     h->matPlus2Min1, h->matPlus2Min2, h->matPlus2Min3,
+                     h->matPlus2Min4, h->matPlus2Min5,
+                     h->matT1toVx_Min, h->matVytoVx_Min, h->matVztoVx_Min,
+                     h->matT1toVx_Plus, h->matVytoVx_Plus, h->matVztoVx_Plus};
+    float *d_yz[] = {d->D21_1, d->D22_1, d->D23_1, d->D31_1, d->D32_1, d->D33_1,
+                     d->D21_2, d->D22_2, d->D23_2, d->D31_2, d->D32_2, d->D33_2,
+                     d->matMin2Plus1, d->matMin2Plus2, d->matMin2Plus3,
+                     d->matMin2Plus4, d->matMin2Plus5,
+                     d->matPlus2Min1, d->matPlus2Min2, d->matPlus2Min3,
+                     d->matPlus2Min4, d->matPlus2Min5,
+                     d->matT1toVx_Min, d->matVytoVx_Min, d->matVztoVx_Min,
+                     d->matT1toVx_Plus, d->matVytoVx_Plus, d->matVztoVx_Plus};
+    int num_yz = sizeof(h_yz) / sizeof(float *);
+
+    for (int n=0; n<num_yz; n++)
+    {
+      int im = resid_add(resid, "fault_coef", h_yz[n], ny*nz*9, 0);
+      resid_add_seg(resid, im, h_yz[n], d_yz[n], ny*nz*9);
+    }
+
+    float *h_2[] = {h->rho_f, h->mu_f, h->lam_f};
+    float *d_2[] = {d->rho_f, d->mu_f, d->lam_f};
+    for (int n=0; n<3; n++)
+    {
+      int im = resid_add(resid, "fault_coef", h_2[n], ny*nz*2, 0);
+      resid_add_seg(resid, im, h_2[n], d_2[n], ny*nz*2);
+    }
+
+    float *h_3[] = {h->vec_n, h->vec_s1, h->vec_s2};
+    float *d_3[] = {d->vec_n, d->vec_s1, d->vec_s2};
+    for (int n=0; n<3; n++)
+    {
+      int im = resid_add(resid, "fault_coef", h_3[n], ny*nz*3, 0);
+      resid_add_seg(resid, im, h_3[n], d_3[n], ny*nz*3);
+    }
+
+    float *h_1[] = {h->x_et, h->y_et, h->z_et};
+    float *d_1[] = {d->x_et, d->y_et, d->z_et};
+    for (int n=0; n<3; n++)
+    {
+      int im = resid_add(resid, "fault_coef", h_1[n], ny*nz, 0);
+      resid_add_seg(resid, im, h_1[n], d_1[n], ny*nz);
+    }
+    // matrix along free surface line are small, keep them
+  }
+
+  return 0;
+}
+
+/*
+ * release pages of host blocks fully covered by device copy or droppable,
+ *  and protect them so a read without resid_get crashes
+ */
+
+int
+resid_release(resid_t *resid)
+{
+  if (resid->enable == 0) return 0;
+
+  size_t page = (size_t) sysconf(_SC_PAGESIZE);
+
+  for (int n=0; n < resid->num_of_mirror; n++)
+  {
+    resid_mirror_t *m = resid->mirror + n;
+
+    if (m->is_resident == 0) continue;
+
+    if (m->is_drop == 0)
+    {
+      size_t siz_seg = 0;
+      for (int i=0; i < m->num_of_seg; i++) siz_seg += m->seg_len[i];
+      // part of the block only on host, keep it
+      if (siz_seg < m->siz_host) continue;
+    }
+
+    // only whole pages inside the block
+    size_t addr1 = (size_t) m->host;
+    size_t addr2 = addr1 + m->siz_host * sizeof(float);
+    addr1 = (addr1 + page - 1) / page * page;
+    addr2 = addr2 / page * page;
+
+    if (addr2 > addr1)
+    {
+      if (madvise((void *) addr1, addr2 - addr1, MADV_DONTNEED) == 0) {
+        resid->nbyte_released += addr2 - addr1;
+      }
+      if (mprotect((void *) addr1, addr2 - addr1, PROT_NONE) != 0) {
+        fprintf(stderr,"Error: can't protect released host %s\n", m->name);
+        fflush(stderr);
+        exit(1);
+      }
+      m->page_beg   = (char *) addr1;
+      m->nbyte_page = addr2 - addr1;
+    }
+    m->is_resident = 0;
+  }
+
+  return 0;
+}
+
+/*
+ * host pointer of a managed block valid to use, the block is fetched from
+ *  device on first use after release. host consumers get blocks through
+ *  it, pointers not managed are returned as they are
+ */
+
+float *
+resid_get(resid_t *resid, float *host)
+{
+  for (int n=0; n < resid->num_of_mirror; n++)
+  {
+    resid_mirror_t *m = resid->mirror + n;
+
+    if (host < m->host || host >= m->host + m->siz_host) continue;
+
+    if (m->is_resident == 1) return host;
+
+    if (m->is_drop == 1) {
+      fprintf(stderr,"Error: host %s has been released and has no device copy\n",
+              m->name);
+      fflush(stderr);
+      exit(1);
+    }
+
+    if (m->nbyte_page > 0 &&
+        mprotect(m->page_beg, m->nbyte_page, PROT_READ | PROT_WRITE) != 0) {
+      fprintf(stderr,"Error: can't unprotect released host %s\n", m->name);
+      fflush(stderr);
+      exit(1);
+    }
+    for (int i=0; i < m->num_of_seg; i++)
+    {
+      CUDACHECK(cudaMemcpy(m->host + m->seg_offset[i], m->seg_dev[i],
+                           m->seg_len[i] * sizeof(float), cudaMemcpyDeviceToHost));
+    }
+    m->is_resident = 1;
+
+    return host;
+  }
+
+  // not managed, always resident
+  return host;
+}
+
+/*
+ * refill all released host blocks which have device copy,
+ *  before device copies are freed and host is used again
+ */
+
+int
+resid_fetch_all(resid_t *resid)
+{
+  for (int n=0; n < resid->num_of_mirror; n++)
+  {
+    resid_mirror_t *m = resid->mirror + n;
+    if (m->is_resident == 0 && m->is_drop == 0) {
+      resid_get(resid, m->host);
+    }
+  }
+
+  return 0;
+}
+
+int
+resid_print(resid_t *resid, int myid)
+{
+  if (resid->enable == 0) return 0;
+
+  int num_released = 0;
+  for (int n=0; n < resid->num_of_mirror; n++) {
+    if (resid->mirror[n].is_resident == 0) num_released += 1;
+  }
+
+  fprintf(stdout,"-> thread %d released %d of %d host mirrors, %.2f MB\n",
+          myid, num_released, resid->num_of_mirror,
+          resid->nbyte_released / (1024.0 * 1024.0));
+  fflush(stdout);
+
+  return 0;
+}
+
+/*
+ * dropped and not fetched blocks stay protected, they have no valid
+ *  value and should not be used or freed to heap again
+ */
+
+int
+resid_free(resid_t *resid)
+{
+  free(resid->mirror);
+  resid->mirror = NULL;
+  resid->num_of_mirror = 0;
+  resid->max_of_mirror = 0;
+
+  return 0;
+}
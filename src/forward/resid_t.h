@@ -0,0 +1,97 @@
+#ifndef RESID_T_H
+#define RESID_T_H
+
+#include "constants.h"
+#include "gd_t.h"
+#include "md_t.h"
+#include "fault_info.h"
+
+/*************************************************
+ * structure
+ *************************************************/
+
+#define RESID_NAME_STRLEN 32
+#define RESID_MAX_SEG     22
+
+/*
+ * one host array which has been uploaded to device.
+ *  the host block is released by madvise and its pages are protected,
+ *  so the address and the view pointers into it (md->lambda etc) keep
+ *  valid but a read before resid_get crashes instead of getting zeros.
+ *  resid_get refills the block from the device segments
+ */
+
+typedef struct
+{
+  char   name[RESID_NAME_STRLEN];
+  float *host;
+  size_t siz_host;  // number of float
+
+  // device copy of pieces of the host block
+  int    num_of_seg;
+  size_t seg_offset[RESID_MAX_SEG];
+  size_t seg_len   [RESID_MAX_SEG];
+  float *seg_dev   [RESID_MAX_SEG];
+
+  // 1: no device copy, can't be fetched again
+  int    is_drop;
+  int    is_resident;
+
+  // whole pages released and protected
+  char  *page_beg;
+  size_t nbyte_page;
+} resid_mirror_t;
+
+typedef struct
+{
+  int enable;
+
+  int num_of_mirror;
+  int max_of_mirror;
+  resid_mirror_t *mirror;
+
+  size_t nbyte_released;
+} resid_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+resid_init(resid_t *resid, int enable);
+
+int
+resid_add(resid_t *resid, char *name, float *host, size_t siz_host, int is_drop);
+
+int
+resid_add_seg(resid_t *resid, int id, float *host_seg, float *dev, size_t len);
+
+int
+resid_add_md(resid_t *resid, md_t *md, md_t *md_d);
+
+int
+resid_add_metric(resid_t *resid, gd_metric_t *metric, gd_metric_t *metric_d);
+
+int
+resid_add_gd(resid_t *resid, gd_t *gd, gd_metric_t *metric_d, int is_keep_coord);
+
+int
+resid_add_fault_coef(resid_t *resid, gd_t *gd,
+                     fault_coef_t *FC, fault_coef_t *FC_d);
+
+int
+resid_release(resid_t *resid);
+
+float *
+resid_get(resid_t *resid, float *host);
+
+int
+resid_fetch_all(resid_t *resid);
+
+int
+resid_print(resid_t *resid, int myid);
+
+int
+resid_free(resid_t *resid);
+
+#endif
@@ -0,0 +1,227 @@
+/*******************************************************************************
+ * fused RK update of wavefield, PML auxvars and fault wavefield
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "constants.h"
+#include "rk_fuse.h"
+#include "cuda_common.h"
+
+/*
+ * geometry of fault slice
+ */
+
+int
+rk_fuse_init(rk_fuse_t *fuse, gd_t *gd)
+{
+  fuse->nj1 = gd->nj1;
+  fuse->nj2 = gd->nj2;
+  fuse->nk1 = gd->nk1;
+  fuse->nk2 = gd->nk2;
+
+  fuse->ny           = gd->ny;
+  fuse->siz_slice_yz = gd->siz_slice_yz;
+
+  rk_fuse_clear(fuse);
+
+  return 0;
+}
+
+int
+rk_fuse_clear(rk_fuse_t *fuse)
+{
+  fuse->num_of_seg = 0;
+  fuse->num_of_blk = 0;
+
+  return 0;
+}
+
+/*
+ * segments of one list must not overlap, nor read dst of another
+ */
+
+int
+rk_fuse_add(rk_fuse_t *fuse, int kind, float coef, size_t size,
+            float *dst, float *src1, float *src2, int *united)
+{
+  if (size == 0) return 0;
+
+  if (fuse->num_of_seg >= RK_FUSE_MAX_SEG) {
+    fprintf(stderr,"Error: more than %d segments in fused rk update\n", RK_FUSE_MAX_SEG);
+    fflush(stderr);
+    exit(1);
+  }
+
+  rk_fuse_seg_t *s = fuse->seg + fuse->num_of_seg;
+  s->dst     = dst;
+  s->src1    = src1;
+  s->src2    = src2;
+  s->united  = united;
+  s->coef    = coef;
+  s->kind    = kind;
+  s->size    = size;
+  s->blk_beg = fuse->num_of_blk;
+
+  fuse->num_of_seg += 1;
+  fuse->num_of_blk += (size + RK_FUSE_BLOCK_SIZE - 1) / RK_FUSE_BLOCK_SIZE;
+
+  return 0;
+}
+
+/*
+ * lists of one stage, same updates as the separate kernels:
+ *  first stage : tmp = pre + a*rhs, end = pre + b*rhs
+ *  other stages: tmp = pre + a*rhs, end += b*rhs
+ *  last stage  : end += b*rhs
+ *  fuse_send gets values packed for neighbours, fuse_rest the others
+ */
+
+int
+rk_fuse_set_stage(rk_fuse_t *fuse_send, rk_fuse_t *fuse_rest,
+                  int istage, int num_rk_stages,
+                  float coef_a, float coef_b,
+                  wav_t wav_d, float *w_pre_d, float *w_tmp_d,
+                  float *w_rhs_d, float *w_end_d,
+                  fault_wav_t fault_wav_d, float *f_pre_d, float *f_tmp_d,
+                  float *f_rhs_d, float *f_end_d,
+                  fault_t fault_d, bdrypml_t bdrypml_d)
+{
+  rk_fuse_clear(fuse_send);
+  rk_fuse_clear(fuse_rest);
+
+  int is_last = (istage == num_rk_stages-1) ? 1 : 0;
+
+  // end level starts from pre at first stage
+  float *w_end_src1 = (istage == 0) ? w_pre_d : NULL;
+  float *f_end_src1 = (istage == 0) ? f_pre_d : NULL;
+
+  size_t siz_f = fault_wav_d.siz_ilevel;
+
+  if (is_last == 0)
+  {
+    rk_fuse_add(fuse_send, RK_FUSE_SEG_PLAIN, coef_a, wav_d.siz_ilevel,
+                w_tmp_d, w_pre_d, w_rhs_d, NULL);
+    for (int id=0; id < fault_wav_d.number_fault; id++)
+    {
+      rk_fuse_add(fuse_send, RK_FUSE_SEG_FAULT, coef_a, siz_f,
+                  f_tmp_d + id*siz_f, f_pre_d + id*siz_f, f_rhs_d + id*siz_f,
+                  fault_d.fault_one[id].united);
+    }
+
+    rk_fuse_add(fuse_rest, RK_FUSE_SEG_PLAIN, coef_b, wav_d.siz_ilevel,
+                w_end_d, w_end_src1, w_rhs_d, NULL);
+    for (int id=0; id < fault_wav_d.number_fault; id++)
+    {
+      rk_fuse_add(fuse_rest, RK_FUSE_SEG_FAULT, coef_b, siz_f,
+                  f_end_d + id*siz_f, f_end_src1 == NULL ? NULL : f_end_src1 + id*siz_f,
+                  f_rhs_d + id*siz_f, fault_d.fault_one[id].united);
+    }
+  }
+  else
+  {
+    rk_fuse_add(fuse_send, RK_FUSE_SEG_PLAIN, coef_b, wav_d.siz_ilevel,
+                w_end_d, w_end_src1, w_rhs_d, NULL);
+    for (int id=0; id < fault_wav_d.number_fault; id++)
+    {
+      rk_fuse_add(fuse_send, RK_FUSE_SEG_FAULT, coef_b, siz_f,
+                  f_end_d + id*siz_f, f_end_src1 == NULL ? NULL : f_end_src1 + id*siz_f,
+                  f_rhs_d + id*siz_f, fault_d.fault_one[id].united);
+    }
+  }
+
+  if (bdrypml_d.is_enable_pml == 1)
+  {
+    for (int idim=0; idim<CONST_NDIM; idim++) {
+      for (int iside=0; iside<2; iside++) {
+        if (bdrypml_d.is_sides_pml[idim][iside]==1) {
+          bdrypml_auxvar_t *auxvar_d = &(bdrypml_d.auxvar[idim][iside]);
+          if (is_last == 0) {
+            rk_fuse_add(fuse_rest, RK_FUSE_SEG_PLAIN, coef_a, auxvar_d->siz_ilevel,
+                        auxvar_d->tmp, auxvar_d->pre, auxvar_d->rhs, NULL);
+          }
+          rk_fuse_add(fuse_rest, RK_FUSE_SEG_PLAIN, coef_b, auxvar_d->siz_ilevel,
+                      auxvar_d->end, istage == 0 ? auxvar_d->pre : NULL,
+                      auxvar_d->rhs, NULL);
+        }
+      }
+    }
+  }
+
+  return 0;
+}
+
+int
+rk_fuse_update(rk_fuse_t *fuse)
+{
+  if (fuse->num_of_seg == 0) return 0;
+
+  dim3 block(RK_FUSE_BLOCK_SIZE);
+  dim3 grid;
+  grid.x = fuse->num_of_blk;
+  rk_fuse_update_gpu <<<grid, block>>> (*fuse);
+
+  return 0;
+}
+
+/*
+ * one launch per segment, same updates as rk_fuse_update
+ */
+
+int
+rk_fuse_update_each(rk_fuse_t *fuse)
+{
+  rk_fuse_t one = *fuse;
+  one.num_of_seg = 1;
+
+  dim3 block(RK_FUSE_BLOCK_SIZE);
+  for (int n=0; n < fuse->num_of_seg; n++)
+  {
+    one.seg[0] = fuse->seg[n];
+    one.seg[0].blk_beg = 0;
+    one.num_of_blk = (one.seg[0].size + RK_FUSE_BLOCK_SIZE - 1) / RK_FUSE_BLOCK_SIZE;
+    dim3 grid;
+    grid.x = one.num_of_blk;
+    rk_fuse_update_gpu <<<grid, block>>> (one);
+  }
+
+  return 0;
+}
+
+/*
+ * same points as the device, one parallel region over all segments
+ */
+
+int
+rk_fuse_update_host(rk_fuse_t *fuse)
+{
+#pragma omp parallel
+  {
+    for (int n=0; n < fuse->num_of_seg; n++)
+    {
+      rk_fuse_seg_t *s = fuse->seg + n;
+#pragma omp for schedule(static) nowait
+      for (size_t e=0; e < s->size; e++) {
+        rk_fuse_point(fuse, s, e);
+      }
+    }
+  }
+
+  return 0;
+}
+
+__global__ void
+rk_fuse_update_gpu(rk_fuse_t fuse)
+{
+  // segment of this block, same for all threads of block
+  int n = 0;
+  while (n+1 < fuse.num_of_seg && blockIdx.x >= fuse.seg[n+1].blk_beg) {
+    n += 1;
+  }
+
+  size_t e = (blockIdx.x - fuse.seg[n].blk_beg) * blockDim.x + threadIdx.x;
+  if (e < fuse.seg[n].size) {
+    rk_fuse_point(&fuse, fuse.seg + n, e);
+  }
+}
@@ -0,0 +1,116 @@
+#ifndef RK_FUSE_H
+#define RK_FUSE_H
+
+#include <math.h>
+
+#include "gd_t.h"
+#include "wav_t.h"
+#include "bdry_t.h"
+#include "fault_info.h"
+#include "fault_wav_t.h"
+#include <cuda_runtime.h>
+
+/*************************************************
+ * fused RK update of wavefield, PML auxvars and fault wavefield
+ *  a list of segments dst = src1 + coef * src2 (dst += coef * src2 if
+ *  src1 is NULL) is updated by one launch, blocks are assigned to
+ *  segments in order. each stage uses two lists: values sent to
+ *  neighbours this stage, updated before fault2wave and pack, and the
+ *  rest, updated after isend to overlap the exchange.
+ *  fault segments only update points in nj,nk with united == 0.
+ *  ablexp damping is not fused, bdry_ablexp_apply stays after the
+ *  stages as it must follow fault2wave and the exchange of w_end.
+ *  rk_fuse_update_each launches the segments one by one, the per-array
+ *  path; host version uses the same point function, results are identical
+ *************************************************/
+
+#define RK_FUSE_MAX_SEG    32
+#define RK_FUSE_BLOCK_SIZE 256
+
+#define RK_FUSE_SEG_PLAIN 0
+#define RK_FUSE_SEG_FAULT 1
+
+typedef struct
+{
+  float *dst;
+  float *src1; // NULL for dst += coef * src2
+  float *src2;
+  int   *united; // of fault segment
+  float  coef;
+  int    kind;
+  size_t size;
+  size_t blk_beg; // first block of this segment in launch
+} rk_fuse_seg_t;
+
+typedef struct
+{
+  int    num_of_seg;
+  size_t num_of_blk;
+  rk_fuse_seg_t seg[RK_FUSE_MAX_SEG];
+
+  // inner index of fault slice in j,k
+  int nj1, nj2, nk1, nk2;
+  // fault slice
+  int    ny;
+  size_t siz_slice_yz;
+} rk_fuse_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+rk_fuse_init(rk_fuse_t *fuse, gd_t *gd);
+
+int
+rk_fuse_clear(rk_fuse_t *fuse);
+
+int
+rk_fuse_add(rk_fuse_t *fuse, int kind, float coef, size_t size,
+            float *dst, float *src1, float *src2, int *united);
+
+int
+rk_fuse_set_stage(rk_fuse_t *fuse_send, rk_fuse_t *fuse_rest,
+                  int istage, int num_rk_stages,
+                  float coef_a, float coef_b,
+                  wav_t wav_d, float *w_pre_d, float *w_tmp_d,
+                  float *w_rhs_d, float *w_end_d,
+                  fault_wav_t fault_wav_d, float *f_pre_d, float *f_tmp_d,
+                  float *f_rhs_d, float *f_end_d,
+                  fault_t fault_d, bdrypml_t bdrypml_d);
+
+int
+rk_fuse_update(rk_fuse_t *fuse);
+
+int
+rk_fuse_update_each(rk_fuse_t *fuse);
+
+int
+rk_fuse_update_host(rk_fuse_t *fuse);
+
+__global__ void
+rk_fuse_update_gpu(rk_fuse_t fuse);
+
+/*
+ * update of point e of segment s, shared by device and host.
+ *  fmaf is what nvcc contracts in + coef * in2 to, so device results
+ *  equal wav_update and host results equal device ones
+ */
+
+__host__ __device__ static inline void
+rk_fuse_point(const rk_fuse_t *fuse, const rk_fuse_seg_t *s, size_t e)
+{
+  if (s->kind == RK_FUSE_SEG_FAULT)
+  {
+    size_t iptr_f = e % fuse->siz_slice_yz;
+    int j = (int) (iptr_f % fuse->ny);
+    int k = (int) (iptr_f / fuse->ny);
+    if (j < fuse->nj1 || j > fuse->nj2 || k < fuse->nk1 || k > fuse->nk2) return;
+    if (s->united[iptr_f] != 0) return;
+  }
+
+  float w1 = (s->src1 != NULL) ? s->src1[e] : s->dst[e];
+  s->dst[e] = fmaf(s->coef, s->src2[e], w1);
+}
+
+#endif
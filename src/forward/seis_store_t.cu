@@ -0,0 +1,247 @@
+/*******************************************************************************
+ * on-disk store of station traces, written by blocks in background
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "seis_store_t.h"
+
+int
+seis_store_init(seis_store_t *store, int nt_chunk, int nt_lag,
+                int num_of_trace, int nt_out)
+{
+  store->enable       = (nt_chunk > 0 && num_of_trace > 0) ? 1 : 0;
+  store->num_of_trace = num_of_trace;
+  store->nt_out       = nt_out;
+  store->nt_chunk     = nt_out;
+  store->nt_buff      = nt_out;
+  store->trace        = (float **) malloc((num_of_trace + 1) * sizeof(float *));
+  store->num_of_put   = 0;
+  store->fp           = NULL;
+  store->stage        = NULL;
+  store->is_writing   = 0;
+  store->ierr_writer  = 0;
+
+  if (store->enable == 0) return 0;
+
+  // ring keeps samples of the chunk being filled and those of traces
+  //  ahead of the slowest one
+  if (nt_chunk < nt_out) store->nt_chunk = nt_chunk;
+  if (store->nt_chunk + nt_lag < nt_out) store->nt_buff = store->nt_chunk + nt_lag;
+
+  store->stage = (float *) malloc((size_t) num_of_trace * store->nt_chunk * sizeof(float));
+
+  return 0;
+}
+
+/*
+ * new file, or file of interrupted run whose samples before num_of_put
+ *  from checkpoint are kept
+ */
+
+int
+seis_store_open(seis_store_t *store, char *fname, int is_restart)
+{
+  if (store->enable == 0) return 0;
+
+  if (store->fp != NULL) fclose(store->fp);
+  sprintf(store->fname, "%s", fname);
+
+  int head[3];
+  if (is_restart == 1 && store->num_of_put > 0)
+  {
+    char magic[8];
+    store->fp = fopen(fname, "r+b");
+    if (store->fp == NULL ||
+        fread(magic, 1, 8, store->fp) != 8 ||
+        fread(head, sizeof(int), 3, store->fp) != 3 ||
+        strncmp(magic, SEIS_STORE_MAGIC, 8) != 0 ||
+        head[0] != store->num_of_trace || head[1] != store->nt_out ||
+        head[2] != store->nt_chunk)
+    {
+      fprintf(stderr,"Error: %s is not trace store of this run\n", fname);
+      fflush(stderr);
+      exit(1);
+    }
+  }
+  else
+  {
+    store->fp = fopen(fname, "w+b");
+    head[0] = store->num_of_trace;
+    head[1] = store->nt_out;
+    head[2] = store->nt_chunk;
+    if (store->fp == NULL ||
+        fwrite(SEIS_STORE_MAGIC, 1, 8, store->fp) != 8 ||
+        fwrite(head, sizeof(int), 3, store->fp) != 3)
+    {
+      fprintf(stderr,"Error: can't create trace store %s\n", fname);
+      fflush(stderr);
+      exit(1);
+    }
+  }
+
+  return 0;
+}
+
+static void *
+seis_store_writer(void *arg)
+{
+  seis_store_t *store = (seis_store_t *) arg;
+
+  size_t nval   = (size_t) store->num_of_trace * store->nt_stage;
+  long   offset = SEIS_STORE_HEAD_SIZE
+                + (long) store->m_stage * store->num_of_trace * sizeof(float);
+
+  if (fseek(store->fp, offset, SEEK_SET) != 0 ||
+      fwrite(store->stage, sizeof(float), nval, store->fp) != nval ||
+      fflush(store->fp) != 0)
+  {
+    fprintf(stderr,"Error: failed to write trace store %s\n", store->fname);
+    store->ierr_writer = 1;
+  }
+
+  return NULL;
+}
+
+/*
+ * write full chunks of samples before num_of_ready, and the last
+ *  shorter one once all samples are ready
+ */
+
+int
+seis_store_put(seis_store_t *store, int num_of_ready)
+{
+  if (store->enable == 0) return 0;
+
+  while (store->num_of_put < num_of_ready &&
+         (num_of_ready - store->num_of_put >= store->nt_chunk ||
+          num_of_ready == store->nt_out))
+  {
+    int m0 = store->num_of_put;
+    int nt = store->nt_out - m0;
+    if (nt > store->nt_chunk) nt = store->nt_chunk;
+
+    // stage is reused
+    seis_store_wait(store);
+
+    for (int itr=0; itr < store->num_of_trace; itr++)
+    {
+      float *ring  = store->trace[itr];
+      float *stage = store->stage + (size_t) itr * nt;
+      for (int m=m0; m < m0+nt; m++) {
+        stage[m-m0] = ring[m % store->nt_buff];
+      }
+    }
+    store->m_stage  = m0;
+    store->nt_stage = nt;
+
+    if (pthread_create(&(store->writer), NULL, seis_store_writer, store) != 0) {
+      fprintf(stderr,"Error: can't create trace store writer thread\n");
+      fflush(stderr);
+      exit(1);
+    }
+    store->is_writing = 1;
+    store->num_of_put += nt;
+  }
+
+  return 0;
+}
+
+int
+seis_store_wait(seis_store_t *store)
+{
+  if (store->is_writing == 0) return 0;
+
+  pthread_join(store->writer, NULL);
+  store->is_writing = 0;
+
+  if (store->ierr_writer != 0) exit(1);
+
+  return 0;
+}
+
+int
+seis_store_close(seis_store_t *store)
+{
+  if (store->enable == 0) return 0;
+
+  seis_store_wait(store);
+  if (store->fp != NULL) fclose(store->fp);
+  store->fp = NULL;
+
+  return 0;
+}
+
+/*
+ * full traces itrace0 to itrace0+ntrace-1 into buff[ntrace][nt_out],
+ *  samples not written are zero
+ */
+
+int
+seis_store_read(seis_store_t *store, int itrace0, int ntrace, float *buff)
+{
+  seis_store_wait(store);
+
+  if (store->fp == NULL) {
+    store->fp = fopen(store->fname, "rb");
+  }
+  if (store->fp == NULL) {
+    fprintf(stderr,"Error: can't open trace store %s\n", store->fname);
+    fflush(stderr);
+    exit(1);
+  }
+
+  memset(buff, 0, sizeof(float) * ntrace * store->nt_out);
+
+  float *block = (float *) malloc((size_t) ntrace * store->nt_chunk * sizeof(float));
+  for (int m0=0; m0 < store->num_of_put; m0 += store->nt_chunk)
+  {
+    int nt = store->nt_out - m0;
+    if (nt > store->nt_chunk) nt = store->nt_chunk;
+
+    size_t nval   = (size_t) ntrace * nt;
+    long   offset = SEIS_STORE_HEAD_SIZE
+                  + ((long) m0 * store->num_of_trace + (long) itrace0 * nt) * sizeof(float);
+    if (fseek(store->fp, offset, SEEK_SET) != 0 ||
+        fread(block, sizeof(float), nval, store->fp) != nval)
+    {
+      fprintf(stderr,"Error: trace store %s is cut at sample %d\n", store->fname, m0);
+      fflush(stderr);
+      exit(1);
+    }
+
+    for (int itr=0; itr < ntrace; itr++) {
+      memcpy(buff + (size_t) itr * store->nt_out + m0, block + (size_t) itr * nt,
+             nt * sizeof(float));
+    }
+  }
+  free(block);
+
+  return 0;
+}
+
+/*
+ * before another ensemble member
+ */
+
+int
+seis_store_reset(seis_store_t *store)
+{
+  seis_store_wait(store);
+  store->num_of_put = 0;
+
+  return 0;
+}
+
+int
+seis_store_free(seis_store_t *store)
+{
+  seis_store_close(store);
+  free(store->trace);
+  if (store->stage != NULL) free(store->stage);
+  store->enable = 0;
+
+  return 0;
+}
@@ -0,0 +1,73 @@
+#ifndef SEIS_STORE_T_H
+#define SEIS_STORE_T_H
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include "constants.h"
+
+/*************************************************
+ * on-disk store of station traces of one thread
+ *  traces are kept in rings of nt_buff samples, sample m at m % nt_buff.
+ *  each nt_chunk samples of all traces are staged and written by a
+ *  background thread as one block, so host memory does not grow with
+ *  nt_total. block b is at offset of b*num_of_trace*nt_chunk samples
+ *  after header, trace by trace, the last one is shorter.
+ *  disabled store keeps full traces, nt_buff = nt_out
+ *************************************************/
+
+#define SEIS_STORE_MAGIC "CGFDSST1"
+#define SEIS_STORE_HEAD_SIZE (8 + 3 * sizeof(int))
+
+typedef struct
+{
+  int    enable;
+  int    num_of_trace;
+  int    nt_out;    // samples of full trace
+  int    nt_chunk;  // samples of each block
+  int    nt_buff;   // samples of ring of each trace
+  float **trace;    // ring of each trace, set by owner
+
+  int    num_of_put; // samples written or being written
+  char   fname[CONST_MAX_STRLEN];
+  FILE  *fp;
+
+  // staged block for background writer
+  float *stage;     // [num_of_trace][nt_chunk]
+  int    nt_stage;
+  int    m_stage;   // first sample of staged block
+  pthread_t writer;
+  int    is_writing;
+  int    ierr_writer;
+} seis_store_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+seis_store_init(seis_store_t *store, int nt_chunk, int nt_lag,
+                int num_of_trace, int nt_out);
+
+int
+seis_store_open(seis_store_t *store, char *fname, int is_restart);
+
+int
+seis_store_put(seis_store_t *store, int num_of_ready);
+
+int
+seis_store_wait(seis_store_t *store);
+
+int
+seis_store_close(seis_store_t *store);
+
+int
+seis_store_read(seis_store_t *store, int itrace0, int ntrace, float *buff);
+
+int
+seis_store_reset(seis_store_t *store);
+
+int
+seis_store_free(seis_store_t *store);
+
+#endif
@@ -0,0 +1,366 @@
+/*******************************************************************************
+ * set-up tasks run by a pool of threads in order of deps
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "constants.h"
+#include "setup_graph.h"
+#include "prof_t.h"
+#include "cuda_common.h"
+
+int
+setup_graph_init(setup_graph_t *graph, int num_of_thread, int myid)
+{
+  graph->myid          = myid;
+  graph->num_of_task   = 0;
+  graph->num_of_thread = num_of_thread > 0 ? num_of_thread : 0;
+  graph->thread        = NULL;
+  graph->is_io_busy    = 0;
+  graph->t_start       = 0.0;
+
+  graph->device = -1;
+  if (graph->num_of_thread > 0) {
+    CUDACHECK(cudaGetDevice(&(graph->device)));
+  }
+
+  pthread_mutex_init(&(graph->mutex), NULL);
+  pthread_cond_init (&(graph->cond),  NULL);
+
+  return 0;
+}
+
+/*
+ * deps must be added before, so order of adding is a valid serial order
+ */
+
+int
+setup_graph_add(setup_graph_t *graph, const char *name,
+                setup_task_func_t func, void *arg, int is_io,
+                int num_of_dep, int *dep)
+{
+  int itask = graph->num_of_task;
+
+  if (itask >= SETUP_GRAPH_MAX_TASK || num_of_dep > SETUP_GRAPH_MAX_DEP) {
+    fprintf(stderr,"Error: too many set-up tasks or deps at %s\n", name);
+    fflush(stderr);
+    exit(1);
+  }
+
+  setup_task_t *task = graph->task + itask;
+
+  snprintf(task->name, SETUP_GRAPH_NAME_STRLEN, "%s", name);
+  task->func       = func;
+  task->arg        = arg;
+  task->is_io      = is_io;
+  task->num_of_dep = 0;
+  for (int n=0; n < num_of_dep; n++)
+  {
+    // negative id is a task not added in this run
+    if (dep[n] < 0) continue;
+    if (dep[n] >= itask) {
+      fprintf(stderr,"Error: dep %d of set-up task %s is not added yet\n", dep[n], name);
+      fflush(stderr);
+      exit(1);
+    }
+    task->dep[task->num_of_dep] = dep[n];
+    task->num_of_dep += 1;
+  }
+  task->state   = SETUP_TASK_WAIT;
+  task->ithread = -1;
+  task->ierr    = 0;
+  task->t_beg   = 0.0;
+  task->t_end   = 0.0;
+
+  graph->num_of_task += 1;
+
+  return itask;
+}
+
+/*
+ * first task which can start now, -1 if none. called with mutex held
+ */
+
+static int
+setup_graph_pick(setup_graph_t *graph)
+{
+  for (int i=0; i < graph->num_of_task; i++)
+  {
+    setup_task_t *task = graph->task + i;
+
+    if (task->state != SETUP_TASK_WAIT) continue;
+    if (task->is_io == 1 && graph->is_io_busy == 1) continue;
+
+    int is_ready = 1;
+    for (int n=0; n < task->num_of_dep; n++) {
+      if (graph->task[task->dep[n]].state != SETUP_TASK_DONE) is_ready = 0;
+    }
+    if (is_ready == 1) return i;
+  }
+
+  return -1;
+}
+
+static int
+setup_graph_has_wait(setup_graph_t *graph)
+{
+  for (int i=0; i < graph->num_of_task; i++) {
+    if (graph->task[i].state == SETUP_TASK_WAIT) return 1;
+  }
+  return 0;
+}
+
+/*
+ * run task itask, called with mutex held and returns with it held
+ */
+
+static void
+setup_graph_run(setup_graph_t *graph, int itask, int ithread)
+{
+  setup_task_t *task = graph->task + itask;
+
+  task->state   = SETUP_TASK_RUN;
+  task->ithread = ithread;
+  if (task->is_io == 1) graph->is_io_busy = 1;
+  pthread_mutex_unlock(&(graph->mutex));
+
+  double t_beg = prof_wtime() - graph->t_start;
+  int ierr = task->func(task->arg);
+  double t_end = prof_wtime() - graph->t_start;
+
+  pthread_mutex_lock(&(graph->mutex));
+  task->t_beg = t_beg;
+  task->t_end = t_end;
+  task->ierr  = ierr;
+  task->state = SETUP_TASK_DONE;
+  if (task->is_io == 1) graph->is_io_busy = 0;
+  pthread_cond_broadcast(&(graph->cond));
+}
+
+typedef struct
+{
+  setup_graph_t *graph;
+  int ithread;
+} setup_worker_arg_t;
+
+static void *
+setup_graph_worker(void *ptr)
+{
+  setup_worker_arg_t *worker = (setup_worker_arg_t *) ptr;
+  setup_graph_t *graph = worker->graph;
+  int ithread = worker->ithread;
+  free(worker);
+
+  // device is selected per thread
+  if (graph->device >= 0) {
+    CUDACHECK(cudaSetDevice(graph->device));
+  }
+
+  pthread_mutex_lock(&(graph->mutex));
+  while (setup_graph_has_wait(graph) == 1)
+  {
+    int itask = setup_graph_pick(graph);
+    if (itask < 0) {
+      pthread_cond_wait(&(graph->cond), &(graph->mutex));
+      continue;
+    }
+    setup_graph_run(graph, itask, ithread);
+  }
+  pthread_mutex_unlock(&(graph->mutex));
+
+  return NULL;
+}
+
+int
+setup_graph_start(setup_graph_t *graph)
+{
+  graph->t_start    = prof_wtime();
+
+  if (graph->num_of_thread == 0) return 0;
+
+  graph->thread = (pthread_t *) malloc(sizeof(pthread_t) * graph->num_of_thread);
+
+  for (int n=0; n < graph->num_of_thread; n++)
+  {
+    setup_worker_arg_t *worker = (setup_worker_arg_t *) malloc(sizeof(setup_worker_arg_t));
+    worker->graph   = graph;
+    worker->ithread = n;
+    if (pthread_create(graph->thread + n, NULL, setup_graph_worker, worker) != 0) {
+      fprintf(stderr,"Error: can't create set-up thread %d\n", n);
+      fflush(stderr);
+      exit(1);
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * block until task itask is done, called by main thread only, so a
+ *  failed task aborts all threads here
+ */
+
+int
+setup_graph_wait(setup_graph_t *graph, int itask)
+{
+  if (itask < 0) return 0;
+
+  pthread_mutex_lock(&(graph->mutex));
+
+  if (graph->num_of_thread == 0)
+  {
+    // serial: run tasks in order of adding up to itask
+    for (int i=0; i <= itask; i++) {
+      if (graph->task[i].state == SETUP_TASK_WAIT) {
+        setup_graph_run(graph, i, -1);
+      }
+    }
+  }
+  else
+  {
+    while (graph->task[itask].state != SETUP_TASK_DONE) {
+      pthread_cond_wait(&(graph->cond), &(graph->mutex));
+    }
+  }
+
+  int ierr = graph->task[itask].ierr;
+  pthread_mutex_unlock(&(graph->mutex));
+
+  if (ierr != 0) {
+    fprintf(stderr,"Error: set-up task %s failed with %d\n", graph->task[itask].name, ierr);
+    fflush(stderr);
+    MPI_Abort(MPI_COMM_WORLD,1);
+  }
+
+  return ierr;
+}
+
+int
+setup_graph_finish(setup_graph_t *graph)
+{
+  if (graph->num_of_task > 0) {
+    setup_graph_wait(graph, graph->num_of_task - 1);
+  }
+
+  // later tasks may be done before earlier ones
+  for (int i=0; i < graph->num_of_task; i++) {
+    setup_graph_wait(graph, i);
+  }
+
+  if (graph->thread != NULL)
+  {
+    for (int n=0; n < graph->num_of_thread; n++) {
+      pthread_join(graph->thread[n], NULL);
+    }
+    free(graph->thread);
+    graph->thread = NULL;
+  }
+
+  pthread_mutex_destroy(&(graph->mutex));
+  pthread_cond_destroy (&(graph->cond));
+
+  return 0;
+}
+
+double
+setup_graph_duration(setup_graph_t *graph, int itask)
+{
+  if (itask < 0) return 0.0;
+
+  return graph->task[itask].t_end - graph->task[itask].t_beg;
+}
+
+/*
+ * timeline of this thread and slowest end of each task over all threads.
+ *  critical path is the longest chain of durations through deps, the
+ *  lower bound of set-up time however many threads are used
+ */
+
+int
+setup_graph_report(setup_graph_t *graph, MPI_Comm comm)
+{
+  int num_of_task = graph->num_of_task;
+
+  double t_end[SETUP_GRAPH_MAX_TASK];
+  double t_end_max[SETUP_GRAPH_MAX_TASK];
+  for (int i=0; i < num_of_task; i++) {
+    t_end[i] = graph->task[i].t_end;
+  }
+  MPI_Reduce(t_end, t_end_max, num_of_task, MPI_DOUBLE, MPI_MAX, 0, comm);
+
+  if (graph->myid != 0) return 0;
+
+  // longest chain ending at each task
+  double t_path[SETUP_GRAPH_MAX_TASK];
+  int    prev  [SETUP_GRAPH_MAX_TASK];
+  double t_serial = 0.0;
+  double t_span   = 0.0;
+  int    ilast    = -1;
+  for (int i=0; i < num_of_task; i++)
+  {
+    setup_task_t *task = graph->task + i;
+    t_path[i] = 0.0;
+    prev  [i] = -1;
+    for (int n=0; n < task->num_of_dep; n++) {
+      int id = task->dep[n];
+      if (t_path[id] > t_path[i]) {
+        t_path[i] = t_path[id];
+        prev  [i] = id;
+      }
+    }
+    t_path[i] += task->t_end - task->t_beg;
+    t_serial  += task->t_end - task->t_beg;
+    if (task->t_end > t_span) t_span = task->t_end;
+    if (ilast < 0 || t_path[i] > t_path[ilast]) ilast = i;
+  }
+
+  // bar of 40 columns over span
+  int ncol = 40;
+  double t_col = (t_span > 0.0) ? t_span / ncol : 1.0;
+
+  fprintf(stdout,"set-up timeline of %d tasks on %d threads, seconds since start:\n",
+          num_of_task, graph->num_of_thread);
+  fprintf(stdout,"  %-16s %-6s %9s %9s %9s %9s\n",
+          "task", "thread", "start", "end", "duration", "end_max");
+  for (int i=0; i < num_of_task; i++)
+  {
+    setup_task_t *task = graph->task + i;
+    char bar[64];
+    for (int n=0; n < ncol; n++) {
+      double t = (n + 0.5) * t_col;
+      bar[n] = (t >= task->t_beg && t < task->t_end) ? '#' : '.';
+    }
+    bar[ncol] = '\0';
+
+    char thread_name[16];
+    if (task->ithread < 0) {
+      sprintf(thread_name, "main");
+    } else {
+      sprintf(thread_name, "%d%s", task->ithread, task->is_io == 1 ? "io" : "");
+    }
+
+    fprintf(stdout,"  %-16s %-6s %9.3f %9.3f %9.3f %9.3f |%s|\n",
+            task->name, thread_name, task->t_beg, task->t_end,
+            task->t_end - task->t_beg, t_end_max[i], bar);
+  }
+
+  // critical path from last to first
+  char path[CONST_MAX_STRLEN];
+  path[0] = '\0';
+  for (int i = ilast; i >= 0; i = prev[i])
+  {
+    char name[CONST_MAX_STRLEN];
+    snprintf(name, CONST_MAX_STRLEN, "%s%s", graph->task[i].name,
+             path[0] == '\0' ? "" : " -> ");
+    if (strlen(path) + strlen(name) + 1 >= CONST_MAX_STRLEN) break;
+    memmove(path + strlen(name), path, strlen(path) + 1);
+    memcpy(path, name, strlen(name));
+  }
+  fprintf(stdout,"  critical path %.3f s: %s\n", ilast >= 0 ? t_path[ilast] : 0.0, path);
+  fprintf(stdout,"  span %.3f s, sum of tasks %.3f s\n", t_span, t_serial);
+  fflush(stdout);
+
+  return 0;
+}
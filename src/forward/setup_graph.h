@@ -0,0 +1,86 @@
+#ifndef SETUP_GRAPH_H
+#define SETUP_GRAPH_H
+
+#include <pthread.h>
+#include <mpi.h>
+
+/*************************************************
+ * set-up as a small dependency graph run by a pool of threads
+ *  a task starts when all its deps are done. io tasks run one at a
+ *  time as netcdf is not thread safe. MPI is only called by the main
+ *  thread, which waits for the tasks it needs and goes on with others.
+ *  with 0 thread, tasks run on the main thread in order of adding
+ *************************************************/
+
+#define SETUP_GRAPH_MAX_TASK    32
+#define SETUP_GRAPH_MAX_DEP      4
+#define SETUP_GRAPH_NAME_STRLEN 32
+
+// state of task
+#define SETUP_TASK_WAIT 0
+#define SETUP_TASK_RUN  1
+#define SETUP_TASK_DONE 2
+
+typedef int (*setup_task_func_t)(void *arg);
+
+typedef struct
+{
+  char name[SETUP_GRAPH_NAME_STRLEN];
+  setup_task_func_t func;
+  void *arg;
+  int   is_io;
+  int   num_of_dep;
+  int   dep[SETUP_GRAPH_MAX_DEP];
+
+  int    state;
+  int    ithread; // -1 for main thread
+  int    ierr;
+  double t_beg;   // seconds since graph start
+  double t_end;
+} setup_task_t;
+
+typedef struct
+{
+  int myid;
+  int device; // cuda device of main thread, set in each worker
+
+  int num_of_task;
+  setup_task_t task[SETUP_GRAPH_MAX_TASK];
+
+  int num_of_thread;
+  pthread_t *thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  int is_io_busy;
+
+  double t_start;
+} setup_graph_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+setup_graph_init(setup_graph_t *graph, int num_of_thread, int myid);
+
+int
+setup_graph_add(setup_graph_t *graph, const char *name,
+                setup_task_func_t func, void *arg, int is_io,
+                int num_of_dep, int *dep);
+
+int
+setup_graph_start(setup_graph_t *graph);
+
+int
+setup_graph_wait(setup_graph_t *graph, int itask);
+
+int
+setup_graph_finish(setup_graph_t *graph);
+
+double
+setup_graph_duration(setup_graph_t *graph, int itask);
+
+int
+setup_graph_report(setup_graph_t *graph, MPI_Comm comm);
+
+#endif
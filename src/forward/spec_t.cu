@@ -0,0 +1,86 @@
+/*******************************************************************************
+ * streaming Fourier spectra of station traces
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "constants.h"
+#include "spec_t.h"
+
+int
+spec_init(spec_t *spec, int num_of_freq, float *freq, float dt, int num_of_trace)
+{
+  spec->enable       = (num_of_freq > 0) ? 1 : 0;
+  spec->num_of_freq  = num_of_freq > 0 ? num_of_freq : 0;
+  spec->num_of_trace = num_of_trace;
+  spec->num_of_step  = 0;
+  spec->dt           = dt;
+  spec->freq         = NULL;
+  spec->coef         = NULL;
+  spec->state        = NULL;
+
+  if (spec->enable == 0) return 0;
+
+  spec->freq = (float  *) malloc(num_of_freq * sizeof(float));
+  spec->coef = (double *) malloc(num_of_freq * sizeof(double));
+  for (int n=0; n < num_of_freq; n++)
+  {
+    spec->freq[n] = freq[n];
+    spec->coef[n] = 2.0 * cos(2.0 * PI * freq[n] * dt);
+  }
+
+  spec->state = (double *) calloc((size_t) num_of_trace * num_of_freq * 2 + 1,
+                                  sizeof(double));
+
+  return 0;
+}
+
+/*
+ * before another ensemble member
+ */
+
+int
+spec_reset(spec_t *spec)
+{
+  if (spec->enable == 0) return 0;
+
+  memset(spec->state, 0, sizeof(double) * spec->num_of_trace * spec->num_of_freq * 2);
+  spec->num_of_step = 0;
+
+  return 0;
+}
+
+/*
+ * amplitude |X(f)| of trace itrace at all frequencies
+ */
+
+int
+spec_amp(spec_t *spec, int itrace, float *amp)
+{
+  double *s = spec->state + (size_t) itrace * spec->num_of_freq * 2;
+  for (int n=0; n < spec->num_of_freq; n++)
+  {
+    double wdt = 2.0 * PI * spec->freq[n] * spec->dt;
+    double re  = s[2*n] - cos(wdt) * s[2*n+1];
+    double im  = sin(wdt) * s[2*n+1];
+    amp[n] = (float) (spec->dt * sqrt(re * re + im * im));
+  }
+
+  return 0;
+}
+
+int
+spec_free(spec_t *spec)
+{
+  if (spec->enable == 0) return 0;
+
+  free(spec->freq);
+  free(spec->coef);
+  free(spec->state);
+  spec->enable = 0;
+
+  return 0;
+}
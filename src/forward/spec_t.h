@@ -0,0 +1,59 @@
+#ifndef SPEC_T_H
+#define SPEC_T_H
+
+/*************************************************
+ * streaming Fourier spectra of station traces at fixed frequencies
+ *  each step of each trace advances a Goertzel recurrence of every
+ *  frequency, s(n) = x(n) + 2cos(w*dt)*s(n-1) - s(n-2), so spectra
+ *  need no stored trace. after N steps
+ *   X(f) = dt * sum x(n) exp(-i*w*n*dt)
+ *        = dt * exp(-i*w*(N-1)*dt) * (s(N-1) - exp(-i*w*dt)*s(N-2))
+ *  time is from the first step. state is double, the recurrence loses
+ *  precision at low frequency in float
+ *************************************************/
+
+typedef struct
+{
+  int    enable;
+  int    num_of_freq;
+  int    num_of_trace;
+  int    num_of_step;  // steps pushed
+  float  dt;
+  float *freq;
+  double *coef;   // [num_of_freq] 2cos(w*dt)
+  double *state;  // [num_of_trace][num_of_freq][2], s(n-1) s(n-2)
+} spec_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+spec_init(spec_t *spec, int num_of_freq, float *freq, float dt, int num_of_trace);
+
+int
+spec_reset(spec_t *spec);
+
+int
+spec_amp(spec_t *spec, int itrace, float *amp);
+
+int
+spec_free(spec_t *spec);
+
+/*
+ * input of next step to trace itrace
+ */
+
+static inline void
+spec_push(spec_t *spec, int itrace, float v)
+{
+  double *s = spec->state + (size_t) itrace * spec->num_of_freq * 2;
+  for (int n=0; n < spec->num_of_freq; n++)
+  {
+    double s0 = v + spec->coef[n] * s[2*n] - s[2*n+1];
+    s[2*n+1] = s[2*n];
+    s[2*n]   = s0;
+  }
+}
+
+#endif
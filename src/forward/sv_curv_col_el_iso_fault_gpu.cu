@@ -60,20 +60,11 @@ sv_curv_col_el_iso_fault_onestage(
   size_t siz_iz = gd_d.siz_iz;
   size_t siz_slice_yz = gd_d.siz_slice_yz;
 
-  float *xi_x  = metric_d.xi_x;
-  float *xi_y  = metric_d.xi_y;
-  float *xi_z  = metric_d.xi_z;
-  float *et_x  = metric_d.eta_x;
-  float *et_y  = metric_d.eta_y;
-  float *et_z  = metric_d.eta_z;
-  float *zt_x  = metric_d.zeta_x;
-  float *zt_y  = metric_d.zeta_y;
-  float *zt_z  = metric_d.zeta_z;
-  float *jac3d = metric_d.jac;
-
   float *lam3d = md_d.lambda;
   float * mu3d = md_d.mu;
   float *slw3d = md_d.rho;
+  void  *mat_id = md_d.mat_id;
+  int mat_nbyte = md_d.mat_nbyte;
 
   int idir = fdx_op->dir;
   int jdir = fdy_op->dir;
@@ -126,10 +117,8 @@ sv_curv_col_el_iso_fault_onestage(
                                              f_T3x, f_T3y, f_T3z,
                                              f_hVx, f_hVy, f_hVz, 
                                              f_T1x, f_T1y, f_T1z,
-                                             xi_x, xi_y, xi_z,
-                                             et_x, et_y, et_z,
-                                             zt_x, zt_y, zt_z,
-                                             jac3d, slw3d, isfree,
+                                             metric_d,
+                                             slw3d, mat_id, mat_nbyte, isfree,
                                              nj1, nj, nk1, nk, ny,
                                              siz_iy, siz_iz, siz_slice_yz,
                                              idir, jdir, kdir, id, F, FC);
@@ -151,10 +140,9 @@ sv_curv_col_el_iso_fault_onestage(
                                                   f_hT2x, f_hT2y, f_hT2z,
                                                   f_hT3x, f_hT3y, f_hT3z, 
                                                   f_hT1x, f_hT1y, f_hT1z,
-                                                  xi_x, xi_y, xi_z, 
-                                                  et_x, et_y, et_z, 
-                                                  zt_x, zt_y, zt_z,
-                                                  lam3d, mu3d, slw3d, 
+                                                  metric_d,
+                                                  lam3d, mu3d, slw3d,
+                                                  mat_id, mat_nbyte,
                                                   matVx2Vz, matVy2Vz,
                                                   isfree, imethod,
                                                   nj1, nj, nk1, nk, ny,
@@ -171,10 +159,9 @@ sv_curv_col_el_iso_fault_onestage(
                                                   f_hT2x, f_hT2y, f_hT2z,
                                                   f_hT3x, f_hT3y, f_hT3z,
                                                   f_hT1x, f_hT1y, f_hT1z,
-                                                  xi_x, xi_y, xi_z,
-                                                  et_x, et_y, et_z,
-                                                  zt_x, zt_y, zt_z,
+                                                  metric_d,
                                                   lam3d, mu3d, slw3d,
+                                                  mat_id, mat_nbyte,
                                                   matVx2Vz, matVy2Vz, 
                                                   isfree, imethod,
                                                   nj1, nj, nk1, nk, ny,
@@ -197,10 +184,9 @@ void sv_curv_col_el_iso_rhs_fault_velo_gpu(
                        float * f_T3x, float * f_T3y, float * f_T3z,
                        float * f_hVx, float * f_hVy, float * f_hVz,
                        float * f_T1x, float * f_T1y, float * f_T1z,
-                       float * xi_x,  float * xi_y, float * xi_z,
-                       float * et_x,  float * et_y, float * et_z,
-                       float * zt_x,  float * zt_y, float * zt_z,
-                       float * jac3d, float * slw3d,  
+                       gd_metric_t metric_d,
+                       float * slw3d,
+                       void * mat_id, int mat_nbyte,
                        int isfree, int nj1, int nj, int nk1, int nk, int ny, 
                        size_t siz_iy, size_t siz_iz, size_t siz_slice_yz,
                        int idir, int jdir, int kdir,
@@ -215,6 +201,7 @@ void sv_curv_col_el_iso_rhs_fault_velo_gpu(
 
   size_t iptr, iptr_f;
   float rrhojac;
+  gd_metric_pt_t mt;
   float *T2x_ptr;
   float *T2y_ptr;
   float *T2z_ptr;
@@ -242,19 +229,24 @@ void sv_curv_col_el_iso_rhs_fault_velo_gpu(
       for (int l=-3; l<=3; l++)
       {
         iptr = (i+l) + (iy+nj1) * siz_iy + (iz+nk1) * siz_iz;
-        vecT1x[l+3] = jac3d[iptr]*(xi_x[iptr]*Txx[iptr] + xi_y[iptr]*Txy[iptr] + xi_z[iptr]*Txz[iptr]);
-        vecT1y[l+3] = jac3d[iptr]*(xi_x[iptr]*Txy[iptr] + xi_y[iptr]*Tyy[iptr] + xi_z[iptr]*Tyz[iptr]);
-        vecT1z[l+3] = jac3d[iptr]*(xi_x[iptr]*Txz[iptr] + xi_y[iptr]*Tyz[iptr] + xi_z[iptr]*Tzz[iptr]);
+        mt = gd_metric_get(&metric_d, iptr);
+        vecT1x[l+3] = mt.jac*(mt.xi_x*Txx[iptr] + mt.xi_y*Txy[iptr] + mt.xi_z*Txz[iptr]);
+        vecT1y[l+3] = mt.jac*(mt.xi_x*Txy[iptr] + mt.xi_y*Tyy[iptr] + mt.xi_z*Tyz[iptr]);
+        vecT1z[l+3] = mt.jac*(mt.xi_x*Txz[iptr] + mt.xi_y*Tyz[iptr] + mt.xi_z*Tzz[iptr]);
 
         iptr = i + (iy+nj1+l) * siz_iy + (iz+nk1) * siz_iz;
-        vecT2x[l+3] = jac3d[iptr]*(et_x[iptr]*Txx[iptr] + et_y[iptr]*Txy[iptr] + et_z[iptr]*Txz[iptr]);
-        vecT2y[l+3] = jac3d[iptr]*(et_x[iptr]*Txy[iptr] + et_y[iptr]*Tyy[iptr] + et_z[iptr]*Tyz[iptr]);
-        vecT2z[l+3] = jac3d[iptr]*(et_x[iptr]*Txz[iptr] + et_y[iptr]*Tyz[iptr] + et_z[iptr]*Tzz[iptr]);
+
+        mt = gd_metric_get(&metric_d, iptr);
+        vecT2x[l+3] = mt.jac*(mt.eta_x*Txx[iptr] + mt.eta_y*Txy[iptr] + mt.eta_z*Txz[iptr]);
+        vecT2y[l+3] = mt.jac*(mt.eta_x*Txy[iptr] + mt.eta_y*Tyy[iptr] + mt.eta_z*Tyz[iptr]);
+        vecT2z[l+3] = mt.jac*(mt.eta_x*Txz[iptr] + mt.eta_y*Tyz[iptr] + mt.eta_z*Tzz[iptr]);
 
         iptr = i + (iy+nj1) * siz_iy + (iz+nk1+l) * siz_iz;
-        vecT3x[l+3] = jac3d[iptr]*(zt_x[iptr]*Txx[iptr] + zt_y[iptr]*Txy[iptr] + zt_z[iptr]*Txz[iptr]);
-        vecT3y[l+3] = jac3d[iptr]*(zt_x[iptr]*Txy[iptr] + zt_y[iptr]*Tyy[iptr] + zt_z[iptr]*Tyz[iptr]);
-        vecT3z[l+3] = jac3d[iptr]*(zt_x[iptr]*Txz[iptr] + zt_y[iptr]*Tyz[iptr] + zt_z[iptr]*Tzz[iptr]);
+
+        mt = gd_metric_get(&metric_d, iptr);
+        vecT3x[l+3] = mt.jac*(mt.zeta_x*Txx[iptr] + mt.zeta_y*Txy[iptr] + mt.zeta_z*Txz[iptr]);
+        vecT3y[l+3] = mt.jac*(mt.zeta_x*Txy[iptr] + mt.zeta_y*Tyy[iptr] + mt.zeta_z*Tyz[iptr]);
+        vecT3z[l+3] = mt.jac*(mt.zeta_x*Txz[iptr] + mt.zeta_y*Tyz[iptr] + mt.zeta_z*Tzz[iptr]);
       }
 
       iptr_f = (iy+nj1) + (iz+nk1) * ny + 3 * siz_slice_yz;
@@ -313,7 +305,8 @@ void sv_curv_col_el_iso_rhs_fault_velo_gpu(
       M_FD_VEC(DzT3z, vecT3z+3, kdir);
 
       iptr = i + (iy+nj1) * siz_iy + (iz+nk1) * siz_iz;
-      rrhojac = slw3d[iptr] / jac3d[iptr];
+      mt = gd_metric_get(&metric_d, iptr);
+      rrhojac = slw3d[md_mat_iptr(mat_id, mat_nbyte, iptr)] / mt.jac;
 
       hVx[iptr] = (DxT1x+DyT2x+DzT3x)*rrhojac;
       hVy[iptr] = (DxT1y+DyT2y+DzT3y)*rrhojac;
@@ -419,7 +412,8 @@ void sv_curv_col_el_iso_rhs_fault_velo_gpu(
 
       iptr = i0 + (iy+nj1) * siz_iy + (iz+nk1) * siz_iz;
       iptr_f = (iy+nj1) + (iz+nk1) * ny + m * siz_slice_yz; 
-      rrhojac = 1.0 / (FC_thisone->rho_f[iptr_f] * jac3d[iptr]);
+      mt = gd_metric_get(&metric_d, iptr);
+      rrhojac = 1.0 / (FC_thisone->rho_f[iptr_f] * mt.jac);
       f_hVx[iptr_f] = (DxT1x+DyT2x+DzT3x)*rrhojac;
       f_hVy[iptr_f] = (DxT1y+DyT2y+DzT3y)*rrhojac;
       f_hVz[iptr_f] = (DxT1z+DyT2z+DzT3z)*rrhojac;
@@ -437,10 +431,9 @@ void sv_curv_col_el_iso_rhs_fault_stress_F_gpu(
                        float * f_hT2x, float * f_hT2y, float * f_hT2z,
                        float * f_hT3x, float * f_hT3y, float * f_hT3z,
                        float * f_hT1x,float * f_hT1y,float * f_hT1z,
-                       float * xi_x,  float * xi_y, float * xi_z,
-                       float * et_x,  float * et_y, float * et_z,
-                       float * zt_x,  float * zt_y, float * zt_z,
-                       float * lam3d, float * mu3d, float * slw3d, 
+                       gd_metric_t metric_d,
+                       float * lam3d, float * mu3d, float * slw3d,
+                       void * mat_id, int mat_nbyte,
                        float *matVx2Vz, float *matVy2Vz,
                        int isfree, int imethod,
                        int nj1, int nj, int nk1, int nk, int ny, 
@@ -455,7 +448,7 @@ void sv_curv_col_el_iso_rhs_fault_stress_F_gpu(
   fault_coef_one_t *FC_thisone = FC.fault_coef_one + id;
   int i0 = F.fault_index[id] + 3; //fault plane x index with ghost
 
-  size_t iptr, iptr_f;
+  size_t iptr, iptr_f, iptr_md;
   size_t idx;
   float *Vx_ptr;
   float *Vy_ptr;
@@ -466,6 +459,7 @@ void sv_curv_col_el_iso_rhs_fault_stress_F_gpu(
   float xix, xiy, xiz;
   float etx, ety, etz;
   float ztx, zty, ztz;
+  gd_metric_pt_t mt;
   float mu, lam, lam2mu;
 
   float DxVx[8],DxVy[8],DxVz[8];
@@ -1123,11 +1117,13 @@ void sv_curv_col_el_iso_rhs_fault_stress_F_gpu(
       }
 
       iptr = (i0+m) + (iy+nj1) * siz_iy + (iz+nk1) * siz_iz;
-      lam = lam3d[iptr]; mu = mu3d[iptr];
+      iptr_md = md_mat_iptr(mat_id, mat_nbyte, iptr);
+      lam = lam3d[iptr_md]; mu = mu3d[iptr_md];
       lam2mu  = lam + 2.0*mu;
-      xix = xi_x[iptr]; xiy = xi_y[iptr]; xiz = xi_z[iptr];
-      etx = et_x[iptr]; ety = et_y[iptr]; etz = et_z[iptr];
-      ztx = zt_x[iptr]; zty = zt_y[iptr]; ztz = zt_z[iptr];
+      mt = gd_metric_get(&metric_d, iptr);
+      xix = mt.xi_x;  xiy = mt.xi_y;  xiz = mt.xi_z;
+      etx = mt.eta_x; ety = mt.eta_y; etz = mt.eta_z;
+      ztx = mt.zeta_x; zty = mt.zeta_y; ztz = mt.zeta_z;
 
       hTxx[iptr] =   lam2mu * ( xix*DxVx[n] + etx*DyVx[n] + ztx*DzVx[n])
                    + lam    * ( xiy*DxVy[n] + ety*DyVy[n] + zty*DzVy[n]
@@ -1167,10 +1163,9 @@ void sv_curv_col_el_iso_rhs_fault_stress_B_gpu(
                        float * f_hT2x, float * f_hT2y, float * f_hT2z,
                        float * f_hT3x, float * f_hT3y, float * f_hT3z,
                        float * f_hT1x,float * f_hT1y,float * f_hT1z,
-                       float * xi_x,  float * xi_y, float * xi_z,
-                       float * et_x,  float * et_y, float * et_z,
-                       float * zt_x,  float * zt_y, float * zt_z,
-                       float * lam3d, float * mu3d, float * slw3d, 
+                       gd_metric_t metric_d,
+                       float * lam3d, float * mu3d, float * slw3d,
+                       void * mat_id, int mat_nbyte,
                        float *matVx2Vz, float *matVy2Vz,
                        int isfree, int imethod,
                        int nj1, int nj, int nk1, int nk, int ny, 
@@ -1185,7 +1180,7 @@ void sv_curv_col_el_iso_rhs_fault_stress_B_gpu(
   fault_coef_one_t *FC_thisone = FC.fault_coef_one + id;
   int i0 = F.fault_index[id] + 3; //fault plane x index with ghost
 
-  size_t iptr, iptr_f;
+  size_t iptr, iptr_f, iptr_md;
   size_t idx;
   float *Vx_ptr;
   float *Vy_ptr;
@@ -1196,6 +1191,7 @@ void sv_curv_col_el_iso_rhs_fault_stress_B_gpu(
   float xix, xiy, xiz;
   float etx, ety, etz;
   float ztx, zty, ztz;
+  gd_metric_pt_t mt;
   float mu, lam, lam2mu;
 
   float DxVx[8],DxVy[8],DxVz[8];
@@ -1844,11 +1840,13 @@ void sv_curv_col_el_iso_rhs_fault_stress_B_gpu(
       }
 
       iptr = (i0+m) + (iy+nj1) * siz_iy + (iz+nk1) * siz_iz;
-      lam = lam3d[iptr]; mu = mu3d[iptr];
+      iptr_md = md_mat_iptr(mat_id, mat_nbyte, iptr);
+      lam = lam3d[iptr_md]; mu = mu3d[iptr_md];
       lam2mu  = lam + 2.0*mu;
-      xix = xi_x[iptr]; xiy = xi_y[iptr]; xiz = xi_z[iptr];
-      etx = et_x[iptr]; ety = et_y[iptr]; etz = et_z[iptr];
-      ztx = zt_x[iptr]; zty = zt_y[iptr]; ztz = zt_z[iptr];
+      mt = gd_metric_get(&metric_d, iptr);
+      xix = mt.xi_x;  xiy = mt.xi_y;  xiz = mt.xi_z;
+      etx = mt.eta_x; ety = mt.eta_y; etz = mt.eta_z;
+      ztx = mt.zeta_x; zty = mt.zeta_y; ztz = mt.zeta_z;
 
       hTxx[iptr] =   lam2mu * ( xix*DxVx[n] + etx*DyVx[n] + ztx*DzVx[n])
                    + lam    * ( xiy*DxVy[n] + ety*DyVy[n] + zty*DzVy[n]
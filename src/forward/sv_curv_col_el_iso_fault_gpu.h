@@ -41,10 +41,9 @@ void sv_curv_col_el_iso_rhs_fault_velo_gpu(
                        float * f_T3x, float * f_T3y, float * f_T3z,
                        float * f_hVx, float * f_hVy, float * f_hVz,
                        float * f_T1x, float * f_T1y, float * f_T1z,
-                       float * xi_x,  float * xi_y, float * xi_z,
-                       float * et_x,  float * et_y, float * et_z,
-                       float * zt_x,  float * zt_y, float * zt_z,
-                       float * jac3d, float * slw3d,  
+                       gd_metric_t metric_d,
+                       float * slw3d,
+                       void * mat_id, int mat_nbyte,
                        int isfree, int nj1, int nj, int nk1, int nk, int ny, 
                        size_t siz_iy, size_t siz_iz, size_t siz_slice_yz,
                        int idir, int jdir, int kdir,
@@ -59,10 +58,9 @@ void sv_curv_col_el_iso_rhs_fault_stress_F_gpu(
                        float * f_hT2x, float * f_hT2y, float * f_hT2z,
                        float * f_hT3x, float * f_hT3y, float * f_hT3z,
                        float * f_hT1x,float * f_hT1y,float * f_hT1z,
-                       float * xi_x,  float * xi_y, float * xi_z,
-                       float * et_x,  float * et_y, float * et_z,
-                       float * zt_x,  float * zt_y, float * zt_z,
-                       float * lam3d, float * mu3d, float * slw3d, 
+                       gd_metric_t metric_d,
+                       float * lam3d, float * mu3d, float * slw3d,
+                       void * mat_id, int mat_nbyte,
                        float *matVx2Vz, float *matVy2Vz,
                        int isfree, int imethod,
                        int nj1, int nj, int nk1, int nk, int ny, 
@@ -79,10 +77,9 @@ void sv_curv_col_el_iso_rhs_fault_stress_B_gpu(
                        float * f_hT2x, float * f_hT2y, float * f_hT2z,
                        float * f_hT3x, float * f_hT3y, float * f_hT3z,
                        float * f_hT1x,float * f_hT1y,float * f_hT1z,
-                       float * xi_x,  float * xi_y, float * xi_z,
-                       float * et_x,  float * et_y, float * et_z,
-                       float * zt_x,  float * zt_y, float * zt_z,
-                       float * lam3d, float * mu3d, float * slw3d, 
+                       gd_metric_t metric_d,
+                       float * lam3d, float * mu3d, float * slw3d,
+                       void * mat_id, int mat_nbyte,
                        float *matVx2Vz, float *matVy2Vz,
                        int isfree, int imethod,
                        int nj1, int nj, int nk1, int nk, int ny, 
@@ -34,6 +34,7 @@ sv_curv_col_el_iso_onestage(
   fd_op_t *fdx_op,
   fd_op_t *fdy_op,
   fd_op_t *fdz_op,
+  prof_t  *prof,
   const int myid)
 {
   // local pointer get each vars
@@ -56,20 +57,11 @@ sv_curv_col_el_iso_onestage(
   float *hTyz  = rhs_d   + wav_d.Tyz_pos; 
   float *hTxy  = rhs_d   + wav_d.Txy_pos; 
 
-  float *xi_x  = metric_d.xi_x;
-  float *xi_y  = metric_d.xi_y;
-  float *xi_z  = metric_d.xi_z;
-  float *et_x  = metric_d.eta_x;
-  float *et_y  = metric_d.eta_y;
-  float *et_z  = metric_d.eta_z;
-  float *zt_x  = metric_d.zeta_x;
-  float *zt_y  = metric_d.zeta_y;
-  float *zt_z  = metric_d.zeta_z;
-  float *jac3d = metric_d.jac;
-
   float *lam3d = md_d.lambda;
   float * mu3d = md_d.mu;
   float *slw3d = md_d.rho;
+  void  *mat_id = md_d.mat_id;
+  int mat_nbyte = md_d.mat_nbyte;
 
   // grid size
   int ni1 = gd_d.ni1;
@@ -146,6 +138,7 @@ sv_curv_col_el_iso_onestage(
   CUDACHECK(cudaMemcpy(lfdy_indx_d,lfdy_indx,fdy_len*sizeof(int),cudaMemcpyHostToDevice));
   CUDACHECK(cudaMemcpy(lfdz_indx_d,lfdz_indx,fdz_len*sizeof(int),cudaMemcpyHostToDevice));
 
+  prof_beg(prof, PROF_RHS_INNER);
   {
     dim3 block(8,8,8);
     dim3 grid;
@@ -155,8 +148,9 @@ sv_curv_col_el_iso_onestage(
     sv_curv_col_el_iso_rhs_inner_gpu <<<grid, block>>> (
                         Vx,Vy,Vz,Txx,Tyy,Tzz,Txz,Tyz,Txy,
                         hVx,hVy,hVz,hTxx,hTyy,hTzz,hTxz,hTyz,hTxy,
-                        xi_x, xi_y, xi_z, et_x, et_y, et_z, zt_x, zt_y, zt_z,
+                        metric_d,
                         lam3d, mu3d, slw3d,
+                        mat_id, mat_nbyte,
                         ni1,ni,nj1,nj,nk1,nk,siz_iy,siz_iz,
                         lfdx_shift_d, lfdx_coef_d,
                         lfdy_shift_d, lfdy_coef_d,
@@ -164,11 +158,13 @@ sv_curv_col_el_iso_onestage(
                         myid);
     CUDACHECK(cudaDeviceSynchronize());
   }
+  prof_end(prof, PROF_RHS_INNER);
 
   // free, abs, source in turn
   // free surface at z2
   if (bdryfree_d.is_sides_free[2][1] == 1)
   {
+    prof_beg(prof, PROF_FREE_SURFACE);
     // tractiong
     {
       dim3 block(8,8);
@@ -177,8 +173,9 @@ sv_curv_col_el_iso_onestage(
       grid.y = (nj+block.y-1)/block.y;
       sv_curv_col_el_iso_rhs_timg_z2_gpu  <<<grid, block>>> (
                           Txx,Tyy,Tzz,Txz,Tyz,Txy,hVx,hVy,hVz,
-                          xi_x, xi_y, xi_z, et_x, et_y, et_z, zt_x, zt_y, zt_z,
-                          jac3d, slw3d,
+                          metric_d,
+                          slw3d,
+                          mat_id, mat_nbyte,
                           ni1,ni,nj1,nj,nk1,nk2,siz_iy,siz_iz,
                           fdx_len, lfdx_indx_d, 
                           fdy_len, lfdy_indx_d, 
@@ -195,29 +192,34 @@ sv_curv_col_el_iso_onestage(
       grid.y = (nj+block.y-1)/block.y;
       sv_curv_col_el_iso_rhs_vlow_z2_gpu  <<<grid, block>>> (
                         Vx,Vy,Vz,hTxx,hTyy,hTzz,hTxz,hTyz,hTxy,
-                        xi_x, xi_y, xi_z, et_x, et_y, et_z, zt_x, zt_y, zt_z,
+                        metric_d,
                         lam3d, mu3d, slw3d,
+                        mat_id, mat_nbyte,
                         matVx2Vz,matVy2Vz,
                         ni1,ni,nj1,nj,nk1,nk2,siz_iy,siz_iz,
                         idir, jdir, kdir,
                         myid);
       CUDACHECK(cudaDeviceSynchronize());
     }
+    prof_end(prof, PROF_FREE_SURFACE);
   }
 
   // cfs-pml, loop face inside
   if (bdrypml_d.is_enable_pml == 1)
   {
+    prof_beg(prof, PROF_PML);
     sv_curv_col_el_iso_rhs_cfspml(Vx,Vy,Vz,Txx,Tyy,Tzz,Txz,Tyz,Txy,
                                   hVx,hVy,hVz,hTxx,hTyy,hTzz,hTxz,hTyz,hTxy,
-                                  xi_x, xi_y, xi_z, et_x, et_y, et_z, zt_x, zt_y, zt_z,
+                                  metric_d,
                                   lam3d, mu3d, slw3d,
+                                  mat_id, mat_nbyte,
                                   nk2, siz_iy,siz_iz,
                                   lfdx_shift_d, lfdx_coef_d,
                                   lfdy_shift_d, lfdy_coef_d,
                                   lfdz_shift_d, lfdz_coef_d,
                                   bdrypml_d, bdryfree_d,
                                   myid);
+    prof_end(prof, PROF_PML);
   }
   
   // end func
@@ -236,10 +238,9 @@ sv_curv_col_el_iso_rhs_inner_gpu(
     float * hVx , float * hVy , float * hVz ,
     float * hTxx, float * hTyy, float * hTzz,
     float * hTxz, float * hTyz, float * hTxy,
-    float * xi_x, float * xi_y, float * xi_z,
-    float * et_x, float * et_y, float * et_z,
-    float * zt_x, float * zt_y, float * zt_z,
+    gd_metric_t metric_d,
     float * lam3d, float * mu3d, float * slw3d,
+    void * mat_id, int mat_nbyte,
     int ni1, int ni, int nj1, int nj, int nk1, int nk,
     size_t siz_iy, size_t siz_iz,
     int * lfdx_shift, float * lfdx_coef,
@@ -253,6 +254,7 @@ sv_curv_col_el_iso_rhs_inner_gpu(
   float DzTxx,DzTyy,DzTzz,DzTxy,DzTxz,DzTyz,DzVx,DzVy,DzVz;
   float lam,mu,lam2mu,slw;
   float xix,xiy,xiz,etx,ety,etz,ztx,zty,ztz;
+  gd_metric_pt_t mt;
 
   float * Vx_ptr;
   float * Vy_ptr;
@@ -329,20 +331,22 @@ sv_curv_col_el_iso_rhs_inner_gpu(
     M_FD_SHIFT_PTR_MACDRP_COEF(DzTxy, Txy_ptr, lfdz_shift, lfdz_coef);
     
     // metric
-    xix = xi_x[iptr];
-    xiy = xi_y[iptr];
-    xiz = xi_z[iptr];
-    etx = et_x[iptr];
-    ety = et_y[iptr];
-    etz = et_z[iptr];
-    ztx = zt_x[iptr];
-    zty = zt_y[iptr];
-    ztz = zt_z[iptr];
+    mt = gd_metric_get(&metric_d, iptr);
+    xix = mt.xi_x;
+    xiy = mt.xi_y;
+    xiz = mt.xi_z;
+    etx = mt.eta_x;
+    ety = mt.eta_y;
+    etz = mt.eta_z;
+    ztx = mt.zeta_x;
+    zty = mt.zeta_y;
+    ztz = mt.zeta_z;
 
     // medium
-    lam = lam3d[iptr];
-    mu  =  mu3d[iptr];
-    slw = slw3d[iptr];
+    size_t iptr_md = md_mat_iptr(mat_id, mat_nbyte, iptr);
+    lam = lam3d[iptr_md];
+    mu  =  mu3d[iptr_md];
+    slw = slw3d[iptr_md];
     lam2mu = lam + 2.0 * mu;
 
     // moment equation
@@ -400,10 +404,9 @@ sv_curv_col_el_iso_rhs_timg_z2_gpu(
     float *  Txx, float *  Tyy, float *  Tzz,
     float *  Txz, float *  Tyz, float *  Txy,
     float * hVx , float * hVy , float * hVz ,
-    float * xi_x, float * xi_y, float * xi_z,
-    float * et_x, float * et_y, float * et_z,
-    float * zt_x, float * zt_y, float * zt_z,
-    float * jac3d, float * slw3d,
+    gd_metric_t metric_d,
+    float * slw3d,
+    void * mat_id, int mat_nbyte,
     int ni1, int ni, int nj1, int nj, int nk1, int nk2,
     size_t siz_iy, size_t siz_iz, 
     int fdx_len, int * fdx_indx, 
@@ -416,6 +419,7 @@ sv_curv_col_el_iso_rhs_timg_z2_gpu(
   float DxTx,DyTy,DzTz;
   float slwjac;
   float xix,xiy,xiz,etx,ety,etz,ztx,zty,ztz;
+  gd_metric_pt_t mt;
 
   // to save traction and other two dir force var
   float vecxi[5] = {0.0};
@@ -444,18 +448,19 @@ sv_curv_col_el_iso_rhs_timg_z2_gpu(
     {
       size_t iptr = (ix+ni1) + (iy+nj1) * siz_iy + k * siz_iz;
       // metric
-      xix = xi_x[iptr];
-      xiy = xi_y[iptr];
-      xiz = xi_z[iptr];
-      etx = et_x[iptr];
-      ety = et_y[iptr];
-      etz = et_z[iptr];
-      ztx = zt_x[iptr];
-      zty = zt_y[iptr];
-      ztz = zt_z[iptr];
+      mt = gd_metric_get(&metric_d, iptr);
+      xix = mt.xi_x;
+      xiy = mt.xi_y;
+      xiz = mt.xi_z;
+      etx = mt.eta_x;
+      ety = mt.eta_y;
+      etz = mt.eta_z;
+      ztx = mt.zeta_x;
+      zty = mt.zeta_y;
+      ztz = mt.zeta_z;
 
       // slowness and jac
-      slwjac = slw3d[iptr] / jac3d[iptr];
+      slwjac = slw3d[md_mat_iptr(mat_id, mat_nbyte, iptr)] / mt.jac;
 
       //
       // for hVx
@@ -464,23 +469,26 @@ sv_curv_col_el_iso_rhs_timg_z2_gpu(
       // transform to conservative vars
       for (n=0; n<fdx_len; n++) {
         iptr4vec = iptr + fdx_indx[n];
-        vecxi[n] = jac3d[iptr4vec] * (  xi_x[iptr4vec] * Txx[iptr4vec]
-                                      + xi_y[iptr4vec] * Txy[iptr4vec]
-                                      + xi_z[iptr4vec] * Txz[iptr4vec] );
+        mt = gd_metric_get(&metric_d, iptr4vec);
+        vecxi[n] = mt.jac * (  mt.xi_x * Txx[iptr4vec]
+                             + mt.xi_y * Txy[iptr4vec]
+                             + mt.xi_z * Txz[iptr4vec] );
       }
       for (n=0; n<fdy_len; n++) {
         iptr4vec = iptr + fdy_indx[n] * siz_iy;
-        vecet[n] = jac3d[iptr4vec] * (  et_x[iptr4vec] * Txx[iptr4vec]
-                                      + et_y[iptr4vec] * Txy[iptr4vec]
-                                      + et_z[iptr4vec] * Txz[iptr4vec] );
+        mt = gd_metric_get(&metric_d, iptr4vec);
+        vecet[n] = mt.jac * (  mt.eta_x * Txx[iptr4vec]
+                             + mt.eta_y * Txy[iptr4vec]
+                             + mt.eta_z * Txz[iptr4vec] );
       }
 
       // blow surface -> cal
       for (n=0; n<n_free; n++) {
         iptr4vec = iptr + fdz_indx[n]  * siz_iz;
-        veczt[n] = jac3d[iptr4vec] * (  zt_x[iptr4vec] * Txx[iptr4vec]
-                                      + zt_y[iptr4vec] * Txy[iptr4vec]
-                                      + zt_z[iptr4vec] * Txz[iptr4vec] );
+        mt = gd_metric_get(&metric_d, iptr4vec);
+        veczt[n] = mt.jac * (  mt.zeta_x * Txx[iptr4vec]
+                             + mt.zeta_y * Txy[iptr4vec]
+                             + mt.zeta_z * Txz[iptr4vec] );
       }
 
       // at surface -> set to 0
@@ -492,9 +500,10 @@ sv_curv_col_el_iso_rhs_timg_z2_gpu(
         int n_img = fdz_indx[n] - 2*(n-n_free);
         //int n_img = index_dis - (n-n_free); // this method more easy to understand mirror point
         iptr4vec = iptr + n_img * siz_iz;
-        veczt[n] = -jac3d[iptr4vec] * (  zt_x[iptr4vec] * Txx[iptr4vec]
-                                       + zt_y[iptr4vec] * Txy[iptr4vec]
-                                       + zt_z[iptr4vec] * Txz[iptr4vec] );
+        mt = gd_metric_get(&metric_d, iptr4vec);
+        veczt[n] = -mt.jac * (  mt.zeta_x * Txx[iptr4vec]
+                              + mt.zeta_y * Txy[iptr4vec]
+                              + mt.zeta_z * Txz[iptr4vec] );
       }
 
       // deri
@@ -510,23 +519,26 @@ sv_curv_col_el_iso_rhs_timg_z2_gpu(
       // transform to conservative vars
       for (n=0; n<fdx_len; n++) {
         iptr4vec = iptr + fdx_indx[n];
-        vecxi[n] = jac3d[iptr4vec] * (  xi_x[iptr4vec] * Txy[iptr4vec]
-                                      + xi_y[iptr4vec] * Tyy[iptr4vec]
-                                      + xi_z[iptr4vec] * Tyz[iptr4vec] );
+        mt = gd_metric_get(&metric_d, iptr4vec);
+        vecxi[n] = mt.jac * (  mt.xi_x * Txy[iptr4vec]
+                             + mt.xi_y * Tyy[iptr4vec]
+                             + mt.xi_z * Tyz[iptr4vec] );
       }
       for (n=0; n<fdy_len; n++) {
         iptr4vec = iptr + fdy_indx[n] * siz_iy;
-        vecet[n] = jac3d[iptr4vec] * (  et_x[iptr4vec] * Txy[iptr4vec]
-                                      + et_y[iptr4vec] * Tyy[iptr4vec]
-                                      + et_z[iptr4vec] * Tyz[iptr4vec] );
+        mt = gd_metric_get(&metric_d, iptr4vec);
+        vecet[n] = mt.jac * (  mt.eta_x * Txy[iptr4vec]
+                             + mt.eta_y * Tyy[iptr4vec]
+                             + mt.eta_z * Tyz[iptr4vec] );
       }
 
       // blow surface -> cal
       for (n=0; n<n_free; n++) {
         iptr4vec = iptr + fdz_indx[n] * siz_iz;
-        veczt[n] = jac3d[iptr4vec] * (  zt_x[iptr4vec] * Txy[iptr4vec]
-                                      + zt_y[iptr4vec] * Tyy[iptr4vec]
-                                      + zt_z[iptr4vec] * Tyz[iptr4vec] );
+        mt = gd_metric_get(&metric_d, iptr4vec);
+        veczt[n] = mt.jac * (  mt.zeta_x * Txy[iptr4vec]
+                             + mt.zeta_y * Tyy[iptr4vec]
+                             + mt.zeta_z * Tyz[iptr4vec] );
       }
 
       // at surface -> set to 0
@@ -537,9 +549,10 @@ sv_curv_col_el_iso_rhs_timg_z2_gpu(
         int n_img = fdz_indx[n] - 2*(n-n_free);
         //int n_img = index_dis - (n-n_free);
         iptr4vec = iptr + n_img * siz_iz;
-        veczt[n] = -jac3d[iptr4vec] * (  zt_x[iptr4vec] * Txy[iptr4vec]
-                                       + zt_y[iptr4vec] * Tyy[iptr4vec]
-                                       + zt_z[iptr4vec] * Tyz[iptr4vec] );
+        mt = gd_metric_get(&metric_d, iptr4vec);
+        veczt[n] = -mt.jac * (  mt.zeta_x * Txy[iptr4vec]
+                              + mt.zeta_y * Tyy[iptr4vec]
+                              + mt.zeta_z * Tyz[iptr4vec] );
       }
 
       // deri
@@ -556,23 +569,26 @@ sv_curv_col_el_iso_rhs_timg_z2_gpu(
       // transform to conservative vars
       for (n=0; n<fdx_len; n++) {
         iptr4vec = iptr + fdx_indx[n];
-        vecxi[n] = jac3d[iptr4vec] * (  xi_x[iptr4vec] * Txz[iptr4vec]
-                                      + xi_y[iptr4vec] * Tyz[iptr4vec]
-                                      + xi_z[iptr4vec] * Tzz[iptr4vec] );
+        mt = gd_metric_get(&metric_d, iptr4vec);
+        vecxi[n] = mt.jac * (  mt.xi_x * Txz[iptr4vec]
+                             + mt.xi_y * Tyz[iptr4vec]
+                             + mt.xi_z * Tzz[iptr4vec] );
       }
       for (n=0; n<fdy_len; n++) {
         iptr4vec = iptr + fdy_indx[n] * siz_iy;
-        vecet[n] = jac3d[iptr4vec] * (  et_x[iptr4vec] * Txz[iptr4vec]
-                                      + et_y[iptr4vec] * Tyz[iptr4vec]
-                                      + et_z[iptr4vec] * Tzz[iptr4vec] );
+        mt = gd_metric_get(&metric_d, iptr4vec);
+        vecet[n] = mt.jac * (  mt.eta_x * Txz[iptr4vec]
+                             + mt.eta_y * Tyz[iptr4vec]
+                             + mt.eta_z * Tzz[iptr4vec] );
       }
 
       // blow surface -> cal
       for (n=0; n<n_free; n++) {
         iptr4vec = iptr + fdz_indx[n] * siz_iz;
-        veczt[n] = jac3d[iptr4vec] * (  zt_x[iptr4vec] * Txz[iptr4vec]
-                                      + zt_y[iptr4vec] * Tyz[iptr4vec]
-                                      + zt_z[iptr4vec] * Tzz[iptr4vec] );
+        mt = gd_metric_get(&metric_d, iptr4vec);
+        veczt[n] = mt.jac * (  mt.zeta_x * Txz[iptr4vec]
+                             + mt.zeta_y * Tyz[iptr4vec]
+                             + mt.zeta_z * Tzz[iptr4vec] );
       }
 
       // at surface -> set to 0
@@ -583,9 +599,10 @@ sv_curv_col_el_iso_rhs_timg_z2_gpu(
         int n_img = fdz_indx[n] - 2*(n-n_free);
         //int n_img = index_dis - (n-n_free);
         iptr4vec = iptr + n_img * siz_iz;
-        veczt[n] = -jac3d[iptr4vec] * (  zt_x[iptr4vec] * Txz[iptr4vec]
-                                       + zt_y[iptr4vec] * Tyz[iptr4vec]
-                                       + zt_z[iptr4vec] * Tzz[iptr4vec] );
+        mt = gd_metric_get(&metric_d, iptr4vec);
+        veczt[n] = -mt.jac * (  mt.zeta_x * Txz[iptr4vec]
+                              + mt.zeta_y * Tyz[iptr4vec]
+                              + mt.zeta_z * Tzz[iptr4vec] );
       }
 
       // for hVx 
@@ -608,10 +625,9 @@ sv_curv_col_el_iso_rhs_vlow_z2_gpu(
     float *  Vx , float *  Vy , float *  Vz ,
     float * hTxx, float * hTyy, float * hTzz,
     float * hTxz, float * hTyz, float * hTxy,
-    float * xi_x, float * xi_y, float * xi_z,
-    float * et_x, float * et_y, float * et_z,
-    float * zt_x, float * zt_y, float * zt_z,
+    gd_metric_t metric_d,
     float * lam3d, float * mu3d, float * slw3d,
+    void * mat_id, int mat_nbyte,
     float * matVx2Vz, float * matVy2Vz,
     int ni1, int ni, int nj1, int nj, int nk1, int nk2,
     size_t siz_iy, size_t siz_iz,
@@ -627,6 +643,7 @@ sv_curv_col_el_iso_rhs_vlow_z2_gpu(
   float DzVx,DzVy,DzVz;
   float lam,mu,lam2mu,slw;
   float xix,xiy,xiz,etx,ety,etz,ztx,zty,ztz;
+  gd_metric_pt_t mt;
 
   float * Vx_ptr;
   float * Vy_ptr;
@@ -645,20 +662,22 @@ sv_curv_col_el_iso_rhs_vlow_z2_gpu(
       size_t iptr   = (ix+ni1) + (iy+nj1) * siz_iy + k * siz_iz;
 
       // metric
-      xix = xi_x[iptr];
-      xiy = xi_y[iptr];
-      xiz = xi_z[iptr];
-      etx = et_x[iptr];
-      ety = et_y[iptr];
-      etz = et_z[iptr];
-      ztx = zt_x[iptr];
-      zty = zt_y[iptr];
-      ztz = zt_z[iptr];
+      mt = gd_metric_get(&metric_d, iptr);
+      xix = mt.xi_x;
+      xiy = mt.xi_y;
+      xiz = mt.xi_z;
+      etx = mt.eta_x;
+      ety = mt.eta_y;
+      etz = mt.eta_z;
+      ztx = mt.zeta_x;
+      zty = mt.zeta_y;
+      ztz = mt.zeta_z;
 
       // medium
-      lam = lam3d[iptr];
-      mu  =  mu3d[iptr];
-      slw = slw3d[iptr];
+      size_t iptr_md = md_mat_iptr(mat_id, mat_nbyte, iptr);
+      lam = lam3d[iptr_md];
+      mu  =  mu3d[iptr_md];
+      slw = slw3d[iptr_md];
       lam2mu = lam + 2.0 * mu;
 
       Vx_ptr = Vx + iptr;
@@ -762,10 +781,9 @@ sv_curv_col_el_iso_rhs_cfspml(
     float * hVx , float * hVy , float * hVz ,
     float * hTxx, float * hTyy, float * hTzz,
     float * hTxz, float * hTyz, float * hTxy,
-    float * xi_x, float * xi_y, float * xi_z,
-    float * et_x, float * et_y, float * et_z,
-    float * zt_x, float * zt_y, float * zt_z,
+    gd_metric_t metric_d,
     float * lam3d, float *  mu3d, float * slw3d,
+    void * mat_id, int mat_nbyte,
     int nk2, size_t siz_iy, size_t siz_iz,
     int *lfdx_shift, float *lfdx_coef,
     int *lfdy_shift, float *lfdy_coef,
@@ -805,8 +823,8 @@ sv_curv_col_el_iso_rhs_cfspml(
                                 Vx , Vy , Vz , Txx,  Tyy,  Tzz,
                                 Txz,  Tyz,  Txy, hVx , hVy , hVz,
                                 hTxx, hTyy, hTzz, hTxz, hTyz, hTxy,
-                                xi_x, xi_y, xi_z, et_x, et_y, et_z,
-                                zt_x, zt_y, zt_z, lam3d, mu3d, slw3d,
+                                metric_d,
+                                lam3d, mu3d, slw3d, mat_id, mat_nbyte,
                                 nk2, siz_iy, siz_iz,
                                 lfdx_shift, lfdx_coef,
                                 lfdy_shift, lfdy_coef,
@@ -829,10 +847,9 @@ sv_curv_col_el_iso_rhs_cfspml_gpu(int idim, int iside,
                                         float * hVx , float * hVy , float * hVz ,
                                         float * hTxx, float * hTyy, float * hTzz,
                                         float * hTxz, float * hTyz, float * hTxy,
-                                        float * xi_x, float * xi_y, float * xi_z,
-                                        float * et_x, float * et_y, float * et_z,
-                                        float * zt_x, float * zt_y, float * zt_z,
+                                        gd_metric_t metric_d,
                                         float * lam3d, float *  mu3d, float * slw3d,
+                                        void * mat_id, int mat_nbyte,
                                         int nk2, size_t siz_iy, size_t siz_iz,
                                         int *lfdx_shift, float *lfdx_coef,
                                         int *lfdy_shift, float *lfdy_coef,
@@ -846,7 +863,7 @@ sv_curv_col_el_iso_rhs_cfspml_gpu(int idim, int iside,
   float *matVx2Vz = bdryfree.matVx2Vz2;
   float *matVy2Vz = bdryfree.matVy2Vz2;
   // local
-  size_t iptr, iptr_a;
+  size_t iptr, iptr_a, iptr_md;
   float coef_A, coef_B, coef_D, coef_B_minus_1;
 
   float * Vx_ptr;
@@ -878,6 +895,7 @@ sv_curv_col_el_iso_rhs_cfspml_gpu(int idim, int iside,
   float DzTxx,DzTyy,DzTzz,DzTxy,DzTxz,DzTyz,DzVx,DzVy,DzVz;
   float lam,mu,lam2mu,slw;
   float xix,xiy,xiz,etx,ety,etz,ztx,zty,ztz;
+  gd_metric_pt_t mt;
   float hVx_rhs,hVy_rhs,hVz_rhs;
   float hTxx_rhs,hTyy_rhs,hTzz_rhs,hTxz_rhs,hTyz_rhs,hTxy_rhs;
   // for free surface
@@ -927,14 +945,16 @@ sv_curv_col_el_iso_rhs_cfspml_gpu(int idim, int iside,
       coef_B_minus_1 = coef_B - 1.0;
 
       // metric
-      xix = xi_x[iptr];
-      xiy = xi_y[iptr];
-      xiz = xi_z[iptr];
+      mt = gd_metric_get(&metric_d, iptr);
+      xix = mt.xi_x;
+      xiy = mt.xi_y;
+      xiz = mt.xi_z;
 
       // medium
-      lam = lam3d[iptr];
-      mu  =  mu3d[iptr];
-      slw = slw3d[iptr];
+      iptr_md = md_mat_iptr(mat_id, mat_nbyte, iptr);
+      lam = lam3d[iptr_md];
+      mu  =  mu3d[iptr_md];
+      slw = slw3d[iptr_md];
       lam2mu = lam + 2.0 * mu;
 
       Vx_ptr = Vx + iptr;
@@ -1014,9 +1034,10 @@ sv_curv_col_el_iso_rhs_cfspml_gpu(int idim, int iside,
                 + matVx2Vz[ij+3*2+2] * DxVz;
 
         // metric
-        ztx = zt_x[iptr];
-        zty = zt_y[iptr];
-        ztz = zt_z[iptr];
+        mt = gd_metric_get(&metric_d, iptr);
+        ztx = mt.zeta_x;
+        zty = mt.zeta_y;
+        ztz = mt.zeta_z;
 
         // keep xi derivative terms, including free surface convered
         hTxx_rhs =    lam2mu * (            ztx*Dx_DzVx)
@@ -1075,14 +1096,16 @@ sv_curv_col_el_iso_rhs_cfspml_gpu(int idim, int iside,
       coef_B_minus_1 = coef_B - 1.0;
 
       // metric
-      etx = et_x[iptr];
-      ety = et_y[iptr];
-      etz = et_z[iptr];
+      mt = gd_metric_get(&metric_d, iptr);
+      etx = mt.eta_x;
+      ety = mt.eta_y;
+      etz = mt.eta_z;
 
       // medium
-      lam = lam3d[iptr];
-      mu  =  mu3d[iptr];
-      slw = slw3d[iptr];
+      iptr_md = md_mat_iptr(mat_id, mat_nbyte, iptr);
+      lam = lam3d[iptr_md];
+      mu  =  mu3d[iptr_md];
+      slw = slw3d[iptr_md];
       lam2mu = lam + 2.0 * mu;
 
       Vx_ptr = Vx + iptr;
@@ -1160,9 +1183,10 @@ sv_curv_col_el_iso_rhs_cfspml_gpu(int idim, int iside,
                 + matVy2Vz[ij+3*2+2] * DyVz;
 
         // metric
-        ztx = zt_x[iptr];
-        zty = zt_y[iptr];
-        ztz = zt_z[iptr];
+        mt = gd_metric_get(&metric_d, iptr);
+        ztx = mt.zeta_x;
+        zty = mt.zeta_y;
+        ztz = mt.zeta_z;
 
         hTxx_rhs =    lam2mu * (             ztx*Dy_DzVx)
                     + lam    * (             zty*Dy_DzVy
@@ -1219,14 +1243,16 @@ sv_curv_col_el_iso_rhs_cfspml_gpu(int idim, int iside,
       coef_B_minus_1 = coef_B - 1.0;
 
       // metric
-      ztx = zt_x[iptr];
-      zty = zt_y[iptr];
-      ztz = zt_z[iptr];
+      mt = gd_metric_get(&metric_d, iptr);
+      ztx = mt.zeta_x;
+      zty = mt.zeta_y;
+      ztz = mt.zeta_z;
 
       // medium
-      lam = lam3d[iptr];
-      mu  =  mu3d[iptr];
-      slw = slw3d[iptr];
+      iptr_md = md_mat_iptr(mat_id, mat_nbyte, iptr);
+      lam = lam3d[iptr_md];
+      mu  =  mu3d[iptr_md];
+      slw = slw3d[iptr_md];
       lam2mu = lam + 2.0 * mu;
 
       Vx_ptr = Vx + iptr;
@@ -1313,16 +1339,6 @@ sv_curv_col_el_iso_dvh2dvz_gpu(gd_t    gd_d,
   size_t siz_icmp = gd_d.siz_icmp;
 
   // point to each var
-  float * xi_x = metric_d.xi_x;
-  float * xi_y = metric_d.xi_y;
-  float * xi_z = metric_d.xi_z;
-  float * et_x = metric_d.eta_x;
-  float * et_y = metric_d.eta_y;
-  float * et_z = metric_d.eta_z;
-  float * zt_x = metric_d.zeta_x;
-  float * zt_y = metric_d.zeta_y;
-  float * zt_z = metric_d.zeta_z;
-
   float * lam3d = md_d.lambda;
   float *  mu3d = md_d.mu;
 
@@ -1333,6 +1349,7 @@ sv_curv_col_el_iso_dvh2dvz_gpu(gd_t    gd_d,
   float AB[3][3], AC[3][3];
 
   float e11, e12, e13, e21, e22, e23, e31, e32, e33;
+  gd_metric_pt_t mt;
   float lam2mu, lam, mu;
  
   int k = nk2;
@@ -1341,18 +1358,20 @@ sv_curv_col_el_iso_dvh2dvz_gpu(gd_t    gd_d,
   if(ix<(ni2-ni1+1) && iy<(nj2-nj1+1))
   {
     size_t iptr = (ix+ni1) + (iy+nj1) * siz_iy + k * siz_iz;
-    e11 = xi_x[iptr];
-    e12 = xi_y[iptr];
-    e13 = xi_z[iptr];
-    e21 = et_x[iptr];
-    e22 = et_y[iptr];
-    e23 = et_z[iptr];
-    e31 = zt_x[iptr];
-    e32 = zt_y[iptr];
-    e33 = zt_z[iptr];
-
-    lam    = lam3d[iptr];
-    mu     =  mu3d[iptr];
+    mt = gd_metric_get(&metric_d, iptr);
+    e11 = mt.xi_x;
+    e12 = mt.xi_y;
+    e13 = mt.xi_z;
+    e21 = mt.eta_x;
+    e22 = mt.eta_y;
+    e23 = mt.eta_z;
+    e31 = mt.zeta_x;
+    e32 = mt.zeta_y;
+    e33 = mt.zeta_z;
+
+    size_t iptr_md = md_mat_iptr(md_d.mat_id, md_d.mat_nbyte, iptr);
+    lam    = lam3d[iptr_md];
+    mu     =  mu3d[iptr_md];
     lam2mu = lam + 2.0f * mu;
 
     // first dim: irow; sec dim: jcol, as Fortran code
@@ -7,6 +7,7 @@
 #include "md_t.h"
 #include "wav_t.h"
 #include "bdry_t.h"
+#include "prof_t.h"
 #include <cuda_runtime.h>
 
 /*************************************************
@@ -28,6 +29,7 @@ sv_curv_col_el_iso_onestage(
   fd_op_t *fdx_op,
   fd_op_t *fdy_op,
   fd_op_t *fdz_op,
+  prof_t  *prof,
   const int myid);
 
 __global__ void
@@ -38,10 +40,9 @@ sv_curv_col_el_iso_rhs_inner_gpu(
     float * hVx , float * hVy , float * hVz ,
     float * hTxx, float * hTyy, float * hTzz,
     float * hTxz, float * hTyz, float * hTxy,
-    float * xi_x, float * xi_y, float * xi_z,
-    float * et_x, float * et_y, float * et_z,
-    float * zt_x, float * zt_y, float * zt_z,
+    gd_metric_t metric_d,
     float * lam3d, float * mu3d, float * slw3d,
+    void * mat_id, int mat_nbyte,
     int ni1, int ni, int nj1, int nj, int nk1, int nk,
     size_t siz_iy, size_t siz_iz,
     int * lfdx_shift, float * lfdx_coef,
@@ -54,10 +55,9 @@ sv_curv_col_el_iso_rhs_timg_z2_gpu(
     float *  Txx, float *  Tyy, float *  Tzz,
     float *  Txz, float *  Tyz, float *  Txy,
     float * hVx , float * hVy , float * hVz ,
-    float * xi_x, float * xi_y, float * xi_z,
-    float * et_x, float * et_y, float * et_z,
-    float * zt_x, float * zt_y, float * zt_z,
-    float * jac3d, float * slw3d,
+    gd_metric_t metric_d,
+    float * slw3d,
+    void * mat_id, int mat_nbyte,
     int ni1, int ni, int nj1, int nj, int nk1, int nk2,
     size_t siz_iy, size_t siz_iz, 
     int fdx_len, int * fdx_indx, 
@@ -71,10 +71,9 @@ sv_curv_col_el_iso_rhs_vlow_z2_gpu(
     float *  Vx , float *  Vy , float *  Vz ,
     float * hTxx, float * hTyy, float * hTzz,
     float * hTxz, float * hTyz, float * hTxy,
-    float * xi_x, float * xi_y, float * xi_z,
-    float * et_x, float * et_y, float * et_z,
-    float * zt_x, float * zt_y, float * zt_z,
+    gd_metric_t metric_d,
     float * lam3d, float * mu3d, float * slw3d,
+    void * mat_id, int mat_nbyte,
     float * matVx2Vz, float * matVy2Vz,
     int ni1, int ni, int nj1, int nj, int nk1, int nk2,
     size_t siz_iy, size_t siz_iz,
@@ -89,10 +88,9 @@ sv_curv_col_el_iso_rhs_cfspml(
     float * hVx , float * hVy , float * hVz ,
     float * hTxx, float * hTyy, float * hTzz,
     float * hTxz, float * hTyz, float * hTxy,
-    float * xi_x, float * xi_y, float * xi_z,
-    float * et_x, float * et_y, float * et_z,
-    float * zt_x, float * zt_y, float * zt_z,
+    gd_metric_t metric_d,
     float * lam3d, float *  mu3d, float * slw3d,
+    void * mat_id, int mat_nbyte,
     int nk2, size_t siz_iy, size_t siz_iz,
     int *lfdx_shift, float *lfdx_coef,
     int *lfdy_shift, float *lfdy_coef,
@@ -109,10 +107,9 @@ sv_curv_col_el_iso_rhs_cfspml_gpu(
     float * hVx , float * hVy , float * hVz ,
     float * hTxx, float * hTyy, float * hTzz,
     float * hTxz, float * hTyz, float * hTxy,
-    float * xi_x, float * xi_y, float * xi_z,
-    float * et_x, float * et_y, float * et_z,
-    float * zt_x, float * zt_y, float * zt_z,
+    gd_metric_t metric_d,
     float * lam3d, float *  mu3d, float * slw3d,
+    void * mat_id, int mat_nbyte,
     int nk2, size_t siz_iy, size_t siz_iz,
     int *lfdx_shift, float *lfdx_coef,
     int *lfdy_shift, float *lfdy_coef,
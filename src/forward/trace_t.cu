@@ -0,0 +1,125 @@
+/*******************************************************************************
+ * event tracer of time loop, each rank writes trace_rank%d.json
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "constants.h"
+#include "prof_t.h"
+#include "trace_t.h"
+
+int
+trace_init(trace_t *trace, int step_start, int step_count, size_t capacity,
+           MPI_Comm comm, int myid)
+{
+  trace->enable     = (step_count > 0 && capacity > 0) ? 1 : 0;
+  trace->myid       = myid;
+  trace->step_start = step_start;
+  trace->step_count = step_count;
+  trace->is_active  = 0;
+  trace->it         = -1;
+  trace->istage     = -1;
+  trace->capacity   = capacity;
+  trace->head       = 0;
+  trace->event      = NULL;
+
+  if (trace->enable == 0) return 0;
+
+  trace->event = (trace_event_t *) malloc(sizeof(trace_event_t) * capacity);
+  if (trace->event == NULL) {
+    fprintf(stderr,"Error: can't malloc %zu trace events\n", capacity);
+    fflush(stderr);
+    exit(1);
+  }
+
+  // common time origin of all ranks
+  MPI_Barrier(comm);
+  trace->t_barrier = prof_wtime();
+
+  return 0;
+}
+
+void
+trace_set_step(trace_t *trace, int it, int istage)
+{
+  if (trace == NULL || trace->enable == 0) return;
+
+  trace->it     = it;
+  trace->istage = istage;
+  trace->is_active = (it >= trace->step_start &&
+                      it <  trace->step_start + trace->step_count) ? 1 : 0;
+}
+
+void
+trace_add(trace_t *trace, int iname, double t_beg, double t_end)
+{
+  if (trace->is_active == 0) return;
+
+  unsigned long islot = __atomic_fetch_add(&(trace->head), 1UL, __ATOMIC_RELAXED);
+  trace_event_t *ev = trace->event + (islot % trace->capacity);
+
+  ev->iname  = iname;
+  ev->it     = trace->it;
+  ev->istage = trace->istage;
+  ev->t_beg  = t_beg;
+  ev->t_end  = t_end;
+}
+
+/*
+ * timestamps are in us of local monotonic clock, t_barrier in otherData
+ *  is used by trace_merge to align ranks
+ */
+
+int
+trace_write(trace_t *trace, char *output_dir)
+{
+  if (trace->enable == 0) return 0;
+
+  char ou_file[CONST_MAX_STRLEN];
+  sprintf(ou_file, "%s/trace_rank%d.json", output_dir, trace->myid);
+
+  FILE *fp = fopen(ou_file, "w");
+  if (fp == NULL) {
+    fprintf(stderr,"Error: can't create trace file %s\n", ou_file);
+    fflush(stderr);
+    return -1;
+  }
+
+  size_t num_event = trace->head < trace->capacity ? trace->head : trace->capacity;
+  // oldest kept event
+  unsigned long islot0 = trace->head - num_event;
+
+  fprintf(fp, "{\"otherData\": {\"rank\": %d, \"barrier_us\": %.3f, \"num_dropped\": %lu},\n",
+          trace->myid, trace->t_barrier * 1.0e6, islot0);
+  fprintf(fp, "\"traceEvents\": [\n");
+  fprintf(fp, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": 0, "
+              "\"args\": {\"name\": \"rank %d\"}}",
+          trace->myid, trace->myid);
+
+  for (size_t n=0; n < num_event; n++)
+  {
+    trace_event_t *ev = trace->event + ((islot0 + n) % trace->capacity);
+    fprintf(fp, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": %d, \"tid\": 0, "
+                "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"it\": %d, \"istage\": %d}}",
+            prof_get_name(ev->iname), trace->myid,
+            ev->t_beg * 1.0e6, (ev->t_end - ev->t_beg) * 1.0e6,
+            ev->it, ev->istage);
+  }
+  fprintf(fp, "\n]}\n");
+
+  fclose(fp);
+
+  return 0;
+}
+
+int
+trace_free(trace_t *trace)
+{
+  if (trace->event != NULL) free(trace->event);
+  trace->event  = NULL;
+  trace->enable = 0;
+
+  return 0;
+}
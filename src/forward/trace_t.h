@@ -0,0 +1,64 @@
+#ifndef TRACE_T_H
+#define TRACE_T_H
+
+#include <mpi.h>
+
+/*************************************************
+ * event tracer of time loop, output in chrome trace-event format
+ *  events are kept in a ring buffer, slot is reserved by atomic add so
+ *  writers need no lock. when the ring is full the oldest events are
+ *  overwritten. only steps in [step_start, step_start+step_count) are
+ *  recorded
+ *************************************************/
+
+typedef struct
+{
+  int   iname;  // scope id of prof_t
+  int   it;
+  int   istage;
+  double t_beg; // seconds of monotonic clock
+  double t_end;
+} trace_event_t;
+
+typedef struct
+{
+  int enable;
+  int myid;
+
+  int step_start;
+  int step_count;
+
+  // current position, set by driver
+  int is_active;
+  int it;
+  int istage;
+
+  // clock at barrier after init, used to align ranks
+  double t_barrier;
+
+  size_t capacity;
+  unsigned long head; // total number of reserved slots
+  trace_event_t *event;
+} trace_t;
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+trace_init(trace_t *trace, int step_start, int step_count, size_t capacity,
+           MPI_Comm comm, int myid);
+
+void
+trace_set_step(trace_t *trace, int it, int istage);
+
+void
+trace_add(trace_t *trace, int iname, double t_beg, double t_end);
+
+int
+trace_write(trace_t *trace, char *output_dir);
+
+int
+trace_free(trace_t *trace);
+
+#endif
@@ -37,16 +37,6 @@ wave2fault_onestage(float *w_cur_d, float *w_rhs_d, wav_t wav_d,
   float *hTxz = w_rhs_d + wav_d.Txz_pos; 
   float *hTxy = w_rhs_d + wav_d.Txy_pos; 
 
-  float *xi_x  = metric_d.xi_x;
-  float *xi_y  = metric_d.xi_y;
-  float *xi_z  = metric_d.xi_z;
-  float *et_x  = metric_d.eta_x;
-  float *et_y  = metric_d.eta_y;
-  float *et_z  = metric_d.eta_z;
-  float *zt_x  = metric_d.zeta_x;
-  float *zt_y  = metric_d.zeta_y;
-  float *zt_z  = metric_d.zeta_z;
-  float *jac3d = metric_d.jac;
   // OUTPUT
   // local pointer get each vars
   for(int id=0; id<FW.number_fault; id++)
@@ -86,10 +76,8 @@ wave2fault_onestage(float *w_cur_d, float *w_rhs_d, wav_t wav_d,
                                        f_T1x, f_T1y, f_T1z,
                                        f_hT2x,f_hT2y,f_hT2z,
                                        f_hT3x,f_hT3y,f_hT3z,
-                                       xi_x, xi_y, xi_z,
-                                       et_x, et_y, et_z,
-                                       zt_x, zt_y, zt_z,
-                                       jac3d, nj, nj1, nk, nk1, ny, 
+                                       metric_d,
+                                       nj, nj1, nk, nk1, ny, 
                                        siz_iy, siz_iz, siz_slice_yz,
                                        id,F);
     }
@@ -109,10 +97,8 @@ wave2fault_gpu(float * Vx,    float * Vy,    float * Vz,
                float * f_T1x, float * f_T1y, float * f_T1z,
                float * f_hT2x,float * f_hT2y,float * f_hT2z,
                float * f_hT3x,float * f_hT3y,float * f_hT3z,
-               float * xi_x,  float * xi_y,  float * xi_z,
-               float * et_x,  float * et_y,  float * et_z,
-               float * zt_x,  float * zt_y,  float * zt_z,
-               float * jac3d, int nj, int nj1, 
+               gd_metric_t metric_d,
+               int nj, int nj1, 
                int nk, int nk1, int ny, 
                size_t siz_iy, size_t siz_iz, 
                size_t siz_slice_yz,
@@ -144,10 +130,11 @@ wave2fault_gpu(float * Vx,    float * Vy,    float * Vz,
   if( iy < nj && iz < nk && F_thisone->united[iptr_f] == 1) 
   {
     iptr = i0 + (iy+nj1) * siz_iy + (iz+nk1) * siz_iz;
-    metric[0][0]=xi_x[iptr];metric[0][1]=et_x[iptr];metric[0][2]=zt_x[iptr];
-    metric[1][0]=xi_y[iptr];metric[1][1]=et_y[iptr];metric[1][2]=zt_y[iptr];
-    metric[2][0]=xi_z[iptr];metric[2][1]=et_z[iptr];metric[2][2]=zt_z[iptr];
-    jac = jac3d[iptr];
+    gd_metric_pt_t mt = gd_metric_get(&metric_d, iptr);
+    metric[0][0]=mt.xi_x;metric[0][1]=mt.eta_x;metric[0][2]=mt.zeta_x;
+    metric[1][0]=mt.xi_y;metric[1][1]=mt.eta_y;metric[1][2]=mt.zeta_y;
+    metric[2][0]=mt.xi_z;metric[2][1]=mt.eta_z;metric[2][2]=mt.zeta_z;
+    jac = mt.jac;
 
     stress[0][0]=Txx[iptr];stress[0][1]=Txy[iptr];stress[0][2]=Txz[iptr];
     stress[1][0]=Txy[iptr];stress[1][1]=Tyy[iptr];stress[1][2]=Tyz[iptr];
@@ -238,16 +225,6 @@ fault2wave_onestage(float *w_cur_d, wav_t wav_d,
   float *Txy   = w_cur_d + wav_d.Txy_pos;
 
   // INPUT
-  float *xi_x  = metric_d.xi_x;
-  float *xi_y  = metric_d.xi_y;
-  float *xi_z  = metric_d.xi_z;
-  float *et_x  = metric_d.eta_x;
-  float *et_y  = metric_d.eta_y;
-  float *et_z  = metric_d.eta_z;
-  float *zt_x  = metric_d.zeta_x;
-  float *zt_y  = metric_d.zeta_y;
-  float *zt_z  = metric_d.zeta_z;
-  float *jac3d = metric_d.jac;
 
   for(int id=0; id<FW.number_fault; id++)
   {
@@ -276,10 +253,8 @@ fault2wave_onestage(float *w_cur_d, wav_t wav_d,
                                        f_T2x, f_T2y, f_T2z, 
                                        f_T3x, f_T3y, f_T3z,
                                        f_T1x, f_T1y, f_T1z,
-                                       xi_x, xi_y, xi_z,
-                                       et_x, et_y, et_z,
-                                       zt_x, zt_y, zt_z,
-                                       jac3d, nj, nj1, nk, nk1, ny, 
+                                       metric_d,
+                                       nj, nj1, nk, nk1, ny, 
                                        siz_iy, siz_iz, 
                                        siz_slice_yz,
                                        id,F);
@@ -297,10 +272,8 @@ fault2wave_gpu(float * Vx,  float * Vy,  float * Vz,
                float * f_T2x, float * f_T2y, float * f_T2z,
                float * f_T3x, float * f_T3y, float * f_T3z,
                float * f_T1x, float * f_T1y, float * f_T1z,
-               float * xi_x,  float * xi_y, float * xi_z,
-               float * et_x,  float * et_y, float * et_z,
-               float * zt_x,  float * zt_y, float * zt_z,
-               float *jac3d, int nj, int nj1,
+               gd_metric_t metric_d,
+               int nj, int nj1,
                int nk, int nk1,int ny,  
                size_t siz_iy, size_t siz_iz, 
                size_t siz_slice_yz,
@@ -331,10 +304,11 @@ fault2wave_gpu(float * Vx,  float * Vy,  float * Vz,
   if( iy < nj && iz < nk && F_thisone->united[iptr_f] == 0)
   { 
     iptr = i0 + (iy+nj1) * siz_iy + (iz+nk1) * siz_iz;
-    metric[0][0]=xi_x[iptr];metric[0][1]=et_x[iptr];metric[0][2]=zt_x[iptr];
-    metric[1][0]=xi_y[iptr];metric[1][1]=et_y[iptr];metric[1][2]=zt_y[iptr];
-    metric[2][0]=xi_z[iptr];metric[2][1]=et_z[iptr];metric[2][2]=zt_z[iptr];
-    jac = 1.0/jac3d[iptr];
+    gd_metric_pt_t mt = gd_metric_get(&metric_d, iptr);
+    metric[0][0]=mt.xi_x;metric[0][1]=mt.eta_x;metric[0][2]=mt.zeta_x;
+    metric[1][0]=mt.xi_y;metric[1][1]=mt.eta_y;metric[1][2]=mt.zeta_y;
+    metric[2][0]=mt.xi_z;metric[2][1]=mt.eta_z;metric[2][2]=mt.zeta_z;
+    jac = 1.0/mt.jac;
 
     //NOTE  T1x -3 : 3. fault T1x is medium, = 0. so 3 * siz_slice_yz
     iptr_f = (iy+nj1) + (iz+nk1) * ny + 3 * siz_slice_yz;  
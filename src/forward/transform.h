@@ -23,10 +23,8 @@ wave2fault_gpu(float * Vx,  float * Vy,  float * Vz,
                float * f_T1x, float * f_T1y, float * f_T1z,
                float * f_hT2x,float * f_hT2y,float * f_hT2z,
                float * f_hT3x,float * f_hT3y,float * f_hT3z,
-               float * xi_x,  float * xi_y, float * xi_z,
-               float * et_x,  float * et_y, float * et_z,
-               float * zt_x,  float * zt_y, float * zt_z,
-               float * jac3d,  int nj, int nj1, 
+               gd_metric_t metric_d,
+               int nj, int nj1, 
                int nk, int nk1, int ny, 
                size_t siz_iy, size_t siz_iz,
                size_t siz_slice_yz, 
@@ -45,10 +43,8 @@ fault2wave_gpu(float * Vx,  float * Vy,  float * Vz,
                float * f_T2x, float * f_T2y, float * f_T2z,
                float * f_T3x, float * f_T3y, float * f_T3z,
                float * f_T1x, float * f_T1y, float * f_T1z,
-               float * xi_x,  float * xi_y, float * xi_z,
-               float * et_x,  float * et_y, float * et_z,
-               float * zt_x,  float * zt_y, float * zt_z,
-               float * jac3d, int nj, int nj1,
+               gd_metric_t metric_d,
+               int nj, int nj1,
                int nk, int nk1, int ny, 
                size_t siz_iy, size_t siz_iz, 
                size_t siz_slice_yz, 
@@ -28,11 +28,6 @@ trial_slipweakening_onestage(
   float *Txz   = w_cur_d + wav_d.Txz_pos;
   float *Txy   = w_cur_d + wav_d.Txy_pos;
 
-  float *xi_x  = metric_d.xi_x;
-  float *xi_y  = metric_d.xi_y;
-  float *xi_z  = metric_d.xi_z;
-  float *jac3d = metric_d.jac;
-
   int nj1 = gd_d.nj1;
   int nk1 = gd_d.nk1;
   int nj  = gd_d.nj;
@@ -76,8 +71,8 @@ trial_slipweakening_onestage(
                            f_T3x, f_T3y, f_T3z,
                            f_T1x, f_T1y, f_T1z,
                            f_mVx, f_mVy, f_mVz,
-                           xi_x,  xi_y,  xi_z,
-                           jac3d, isfree, dt, 
+                           metric_d,
+                           isfree, dt, 
                            nj1, nj, nk1, nk, ny, siz_iy, 
                            siz_iz, siz_slice_yz, 
                            jdir, kdir, 
@@ -96,8 +91,8 @@ trial_slipweakening_gpu(
     float *f_T3x, float *f_T3y, float *f_T3z,
     float *f_T1x, float *f_T1y, float *f_T1z,
     float *f_mVx, float *f_mVy, float *f_mVz,
-    float *xi_x,  float *xi_y,  float *xi_z,
-    float *jac3d, int isfree, float dt, 
+    gd_metric_t metric_d,
+    int isfree, float dt, 
     int nj1, int nj, int nk1, int nk, int ny,
     size_t siz_iy, size_t siz_iz, size_t siz_slice_yz, 
     int jdir, int kdir,
@@ -113,6 +108,7 @@ trial_slipweakening_gpu(
   size_t iptr, iptr_f;
   float xix, xiy, xiz;
   float jac;
+  gd_metric_pt_t mt;
   float vec_n0;
   float jacvec;
   float rho;
@@ -142,7 +138,8 @@ trial_slipweakening_gpu(
       // 0 1 2 3 4 5 6 index 0,1,2 minus, 3 fault, 4,5,6 plus
       iptr_f = (iy+nj1) + (iz+nk1) * ny; 
       iptr = i0 + (iy+nj1) * siz_iy + (iz+nk1) * siz_iz;
-      jac = jac3d[iptr];
+      mt = gd_metric_get(&metric_d, iptr);
+      jac = mt.jac;
       rho = FC_thisone->rho_f[iptr_f + m * siz_slice_yz];
       // dh = 1, so omit dh in formula
       Mrho[m] = 0.5*jac*rho;
@@ -152,10 +149,11 @@ trial_slipweakening_gpu(
       {
         iptr = (i0+(2*m-1)*l) + (iy+nj1) * siz_iy + (iz+nk1) * siz_iz;
         iptr_f = (iy+nj1) + (iz+nk1) * ny; 
-        xix = xi_x[iptr];
-        xiy = xi_y[iptr];
-        xiz = xi_z[iptr];
-        jac = jac3d[iptr];
+        mt = gd_metric_get(&metric_d, iptr);
+        xix = mt.xi_x;
+        xiy = mt.xi_y;
+        xiz = mt.xi_z;
+        jac = mt.jac;
         T1x = jac*(xix * Txx[iptr] + xiy * Txy[iptr] + xiz * Txz[iptr]);
         T1y = jac*(xix * Txy[iptr] + xiy * Tyy[iptr] + xiz * Tyz[iptr]);
         T1z = jac*(xix * Txz[iptr] + xiy * Tyz[iptr] + xiz * Tzz[iptr]);
@@ -288,12 +286,13 @@ trial_slipweakening_gpu(
     vec_s2[2] = FC_thisone->vec_s2[iptr_f * 3 + 2];
 
     iptr = i0 + (iy+nj1) * siz_iy + (iz+nk1) * siz_iz;
-    vec_n[0] = xi_x[iptr];
-    vec_n[1] = xi_y[iptr];
-    vec_n[2] = xi_z[iptr];
+    mt = gd_metric_get(&metric_d, iptr);
+    vec_n[0] = mt.xi_x;
+    vec_n[1] = mt.xi_y;
+    vec_n[2] = mt.xi_z;
     vec_n0 = fdlib_math_norm3(vec_n);
 
-    jacvec = jac3d[iptr] * vec_n0;
+    jacvec = mt.jac * vec_n0;
     for (int i=0; i<3; i++)
     {
       vec_n[i] /= vec_n0;
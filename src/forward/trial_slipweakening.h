@@ -33,8 +33,8 @@ trial_slipweakening_gpu(
                   float *f_T3x, float *f_T3y, float *f_T3z,
                   float *f_T1x, float *f_T1y, float *f_T1z,
                   float *f_mVx, float *f_mVy, float *f_mVz,
-                  float *xi_x,  float *xi_y,  float *xi_z,
-                  float *jac3d, int isfree, float dt, 
+                  gd_metric_t metric_d,
+                  int isfree, float dt, 
                   int nj1, int nj, int nk1, int nk, int ny,
                   size_t siz_iy, size_t siz_iz, size_t siz_slice_yz, 
                   int jdir, int kdir,
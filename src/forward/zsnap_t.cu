@@ -0,0 +1,388 @@
+/*******************************************************************************
+ * error-bounded compression of snapshot frames, coded by host threads
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netcdf.h>
+
+#include "constants.h"
+#include "zsnap_t.h"
+
+static void
+zsnap_nc_err(int ierr)
+{
+  if (ierr != NC_NOERR) {
+    fprintf(stderr,"Error: %s\n", nc_strerror(ierr));
+    fflush(stderr);
+    exit(1);
+  }
+}
+
+int
+zsnap_init(zsnap_t *zsnap, float err_abs, float err_rel, int num_of_thread,
+           int ni, int nj, int nk, int *is_cmp_out, MPI_Comm comm)
+{
+  zsnap->enable        = (err_abs > 0.0f || err_rel > 0.0f) ? 1 : 0;
+  zsnap->err_abs       = err_abs;
+  zsnap->err_rel       = err_rel;
+  zsnap->num_of_thread = num_of_thread > 0 ? num_of_thread : 1;
+  zsnap->comm          = comm;
+  zsnap->it_frame      = -1;
+  zsnap->is_busy       = 0;
+  zsnap->zpos          = 0;
+  zsnap->is_zpos_set   = 1;
+  zsnap->num_of_var    = 0;
+
+  if (zsnap->enable == 0) return 0;
+
+  zsnap->ni = ni;
+  zsnap->nj = nj;
+  zsnap->nk = nk;
+  zsnap->siz_frame = (size_t) ni * nj * nk;
+
+  int nbi, nbj, nbk;
+  zsnap->num_of_block = zblock_frame_dims(ni, nj, nk, &nbi, &nbj, &nbk);
+  zsnap->siz_zbuf = zsnap->num_of_block * ZBLOCK_BOUND(ZBLOCK_MAX_POINTS);
+
+  for (int icmp=0; icmp < ZSNAP_MAX_CMP; icmp++)
+  {
+    zsnap->icmp_to_var[icmp] = -1;
+    if (is_cmp_out[icmp] == 1) {
+      zsnap->icmp_to_var[icmp] = zsnap->num_of_var;
+      zsnap->num_of_var += 1;
+    }
+  }
+
+  int nvar = zsnap->num_of_var;
+  zsnap->frame = (float *) malloc(nvar * zsnap->siz_frame * sizeof(float));
+  zsnap->zbuf  = (unsigned char *) malloc(nvar * zsnap->siz_zbuf);
+  zsnap->zsize = (int *) malloc(nvar * zsnap->num_of_block * sizeof(int));
+  zsnap->zbyte = (size_t *) malloc(nvar * sizeof(size_t));
+  zsnap->eb    = (float *) malloc(nvar * sizeof(float));
+  zsnap->worker = (zsnap_worker_t *) malloc(zsnap->num_of_thread * sizeof(zsnap_worker_t));
+  if (zsnap->frame == NULL || zsnap->zbuf == NULL || zsnap->zsize == NULL
+      || zsnap->zbyte == NULL || zsnap->eb == NULL || zsnap->worker == NULL) {
+    fprintf(stderr,"Error: can't alloc snapshot compression buffer of %d x %d x %d\n",
+            ni, nj, nk);
+    fflush(stderr);
+    exit(1);
+  }
+
+  return 0;
+}
+
+/*
+ * in define mode of new file, time is not unlimited so zdata is the
+ *  only record var and its records are contiguous
+ */
+
+int
+zsnap_def(zsnap_t *zsnap, int ncid, int dimid_time, const char **cmp_name)
+{
+  if (zsnap->enable == 0) return 0;
+
+  int ierr;
+  int dimid[2];
+  char name[CONST_MAX_STRLEN];
+
+  dimid[0] = dimid_time;
+  ierr = nc_def_dim(ncid, "block", zsnap->num_of_block, &dimid[1]); zsnap_nc_err(ierr);
+
+  for (int icmp=0; icmp < ZSNAP_MAX_CMP; icmp++)
+  {
+    if (zsnap->icmp_to_var[icmp] < 0) continue;
+    sprintf(name, "%s_zstart", cmp_name[icmp]);
+    ierr = nc_def_var(ncid, name, NC_DOUBLE, 1, dimid, &zsnap->varid_zstart[icmp]);
+    zsnap_nc_err(ierr);
+    sprintf(name, "%s_zsize", cmp_name[icmp]);
+    ierr = nc_def_var(ncid, name, NC_INT, 2, dimid, &zsnap->varid_zsize[icmp]);
+    zsnap_nc_err(ierr);
+    sprintf(name, "%s_eb", cmp_name[icmp]);
+    ierr = nc_def_var(ncid, name, NC_FLOAT, 1, dimid, &zsnap->varid_eb[icmp]);
+    zsnap_nc_err(ierr);
+  }
+
+  int dimid_zbyte;
+  ierr = nc_def_dim(ncid, "zbyte", NC_UNLIMITED, &dimid_zbyte);   zsnap_nc_err(ierr);
+  ierr = nc_def_var(ncid, "zdata", NC_BYTE, 1, &dimid_zbyte, &zsnap->varid_zdata);
+  zsnap_nc_err(ierr);
+
+  // parameters of codec
+  int block_size[] = { ZBLOCK_N, ZBLOCK_N, ZBLOCK_N };
+  nc_put_att_text (ncid, NC_GLOBAL, "compressor", strlen("zblock"), "zblock");
+  nc_put_att_text (ncid, NC_GLOBAL, "zblock_predictor", strlen("lorenzo3d"), "lorenzo3d");
+  nc_put_att_text (ncid, NC_GLOBAL, "zblock_coder", strlen("rice"), "rice");
+  nc_put_att_int  (ncid, NC_GLOBAL, "zblock_block_size", NC_INT, CONST_NDIM, block_size);
+  nc_put_att_float(ncid, NC_GLOBAL, "zblock_error_abs", NC_FLOAT, 1, &zsnap->err_abs);
+  nc_put_att_float(ncid, NC_GLOBAL, "zblock_error_rel", NC_FLOAT, 1, &zsnap->err_rel);
+
+  return 0;
+}
+
+/*
+ * file of interrupted run, end of zdata is found at first write
+ */
+
+int
+zsnap_inq(zsnap_t *zsnap, int ncid, const char **cmp_name)
+{
+  if (zsnap->enable == 0) return 0;
+
+  int ierr;
+  char name[CONST_MAX_STRLEN];
+
+  for (int icmp=0; icmp < ZSNAP_MAX_CMP; icmp++)
+  {
+    if (zsnap->icmp_to_var[icmp] < 0) continue;
+    sprintf(name, "%s_zstart", cmp_name[icmp]);
+    ierr = nc_inq_varid(ncid, name, &zsnap->varid_zstart[icmp]); zsnap_nc_err(ierr);
+    sprintf(name, "%s_zsize", cmp_name[icmp]);
+    ierr = nc_inq_varid(ncid, name, &zsnap->varid_zsize[icmp]);  zsnap_nc_err(ierr);
+    sprintf(name, "%s_eb", cmp_name[icmp]);
+    ierr = nc_inq_varid(ncid, name, &zsnap->varid_eb[icmp]);     zsnap_nc_err(ierr);
+  }
+  ierr = nc_inq_varid(ncid, "zdata", &zsnap->varid_zdata); zsnap_nc_err(ierr);
+
+  zsnap->is_zpos_set = 0;
+
+  return 0;
+}
+
+/*
+ * staging of component, NULL if not output
+ */
+
+float *
+zsnap_frame(zsnap_t *zsnap, int icmp)
+{
+  int ivar = zsnap->icmp_to_var[icmp];
+  if (ivar < 0) return NULL;
+
+  return zsnap->frame + ivar * zsnap->siz_frame;
+}
+
+static void *
+zsnap_worker(void *arg)
+{
+  zsnap_worker_t *worker = (zsnap_worker_t *) arg;
+  zsnap_t *zsnap = worker->zsnap;
+
+  int ni = zsnap->ni, nj = zsnap->nj, nk = zsnap->nk;
+  int nb = zsnap->num_of_block;
+  size_t siz_bound = ZBLOCK_BOUND(ZBLOCK_MAX_POINTS);
+
+  // blocks of all components by turns
+  for (int m = worker->iw; m < zsnap->num_of_var * nb; m += zsnap->num_of_thread)
+  {
+    int ivar = m / nb;
+    int ib   = m % nb;
+    int bi, bj, bk;
+    size_t off = zblock_frame_offset(ib, ni, nj, nk, &bi, &bj, &bk);
+    zsnap->zsize[m] = (int) zblock_encode(zsnap->frame + ivar * zsnap->siz_frame + off,
+                                          bi, bj, bk, ni, (size_t) ni * nj,
+                                          zsnap->eb[ivar],
+                                          zsnap->zbuf + ivar * zsnap->siz_zbuf + ib * siz_bound);
+  }
+
+  return NULL;
+}
+
+static void *
+zsnap_compressor(void *arg)
+{
+  zsnap_t *zsnap = (zsnap_t *) arg;
+
+  pthread_t *thread = (pthread_t *) malloc(zsnap->num_of_thread * sizeof(pthread_t));
+  for (int iw=1; iw < zsnap->num_of_thread; iw++)
+  {
+    zsnap->worker[iw].zsnap = zsnap;
+    zsnap->worker[iw].iw    = iw;
+    if (pthread_create(thread + iw, NULL, zsnap_worker, zsnap->worker + iw) != 0) {
+      fprintf(stderr,"Error: can't create snapshot compression thread\n");
+      fflush(stderr);
+      exit(1);
+    }
+  }
+  zsnap->worker[0].zsnap = zsnap;
+  zsnap->worker[0].iw    = 0;
+  zsnap_worker(zsnap->worker);
+  for (int iw=1; iw < zsnap->num_of_thread; iw++) {
+    pthread_join(thread[iw], NULL);
+  }
+  free(thread);
+
+  // blocks of each component to one stream, they only move forward
+  size_t siz_bound = ZBLOCK_BOUND(ZBLOCK_MAX_POINTS);
+  for (int ivar=0; ivar < zsnap->num_of_var; ivar++)
+  {
+    unsigned char *zbuf = zsnap->zbuf + ivar * zsnap->siz_zbuf;
+    int *zsize = zsnap->zsize + ivar * zsnap->num_of_block;
+    size_t pos = 0;
+    for (int ib=0; ib < zsnap->num_of_block; ib++)
+    {
+      memmove(zbuf + pos, zbuf + ib * siz_bound, zsize[ib]);
+      pos += zsize[ib];
+    }
+    zsnap->zbyte[ivar] = pos;
+  }
+
+  return NULL;
+}
+
+/*
+ * error bound of staged frame, by main thread as it is collective on
+ *  threads of snapshot, so the merged frame has one bound
+ */
+
+static void
+zsnap_frame_eb(zsnap_t *zsnap)
+{
+  int nvar = zsnap->num_of_var;
+
+  if (zsnap->err_abs > 0.0f)
+  {
+    for (int ivar=0; ivar < nvar; ivar++) {
+      zsnap->eb[ivar] = zsnap->err_abs;
+    }
+    return;
+  }
+
+  // -min and max of each component
+  float *vext = (float *) malloc(2 * nvar * sizeof(float));
+  for (int ivar=0; ivar < nvar; ivar++)
+  {
+    float vmin, vmax;
+    zblock_frame_range(zsnap->frame + ivar * zsnap->siz_frame, zsnap->siz_frame,
+                       &vmin, &vmax);
+    vext[2*ivar+0] = -vmin;
+    vext[2*ivar+1] =  vmax;
+  }
+  MPI_Allreduce(MPI_IN_PLACE, vext, 2*nvar, MPI_FLOAT, MPI_MAX, zsnap->comm);
+
+  for (int ivar=0; ivar < nvar; ivar++) {
+    zsnap->eb[ivar] = zsnap->err_rel * (vext[2*ivar+1] + vext[2*ivar+0]);
+  }
+  free(vext);
+}
+
+/*
+ * all components of frame it_frame are staged
+ */
+
+int
+zsnap_start(zsnap_t *zsnap, int it_frame)
+{
+  if (zsnap->enable == 0) return 0;
+
+  zsnap_frame_eb(zsnap);
+
+  zsnap->it_frame = it_frame;
+  if (pthread_create(&(zsnap->compressor), NULL, zsnap_compressor, zsnap) != 0) {
+    fprintf(stderr,"Error: can't create snapshot compressor thread\n");
+    fflush(stderr);
+    exit(1);
+  }
+  zsnap->is_busy = 1;
+
+  return 0;
+}
+
+int
+zsnap_wait(zsnap_t *zsnap)
+{
+  if (zsnap->is_busy == 0) return 0;
+
+  pthread_join(zsnap->compressor, NULL);
+  zsnap->is_busy = 0;
+
+  return 0;
+}
+
+/*
+ * write staged frame after coding, before staging next one
+ */
+
+int
+zsnap_write(zsnap_t *zsnap, int ncid)
+{
+  if (zsnap->enable == 0) return 0;
+
+  zsnap_wait(zsnap);
+  if (zsnap->it_frame < 0) return 0;
+
+  int ierr;
+  size_t it = zsnap->it_frame;
+  size_t nb = zsnap->num_of_block;
+
+  // after restart, zdata ends with last component of previous frame
+  if (zsnap->is_zpos_set == 0)
+  {
+    zsnap->zpos = 0;
+    if (it > 0)
+    {
+      int icmp_last = ZSNAP_MAX_CMP - 1;
+      while (zsnap->icmp_to_var[icmp_last] < 0) icmp_last--;
+      double zstart;
+      int *zsize = (int *) malloc(nb * sizeof(int));
+      size_t startp[] = { it - 1, 0 };
+      size_t countp[] = { 1, nb };
+      ierr = nc_get_var1_double(ncid, zsnap->varid_zstart[icmp_last], startp, &zstart);
+      zsnap_nc_err(ierr);
+      ierr = nc_get_vara_int(ncid, zsnap->varid_zsize[icmp_last], startp, countp, zsize);
+      zsnap_nc_err(ierr);
+      zsnap->zpos = (size_t) zstart;
+      for (size_t ib=0; ib < nb; ib++) zsnap->zpos += zsize[ib];
+      free(zsize);
+    }
+    zsnap->is_zpos_set = 1;
+  }
+
+  for (int icmp=0; icmp < ZSNAP_MAX_CMP; icmp++)
+  {
+    int ivar = zsnap->icmp_to_var[icmp];
+    if (ivar < 0) continue;
+
+    double zstart = (double) zsnap->zpos;
+    size_t startp[] = { it, 0 };
+    size_t countp[] = { 1, nb };
+    ierr = nc_put_vara_int(ncid, zsnap->varid_zsize[icmp], startp, countp,
+                           zsnap->zsize + ivar * nb);           zsnap_nc_err(ierr);
+    ierr = nc_put_var1_float(ncid, zsnap->varid_eb[icmp], startp, zsnap->eb + ivar);
+    zsnap_nc_err(ierr);
+
+    size_t zbyte = zsnap->zbyte[ivar];
+    if (zbyte > 0) {
+      ierr = nc_put_vara_schar(ncid, zsnap->varid_zdata, &zsnap->zpos, &zbyte,
+                               (signed char *) (zsnap->zbuf + ivar * zsnap->siz_zbuf));
+      zsnap_nc_err(ierr);
+    }
+    zsnap->zpos += zbyte;
+
+    // written last, frame is complete when zstart is set
+    ierr = nc_put_var1_double(ncid, zsnap->varid_zstart[icmp], startp, &zstart);
+    zsnap_nc_err(ierr);
+  }
+
+  zsnap->it_frame = -1;
+
+  return 0;
+}
+
+int
+zsnap_free(zsnap_t *zsnap)
+{
+  if (zsnap->enable == 0) return 0;
+
+  zsnap_wait(zsnap);
+  free(zsnap->frame);
+  free(zsnap->zbuf);
+  free(zsnap->zsize);
+  free(zsnap->zbyte);
+  free(zsnap->eb);
+  free(zsnap->worker);
+  zsnap->enable = 0;
+
+  return 0;
+}
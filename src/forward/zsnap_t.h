@@ -0,0 +1,103 @@
+#ifndef ZSNAP_T_H
+#define ZSNAP_T_H
+
+#include <pthread.h>
+#include <mpi.h>
+
+#include "zblock.h"
+
+/*************************************************
+ * compressed frames of one snapshot file
+ *  components of a frame are staged on host and coded by zblock in
+ *  a background thread with num_of_thread workers over blocks, while
+ *  time loop goes on. the coded frame is written at next output or
+ *  flush, netcdf is only called by the main thread. in the file each
+ *  component has
+ *    <name>_zstart [time]         byte of first block in zdata
+ *    <name>_zsize  [time][block]  bytes of each block
+ *    <name>_eb     [time]         absolute error bound of frame, the
+ *                                 relative bound is of value range of
+ *                                 frame over all threads of snapshot
+ *  and zdata [zbyte] keeps the blocks of all, each block can be
+ *  decoded alone. parameters of codec are global attributes. file is of
+ *  64 bit data format (CDF-5), zdata is not limited to 4 GiB
+ *************************************************/
+
+#define ZSNAP_MAX_CMP 15 // V, T and E
+
+typedef struct zsnap_t zsnap_t;
+
+typedef struct
+{
+  zsnap_t *zsnap;
+  int iw;
+} zsnap_worker_t;
+
+struct zsnap_t
+{
+  int   enable;
+  float err_abs;
+  float err_rel;
+  int   num_of_thread;
+  MPI_Comm comm; // threads of snapshot, for value range of relative bound
+
+  int    ni, nj, nk;
+  size_t siz_frame;
+  int    num_of_block;
+  size_t siz_zbuf;  // of one component
+
+  int num_of_var;
+  int icmp_to_var[ZSNAP_MAX_CMP]; // -1 if not output
+
+  // nc ids
+  int varid_zstart[ZSNAP_MAX_CMP];
+  int varid_zsize [ZSNAP_MAX_CMP];
+  int varid_eb    [ZSNAP_MAX_CMP];
+  int varid_zdata;
+
+  size_t zpos;       // next byte of zdata
+  int    is_zpos_set; // not after reopen
+
+  // staged frame
+  int     it_frame;  // -1 for none
+  float  *frame;     // [num_of_var][siz_frame]
+  unsigned char *zbuf; // [num_of_var][siz_zbuf]
+  int    *zsize;     // [num_of_var][num_of_block]
+  size_t *zbyte;     // [num_of_var]
+  float  *eb;        // [num_of_var]
+
+  pthread_t compressor;
+  int is_busy;
+  zsnap_worker_t *worker;
+};
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+int
+zsnap_init(zsnap_t *zsnap, float err_abs, float err_rel, int num_of_thread,
+           int ni, int nj, int nk, int *is_cmp_out, MPI_Comm comm);
+
+int
+zsnap_def(zsnap_t *zsnap, int ncid, int dimid_time, const char **cmp_name);
+
+int
+zsnap_inq(zsnap_t *zsnap, int ncid, const char **cmp_name);
+
+float *
+zsnap_frame(zsnap_t *zsnap, int icmp);
+
+int
+zsnap_start(zsnap_t *zsnap, int it_frame);
+
+int
+zsnap_wait(zsnap_t *zsnap);
+
+int
+zsnap_write(zsnap_t *zsnap, int ncid);
+
+int
+zsnap_free(zsnap_t *zsnap);
+
+#endif
@@ -0,0 +1,366 @@
+/*******************************************************************************
+ * error-bounded lossy codec of 3d float blocks
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "zblock.h"
+
+/*
+ * bits msb first
+ */
+
+typedef struct
+{
+  unsigned char *p;
+  size_t   pos;
+  size_t   cap;
+  uint64_t acc;
+  int      nacc;
+  int      is_full;
+} zblock_bits_t;
+
+static inline void
+zblock_put(zblock_bits_t *bs, uint32_t val, int nbit)
+{
+  if (nbit == 0) return;
+  bs->acc   = (bs->acc << nbit) | val;
+  bs->nacc += nbit;
+  while (bs->nacc >= 8)
+  {
+    bs->nacc -= 8;
+    if (bs->pos < bs->cap) {
+      bs->p[bs->pos++] = (unsigned char) (bs->acc >> bs->nacc);
+    } else {
+      bs->is_full = 1;
+    }
+  }
+}
+
+static inline void
+zblock_put_end(zblock_bits_t *bs)
+{
+  if (bs->nacc > 0) zblock_put(bs, 0, 8 - bs->nacc);
+}
+
+static inline int
+zblock_get(zblock_bits_t *bs, int nbit, uint32_t *val)
+{
+  while (bs->nacc < nbit)
+  {
+    if (bs->pos >= bs->cap) return 1;
+    bs->acc   = (bs->acc << 8) | bs->p[bs->pos++];
+    bs->nacc += 8;
+  }
+  bs->nacc -= nbit;
+  *val = (uint32_t) ((bs->acc >> bs->nacc) & ((nbit == 32) ? 0xffffffffULL : ((1ULL << nbit) - 1)));
+  return 0;
+}
+
+/*
+ * same expression in encoder and decoder
+ */
+
+static inline float
+zblock_recon(int64_t q, double two_eb)
+{
+  return (float) ((double) q * two_eb);
+}
+
+/*
+ * 3d Lorenzo predictor of quantized values, out of block is zero
+ */
+
+static inline int64_t
+zblock_pred(const int64_t *q, int i, int j, int k, int bi, int bj)
+{
+  size_t sj = bi, sk = (size_t) bi * bj;
+  size_t n  = i + j * sj + k * sk;
+  int64_t a   = (i > 0) ? q[n-1] : 0;
+  int64_t b   = (j > 0) ? q[n-sj] : 0;
+  int64_t c   = (k > 0) ? q[n-sk] : 0;
+  int64_t ab  = (i > 0 && j > 0) ? q[n-1-sj] : 0;
+  int64_t ac  = (i > 0 && k > 0) ? q[n-1-sk] : 0;
+  int64_t bc  = (j > 0 && k > 0) ? q[n-sj-sk] : 0;
+  int64_t abc = (i > 0 && j > 0 && k > 0) ? q[n-1-sj-sk] : 0;
+
+  return a + b + c - ab - ac - bc + abc;
+}
+
+static size_t
+zblock_encode_raw(const float *v, int bi, int bj, int bk, size_t sj, size_t sk,
+                  unsigned char *out)
+{
+  size_t pos = 0;
+  out[pos++] = ZBLOCK_MODE_RAW;
+  for (int k=0; k < bk; k++) {
+    for (int j=0; j < bj; j++) {
+      memcpy(out + pos, v + j * sj + k * sk, bi * sizeof(float));
+      pos += bi * sizeof(float);
+    }
+  }
+  return pos;
+}
+
+size_t
+zblock_encode(const float *v, int bi, int bj, int bk, size_t sj, size_t sk,
+              float eb, unsigned char *out)
+{
+  int npt = bi * bj * bk;
+
+  if (!(eb > 0.0f)) {
+    // no quantization, only exact zero block is saved
+    for (int k=0; k < bk; k++) {
+      for (int j=0; j < bj; j++) {
+        for (int i=0; i < bi; i++) {
+          if (v[i + j * sj + k * sk] != 0.0f) {
+            return zblock_encode_raw(v, bi, bj, bk, sj, sk, out);
+          }
+        }
+      }
+    }
+    out[0] = ZBLOCK_MODE_ZERO;
+    return 1;
+  }
+
+  int64_t  q[ZBLOCK_MAX_POINTS];
+  uint64_t u[ZBLOCK_MAX_POINTS];
+  double two_eb = 2.0 * (double) eb;
+  double inv    = 1.0 / two_eb;
+
+  // quantize, bound is checked on decoded value
+  int is_zero = 1;
+  int n = 0;
+  for (int k=0; k < bk; k++) {
+    for (int j=0; j < bj; j++) {
+      for (int i=0; i < bi; i++, n++)
+      {
+        float  val = v[i + j * sj + k * sk];
+        double r   = rint((double) val * inv);
+        if (!(fabs(r) < ZBLOCK_MAX_Q) ||
+            !(fabsf(zblock_recon((int64_t) r, two_eb) - val) <= eb)) {
+          return zblock_encode_raw(v, bi, bj, bk, sj, sk, out);
+        }
+        q[n] = (int64_t) r;
+        if (q[n] != 0) is_zero = 0;
+      }
+    }
+  }
+  if (is_zero == 1) {
+    out[0] = ZBLOCK_MODE_ZERO;
+    return 1;
+  }
+
+  // zigzag of residuals
+  double sum = 0.0;
+  n = 0;
+  for (int k=0; k < bk; k++) {
+    for (int j=0; j < bj; j++) {
+      for (int i=0; i < bi; i++, n++)
+      {
+        int64_t d = q[n] - zblock_pred(q, i, j, k, bi, bj);
+        u[n] = ((uint64_t) d << 1) ^ (uint64_t) (d >> 63);
+        sum += (double) u[n];
+      }
+    }
+  }
+
+  // parameter near log2 of mean, best of neighbours
+  int k0 = 0;
+  while (k0 < 30 && (double) (1ULL << (k0 + 1)) <= sum / npt + 1.0) k0++;
+  int    k_best    = k0;
+  size_t bit_best  = (size_t) -1;
+  for (int kk = (k0 > 0 ? k0 - 1 : 0); kk <= k0 + 1; kk++)
+  {
+    size_t nbit = 0;
+    for (n=0; n < npt; n++) {
+      uint64_t qu = u[n] >> kk;
+      nbit += (qu < ZBLOCK_ESC) ? qu + 1 + kk : ZBLOCK_ESC + 64;
+    }
+    if (nbit < bit_best) {
+      bit_best = nbit;
+      k_best   = kk;
+    }
+  }
+
+  size_t cap = 1 + (size_t) npt * sizeof(float);
+  if (2 + (bit_best + 7) / 8 >= cap) {
+    return zblock_encode_raw(v, bi, bj, bk, sj, sk, out);
+  }
+
+  out[0] = ZBLOCK_MODE_RICE;
+  out[1] = (unsigned char) k_best;
+  zblock_bits_t bs = { out, 2, cap, 0, 0, 0 };
+  for (n=0; n < npt; n++)
+  {
+    uint64_t qu = u[n] >> k_best;
+    if (qu < ZBLOCK_ESC)
+    {
+      zblock_put(&bs, (uint32_t) ((1ULL << qu) - 1), (int) qu);
+      zblock_put(&bs, 0, 1);
+      if (k_best > 16) {
+        zblock_put(&bs, (uint32_t) (u[n] >> 16) & ((1U << (k_best - 16)) - 1), k_best - 16);
+        zblock_put(&bs, (uint32_t) u[n] & 0xffff, 16);
+      } else {
+        zblock_put(&bs, (uint32_t) u[n] & ((1U << k_best) - 1), k_best);
+      }
+    }
+    else
+    {
+      zblock_put(&bs, (1U << ZBLOCK_ESC) - 1, ZBLOCK_ESC);
+      zblock_put(&bs, (uint32_t) (u[n] >> 48), 16);
+      zblock_put(&bs, (uint32_t) (u[n] >> 32) & 0xffff, 16);
+      zblock_put(&bs, (uint32_t) (u[n] >> 16) & 0xffff, 16);
+      zblock_put(&bs, (uint32_t) u[n] & 0xffff, 16);
+    }
+  }
+  zblock_put_end(&bs);
+
+  if (bs.is_full == 1) {
+    return zblock_encode_raw(v, bi, bj, bk, sj, sk, out);
+  }
+
+  return bs.pos;
+}
+
+int
+zblock_decode(const unsigned char *in, size_t nbyte,
+              int bi, int bj, int bk, size_t sj, size_t sk,
+              float eb, float *v)
+{
+  int npt = bi * bj * bk;
+
+  if (nbyte < 1) return 1;
+
+  if (in[0] == ZBLOCK_MODE_ZERO)
+  {
+    for (int k=0; k < bk; k++) {
+      for (int j=0; j < bj; j++) {
+        memset(v + j * sj + k * sk, 0, bi * sizeof(float));
+      }
+    }
+    return 0;
+  }
+
+  if (in[0] == ZBLOCK_MODE_RAW)
+  {
+    if (nbyte < 1 + (size_t) npt * sizeof(float)) return 1;
+    size_t pos = 1;
+    for (int k=0; k < bk; k++) {
+      for (int j=0; j < bj; j++) {
+        memcpy(v + j * sj + k * sk, in + pos, bi * sizeof(float));
+        pos += bi * sizeof(float);
+      }
+    }
+    return 0;
+  }
+
+  if (in[0] != ZBLOCK_MODE_RICE || nbyte < 2) return 1;
+
+  int k_rice = in[1];
+  if (k_rice > 32) return 1;
+
+  int64_t q[ZBLOCK_MAX_POINTS];
+  double two_eb = 2.0 * (double) eb;
+  zblock_bits_t bs = { (unsigned char *) in, 2, nbyte, 0, 0, 0 };
+
+  int n = 0;
+  for (int k=0; k < bk; k++) {
+    for (int j=0; j < bj; j++) {
+      for (int i=0; i < bi; i++, n++)
+      {
+        uint32_t bit = 1, hi = 0, lo = 0;
+        int qu = 0;
+        while (qu < ZBLOCK_ESC)
+        {
+          if (zblock_get(&bs, 1, &bit) != 0) return 1;
+          if (bit == 0) break;
+          qu++;
+        }
+
+        uint64_t u;
+        if (qu < ZBLOCK_ESC)
+        {
+          if (k_rice > 16) {
+            if (zblock_get(&bs, k_rice - 16, &hi) != 0) return 1;
+            if (zblock_get(&bs, 16, &lo) != 0) return 1;
+            u = ((uint64_t) qu << k_rice) | ((uint64_t) hi << 16) | lo;
+          } else {
+            if (zblock_get(&bs, k_rice, &lo) != 0) return 1;
+            u = ((uint64_t) qu << k_rice) | lo;
+          }
+        }
+        else
+        {
+          u = 0;
+          for (int m=0; m < 4; m++) {
+            if (zblock_get(&bs, 16, &lo) != 0) return 1;
+            u = (u << 16) | lo;
+          }
+        }
+
+        int64_t d = (int64_t) (u >> 1) ^ -(int64_t) (u & 1);
+        q[n] = d + zblock_pred(q, i, j, k, bi, bj);
+        v[i + j * sj + k * sk] = zblock_recon(q[n], two_eb);
+      }
+    }
+  }
+
+  return 0;
+}
+
+int
+zblock_frame_dims(int ni, int nj, int nk, int *nbi, int *nbj, int *nbk)
+{
+  *nbi = (ni + ZBLOCK_N - 1) / ZBLOCK_N;
+  *nbj = (nj + ZBLOCK_N - 1) / ZBLOCK_N;
+  *nbk = (nk + ZBLOCK_N - 1) / ZBLOCK_N;
+
+  return (*nbi) * (*nbj) * (*nbk);
+}
+
+/*
+ * first point of block b in frame and its size, edge blocks are smaller
+ */
+
+size_t
+zblock_frame_offset(int b, int ni, int nj, int nk,
+                    int *bi, int *bj, int *bk)
+{
+  int nbi, nbj, nbk;
+  zblock_frame_dims(ni, nj, nk, &nbi, &nbj, &nbk);
+
+  int i0 = (b % nbi) * ZBLOCK_N;
+  int j0 = (b / nbi % nbj) * ZBLOCK_N;
+  int k0 = (b / (nbi * nbj)) * ZBLOCK_N;
+  *bi = (ni - i0 < ZBLOCK_N) ? ni - i0 : ZBLOCK_N;
+  *bj = (nj - j0 < ZBLOCK_N) ? nj - j0 : ZBLOCK_N;
+  *bk = (nk - k0 < ZBLOCK_N) ? nk - k0 : ZBLOCK_N;
+
+  return i0 + (size_t) j0 * ni + (size_t) k0 * ni * nj;
+}
+
+void
+zblock_frame_range(const float *v, size_t n, float *vmin, float *vmax)
+{
+  float v1 = 0.0f, v2 = 0.0f;
+  int is_first = 1;
+
+  for (size_t m=0; m < n; m++)
+  {
+    if (!isfinite(v[m])) continue;
+    if (is_first == 1) {
+      v1 = v[m];
+      v2 = v[m];
+      is_first = 0;
+    }
+    if (v[m] < v1) v1 = v[m];
+    if (v[m] > v2) v2 = v[m];
+  }
+
+  *vmin = v1;
+  *vmax = v2;
+}
@@ -0,0 +1,62 @@
+#ifndef ZBLOCK_H
+#define ZBLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*************************************************
+ * error-bounded lossy codec of 3d float blocks, host only
+ *  values are quantized to integers q = rint(v/(2*eb)), so each decoded
+ *  value is within eb of the input. q is predicted from its neighbours
+ *  in the block by 3d Lorenzo, and the residuals are Rice coded with
+ *  the best parameter of the block. blocks are coded independently,
+ *  each stream starts with one mode byte:
+ *    ZERO  all q are 0, no more bytes
+ *    RICE  one byte of Rice parameter k, then bits of residuals
+ *    RAW   floats as they are, when quantization overflows, misses eb
+ *          in float precision, or doesn't save space
+ *************************************************/
+
+#define ZBLOCK_N          8   // points of block edge
+#define ZBLOCK_MAX_POINTS (ZBLOCK_N * ZBLOCK_N * ZBLOCK_N)
+
+#define ZBLOCK_MODE_ZERO  0
+#define ZBLOCK_MODE_RICE  1
+#define ZBLOCK_MODE_RAW   2
+
+#define ZBLOCK_ESC        24  // unary quotient of escaped 64 bit residual
+#define ZBLOCK_MAX_Q      1073741824.0 // |q| limit, 2^30
+
+// max bytes of one block stream
+#define ZBLOCK_BOUND(npt) (2 + 4 * (size_t)(npt))
+
+/*************************************************
+ * function prototype
+ *************************************************/
+
+// block of bi x bj x bk points at v, strides sj and sk of j and k,
+//  returns bytes written to out
+size_t
+zblock_encode(const float *v, int bi, int bj, int bk, size_t sj, size_t sk,
+              float eb, unsigned char *out);
+
+// returns 0, or 1 if stream is broken
+int
+zblock_decode(const unsigned char *in, size_t nbyte,
+              int bi, int bj, int bk, size_t sj, size_t sk,
+              float eb, float *v);
+
+// blocks of frame of ni x nj x nk, i fastest, block b is
+//  (b % nbi, b / nbi % nbj, b / (nbi*nbj))
+int
+zblock_frame_dims(int ni, int nj, int nk, int *nbi, int *nbj, int *nbk);
+
+size_t
+zblock_frame_offset(int b, int ni, int nj, int nk,
+                    int *bi, int *bj, int *bk);
+
+// min and max of n values, NaN and Inf are skipped
+void
+zblock_frame_range(const float *v, size_t n, float *vmin, float *vmax);
+
+#endif
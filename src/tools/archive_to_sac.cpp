@@ -0,0 +1,149 @@
+/*******************************************************************************
+ * write sac files of all traces in seismo_archive.nc, with the same names
+ *  and headers as sac output of the solver
+ *
+ *  usage: archive_to_sac <seismo_archive.nc> <output_dir>
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netcdf.h>
+
+#include "sacLib.h"
+
+// same as src/forward/io_funcs.h
+#define IO_ARCHIVE_NAME_STRLEN 128
+#define MAX_STRLEN 1024
+
+static void
+handle_nc_err(int ierr)
+{
+  if (ierr != NC_NOERR) {
+    fprintf(stderr,"Error: %s\n", nc_strerror(ierr));
+    exit(1);
+  }
+}
+
+static int
+inq_dim_len(int ncid, const char *kind, const char *suffix, size_t *len)
+{
+  char name[MAX_STRLEN];
+  int  dimid;
+  sprintf(name, "%s_%s", kind, suffix);
+  if (nc_inq_dimid(ncid, name, &dimid) != NC_NOERR) return 1;
+  handle_nc_err(nc_inq_dimlen(ncid, dimid, len));
+  return 0;
+}
+
+static int
+get_varid(int ncid, const char *kind, const char *suffix)
+{
+  char name[MAX_STRLEN];
+  int  varid;
+  sprintf(name, "%s_%s", kind, suffix);
+  handle_nc_err(nc_inq_varid(ncid, name, &varid));
+  return varid;
+}
+
+/*
+ * sac files of one kind of stations, name of file is prefix name.cmp.sac
+ */
+
+static int
+write_kind(int ncid, const char *kind, const char *prefix, char *output_dir)
+{
+  size_t num_of_sta, ncmp, nt;
+  if (inq_dim_len(ncid, kind, "station", &num_of_sta) != 0) return 0;
+  inq_dim_len(ncid, kind, "component", &ncmp);
+  inq_dim_len(ncid, kind, "time", &nt);
+
+  int varid_seismo = get_varid(ncid, kind, "seismo");
+  float delta;
+  handle_nc_err(nc_get_att_float(ncid, varid_seismo, "delta", &delta));
+
+  // strain of stations in elastic iso medium
+  size_t nstrain = 0;
+  int varid_strain = -1;
+  if (inq_dim_len(ncid, kind, "strain_component", &nstrain) == 0) {
+    varid_strain = get_varid(ncid, kind, "strain");
+  }
+  char strain_name[6][8] = {"Exx","Eyy","Ezz","Eyz","Exz","Exy"};
+
+  char *cmp_name = (char *) malloc(ncmp * IO_ARCHIVE_NAME_STRLEN);
+  handle_nc_err(nc_get_var_text(ncid, get_varid(ncid, kind, "component_name"), cmp_name));
+
+  char  *sta_name = (char  *) malloc(num_of_sta * IO_ARCHIVE_NAME_STRLEN);
+  float *x = (float *) malloc(num_of_sta * sizeof(float));
+  float *y = (float *) malloc(num_of_sta * sizeof(float));
+  float *z = (float *) malloc(num_of_sta * sizeof(float));
+  handle_nc_err(nc_get_var_text (ncid, get_varid(ncid, kind, "name"), sta_name));
+  handle_nc_err(nc_get_var_float(ncid, get_varid(ncid, kind, "x"), x));
+  handle_nc_err(nc_get_var_float(ncid, get_varid(ncid, kind, "y"), y));
+  handle_nc_err(nc_get_var_float(ncid, get_varid(ncid, kind, "z"), z));
+
+  size_t nbuff = (ncmp > nstrain ? ncmp : nstrain) * nt;
+  float *seismo = (float *) malloc(nbuff * sizeof(float));
+  char ou_file[MAX_STRLEN];
+  char err_message[MAX_STRLEN];
+
+  for (size_t ir=0; ir < num_of_sta; ir++)
+  {
+    char *name = sta_name + ir * IO_ARCHIVE_NAME_STRLEN;
+    name[IO_ARCHIVE_NAME_STRLEN-1] = '\0';
+
+    size_t start[3] = { ir, 0, 0 };
+    size_t count[3] = { 1, ncmp, nt };
+    handle_nc_err(nc_get_vara_float(ncid, varid_seismo, start, count, seismo));
+    for (size_t icmp=0; icmp < ncmp; icmp++)
+    {
+      char *this_cmp = cmp_name + icmp * IO_ARCHIVE_NAME_STRLEN;
+      this_cmp[IO_ARCHIVE_NAME_STRLEN-1] = '\0';
+      sprintf(ou_file, "%s/%s%s.%s.sac", output_dir, prefix, name, this_cmp);
+      sacExport1C1R(ou_file, seismo + icmp * nt, 0.0, 0.0, 0.0, 0.0,
+                    x[ir], y[ir], z[ir], delta, delta, nt, err_message);
+    }
+
+    if (varid_strain < 0) continue;
+
+    count[1] = nstrain;
+    handle_nc_err(nc_get_vara_float(ncid, varid_strain, start, count, seismo));
+    for (size_t icmp=0; icmp < nstrain && icmp < 6; icmp++)
+    {
+      sprintf(ou_file, "%s/%s%s.%s.sac", output_dir, prefix, name, strain_name[icmp]);
+      sacExport1C1R(ou_file, seismo + icmp * nt, 0.0, 0.0, 0.0, 0.0,
+                    x[ir], y[ir], z[ir], delta, delta, nt, err_message);
+    }
+  }
+
+  fprintf(stdout, "%s: %d stations, %d components, %d samples, delta=%g\n",
+          kind, (int)num_of_sta, (int)(ncmp + nstrain), (int)nt, delta);
+
+  free(cmp_name);
+  free(sta_name);
+  free(x);
+  free(y);
+  free(z);
+  free(seismo);
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc != 3) {
+    fprintf(stdout,"usage: archive_to_sac <seismo_archive.nc> <output_dir>\n");
+    exit(1);
+  }
+
+  int ncid;
+  handle_nc_err(nc_open(argv[1], NC_NOWRITE, &ncid));
+
+  write_kind(ncid, "recv"      , ""      , argv[2]);
+  write_kind(ncid, "line"      , ""      , argv[2]);
+  write_kind(ncid, "fault_recv", "fault_", argv[2]);
+
+  handle_nc_err(nc_close(ncid));
+
+  return 0;
+}
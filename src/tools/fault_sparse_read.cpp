@@ -0,0 +1,218 @@
+/*******************************************************************************
+ * reconstruct dense fault frames from sparse fault output
+ *  frames are rebuilt by applying written points in order from the last
+ *  key frame before the first frame asked for, found by the index file.
+ *  output nc has the same time, Tn ... Slip2 vars as the dense fault
+ *  output, Peak_vs and Init_t0 stay in the fault nc file of the run
+ *
+ *  usage: fault_sparse_read <x_sparse.bin> <x_sparse.idx> <out.nc>
+ *                           [frame_start frame_count]
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netcdf.h>
+
+// same layout as src/forward/fault_sparse_t.h
+#define FAULT_SPARSE_MAGIC     "CGFDFSP1"
+#define FAULT_SPARSE_IDX_MAGIC "CGFDFSI1"
+#define FAULT_SPARSE_NCMP      9
+#define FAULT_SPARSE_NAME_STRLEN 8
+
+typedef struct
+{
+  int   it;
+  float time;
+  int   num_of_run;
+  int   num_of_point;
+  int   is_key;
+  long long offset;
+} fault_sparse_idx_t;
+
+static void
+handle_nc_err(int ierr)
+{
+  if (ierr != NC_NOERR) {
+    fprintf(stderr,"Error: %s\n", nc_strerror(ierr));
+    exit(1);
+  }
+}
+
+static long long
+file_size(FILE *fp)
+{
+  fseek(fp, 0, SEEK_END);
+  long long nbyte = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  return nbyte;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc != 4 && argc != 6) {
+    fprintf(stdout,"usage: fault_sparse_read <x_sparse.bin> <x_sparse.idx> <out.nc>"
+                   " [frame_start frame_count]\n");
+    exit(1);
+  }
+
+  FILE *fp     = fopen(argv[1], "rb");
+  FILE *fp_idx = fopen(argv[2], "rb");
+  if (fp == NULL || fp_idx == NULL) {
+    fprintf(stderr,"Error: can't open %s or %s\n", argv[1], argv[2]);
+    exit(1);
+  }
+  long long nbyte_bin = file_size(fp);
+  long long nbyte_idx = file_size(fp_idx);
+
+  //-- header
+  char magic[8];
+  int  nj, nk, ncmp, i_index, topoid[3];
+  float vs_threshold, tolerance;
+  char cmp_name[FAULT_SPARSE_NCMP][FAULT_SPARSE_NAME_STRLEN];
+  int ierr = 0;
+  ierr += fread(magic, 1, 8, fp) != 8;
+  ierr += fread(&nj,      sizeof(int), 1, fp) != 1;
+  ierr += fread(&nk,      sizeof(int), 1, fp) != 1;
+  ierr += fread(&ncmp,    sizeof(int), 1, fp) != 1;
+  ierr += fread(&i_index, sizeof(int), 1, fp) != 1;
+  ierr += fread(topoid,   sizeof(int), 3, fp) != 3;
+  ierr += fread(&vs_threshold, sizeof(float), 1, fp) != 1;
+  ierr += fread(&tolerance,    sizeof(float), 1, fp) != 1;
+  ierr += fread(cmp_name, 1, sizeof(cmp_name), fp) != sizeof(cmp_name);
+  if (ierr != 0 || strncmp(magic, FAULT_SPARSE_MAGIC, 8) != 0 || ncmp != FAULT_SPARSE_NCMP) {
+    fprintf(stderr,"Error: %s is not sparse fault output\n", argv[1]);
+    exit(1);
+  }
+
+  //-- index table
+  if (fread(magic, 1, 8, fp_idx) != 8 || strncmp(magic, FAULT_SPARSE_IDX_MAGIC, 8) != 0) {
+    fprintf(stderr,"Error: %s is not index of sparse fault output\n", argv[2]);
+    exit(1);
+  }
+  int num_of_frame = 0;
+  int max_frame    = 1024;
+  fault_sparse_idx_t *idx = (fault_sparse_idx_t *) malloc(max_frame * sizeof(fault_sparse_idx_t));
+  for (;;)
+  {
+    fault_sparse_idx_t rec;
+    if (fread(&rec.it,           sizeof(int),   1, fp_idx) != 1) break;
+    if (fread(&rec.time,         sizeof(float), 1, fp_idx) != 1) break;
+    if (fread(&rec.num_of_run,   sizeof(int),   1, fp_idx) != 1) break;
+    if (fread(&rec.num_of_point, sizeof(int),   1, fp_idx) != 1) break;
+    if (fread(&rec.is_key,       sizeof(int),   1, fp_idx) != 1) break;
+    if (fread(&rec.offset, sizeof(long long),   1, fp_idx) != 1) break;
+    if (num_of_frame == max_frame) {
+      max_frame *= 2;
+      idx = (fault_sparse_idx_t *) realloc(idx, max_frame * sizeof(fault_sparse_idx_t));
+    }
+    idx[num_of_frame] = rec;
+    num_of_frame += 1;
+  }
+  fclose(fp_idx);
+
+  int frame_start = 0;
+  int frame_count = num_of_frame;
+  if (argc == 6) {
+    frame_start = atoi(argv[4]);
+    frame_count = atoi(argv[5]);
+  }
+  if (frame_start < 0 || frame_count < 0 || frame_start + frame_count > num_of_frame) {
+    fprintf(stderr,"Error: frames [%d,%d) out of %d frames\n",
+            frame_start, frame_start+frame_count, num_of_frame);
+    exit(1);
+  }
+
+  // rebuild from last key frame
+  int frame_key = 0;
+  for (int n=0; n <= frame_start && n < num_of_frame; n++) {
+    if (idx[n].is_key == 1) frame_key = n;
+  }
+
+  //-- output nc, same as dense fault output
+  int ncid, dimid[3], timeid, varid[FAULT_SPARSE_NCMP];
+  handle_nc_err(nc_create(argv[3], NC_CLOBBER, &ncid));
+  handle_nc_err(nc_def_dim(ncid, "time", NC_UNLIMITED, &dimid[0]));
+  handle_nc_err(nc_def_dim(ncid, "k"   , nk          , &dimid[1]));
+  handle_nc_err(nc_def_dim(ncid, "j"   , nj          , &dimid[2]));
+  handle_nc_err(nc_def_var(ncid, "time", NC_FLOAT, 1, dimid, &timeid));
+  for (int icmp=0; icmp < ncmp; icmp++) {
+    cmp_name[icmp][FAULT_SPARSE_NAME_STRLEN-1] = '\0';
+    handle_nc_err(nc_def_var(ncid, cmp_name[icmp], NC_FLOAT, 3, dimid, varid+icmp));
+  }
+  nc_put_att_int(ncid, NC_GLOBAL, "i_index_with_ghosts_in_this_thread", NC_INT, 1, &i_index);
+  nc_put_att_int(ncid, NC_GLOBAL, "coords_of_mpi_topo", NC_INT, 3, topoid);
+  handle_nc_err(nc_enddef(ncid));
+
+  //-- apply frames
+  size_t siz_slice = (size_t)nj * nk;
+  float *cur = (float *) calloc(ncmp * siz_slice, sizeof(float));
+  int   *run = (int   *) malloc((siz_slice+1) * sizeof(int));
+  float *val = (float *) malloc(ncmp * siz_slice * sizeof(float));
+
+  for (int n = frame_key; n < frame_start + frame_count; n++)
+  {
+    int it, num_of_run, num_of_point;
+    float time;
+    fseek(fp, idx[n].offset, SEEK_SET);
+    ierr = 0;
+    ierr += fread(&it,           sizeof(int),   1, fp) != 1;
+    ierr += fread(&time,         sizeof(float), 1, fp) != 1;
+    ierr += fread(&num_of_run,   sizeof(int),   1, fp) != 1;
+    ierr += fread(&num_of_point, sizeof(int),   1, fp) != 1;
+    if (ierr != 0 || it != idx[n].it || num_of_run != idx[n].num_of_run ||
+        num_of_point != idx[n].num_of_point || num_of_point > (int)siz_slice)
+    {
+      fprintf(stderr,"Error: frame %d of %s does not match its index\n", n, argv[1]);
+      exit(1);
+    }
+    size_t nval = (size_t)ncmp * num_of_point;
+    ierr += fread(run, sizeof(int), 2*num_of_run, fp) != 2*num_of_run;
+    ierr += fread(val, sizeof(float), nval, fp) != nval;
+    if (ierr != 0) {
+      fprintf(stderr,"Error: frame %d of %s is cut\n", n, argv[1]);
+      exit(1);
+    }
+
+    int ip = 0;
+    for (int r=0; r < num_of_run; r++)
+    {
+      for (int p = run[2*r]; p < run[2*r] + run[2*r+1]; p++) {
+        for (int icmp=0; icmp < ncmp; icmp++) {
+          cur[icmp*siz_slice + p] = val[icmp*num_of_point + ip];
+        }
+        ip += 1;
+      }
+    }
+
+    if (n < frame_start) continue;
+
+    size_t start_t   = n - frame_start;
+    size_t startp[3] = { start_t, 0, 0 };
+    size_t countp[3] = { 1, (size_t)nk, (size_t)nj };
+    handle_nc_err(nc_put_var1_float(ncid, timeid, &start_t, &time));
+    for (int icmp=0; icmp < ncmp; icmp++) {
+      handle_nc_err(nc_put_vara_float(ncid, varid[icmp], startp, countp, cur + icmp*siz_slice));
+    }
+  }
+
+  handle_nc_err(nc_close(ncid));
+  fclose(fp);
+
+  // dense frames of fault nc: time and ncmp values of all points
+  double nbyte_dense  = (double) num_of_frame * sizeof(float) * (1 + ncmp * siz_slice);
+  double nbyte_sparse = (double) (nbyte_bin + nbyte_idx);
+  fprintf(stdout,"%d frames of %d x %d points, vs_threshold=%g, tolerance=%g\n",
+          num_of_frame, nj, nk, vs_threshold, tolerance);
+  fprintf(stdout,"sparse %.3f MB, dense %.3f MB, compression ratio %.2f\n",
+          nbyte_sparse / 1.0e6, nbyte_dense / 1.0e6,
+          nbyte_sparse > 0.0 ? nbyte_dense / nbyte_sparse : 0.0);
+  fprintf(stdout,"wrote frames [%d,%d) to %s\n", frame_start, frame_start+frame_count, argv[3]);
+
+  free(idx);
+  free(cur);
+  free(run);
+  free(val);
+
+  return 0;
+}
@@ -0,0 +1,553 @@
+/*******************************************************************************
+ * merge nc files of all threads (fault, slice, snapshot, PG_V_A_D) into one
+ *  global file. place of each file is taken from its global attribute
+ *  "first_index_to_snapshot_output" of snapshot, or
+ *  "global_index_of_first_physical_points" of others, with ghost points
+ *  dropped by "count_index_of_physical_points" if dims have them.
+ *
+ *  netcdf library is not thread safe, so the pool is of worker processes:
+ *  each opens its share of input files once, reads hyperslabs of a chunk
+ *  of time frames into a shared buffer, while the main process writes the
+ *  previous chunk from the other buffer.
+ *
+ *  usage: nc_merge [-t first:last] [-v var1,var2,...] [-n num_of_worker]
+ *                  [-m buffer_MB] <out.nc> <in_px0_py0_pz0.nc> ...
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <netcdf.h>
+
+#define NC_MERGE_MAX_VAR 64
+#define NC_MERGE_NAME_STRLEN 256
+
+// spatial axes
+#define NC_MERGE_NAXIS 3
+static const char *axis_name[NC_MERGE_NAXIS] = { "i", "j", "k" };
+
+typedef struct
+{
+  char *fname;
+  int   off   [NC_MERGE_NAXIS]; // global index of first point kept
+  int   start [NC_MERGE_NAXIS]; // index in file of first point kept
+  int   count [NC_MERGE_NAXIS]; // points kept
+  int   nt;
+} nc_merge_file_t;
+
+typedef struct
+{
+  char name[NC_MERGE_NAME_STRLEN];
+  int  has_time;
+  int  num_of_axis;
+  int  axis[NC_MERGE_NAXIS]; // axis of each spatial dim, in order of dims
+  size_t siz_frame;          // global points of one time frame
+} nc_merge_var_t;
+
+typedef struct
+{
+  int ivar;
+  int it0;   // first output frame
+  int nt;
+  int ibuf;
+  int is_quit;
+} nc_merge_job_t;
+
+static void
+handle_nc_err(int ierr, const char *fname)
+{
+  if (ierr != NC_NOERR) {
+    fprintf(stderr,"Error: %s: %s\n", fname, nc_strerror(ierr));
+    exit(1);
+  }
+}
+
+static int
+axis_of_dim(const char *name)
+{
+  for (int a=0; a < NC_MERGE_NAXIS; a++) {
+    if (strcmp(name, axis_name[a]) == 0) return a;
+  }
+  return -1;
+}
+
+/*
+ * place of one input file in global index
+ */
+
+static void
+read_file_info(nc_merge_file_t *F)
+{
+  int ncid, ierr;
+  ierr = nc_open(F->fname, NC_NOWRITE, &ncid); handle_nc_err(ierr, F->fname);
+
+  int len[NC_MERGE_NAXIS] = { 1, 1, 1 };
+  for (int a=0; a < NC_MERGE_NAXIS; a++)
+  {
+    int dimid;
+    size_t n;
+    if (nc_inq_dimid(ncid, axis_name[a], &dimid) == NC_NOERR) {
+      handle_nc_err(nc_inq_dimlen(ncid, dimid, &n), F->fname);
+      len[a] = (int) n;
+    }
+    F->off[a]   = 0;
+    F->start[a] = 0;
+    F->count[a] = len[a];
+  }
+
+  int dimid_t;
+  size_t nt = 0;
+  if (nc_inq_dimid(ncid, "time", &dimid_t) == NC_NOERR) {
+    handle_nc_err(nc_inq_dimlen(ncid, dimid_t, &nt), F->fname);
+  }
+  F->nt = (int) nt;
+
+  int g[NC_MERGE_NAXIS] = { 0, 0, 0 };
+  size_t natt = 0;
+  if (nc_inq_attlen(ncid, NC_GLOBAL, "first_index_to_snapshot_output", &natt) == NC_NOERR)
+  {
+    // snapshot, dims are points of output
+    handle_nc_err(nc_get_att_int(ncid, NC_GLOBAL, "first_index_to_snapshot_output", g),
+                  F->fname);
+  }
+  else if (nc_inq_attlen(ncid, NC_GLOBAL, "global_index_of_first_physical_points", &natt)
+           == NC_NOERR && natt <= NC_MERGE_NAXIS)
+  {
+    handle_nc_err(nc_get_att_int(ncid, NC_GLOBAL, "global_index_of_first_physical_points", g),
+                  F->fname);
+    // dims with ghost points
+    int c[NC_MERGE_NAXIS];
+    size_t ncount = 0;
+    if (nc_inq_attlen(ncid, NC_GLOBAL, "count_index_of_physical_points", &ncount) == NC_NOERR
+        && ncount == natt)
+    {
+      handle_nc_err(nc_get_att_int(ncid, NC_GLOBAL, "count_index_of_physical_points", c),
+                    F->fname);
+      for (int a=0; a < (int) ncount; a++) {
+        F->start[a] = (len[a] - c[a]) / 2;
+        F->count[a] = c[a];
+      }
+    }
+  }
+  else
+  {
+    fprintf(stderr,"Error: %s has no global index attribute, rerun with this version\n",
+            F->fname);
+    exit(1);
+  }
+  for (int a=0; a < NC_MERGE_NAXIS; a++) {
+    F->off[a] = g[a];
+  }
+
+  nc_close(ncid);
+}
+
+static int
+in_var_list(const char *name, char *list)
+{
+  if (list == NULL) return 1;
+
+  char buff[NC_MERGE_NAME_STRLEN * 4];
+  snprintf(buff, sizeof(buff), "%s", list);
+  for (char *p = strtok(buff, ","); p != NULL; p = strtok(NULL, ",")) {
+    if (strcmp(p, name) == 0) return 1;
+  }
+  return 0;
+}
+
+/*
+ * frames it_first+it0 ... of var of one file into its place in buf
+ */
+
+static int
+read_to_buff(int ncid, nc_merge_file_t *F, nc_merge_var_t *V, size_t *glen,
+             int it_first, int it0, int nt, float *buf, float **wrk, size_t *siz_wrk)
+{
+  int varid;
+  if (nc_inq_varid(ncid, V->name, &varid) != NC_NOERR) {
+    fprintf(stderr,"Error: %s has no var %s\n", F->fname, V->name);
+    return 1;
+  }
+
+  size_t start[NC_MERGE_NAXIS+1], count[NC_MERGE_NAXIS+1];
+  int nd = 0;
+  if (V->has_time == 1) {
+    start[0] = it_first + it0;
+    count[0] = nt;
+    nd = 1;
+  }
+  size_t siz_local = nt;
+  for (int m=0; m < V->num_of_axis; m++)
+  {
+    int a = V->axis[m];
+    start[nd+m] = F->start[a];
+    count[nd+m] = F->count[a];
+    siz_local *= F->count[a];
+  }
+
+  if (*siz_wrk < siz_local)
+  {
+    free(*wrk);
+    *wrk = (float *) malloc(siz_local * sizeof(float));
+    *siz_wrk = siz_local;
+  }
+  int ierr = nc_get_vara_float(ncid, varid, start, count, *wrk);
+  if (ierr != NC_NOERR) {
+    fprintf(stderr,"Error: %s: %s: %s\n", F->fname, V->name, nc_strerror(ierr));
+    return 1;
+  }
+
+  // dims of var in order, padded to 3 in front
+  size_t lcnt[NC_MERGE_NAXIS] = { 1, 1, 1 };
+  size_t loff[NC_MERGE_NAXIS] = { 0, 0, 0 };
+  size_t gcnt[NC_MERGE_NAXIS] = { 1, 1, 1 };
+  int pad = NC_MERGE_NAXIS - V->num_of_axis;
+  for (int m=0; m < V->num_of_axis; m++)
+  {
+    int a = V->axis[m];
+    lcnt[pad+m] = F->count[a];
+    loff[pad+m] = F->off[a];
+    gcnt[pad+m] = glen[a];
+  }
+
+  float *src = *wrk;
+  for (int it=0; it < nt; it++) {
+    for (size_t n0=0; n0 < lcnt[0]; n0++) {
+      for (size_t n1=0; n1 < lcnt[1]; n1++)
+      {
+        float *dst = buf + it * V->siz_frame
+                   + ((n0 + loff[0]) * gcnt[1] + n1 + loff[1]) * gcnt[2] + loff[2];
+        memcpy(dst, src, lcnt[2] * sizeof(float));
+        src += lcnt[2];
+      }
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * worker iworker keeps files ifile % num_of_worker == iworker open
+ */
+
+static void
+worker_loop(int iworker, int num_of_worker, nc_merge_file_t *F, int num_of_file,
+            nc_merge_var_t *V, size_t *glen, int it_first, float **buf,
+            int fd_job, int fd_done)
+{
+  int *ncid = (int *) malloc((num_of_file + 1) * sizeof(int));
+  for (int ifile=iworker; ifile < num_of_file; ifile += num_of_worker) {
+    handle_nc_err(nc_open(F[ifile].fname, NC_NOWRITE, &ncid[ifile]), F[ifile].fname);
+  }
+
+  float *wrk = NULL;
+  size_t siz_wrk = 0;
+  nc_merge_job_t job;
+  while (read(fd_job, &job, sizeof(job)) == sizeof(job) && job.is_quit == 0)
+  {
+    char ierr = 0;
+    for (int ifile=iworker; ifile < num_of_file && ierr == 0; ifile += num_of_worker) {
+      ierr = read_to_buff(ncid[ifile], F + ifile, V + job.ivar, glen,
+                          it_first, job.it0, job.nt, buf[job.ibuf], &wrk, &siz_wrk);
+    }
+    if (write(fd_done, &ierr, 1) != 1) break;
+  }
+
+  for (int ifile=iworker; ifile < num_of_file; ifile += num_of_worker) {
+    nc_close(ncid[ifile]);
+  }
+  free(wrk);
+  free(ncid);
+}
+
+static void
+wait_job(int num_of_worker, int *fd_done)
+{
+  for (int w=0; w < num_of_worker; w++)
+  {
+    char ierr = 1;
+    if (read(fd_done[w], &ierr, 1) != 1 || ierr != 0) {
+      fprintf(stderr,"Error: worker %d failed\n", w);
+      exit(1);
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int   it_first = 0;
+  int   it_last  = -1;
+  char *var_list = NULL;
+  int   num_of_worker = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  size_t siz_buff_mb = 1024;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "t:v:n:m:")) != -1)
+  {
+    switch (opt) {
+      case 't':
+        if (sscanf(optarg, "%d:%d", &it_first, &it_last) != 2) it_last = it_first;
+        break;
+      case 'v': var_list = optarg; break;
+      case 'n': num_of_worker = atoi(optarg); break;
+      case 'm': siz_buff_mb = atol(optarg); break;
+      default : break;
+    }
+  }
+  if (argc - optind < 2) {
+    fprintf(stdout,"usage: nc_merge [-t first:last] [-v var1,var2,...] [-n num_of_worker]\n"
+                   "                [-m buffer_MB] <out.nc> <in_px0_py0_pz0.nc> ...\n");
+    exit(1);
+  }
+  char *out_fname = argv[optind];
+  int num_of_file = argc - optind - 1;
+
+  //-- place of each file and global size
+  nc_merge_file_t *F = (nc_merge_file_t *) calloc(num_of_file, sizeof(nc_merge_file_t));
+  size_t glen[NC_MERGE_NAXIS] = { 0, 0, 0 };
+  int nt_all = -1;
+  for (int ifile=0; ifile < num_of_file; ifile++)
+  {
+    F[ifile].fname = argv[optind + 1 + ifile];
+    read_file_info(F + ifile);
+    for (int a=0; a < NC_MERGE_NAXIS; a++) {
+      size_t n = F[ifile].off[a] + F[ifile].count[a];
+      if (glen[a] < n) glen[a] = n;
+    }
+    if (nt_all < 0 || F[ifile].nt < nt_all) nt_all = F[ifile].nt;
+  }
+
+  // frames written by all threads
+  if (it_last < 0 || it_last > nt_all - 1) it_last = nt_all - 1;
+  if (it_first < 0) it_first = 0;
+  int nt_out = it_last - it_first + 1;
+  if (nt_all > 0 && nt_out <= 0) {
+    fprintf(stderr,"Error: no frame in %d:%d, files have %d frames\n",
+            it_first, it_last, nt_all);
+    exit(1);
+  }
+
+  //-- vars of first file
+  nc_merge_var_t V[NC_MERGE_MAX_VAR];
+  int num_of_var = 0;
+  int has_time_var = 0;
+  int is_axis_used[NC_MERGE_NAXIS] = { 0, 0, 0 };
+  {
+    int ncid, nvars;
+    handle_nc_err(nc_open(F[0].fname, NC_NOWRITE, &ncid), F[0].fname);
+    handle_nc_err(nc_inq_nvars(ncid, &nvars), F[0].fname);
+    for (int varid=0; varid < nvars && num_of_var < NC_MERGE_MAX_VAR; varid++)
+    {
+      nc_merge_var_t *v = V + num_of_var;
+      int ndims, dimids[NC_MAX_VAR_DIMS];
+      handle_nc_err(nc_inq_varname(ncid, varid, v->name), F[0].fname);
+      handle_nc_err(nc_inq_varndims(ncid, varid, &ndims), F[0].fname);
+      handle_nc_err(nc_inq_vardimid(ncid, varid, dimids), F[0].fname);
+
+      if (strcmp(v->name, "time") == 0) {
+        has_time_var = 1;
+        continue;
+      }
+      if (in_var_list(v->name, var_list) == 0) continue;
+
+      v->has_time    = 0;
+      v->num_of_axis = 0;
+      v->siz_frame   = 1;
+      int is_ok = 1;
+      for (int m=0; m < ndims; m++)
+      {
+        char dimname[NC_MAX_NAME+1];
+        handle_nc_err(nc_inq_dimname(ncid, dimids[m], dimname), F[0].fname);
+        int a = axis_of_dim(dimname);
+        if (m == 0 && strcmp(dimname, "time") == 0) {
+          v->has_time = 1;
+        } else if (a >= 0 && v->num_of_axis < NC_MERGE_NAXIS) {
+          v->axis[v->num_of_axis++] = a;
+          v->siz_frame *= glen[a];
+        } else {
+          is_ok = 0;
+        }
+      }
+      if (is_ok == 0 || v->num_of_axis == 0) {
+        fprintf(stdout,"skip var %s, dims are not time, k, j, i\n", v->name);
+        continue;
+      }
+      for (int m=0; m < v->num_of_axis; m++) {
+        is_axis_used[v->axis[m]] = 1;
+      }
+      num_of_var += 1;
+    }
+    nc_close(ncid);
+  }
+
+  //-- shared buffers, a chunk of frames fits in each
+  size_t siz_buff = siz_buff_mb * 1024 * 1024 / 2 / sizeof(float);
+  for (int ivar=0; ivar < num_of_var; ivar++) {
+    if (siz_buff < V[ivar].siz_frame) siz_buff = V[ivar].siz_frame;
+  }
+  float *buf[2];
+  buf[0] = (float *) mmap(NULL, 2 * siz_buff * sizeof(float), PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (buf[0] == MAP_FAILED) {
+    fprintf(stderr,"Error: can't map %zu MB of shared buffer\n",
+            2 * siz_buff * sizeof(float) / 1024 / 1024);
+    exit(1);
+  }
+  buf[1] = buf[0] + siz_buff;
+
+  //-- workers
+  if (num_of_worker < 1) num_of_worker = 1;
+  if (num_of_worker > num_of_file) num_of_worker = num_of_file;
+  int   *fd_job  = (int   *) malloc(num_of_worker * sizeof(int));
+  int   *fd_done = (int   *) malloc(num_of_worker * sizeof(int));
+  pid_t *pid     = (pid_t *) malloc(num_of_worker * sizeof(pid_t));
+  for (int w=0; w < num_of_worker; w++)
+  {
+    int p_job[2], p_done[2];
+    if (pipe(p_job) != 0 || pipe(p_done) != 0) {
+      fprintf(stderr,"Error: can't create pipe of worker\n");
+      exit(1);
+    }
+    pid[w] = fork();
+    if (pid[w] < 0) {
+      fprintf(stderr,"Error: can't fork worker\n");
+      exit(1);
+    }
+    if (pid[w] == 0)
+    {
+      close(p_job[1]);
+      close(p_done[0]);
+      for (int w0=0; w0 < w; w0++) {
+        close(fd_job[w0]);
+        close(fd_done[w0]);
+      }
+      worker_loop(w, num_of_worker, F, num_of_file, V, glen, it_first, buf,
+                  p_job[0], p_done[1]);
+      _exit(0);
+    }
+    close(p_job[0]);
+    close(p_done[1]);
+    fd_job [w] = p_job[1];
+    fd_done[w] = p_done[0];
+  }
+
+  //-- output file
+  int ncid, ierr;
+  int dimid_t = -1, dimid[NC_MERGE_NAXIS];
+  int varid_t = -1, varid[NC_MERGE_MAX_VAR];
+  ierr = nc_create(out_fname, NC_CLOBBER | NC_64BIT_OFFSET, &ncid); handle_nc_err(ierr, out_fname);
+  if (nt_all > 0) {
+    ierr = nc_def_dim(ncid, "time", NC_UNLIMITED, &dimid_t); handle_nc_err(ierr, out_fname);
+  }
+  for (int a=NC_MERGE_NAXIS-1; a >= 0; a--) {
+    if (is_axis_used[a] == 0) continue;
+    ierr = nc_def_dim(ncid, axis_name[a], glen[a], &dimid[a]); handle_nc_err(ierr, out_fname);
+  }
+  if (has_time_var == 1 && nt_all > 0) {
+    ierr = nc_def_var(ncid, "time", NC_FLOAT, 1, &dimid_t, &varid_t); handle_nc_err(ierr, out_fname);
+  }
+  for (int ivar=0; ivar < num_of_var; ivar++)
+  {
+    int d[NC_MERGE_NAXIS+1], nd = 0;
+    if (V[ivar].has_time == 1) d[nd++] = dimid_t;
+    for (int m=0; m < V[ivar].num_of_axis; m++) {
+      d[nd++] = dimid[V[ivar].axis[m]];
+    }
+    ierr = nc_def_var(ncid, V[ivar].name, NC_FLOAT, nd, d, &varid[ivar]); handle_nc_err(ierr, out_fname);
+  }
+  nc_put_att_int(ncid, NC_GLOBAL, "number_of_merged_files", NC_INT, 1, &num_of_file);
+  nc_put_att_int(ncid, NC_GLOBAL, "first_frame_of_merged_files", NC_INT, 1, &it_first);
+  ierr = nc_enddef(ncid); handle_nc_err(ierr, out_fname);
+
+  if (varid_t >= 0)
+  {
+    int ncid_in, varid_in;
+    float *t = (float *) malloc(nt_out * sizeof(float));
+    size_t start = it_first, count = nt_out;
+    handle_nc_err(nc_open(F[0].fname, NC_NOWRITE, &ncid_in), F[0].fname);
+    handle_nc_err(nc_inq_varid(ncid_in, "time", &varid_in), F[0].fname);
+    handle_nc_err(nc_get_vara_float(ncid_in, varid_in, &start, &count, t), F[0].fname);
+    nc_close(ncid_in);
+    start = 0;
+    ierr = nc_put_vara_float(ncid, varid_t, &start, &count, t); handle_nc_err(ierr, out_fname);
+    free(t);
+  }
+
+  //-- chunks of frames, next one is read while this one is written
+  for (int ivar=0; ivar < num_of_var; ivar++)
+  {
+    nc_merge_var_t *v = V + ivar;
+    int nt_var   = (v->has_time == 1) ? nt_out : 1;
+    int nt_chunk = (int) (siz_buff / v->siz_frame);
+    if (nt_chunk > nt_var) nt_chunk = nt_var;
+    int num_of_job = (nt_var + nt_chunk - 1) / nt_chunk;
+
+    nc_merge_job_t job_pre;
+    for (int ijob=0; ijob <= num_of_job; ijob++)
+    {
+      nc_merge_job_t job;
+      if (ijob < num_of_job)
+      {
+        job.ivar    = ivar;
+        job.it0     = ijob * nt_chunk;
+        job.nt      = (nt_var - job.it0 < nt_chunk) ? nt_var - job.it0 : nt_chunk;
+        job.ibuf    = ijob % 2;
+        job.is_quit = 0;
+        memset(buf[job.ibuf], 0, job.nt * v->siz_frame * sizeof(float));
+        for (int w=0; w < num_of_worker; w++) {
+          if (write(fd_job[w], &job, sizeof(job)) != sizeof(job)) {
+            fprintf(stderr,"Error: can't send job to worker %d\n", w);
+            exit(1);
+          }
+        }
+      }
+
+      if (ijob > 0)
+      {
+        wait_job(num_of_worker, fd_done);
+        size_t start[NC_MERGE_NAXIS+1], count[NC_MERGE_NAXIS+1];
+        int nd = 0;
+        if (v->has_time == 1) {
+          start[0] = job_pre.it0;
+          count[0] = job_pre.nt;
+          nd = 1;
+        }
+        for (int m=0; m < v->num_of_axis; m++) {
+          start[nd+m] = 0;
+          count[nd+m] = glen[v->axis[m]];
+        }
+        ierr = nc_put_vara_float(ncid, varid[ivar], start, count, buf[job_pre.ibuf]);
+        handle_nc_err(ierr, out_fname);
+      }
+      job_pre = job;
+    }
+    fprintf(stdout,"%s: %d frames of %zu points\n", v->name, nt_var, v->siz_frame);
+  }
+
+  ierr = nc_close(ncid); handle_nc_err(ierr, out_fname);
+
+  //-- stop workers
+  for (int w=0; w < num_of_worker; w++)
+  {
+    nc_merge_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.is_quit = 1;
+    if (write(fd_job[w], &job, sizeof(job)) != sizeof(job)) {
+      fprintf(stderr,"Error: can't stop worker %d\n", w);
+    }
+    close(fd_job[w]);
+    close(fd_done[w]);
+    waitpid(pid[w], NULL, 0);
+  }
+
+  munmap(buf[0], 2 * siz_buff * sizeof(float));
+  free(fd_job);
+  free(fd_done);
+  free(pid);
+  free(F);
+
+  return 0;
+}
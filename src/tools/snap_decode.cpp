@@ -0,0 +1,283 @@
+/*******************************************************************************
+ * decode snapshot file of compressed frames (compress_error_abs or
+ *  compress_error_rel of snapshot) to file of float components with the
+ *  same layout as plain snapshot output, so it can be read or merged by
+ *  nc_merge as usual. each decoded value is within <name>_eb of frame.
+ *
+ *  blocks of a component are decoded by threads, netcdf is only called
+ *  by the main thread.
+ *
+ *  usage: snap_decode [-n num_of_thread] <in.nc> <out.nc>
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <netcdf.h>
+
+#include "zblock.h"
+
+#define SNAP_DECODE_MAX_CMP 15
+
+static const char *cmp_name[SNAP_DECODE_MAX_CMP] = {
+  "Vx", "Vy", "Vz",
+  "Txx", "Tyy", "Tzz", "Txz", "Tyz", "Txy",
+  "Exx", "Eyy", "Ezz", "Exz", "Eyz", "Exy" };
+
+// fill of zstart marks frame not written
+#define SNAP_DECODE_NO_FRAME 1.0e36
+
+typedef struct
+{
+  const unsigned char *zdata;
+  const int    *zsize;
+  const size_t *zoff;
+  int   num_of_block;
+  int   ni, nj, nk;
+  float eb;
+  float *var;
+  int   iw;
+  int   num_of_thread;
+  int   num_of_broken;
+} snap_decode_job_t;
+
+static void
+handle_nc_err(int ierr, const char *fname)
+{
+  if (ierr != NC_NOERR) {
+    fprintf(stderr,"Error: %s: %s\n", fname, nc_strerror(ierr));
+    exit(1);
+  }
+}
+
+static void *
+decode_worker(void *arg)
+{
+  snap_decode_job_t *job = (snap_decode_job_t *) arg;
+  int ni = job->ni, nj = job->nj, nk = job->nk;
+
+  job->num_of_broken = 0;
+  for (int ib = job->iw; ib < job->num_of_block; ib += job->num_of_thread)
+  {
+    int bi, bj, bk;
+    size_t off = zblock_frame_offset(ib, ni, nj, nk, &bi, &bj, &bk);
+    job->num_of_broken += zblock_decode(job->zdata + job->zoff[ib], job->zsize[ib],
+                                        bi, bj, bk, ni, (size_t) ni * nj,
+                                        job->eb, job->var + off);
+  }
+
+  return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+  int num_of_thread = 4;
+  int iarg = 1;
+  while (iarg < argc && argv[iarg][0] == '-')
+  {
+    if (strcmp(argv[iarg], "-n") == 0 && iarg+1 < argc) {
+      num_of_thread = atoi(argv[iarg+1]);
+      iarg += 2;
+    } else {
+      break;
+    }
+  }
+  if (argc - iarg != 2 || num_of_thread < 1) {
+    fprintf(stderr,"usage: %s [-n num_of_thread] <in.nc> <out.nc>\n", argv[0]);
+    exit(1);
+  }
+  char *in_file  = argv[iarg];
+  char *out_file = argv[iarg+1];
+
+  int ncid, ierr;
+  ierr = nc_open(in_file, NC_NOWRITE, &ncid); handle_nc_err(ierr, in_file);
+
+  size_t natt = 0;
+  if (nc_inq_attlen(ncid, NC_GLOBAL, "compressor", &natt) != NC_NOERR) {
+    fprintf(stderr,"Error: %s is not a compressed snapshot\n", in_file);
+    exit(1);
+  }
+
+  // dims
+  const char *dim_name[] = { "time", "k", "j", "i", "block" };
+  size_t len[5];
+  for (int d=0; d < 5; d++)
+  {
+    int dimid;
+    ierr = nc_inq_dimid(ncid, dim_name[d], &dimid);  handle_nc_err(ierr, in_file);
+    ierr = nc_inq_dimlen(ncid, dimid, &len[d]);      handle_nc_err(ierr, in_file);
+  }
+  int nt = (int) len[0];
+  int nk = (int) len[1], nj = (int) len[2], ni = (int) len[3];
+  int num_of_block = (int) len[4];
+
+  int nbi, nbj, nbk;
+  if (zblock_frame_dims(ni, nj, nk, &nbi, &nbj, &nbk) != num_of_block) {
+    fprintf(stderr,"Error: %s has %d blocks, but %d of %d x %d x %d\n",
+            in_file, num_of_block, nbi*nbj*nbk, ni, nj, nk);
+    exit(1);
+  }
+
+  // components in file
+  int num_of_var = 0;
+  int icmp_of_var[SNAP_DECODE_MAX_CMP];
+  int varid_zstart[SNAP_DECODE_MAX_CMP];
+  int varid_zsize [SNAP_DECODE_MAX_CMP];
+  int varid_eb    [SNAP_DECODE_MAX_CMP];
+  char name[256];
+  for (int icmp=0; icmp < SNAP_DECODE_MAX_CMP; icmp++)
+  {
+    sprintf(name, "%s_zsize", cmp_name[icmp]);
+    if (nc_inq_varid(ncid, name, &varid_zsize[num_of_var]) != NC_NOERR) continue;
+    sprintf(name, "%s_zstart", cmp_name[icmp]);
+    ierr = nc_inq_varid(ncid, name, &varid_zstart[num_of_var]); handle_nc_err(ierr, in_file);
+    sprintf(name, "%s_eb", cmp_name[icmp]);
+    ierr = nc_inq_varid(ncid, name, &varid_eb[num_of_var]);     handle_nc_err(ierr, in_file);
+    icmp_of_var[num_of_var] = icmp;
+    num_of_var += 1;
+  }
+  int timeid_in, varid_zdata;
+  ierr = nc_inq_varid(ncid, "time", &timeid_in);    handle_nc_err(ierr, in_file);
+  ierr = nc_inq_varid(ncid, "zdata", &varid_zdata); handle_nc_err(ierr, in_file);
+
+  // frames written, of last component as it is written last
+  double *zstart = (double *) malloc(nt * sizeof(double));
+  int nt_out = 0;
+  if (num_of_var > 0)
+  {
+    ierr = nc_get_var_double(ncid, varid_zstart[num_of_var-1], zstart);
+    handle_nc_err(ierr, in_file);
+    while (nt_out < nt && zstart[nt_out] < SNAP_DECODE_NO_FRAME) nt_out++;
+  }
+
+  // output of plain layout
+  int ncid_out;
+  int dimid[4];
+  int timeid;
+  int varid[SNAP_DECODE_MAX_CMP];
+  ierr = nc_create(out_file, NC_CLOBBER, &ncid_out);              handle_nc_err(ierr, out_file);
+  ierr = nc_def_dim(ncid_out, "time", NC_UNLIMITED, &dimid[0]);   handle_nc_err(ierr, out_file);
+  ierr = nc_def_dim(ncid_out, "k", nk, &dimid[1]);                handle_nc_err(ierr, out_file);
+  ierr = nc_def_dim(ncid_out, "j", nj, &dimid[2]);                handle_nc_err(ierr, out_file);
+  ierr = nc_def_dim(ncid_out, "i", ni, &dimid[3]);                handle_nc_err(ierr, out_file);
+  ierr = nc_def_var(ncid_out, "time", NC_FLOAT, 1, dimid, &timeid); handle_nc_err(ierr, out_file);
+  for (int ivar=0; ivar < num_of_var; ivar++)
+  {
+    ierr = nc_def_var(ncid_out, cmp_name[icmp_of_var[ivar]], NC_FLOAT, 4, dimid, &varid[ivar]);
+    handle_nc_err(ierr, out_file);
+  }
+  // global attributes except of codec
+  int num_of_att;
+  ierr = nc_inq_natts(ncid, &num_of_att); handle_nc_err(ierr, in_file);
+  for (int n=0; n < num_of_att; n++)
+  {
+    ierr = nc_inq_attname(ncid, NC_GLOBAL, n, name); handle_nc_err(ierr, in_file);
+    if (strcmp(name, "compressor") == 0 || strncmp(name, "zblock_", 7) == 0) continue;
+    ierr = nc_copy_att(ncid, NC_GLOBAL, name, ncid_out, NC_GLOBAL);
+    handle_nc_err(ierr, out_file);
+  }
+  ierr = nc_enddef(ncid_out); handle_nc_err(ierr, out_file);
+
+  // work space
+  size_t siz_frame = (size_t) ni * nj * nk;
+  size_t siz_zdata = num_of_block * ZBLOCK_BOUND(ZBLOCK_MAX_POINTS);
+  float  *var   = (float *) malloc(siz_frame * sizeof(float));
+  unsigned char *zdata = (unsigned char *) malloc(siz_zdata);
+  int    *zsize = (int *) malloc(num_of_block * sizeof(int));
+  size_t *zoff  = (size_t *) malloc(num_of_block * sizeof(size_t));
+  pthread_t *thread = (pthread_t *) malloc(num_of_thread * sizeof(pthread_t));
+  snap_decode_job_t *job = (snap_decode_job_t *) malloc(num_of_thread * sizeof(snap_decode_job_t));
+  if (var == NULL || zdata == NULL) {
+    fprintf(stderr,"Error: can't alloc frame of %d x %d x %d\n", ni, nj, nk);
+    exit(1);
+  }
+
+  for (int it=0; it < nt_out; it++)
+  {
+    size_t start_t = it;
+    float t;
+    ierr = nc_get_var1_float(ncid, timeid_in, &start_t, &t);  handle_nc_err(ierr, in_file);
+    ierr = nc_put_var1_float(ncid_out, timeid, &start_t, &t); handle_nc_err(ierr, out_file);
+
+    for (int ivar=0; ivar < num_of_var; ivar++)
+    {
+      size_t startp[] = { start_t, 0, 0, 0 };
+      size_t countp[] = { 1, (size_t) num_of_block, 0, 0 };
+      double zpos;
+      float  eb;
+      ierr = nc_get_vara_int(ncid, varid_zsize[ivar], startp, countp, zsize);
+      handle_nc_err(ierr, in_file);
+      ierr = nc_get_var1_double(ncid, varid_zstart[ivar], startp, &zpos);
+      handle_nc_err(ierr, in_file);
+      ierr = nc_get_var1_float(ncid, varid_eb[ivar], startp, &eb);
+      handle_nc_err(ierr, in_file);
+
+      size_t zbyte = 0;
+      for (int ib=0; ib < num_of_block; ib++) {
+        zoff[ib] = zbyte;
+        zbyte += zsize[ib];
+      }
+      if (zbyte > siz_zdata) {
+        fprintf(stderr,"Error: %s_zsize of frame %d larger than bound\n",
+                cmp_name[icmp_of_var[ivar]], it);
+        exit(1);
+      }
+      size_t zstart_var = (size_t) zpos;
+      if (zbyte > 0) {
+        ierr = nc_get_vara_schar(ncid, varid_zdata, &zstart_var, &zbyte, (signed char *) zdata);
+        handle_nc_err(ierr, in_file);
+      }
+
+      for (int iw=0; iw < num_of_thread; iw++)
+      {
+        job[iw].zdata = zdata;
+        job[iw].zsize = zsize;
+        job[iw].zoff  = zoff;
+        job[iw].num_of_block = num_of_block;
+        job[iw].ni = ni;
+        job[iw].nj = nj;
+        job[iw].nk = nk;
+        job[iw].eb = eb;
+        job[iw].var = var;
+        job[iw].iw  = iw;
+        job[iw].num_of_thread = num_of_thread;
+        if (iw > 0 && pthread_create(thread + iw, NULL, decode_worker, job + iw) != 0) {
+          fprintf(stderr,"Error: can't create decode thread\n");
+          exit(1);
+        }
+      }
+      decode_worker(job);
+      int num_of_broken = job[0].num_of_broken;
+      for (int iw=1; iw < num_of_thread; iw++) {
+        pthread_join(thread[iw], NULL);
+        num_of_broken += job[iw].num_of_broken;
+      }
+      if (num_of_broken > 0) {
+        fprintf(stderr,"Error: %d broken blocks of %s at frame %d\n",
+                num_of_broken, cmp_name[icmp_of_var[ivar]], it);
+        exit(1);
+      }
+
+      size_t count_out[] = { 1, (size_t) nk, (size_t) nj, (size_t) ni };
+      ierr = nc_put_vara_float(ncid_out, varid[ivar], startp, count_out, var);
+      handle_nc_err(ierr, out_file);
+    }
+  }
+
+  nc_close(ncid);
+  nc_close(ncid_out);
+
+  fprintf(stdout,"%s: %d frames of %d components decoded to %s\n",
+          in_file, nt_out, num_of_var, out_file);
+
+  free(zstart);
+  free(var);
+  free(zdata);
+  free(zsize);
+  free(zoff);
+  free(thread);
+  free(job);
+
+  return 0;
+}
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * merge trace_rank%d.json of all ranks into one chrome trace file
+ *  timestamps of each rank are shifted by its barrier_us, so all ranks
+ *  start from the common MPI_Barrier after tracer init
+ *
+ *  usage: trace_merge <out.json> trace_rank0.json trace_rank1.json ...
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_LINE_STRLEN 1024
+
+int main(int argc, char **argv)
+{
+  if (argc < 3) {
+    fprintf(stdout,"usage: trace_merge <out.json> <trace_rank0.json> ...\n");
+    exit(1);
+  }
+
+  FILE *fpo = fopen(argv[1], "w");
+  if (fpo == NULL) {
+    fprintf(stderr,"Error: can't create %s\n", argv[1]);
+    exit(1);
+  }
+
+  fprintf(fpo, "{\"traceEvents\": [\n");
+
+  char line[TRACE_LINE_STRLEN];
+  int  is_first = 1;
+  long num_event = 0;
+
+  for (int ifile=2; ifile < argc; ifile++)
+  {
+    FILE *fp = fopen(argv[ifile], "r");
+    if (fp == NULL) {
+      fprintf(stderr,"Error: can't open %s\n", argv[ifile]);
+      exit(1);
+    }
+
+    // first line keeps clock of barrier
+    int    rank = -1;
+    double barrier_us = 0.0;
+    if (fgets(line, TRACE_LINE_STRLEN, fp) == NULL ||
+        sscanf(line, "{\"otherData\": {\"rank\": %d, \"barrier_us\": %lf",
+               &rank, &barrier_us) != 2)
+    {
+      fprintf(stderr,"Error: %s is not written by trace_write\n", argv[ifile]);
+      exit(1);
+    }
+
+    while (fgets(line, TRACE_LINE_STRLEN, fp) != NULL)
+    {
+      if (line[0] != '{') continue;
+
+      // strip tailing comma and newline
+      size_t len = strlen(line);
+      while (len > 0 && (line[len-1] == '\n' || line[len-1] == ',')) {
+        line[--len] = '\0';
+      }
+
+      if (is_first == 0) fprintf(fpo, ",\n");
+      is_first = 0;
+
+      char *p_ts = strstr(line, "\"ts\": ");
+      if (p_ts == NULL)
+      {
+        // metadata event
+        fprintf(fpo, "%s", line);
+      }
+      else
+      {
+        char *p_val = p_ts + strlen("\"ts\": ");
+        char *p_rest;
+        double ts = strtod(p_val, &p_rest);
+        *p_val = '\0';
+        fprintf(fpo, "%s%.3f%s", line, ts - barrier_us, p_rest);
+        num_event += 1;
+      }
+    }
+
+    fclose(fp);
+  }
+
+  fprintf(fpo, "\n]}\n");
+  fclose(fpo);
+
+  fprintf(stdout,"merged %ld events of %d ranks to %s\n", num_event, argc-2, argv[1]);
+
+  return 0;
+}